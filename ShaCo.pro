@@ -1,5 +1,7 @@
 TEMPLATE = subdirs
-SUBDIRS = core app test
+SUBDIRS = core app cli test bench
 
 app.depends = core
+cli.depends = core
 test.depends = core
+bench.depends = core
@@ -7,7 +7,7 @@ VERSION = 1.0.0
 
 TEMPLATE = app
 TARGET = ShaCo
-QT += quick quickcontrols2 serialport svg
+QT += quick quickcontrols2 serialport svg concurrent network
 app.depends = core
 macx:ICON = ../images/ShaCo.icns
 win32:RC_ICONS = ../images/ShaCo.ico
@@ -15,13 +15,23 @@ win32:RC_ICONS = ../images/ShaCo.ico
 HEADERS += \
     controller.h \
     worker.h \
+    workerthread.h \
     localshapesmodel.h \
-    settings.h
+    metricsmodel.h \
+    settings.h \
+    terminalmodel.h \
+    shapesfiltermodel.h \
+    thumbnailprovider.h
 SOURCES += main.cpp \
     controller.cpp \
     worker.cpp \
+    workerthread.cpp \
     localshapesmodel.cpp \
-    settings.cpp
+    metricsmodel.cpp \
+    settings.cpp \
+    terminalmodel.cpp \
+    shapesfiltermodel.cpp \
+    thumbnailprovider.cpp
 
 unix:LIBS += -L../core -lcore
 win32:debug:LIBS += -L../core/debug -lcore
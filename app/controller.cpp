@@ -2,20 +2,50 @@
 #include <memory>
 #include <QMetaObject>
 #include <QDir>
+#include <QStandardPaths>
+#include "core/tracerecorder.h"
+
+namespace {
+    // Lines kept in the terminal
+    constexpr int terminalCapacity = 200000;
+    // Updates of the terminal view are coalesced, this is roughly the display refresh interval
+    constexpr int terminalUpdateIntervalMillis = 16;
+    // Changes in the shapes directory are processed together if notified within this interval
+    constexpr int shapesDebounceMillis = 250;
+    // Refresh interval of the diagnostics view
+    constexpr int metricsRefreshMillis = 1000;
+    // Interval between metrics written to the log while streaming
+    constexpr int metricsLogIntervalMillis = 5000;
+}
 
 Controller::Controller(QObject *parent)
     : QObject(parent)
     , m_thread(this)
+    , m_statusMirror(m_settings.wireTemperature())
     , m_connected(false)
     , m_streamingGCode(false)
     , m_stoppingStreaming(false)
     , m_paused(false)
     , m_senderCreated(false)
-    , m_shapesFinder(QDir::homePath() + "/PolyShaper")
+    , m_shapesFinder(QDir::homePath() + "/PolyShaper",
+                     QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shapes.index",
+                     shapesDebounceMillis,
+                     true,
+                     true)
     , m_shapesModel(m_shapesFinder)
+    , m_shapesFilterModel(m_shapesFinder, m_shapesModel)
+    , m_terminalModel(terminalCapacity, terminalUpdateIntervalMillis)
+    , m_metricsModel(MetricsRegistry::global(), metricsRefreshMillis)
+    , m_metricsLogger(MetricsRegistry::global(),
+                      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/metrics.log",
+                      metricsLogIntervalMillis)
     , m_cutProgress(0)
 {
-    connect(&m_shapesFinder, &LocalShapesFinder::shapesUpdated, &m_shapesModel, &LocalShapesModel::shapesUpdated);
+    connect(&m_statusMirror, &StatusMirror::wireOnChanged, this, &Controller::wireOnChanged);
+    connect(&m_statusMirror, &StatusMirror::temperatureChanged, this, &Controller::wireTemperatureChanged);
+    connect(&m_statusMirror, &StatusMirror::machineStateChanged, this, &Controller::machineStateChanged);
+    connect(this, &Controller::portClosed, &m_terminalModel, &TerminalModel::appendSeparator);
+    connect(this, &Controller::portClosedWithError, &m_terminalModel, &TerminalModel::appendSeparator);
     connect(&m_cutTimer, &QTimer::timeout, this, &Controller::cutClockTimeout);
     m_cutTimer.setInterval(1000);
     m_cutTimer.setSingleShot(false);
@@ -40,12 +70,8 @@ void Controller::creationFinished()
         this, &Controller::signalPortFound
     );
     connect(
-        m_thread.worker()->machineCommunicator(), &MachineCommunication::dataSent,
-        this, &Controller::dataSent
-    );
-    connect(
-        m_thread.worker()->machineCommunicator(), &MachineCommunication::dataReceived,
-        this, &Controller::dataReceived
+        m_thread.worker()->trafficTap(), &TrafficTap::trafficAvailable,
+        &m_terminalModel, &TerminalModel::trafficAvailable
     );
     connect(
         m_thread.worker()->machineCommunicator(), &MachineCommunication::portClosedWithError,
@@ -56,16 +82,33 @@ void Controller::creationFinished()
         this, &Controller::signalPortClosed
     );
     connect(
-        m_thread.worker()->wireController(), &WireController::temperatureChanged,
-        this, &Controller::wireTemperatureChanged
+        m_thread.worker()->commandSender(), &CommandSender::slowAck,
+        this, &Controller::slowAck
     );
     connect(
         m_thread.worker(), &Worker::gcodeSenderCreated,
         this, &Controller::gcodeSenderCreated
     );
+    connect(
+        m_thread.worker(), &Worker::gcodeRefused,
+        this, &Controller::gcodeRefused
+    );
+    connect(
+        m_thread.worker(), &Worker::streamingStarted,
+        this, &Controller::streamingStarted
+    );
+    connect(
+        m_thread.worker(), &Worker::streamingEnded,
+        this, &Controller::streamingEnded
+    );
+
+    m_statusMirror.trackWireController(m_thread.worker()->wireController());
+    m_statusMirror.trackStatusMonitor(m_thread.worker()->statusMonitor());
 
     auto p = m_thread.worker()->portDiscoverer();
     QMetaObject::invokeMethod(p, [p](){ p->start(); });
+    auto w = m_thread.worker();
+    QMetaObject::invokeMethod(w, [w](){ w->startJobServer(); });
 }
 
 bool Controller::connected() const
@@ -85,22 +128,17 @@ bool Controller::stoppingStreaming() const
 
 bool Controller::wireOn() const
 {
-    bool isWireOn = false;
-
-    const auto p = m_thread.worker()->wireController();
-    QMetaObject::invokeMethod(p, [p](){ return p->isWireOn(); }, Qt::BlockingQueuedConnection, &isWireOn);
-
-    return isWireOn;
+    return m_statusMirror.wireOn();
 }
 
 float Controller::wireTemperature() const
 {
-    float temperature = 0.0;
-
-    const auto p = m_thread.worker()->wireController();
-    QMetaObject::invokeMethod(p, [p](){ return p->temperature(); }, Qt::BlockingQueuedConnection, &temperature);
+    return m_statusMirror.temperature();
+}
 
-    return temperature;
+QString Controller::machineState() const
+{
+    return machineState2String(m_statusMirror.machineState());
 }
 
 bool Controller::paused() const
@@ -115,7 +153,7 @@ bool Controller::senderCreated() const
 
 QAbstractItemModel* Controller::localShapesModel()
 {
-    return &m_shapesModel;
+    return &m_shapesFilterModel;
 }
 
 qint64 Controller::cutProgress() const
@@ -123,11 +161,36 @@ qint64 Controller::cutProgress() const
     return m_cutProgress;
 }
 
+QAbstractItemModel* Controller::terminalModel()
+{
+    return &m_terminalModel;
+}
+
+QAbstractItemModel* Controller::metricsModel()
+{
+    return &m_metricsModel;
+}
+
+bool Controller::terminalEnabled() const
+{
+    return m_terminalModel.enabled();
+}
+
+bool Controller::terminalFilterStatusPolling() const
+{
+    return m_terminalModel.filterStatusPolling();
+}
+
 unsigned long Controller::characterSendDelayUs() const
 {
     return m_settings.characterSendDelayUs();
 }
 
+bool Controller::tracingEnabled() const
+{
+    return TraceRecorder::global().isEnabled();
+}
+
 void Controller::sendLine(QByteArray line)
 {
     auto p = m_thread.worker()->machineCommunicator();
@@ -140,25 +203,34 @@ void Controller::setGCodeFile(QUrl fileUrl)
     QMetaObject::invokeMethod(p, [p, fileUrl](){ p->setGCodeFile(fileUrl); });
 }
 
+void Controller::releaseGCodeFile()
+{
+    m_senderCreated = false;
+    emit senderCreatedChanged();
+
+    auto p = m_thread.worker();
+    QMetaObject::invokeMethod(p, [p](){ p->releaseGCodeFile(); });
+}
+
 void Controller::setWireOn(bool wireOn)
 {
-    if (this->wireOn() == wireOn) {
+    if (m_statusMirror.wireOn() == wireOn) {
         return;
     }
 
     auto p = m_thread.worker()->wireController();
     if (wireOn) {
         QMetaObject::invokeMethod(p, [p](){ p->switchWireOn(); });
+        m_statusMirror.setWireOn();
     } else {
         QMetaObject::invokeMethod(p, [p](){ p->switchWireOff(); });
+        m_statusMirror.setWireOff();
     }
-
-    emit wireOnChanged();
 }
 
 void Controller::setWireTemperature(float temperature)
 {
-    if (wireTemperature() == temperature) {
+    if (m_statusMirror.temperature() == temperature) {
         return;
     }
 
@@ -171,7 +243,8 @@ void Controller::setWireTemperature(float temperature)
         QMetaObject::invokeMethod(p, [p, temperature](){ p->setTemperature(temperature); });
     }
 
-    emit wireTemperatureChanged();
+    // The worker will notify the actual temperature (which might be slightly different)
+    m_statusMirror.setTemperature(temperature);
 }
 
 void Controller::startStreamingGCode()
@@ -234,11 +307,51 @@ void Controller::changeLocalShapesSort(QString sortBy)
     m_shapesModel.sortShapes(s);
 }
 
+void Controller::changeLocalShapesSearch(QString text)
+{
+    m_shapesFilterModel.setSearchText(text);
+}
+
+void Controller::changeLocalShapesSquareFilter(QString square)
+{
+    m_shapesFilterModel.setSquareFilter(square);
+}
+
 void Controller::reloadShapes()
 {
     m_shapesFinder.reload();
 }
 
+void Controller::setTerminalEnabled(bool enabled)
+{
+    if (m_terminalModel.enabled() == enabled) {
+        return;
+    }
+
+    m_terminalModel.setEnabled(enabled);
+
+    // Traffic is only collected while the terminal is enabled
+    auto p = m_thread.worker()->trafficTap();
+    if (enabled) {
+        QMetaObject::invokeMethod(p, [p](){ p->subscribe(); });
+    } else {
+        QMetaObject::invokeMethod(p, [p](){ p->unsubscribe(); });
+    }
+
+    emit terminalEnabledChanged();
+}
+
+void Controller::setTerminalFilterStatusPolling(bool filter)
+{
+    if (m_terminalModel.filterStatusPolling() == filter) {
+        return;
+    }
+
+    m_terminalModel.setFilterStatusPolling(filter);
+
+    emit terminalFilterStatusPollingChanged();
+}
+
 void Controller::setCharacterSendDelayUs(unsigned long us)
 {
     if (m_settings.characterSendDelayUs() == us) {
@@ -253,15 +366,41 @@ void Controller::setCharacterSendDelayUs(unsigned long us)
     emit characterSendDelayUsChanged();
 }
 
-void Controller::gcodeSenderCreated(GCodeSender* sender)
+void Controller::setTracingEnabled(bool enabled)
 {
-    connect(sender, &GCodeSender::streamingStarted, this, &Controller::streamingStarted);
-    connect(sender, &GCodeSender::streamingEnded, this, &Controller::streamingEnded);
+    if (TraceRecorder::global().isEnabled() == enabled) {
+        return;
+    }
 
+    TraceRecorder::global().setEnabled(enabled);
+
+    emit tracingEnabledChanged();
+}
+
+bool Controller::saveTrace(QUrl fileUrl)
+{
+    return TraceRecorder::global().saveChromeJson(fileUrl.toLocalFile());
+}
+
+void Controller::setDiagnosticsActive(bool active)
+{
+    m_metricsModel.setActive(active);
+}
+
+void Controller::gcodeSenderCreated(GCodeSender*)
+{
     m_senderCreated = true;
     emit senderCreatedChanged();
 }
 
+void Controller::gcodeRefused(QString description)
+{
+    m_senderCreated = false;
+    emit senderCreatedChanged();
+
+    emit streamingEndedWithError(description);
+}
+
 void Controller::signalPortFound(MachineInfo *info)
 {
     m_connected = true;
@@ -287,6 +426,16 @@ void Controller::signalPortClosed()
     emit connectedChanged();
 }
 
+void Controller::slowAck(CommandCorrelationId correlationId, qint64 latencyUs)
+{
+    // Only G-code lines have a correlation id (their line number)
+    if (correlationId == 0) {
+        m_terminalModel.appendInfo(tr("Slow reply to a command: %1 ms").arg(latencyUs / 1000));
+    } else {
+        m_terminalModel.appendInfo(tr("Slow reply to line %1: %2 ms").arg(correlationId).arg(latencyUs / 1000));
+    }
+}
+
 void Controller::streamingStarted()
 {
     m_streamingGCode = true;
@@ -294,6 +443,9 @@ void Controller::streamingStarted()
     emit streamingGCodeChanged();
 
     initializeCutTimer();
+
+    m_metricsLogger.writeSnapshot();
+    m_metricsLogger.start();
 }
 
 void Controller::streamingEnded(GCodeSender::StreamEndReason reason, QString description)
@@ -316,6 +468,9 @@ void Controller::streamingEnded(GCodeSender::StreamEndReason reason, QString des
     emit senderCreatedChanged();
 
     m_cutTimer.stop();
+
+    m_metricsLogger.stop();
+    m_metricsLogger.writeSnapshot();
 }
 
 void Controller::cutClockTimeout()
@@ -8,9 +8,14 @@
 #include <QTimer>
 #include <QSerialPortInfo>
 #include <QUrl>
-#include "worker.h"
+#include "workerthread.h"
 #include "localshapesmodel.h"
+#include "metricsmodel.h"
+#include "shapesfiltermodel.h"
+#include "terminalmodel.h"
 #include "core/localshapesfinder.h"
+#include "core/metricslogger.h"
+#include "core/statusmirror.h"
 
 class WorkerThread;
 
@@ -23,11 +28,17 @@ class Controller : public QObject
     Q_PROPERTY(bool stoppingStreaming READ stoppingStreaming NOTIFY stoppingStreamingChanged)
     Q_PROPERTY(bool wireOn READ wireOn WRITE setWireOn NOTIFY wireOnChanged)
     Q_PROPERTY(float wireTemperature READ wireTemperature WRITE setWireTemperature NOTIFY wireTemperatureChanged)
+    Q_PROPERTY(QString machineState READ machineState NOTIFY machineStateChanged)
     Q_PROPERTY(bool paused READ paused NOTIFY pausedChanged)
     Q_PROPERTY(bool senderCreated READ senderCreated NOTIFY senderCreatedChanged)
     Q_PROPERTY(QAbstractItemModel* localShapesModel READ localShapesModel NOTIFY localShapesModelChanged)
     Q_PROPERTY(qint64 cutProgress READ cutProgress NOTIFY cutProgressChanged)
+    Q_PROPERTY(QAbstractItemModel* terminalModel READ terminalModel CONSTANT)
+    Q_PROPERTY(bool terminalEnabled READ terminalEnabled WRITE setTerminalEnabled NOTIFY terminalEnabledChanged)
+    Q_PROPERTY(bool terminalFilterStatusPolling READ terminalFilterStatusPolling WRITE setTerminalFilterStatusPolling NOTIFY terminalFilterStatusPollingChanged)
     Q_PROPERTY(unsigned long characterSendDelayUs READ characterSendDelayUs WRITE setCharacterSendDelayUs NOTIFY characterSendDelayUsChanged)
+    Q_PROPERTY(bool tracingEnabled READ tracingEnabled WRITE setTracingEnabled NOTIFY tracingEnabledChanged)
+    Q_PROPERTY(QAbstractItemModel* metricsModel READ metricsModel CONSTANT)
 
 public:
     explicit Controller(QObject *parent = nullptr);
@@ -41,15 +52,23 @@ public:
     bool stoppingStreaming() const;
     bool wireOn() const;
     float wireTemperature() const;
+    QString machineState() const;
     bool paused() const;
     bool senderCreated() const;
     QAbstractItemModel* localShapesModel();
     qint64 cutProgress() const;
+    QAbstractItemModel* terminalModel();
+    bool terminalEnabled() const;
+    bool terminalFilterStatusPolling() const;
     unsigned long characterSendDelayUs() const;
+    bool tracingEnabled() const;
+    QAbstractItemModel* metricsModel();
 
 public slots:
     void sendLine(QByteArray line);
     void setGCodeFile(QUrl fileUrl);
+    // Called when the cut is not started after setGCodeFile(), so that jobs can run
+    void releaseGCodeFile();
     void setWireOn(bool wireOn);
     void setWireTemperature(float temperature);
     void startStreamingGCode();
@@ -57,33 +76,48 @@ public slots:
     void feedHold();
     void resumeFeedHold();
     void changeLocalShapesSort(QString sortBy);
+    void changeLocalShapesSearch(QString text);
+    // One of "any", "square" or "notSquare"
+    void changeLocalShapesSquareFilter(QString square);
     void reloadShapes();
+    void setTerminalEnabled(bool enabled);
+    void setTerminalFilterStatusPolling(bool filter);
     void setCharacterSendDelayUs(unsigned long us);
+    // Events are recorded in TraceRecorder::global(), from all threads
+    void setTracingEnabled(bool enabled);
+    // Saves the recorded events in the Chrome trace event format. Returns false in case of error
+    bool saveTrace(QUrl fileUrl);
+    // The metrics model is only updated while the diagnostics view is visible
+    void setDiagnosticsActive(bool active);
 
 signals:
     void startedPortDiscovery();
     void portFound(QString machineName, QString partNumber, QString serialNumber, QString firmwareVersion);
     void connectedChanged();
-    void dataSent(QByteArray data);
-    void dataReceived(QByteArray data);
     void portClosedWithError(QString reason);
     void portClosed();
     void streamingGCodeChanged();
     void stoppingStreamingChanged();
     void wireOnChanged();
     void wireTemperatureChanged();
+    void machineStateChanged();
     void streamingEndedWithError(QString reason);
     void pausedChanged();
     void senderCreatedChanged();
     void localShapesModelChanged(); // This is never emitted at the moment
     void cutProgressChanged();
+    void terminalEnabledChanged();
+    void terminalFilterStatusPollingChanged();
     void characterSendDelayUsChanged();
+    void tracingEnabledChanged();
 
 private slots:
     void gcodeSenderCreated(GCodeSender* sender);
+    void gcodeRefused(QString description);
     void signalPortFound(MachineInfo* info);
     void signalPortClosedWithError(QString reason);
     void signalPortClosed();
+    void slowAck(CommandCorrelationId correlationId, qint64 latencyUs);
     void streamingStarted();
     void streamingEnded(GCodeSender::StreamEndReason reason, QString description);
     void cutClockTimeout();
@@ -97,6 +131,8 @@ private:
 
     Settings m_settings;
     WorkerThread m_thread;
+    // Never read state of objects in the worker thread directly, use this (it is updated via signals)
+    StatusMirror m_statusMirror;
     bool m_connected;
     bool m_streamingGCode;
     bool m_stoppingStreaming;
@@ -104,6 +140,11 @@ private:
     bool m_senderCreated;
     LocalShapesFinder m_shapesFinder;
     LocalShapesModel m_shapesModel;
+    ShapesFilterModel m_shapesFilterModel;
+    TerminalModel m_terminalModel;
+    MetricsModel m_metricsModel;
+    // Only logs while streaming
+    MetricsLogger m_metricsLogger;
     QTimer m_cutTimer;
     QDateTime m_cutStartTime;
     QDateTime m_cutPauseStart;
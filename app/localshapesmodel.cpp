@@ -1,33 +1,76 @@
 #include "localshapesmodel.h"
 #include <algorithm>
+#include <utility>
+#include <QUrl>
+
+namespace {
+    // If more than this fraction of the shapes changes, the model is reset instead of inserting
+    // and removing single rows
+    const int resetFractionDenominator = 4;
+
+    // The url of the thumbnail, see ThumbnailProvider. The hash of the svg file is part of the
+    // url so that copies of the same shape share the thumbnail
+    QString thumbnailUrl(const QString& svgPath, quint64 svgHash)
+    {
+        const auto hash = (svgHash == 0) ? QString() : QString::number(svgHash, 16);
+
+        return "image://thumbnail/" + hash + "/" + QString::fromLatin1(QUrl::toPercentEncoding(svgPath));
+    }
+
+    QString gcodeStatusString(GCodeCheck::Verdict verdict)
+    {
+        switch (verdict) {
+            case GCodeCheck::Verdict::Unchecked: return "unchecked";
+            case GCodeCheck::Verdict::Valid:     return "valid";
+            case GCodeCheck::Verdict::Warning:   return "warning";
+            case GCodeCheck::Verdict::Invalid:   return "invalid";
+        }
+
+        return QString();
+    }
+
+    QString gcodeProblemString(const GCodeCheck& check)
+    {
+        if (check.message.isEmpty()) {
+            return QString();
+        }
+
+        return (check.line == 0) ? check.message : QString("Line %1: %2").arg(check.line).arg(check.message);
+    }
+}
 
 LocalShapesModel::LocalShapesModel(LocalShapesFinder &finder)
     : m_finder(finder)
-    , m_sortedShapes(m_finder.shapes().keys())
     , m_curSortCriterion(SortCriterion::Newest)
 {
+    // So that "Shape 9" comes before "Shape 10"
+    m_collator.setNumericMode(true);
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+
     connect(&m_finder, &LocalShapesFinder::shapesUpdated, this, &LocalShapesModel::shapesUpdated);
+    connect(&m_finder, &LocalShapesFinder::shapesChecked, this, &LocalShapesModel::shapesChecked);
 
-    sortShapes(m_curSortCriterion);
+    rebuildShapes();
+    sortRows();
 }
 
 int LocalShapesModel::rowCount(const QModelIndex &) const
 {
-    return m_sortedShapes.size();
+    return static_cast<int>(m_rows.size());
 }
 
 QVariant LocalShapesModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() > m_sortedShapes.size() ||
-            !m_finder.shapes().contains(m_sortedShapes[index.row()])) {
+    if (index.row() < 0 || index.row() >= rowCount()) {
         return QVariant();
     }
 
-    const auto& info = m_finder.shapes()[m_sortedShapes[index.row()]];
+    const auto slot = m_rows[static_cast<std::size_t>(index.row())];
+    const auto& info = m_infos[slot];
 
     switch (role) {
         case name:                  return info.name();
-        case svgFilename:           return info.path() + "/" + info.svgFilename();
+        case svgFilename:           return m_svgPaths[slot];
         case square:                return info.square();
         case machineType:           return info.machineType();
         case drawToolpath:          return info.drawToolpath();
@@ -41,7 +84,10 @@ QVariant LocalShapesModel::data(const QModelIndex &index, int role) const
         case duration:              return info.duration();
         case pointsInsideWorkpiece: return info.pointsInsideWorkpiece();
         case speed:                 return info.speed();
-        case gcodeFilename:         return info.path() + "/" + info.gcodeFilename();
+        case gcodeFilename:         return m_gcodePaths[slot];
+        case thumbnailSource:       return thumbnailUrl(m_svgPaths[slot], info.svgHash());
+        case gcodeStatus:           return gcodeStatusString(info.gcodeCheck().verdict);
+        case gcodeProblem:          return gcodeProblemString(info.gcodeCheck());
         default:                    return QVariant();
     }
 }
@@ -66,6 +112,9 @@ QHash<int, QByteArray> LocalShapesModel::roleNames() const
     roles[pointsInsideWorkpiece] = "pointsInsideWorkpiece";
     roles[speed] = "speed";
     roles[gcodeFilename] = "gcodeFilename";
+    roles[thumbnailSource] = "thumbnailSource";
+    roles[gcodeStatus] = "gcodeStatus";
+    roles[gcodeProblem] = "gcodeProblem";
 
     return roles;
 }
@@ -75,31 +124,210 @@ void LocalShapesModel::sortShapes(SortCriterion s)
     m_curSortCriterion = s;
 
     beginResetModel();
+    sortRows();
+    endResetModel();
+}
+
+QString LocalShapesModel::shapeKey(int row) const
+{
+    if (row < 0 || row >= rowCount()) {
+        return QString();
+    }
+
+    return m_keys[m_rows[static_cast<std::size_t>(row)]];
+}
+
+void LocalShapesModel::shapesUpdated(QSet<QString> newShapes, QSet<QString> removedShapes)
+{
+    emit shapesAboutToBeUpdated(newShapes, removedShapes);
+
+    const auto changes = newShapes.size() + removedShapes.size();
+    if (changes > m_finder.shapes().size() / resetFractionDenominator) {
+        beginResetModel();
+        rebuildShapes();
+        sortRows();
+        endResetModel();
+
+        return;
+    }
+
+    // Removing first because a shape can be both in removedShapes and in newShapes if it changed
+    for (const auto& key: removedShapes) {
+        removeShape(key);
+    }
+
+    for (const auto& key: newShapes) {
+        insertShape(key);
+    }
+}
+
+void LocalShapesModel::shapesChecked(QSet<QString> shapes)
+{
+    // Only the check changes, so the position of rows does not change
+    const QVector<int> roles{gcodeStatus, gcodeProblem};
+    for (const auto& key: shapes) {
+        const auto it = m_slots.constFind(key);
+        if (it == m_slots.cend()) {
+            continue;
+        }
+
+        const auto info = m_finder.shapes().value(key);
+        if (!info.isValid()) {
+            continue;
+        }
+
+        const auto slot = it.value();
+        m_infos[slot] = info;
+
+        const auto row = lowerBound(slot);
+        if (row < rowCount() && m_rows[static_cast<std::size_t>(row)] == slot) {
+            emit dataChanged(index(row), index(row), roles);
+        }
+    }
+}
+
+int LocalShapesModel::addShape(const QString& key, const ShapeInfo& info)
+{
+    const auto svgPath = info.path() + "/" + info.svgFilename();
+    const auto gcodePath = info.path() + "/" + info.gcodeFilename();
+    const auto creationTime = info.creationTime().toMSecsSinceEpoch();
+    auto nameSortKey = m_collator.sortKey(info.name());
+
+    int slot;
+    if (m_freeSlots.isEmpty()) {
+        slot = m_keys.size();
 
-    switch (s) {
+        m_keys.append(key);
+        m_infos.append(info);
+        m_svgPaths.append(svgPath);
+        m_gcodePaths.append(gcodePath);
+        m_creationTimes.append(creationTime);
+        m_nameSortKeys.push_back(std::move(nameSortKey));
+    } else {
+        slot = m_freeSlots.takeLast();
+
+        m_keys[slot] = key;
+        m_infos[slot] = info;
+        m_svgPaths[slot] = svgPath;
+        m_gcodePaths[slot] = gcodePath;
+        m_creationTimes[slot] = creationTime;
+        m_nameSortKeys[static_cast<std::size_t>(slot)] = std::move(nameSortKey);
+    }
+
+    m_slots.insert(key, slot);
+
+    return slot;
+}
+
+void LocalShapesModel::freeSlot(int slot)
+{
+    m_slots.remove(m_keys[slot]);
+
+    // Releasing memory, the sort key is overwritten when the slot is reused
+    m_keys[slot].clear();
+    m_infos[slot] = ShapeInfo();
+    m_svgPaths[slot].clear();
+    m_gcodePaths[slot].clear();
+
+    m_freeSlots.append(slot);
+}
+
+bool LocalShapesModel::lessThan(int slot1, int slot2) const
+{
+    // Using the key to break ties, so that the order is total and rows can be found with a
+    // binary search
+    switch (m_curSortCriterion) {
         case SortCriterion::Newest:
-            std::sort(m_sortedShapes.begin(), m_sortedShapes.end(),
-                      [this](const QString& n1, const QString& n2) {
-                          return m_finder.shapes()[n1].creationTime() > m_finder.shapes()[n2].creationTime();
-                      });
+            if (m_creationTimes[slot1] != m_creationTimes[slot2]) {
+                return m_creationTimes[slot1] > m_creationTimes[slot2];
+            }
             break;
         case SortCriterion::AZ:
-            std::sort(m_sortedShapes.begin(), m_sortedShapes.end(), [](const QString& n1, const QString& n2) {
-                          return n1 < n2;
-                      });
-            break;
-        case SortCriterion::ZA:
-            std::sort(m_sortedShapes.begin(), m_sortedShapes.end(), [](const QString& n1, const QString& n2) {
-                          return n1 > n2;
-                      });
+        case SortCriterion::ZA: {
+            const auto c = m_nameSortKeys[static_cast<std::size_t>(slot1)].compare(m_nameSortKeys[static_cast<std::size_t>(slot2)]);
+            if (c != 0) {
+                return (m_curSortCriterion == SortCriterion::AZ) ? (c < 0) : (c > 0);
+            }
             break;
+        }
     }
 
-    endResetModel();
+    return (m_curSortCriterion == SortCriterion::ZA) ? (m_keys[slot1] > m_keys[slot2]) : (m_keys[slot1] < m_keys[slot2]);
+}
+
+int LocalShapesModel::lowerBound(int slot) const
+{
+    const auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), slot, [this](int s1, int s2) {
+        return lessThan(s1, s2);
+    });
+
+    return static_cast<int>(it - m_rows.cbegin());
+}
+
+void LocalShapesModel::removeShape(const QString& key)
+{
+    const auto it = m_slots.constFind(key);
+    if (it == m_slots.cend()) {
+        return;
+    }
+
+    const auto slot = it.value();
+    const auto row = lowerBound(slot);
+
+    if (row < rowCount() && m_rows[static_cast<std::size_t>(row)] == slot) {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rows.erase(m_rows.begin() + row);
+        endRemoveRows();
+    }
+
+    freeSlot(slot);
+}
+
+void LocalShapesModel::insertShape(const QString& key)
+{
+    const auto it = m_finder.shapes().constFind(key);
+    if (it == m_finder.shapes().cend() || m_slots.contains(key)) {
+        return;
+    }
+
+    const auto slot = addShape(key, it.value());
+    const auto row = lowerBound(slot);
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_rows.insert(m_rows.begin() + row, slot);
+    endInsertRows();
+}
+
+void LocalShapesModel::rebuildShapes()
+{
+    const auto size = m_finder.shapes().size();
+
+    m_keys.clear();
+    m_keys.reserve(size);
+    m_infos.clear();
+    m_infos.reserve(size);
+    m_svgPaths.clear();
+    m_svgPaths.reserve(size);
+    m_gcodePaths.clear();
+    m_gcodePaths.reserve(size);
+    m_creationTimes.clear();
+    m_creationTimes.reserve(size);
+    m_nameSortKeys.clear();
+    m_nameSortKeys.reserve(static_cast<std::size_t>(size));
+    m_freeSlots.clear();
+    m_slots.clear();
+    m_slots.reserve(size);
+    m_rows.clear();
+    m_rows.reserve(static_cast<std::size_t>(size));
+
+    for (auto it = m_finder.shapes().cbegin(); it != m_finder.shapes().cend(); ++it) {
+        m_rows.push_back(addShape(it.key(), it.value()));
+    }
 }
 
-void LocalShapesModel::shapesUpdated(QSet<QString>, QSet<QString>)
+void LocalShapesModel::sortRows()
 {
-    m_sortedShapes = m_finder.shapes().keys();
-    sortShapes(m_curSortCriterion);
+    std::sort(m_rows.begin(), m_rows.end(), [this](int s1, int s2) {
+        return lessThan(s1, s2);
+    });
 }
@@ -1,8 +1,13 @@
 #ifndef LOCALSHAPESMODEL_H
 #define LOCALSHAPESMODEL_H
 
+#include <vector>
 #include <QAbstractListModel>
+#include <QCollator>
+#include <QHash>
+#include <QVector>
 #include "core/localshapesfinder.h"
+#include "core/shapeinfo.h"
 
 // TODO-TOMMY This is not tested, see comment in controller.h
 // The model of local shapes
@@ -27,7 +32,10 @@ private:
         duration,
         pointsInsideWorkpiece,
         speed,
-        gcodeFilename
+        gcodeFilename,
+        thumbnailSource,
+        gcodeStatus,
+        gcodeProblem
     };
 
 public:
@@ -47,13 +55,47 @@ public:
     QHash<int, QByteArray> roleNames() const override;
 
     void sortShapes(SortCriterion s);
+    // The key of the shape in LocalShapesFinder
+    QString shapeKey(int row) const;
 
 public slots:
+    // Only rows of changed shapes are inserted or removed, unless the change is large. In that
+    // case the model is reset
     void shapesUpdated(QSet<QString> newShapes, QSet<QString> removedShapes);
+    // Updates the G-code check of shapes
+    void shapesChecked(QSet<QString> shapes);
+
+signals:
+    // Emitted when shapesUpdated is called, before rows are changed
+    void shapesAboutToBeUpdated(QSet<QString> newShapes, QSet<QString> removedShapes);
 
 private:
+    // Shapes are stored in columns (one vector per field) indexed by a slot. Slots of removed
+    // shapes are reused. Everything needed to sort shapes and to answer data() is computed when
+    // a shape is added, so that sorting and scrolling do not need lookups or allocations
+    int addShape(const QString& key, const ShapeInfo& info);
+    void freeSlot(int slot);
+    bool lessThan(int slot1, int slot2) const;
+    // Returns the row of the first slot not less than the given one
+    int lowerBound(int slot) const;
+    void removeShape(const QString& key);
+    void insertShape(const QString& key);
+    void rebuildShapes();
+    void sortRows();
+
     LocalShapesFinder& m_finder;
-    QStringList m_sortedShapes;
+    QCollator m_collator;
+    // The columns
+    QVector<QString> m_keys;
+    QVector<ShapeInfo> m_infos;
+    QVector<QString> m_svgPaths;
+    QVector<QString> m_gcodePaths;
+    QVector<qint64> m_creationTimes; // milliseconds since epoch
+    std::vector<QCollatorSortKey> m_nameSortKeys; // QCollatorSortKey has no default constructor
+    QVector<int> m_freeSlots;
+    QHash<QString, int> m_slots;
+    // The slot of each row, in order
+    std::vector<int> m_rows;
     SortCriterion m_curSortCriterion;
 };
 
@@ -3,8 +3,16 @@
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQuickStyle>
+#include <QStandardPaths>
 #include <iostream>
 #include "controller.h"
+#include "thumbnailprovider.h"
+#include "core/tracerecorder.h"
+
+namespace {
+    // Size of the in-memory cache of thumbnails
+    constexpr int thumbnailsMemoryCacheKb = 64 * 1024;
+}
 
 int main(int argc, char *argv[])
 {
@@ -15,6 +23,11 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationVersion("1.0.0");
 
     QGuiApplication app(argc, argv);
+
+    // Tracing can be enabled from the terminal view, set SHACO_TRACE to also trace the start
+    if (qEnvironmentVariableIsSet("SHACO_TRACE")) {
+        TraceRecorder::global().setEnabled(true);
+    }
 #ifdef Q_OS_MACOS
     app.setWindowIcon(QIcon(":/images/ShaCo.icns"));
 #else
@@ -25,6 +38,10 @@ int main(int argc, char *argv[])
     QQuickStyle::setStyle("Fusion");
 
     QQmlApplicationEngine engine;
+    // The engine takes ownership of the provider
+    engine.addImageProvider("thumbnail", new ThumbnailProvider(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails",
+        thumbnailsMemoryCacheKb));
 
     Controller controller;
     engine.rootContext()->setContextProperty("controller", &controller);
@@ -0,0 +1,111 @@
+#include "metricsmodel.h"
+
+namespace {
+    QString formatHistogram(const HistogramSnapshot& h)
+    {
+        if (h.count == 0) {
+            return "no values";
+        }
+
+        return QString("count %1, mean %2, p50 %3, p99 %4, max %5")
+            .arg(h.count)
+            .arg(h.mean(), 0, 'f', 1)
+            .arg(h.percentile(0.5))
+            .arg(h.percentile(0.99))
+            .arg(h.max);
+    }
+}
+
+MetricsModel::MetricsModel(MetricsRegistry& registry, int refreshIntervalMillis)
+    : m_registry(registry)
+{
+    m_refreshTimer.setInterval(refreshIntervalMillis);
+    m_refreshTimer.setSingleShot(false);
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &MetricsModel::refresh);
+}
+
+int MetricsModel::rowCount(const QModelIndex &) const
+{
+    return m_rows.size();
+}
+
+QVariant MetricsModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const auto& row = m_rows[index.row()];
+
+    switch (role) {
+        case name:  return row.name;
+        case value: return row.value;
+        default:    return QVariant();
+    }
+}
+
+QHash<int, QByteArray> MetricsModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+
+    roles[name] = "name";
+    roles[value] = "value";
+
+    return roles;
+}
+
+bool MetricsModel::active() const
+{
+    return m_refreshTimer.isActive();
+}
+
+void MetricsModel::setActive(bool active)
+{
+    if (active == this->active()) {
+        return;
+    }
+
+    if (active) {
+        refresh();
+        m_refreshTimer.start();
+    } else {
+        m_refreshTimer.stop();
+    }
+}
+
+void MetricsModel::refresh()
+{
+    const auto snapshot = m_registry.snapshot();
+    const auto elapsedSeconds = (m_lastSnapshot.timestampMs == 0) ? 0.0 :
+            static_cast<double>(snapshot.timestampMs - m_lastSnapshot.timestampMs) / 1000.0;
+
+    QVector<Row> rows;
+    for (auto it = snapshot.counters.cbegin(); it != snapshot.counters.cend(); ++it) {
+        auto text = QString::number(it.value());
+        if (elapsedSeconds > 0.0 && m_lastSnapshot.counters.contains(it.key())) {
+            const auto rate = static_cast<double>(it.value() - m_lastSnapshot.counters[it.key()]) / elapsedSeconds;
+            text += QString(" (%1/s)").arg(rate, 0, 'f', 1);
+        }
+        rows.append(Row{it.key(), text});
+    }
+    for (auto it = snapshot.gauges.cbegin(); it != snapshot.gauges.cend(); ++it) {
+        rows.append(Row{it.key(), QString::number(it.value())});
+    }
+    for (auto it = snapshot.histograms.cbegin(); it != snapshot.histograms.cend(); ++it) {
+        rows.append(Row{it.key(), formatHistogram(it.value())});
+    }
+    m_lastSnapshot = snapshot;
+
+    // Metrics are never removed, so if the number of rows is the same, names are the same
+    if (rows.size() == m_rows.size()) {
+        m_rows = rows;
+        if (!m_rows.isEmpty()) {
+            emit dataChanged(index(0), index(m_rows.size() - 1), QVector<int>{value});
+        }
+    } else {
+        beginResetModel();
+        m_rows = rows;
+        endResetModel();
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef METRICSMODEL_H
+#define METRICSMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "core/metrics.h"
+
+// The model of the diagnostics view: one row per metric, with its value formatted as text. Rates
+// of counters are computed between two refreshes. Snapshots are only taken while the model is
+// active
+class MetricsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+private:
+    enum Roles {
+        name = Qt::UserRole,
+        value
+    };
+
+    struct Row {
+        QString name;
+        QString value;
+    };
+
+public:
+    explicit MetricsModel(MetricsRegistry& registry, int refreshIntervalMillis);
+
+    MetricsModel(MetricsModel&) = delete;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool active() const;
+    void setActive(bool active);
+
+private slots:
+    void refresh();
+
+private:
+    MetricsRegistry& m_registry;
+    QTimer m_refreshTimer;
+    QVector<Row> m_rows;
+    MetricsSnapshot m_lastSnapshot;
+};
+
+#endif // METRICSMODEL_H
@@ -1,4 +1,5 @@
 #include "settings.h"
+#include <QStringList>
 
 namespace {
     const char* characterSendDelayUs_pname = "characterSendDelayUs";
@@ -6,6 +7,19 @@ namespace {
 
     const char* wireTemperature_pname = "wireTemperature";
     constexpr float wireTemperature_default = 30.0f;
+
+    const char* slowAckThresholdMs_pname = "slowAckThresholdMs";
+    constexpr unsigned long slowAckThresholdMs_default = 2000;
+
+    const char* nativeSerialPort_pname = "nativeSerialPort";
+    constexpr bool nativeSerialPort_default = false;
+
+    // Stored as a comma-separated list
+    const char* baudRates_pname = "baudRates";
+    constexpr qint32 baudRates_default = 115200;
+
+    // One value per machine, the key is followed by the serial number
+    const char* machineBaudRates_group = "machineBaudRates";
 }
 
 Settings::Settings()
@@ -37,3 +51,73 @@ void Settings::setWireTemperature(float t)
 {
     m_settings.setValue(wireTemperature_pname, t);
 }
+
+unsigned long Settings::slowAckThresholdMs() const
+{
+    bool ok;
+    const auto v = m_settings.value(slowAckThresholdMs_pname).toUInt(&ok);
+
+    return ok ? v : slowAckThresholdMs_default;
+}
+
+void Settings::setSlowAckThresholdMs(unsigned long ms)
+{
+    m_settings.setValue(slowAckThresholdMs_pname, QVariant(static_cast<qulonglong>(ms)));
+}
+
+bool Settings::nativeSerialPort() const
+{
+    return m_settings.value(nativeSerialPort_pname, nativeSerialPort_default).toBool();
+}
+
+void Settings::setNativeSerialPort(bool native)
+{
+    m_settings.setValue(nativeSerialPort_pname, native);
+}
+
+QList<qint32> Settings::baudRates() const
+{
+    QList<qint32> rates;
+    const auto values = m_settings.value(baudRates_pname).toString().split(',', QString::SkipEmptyParts);
+    for (const auto& v: values) {
+        bool ok;
+        const auto rate = v.trimmed().toInt(&ok);
+        if (ok && rate > 0) {
+            rates.append(rate);
+        }
+    }
+
+    return rates.isEmpty() ? QList<qint32>{baudRates_default} : rates;
+}
+
+void Settings::setBaudRates(const QList<qint32>& baudRates)
+{
+    QStringList values;
+    for (auto rate: baudRates) {
+        values.append(QString::number(rate));
+    }
+
+    m_settings.setValue(baudRates_pname, values.join(','));
+}
+
+void Settings::setMachineBaudRate(const QString& serialNumber, qint32 baudRate)
+{
+    m_settings.setValue(QString(machineBaudRates_group) + "/" + serialNumber, baudRate);
+}
+
+QList<qint32> Settings::machineBaudRates() const
+{
+    QList<qint32> rates;
+    const auto prefix = QString(machineBaudRates_group) + "/";
+    for (const auto& key: m_settings.allKeys()) {
+        if (key.startsWith(prefix)) {
+            bool ok;
+            const auto rate = m_settings.value(key).toInt(&ok);
+            if (ok && rate > 0 && !rates.contains(rate)) {
+                rates.append(rate);
+            }
+        }
+    }
+
+    return rates;
+}
@@ -1,7 +1,9 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include <QList>
 #include <QSettings>
+#include <QString>
 
 class Settings {
 public:
@@ -13,6 +15,26 @@ public:
     float wireTemperature() const;
     void setWireTemperature(float t);
 
+    // Replies to G-code lines taking longer than this are reported in the terminal. 0 disables
+    // the check
+    unsigned long slowAckThresholdMs() const;
+    void setSlowAckThresholdMs(unsigned long ms);
+
+    // Whether serial ports are accessed with NativeSerialPort instead of QSerialPort. Ignored if
+    // not on Linux
+    bool nativeSerialPort() const;
+    void setNativeSerialPort(bool native);
+
+    // The baud rates to try when searching for the machine, the fastest first. Machines must
+    // support 115200, higher rates are only used if the firmware answers at that rate
+    QList<qint32> baudRates() const;
+    void setBaudRates(const QList<qint32>& baudRates);
+
+    // Stores the baud rate a machine answered at the last time it was found
+    void setMachineBaudRate(const QString& serialNumber, qint32 baudRate);
+    // The baud rates of all known machines
+    QList<qint32> machineBaudRates() const;
+
 private:
     QSettings m_settings;
 };
@@ -0,0 +1,99 @@
+#include "shapesfiltermodel.h"
+
+ShapesFilterModel::ShapesFilterModel(LocalShapesFinder& finder, LocalShapesModel& model)
+    : QSortFilterProxyModel()
+    , m_finder(finder)
+    , m_model(model)
+{
+    for (auto it = m_finder.shapes().cbegin(); it != m_finder.shapes().cend(); ++it) {
+        m_index.insert(it.key(), it.value());
+    }
+    m_accepted = m_index.search(m_query);
+
+    // The index must be updated before rows are inserted in the source model, because
+    // filterAcceptsRow is called when that happens
+    connect(&m_model, &LocalShapesModel::shapesAboutToBeUpdated, this, &ShapesFilterModel::shapesAboutToBeUpdated);
+
+    setSourceModel(&m_model);
+}
+
+void ShapesFilterModel::setSearchText(QString text)
+{
+    if (text == m_query.text) {
+        return;
+    }
+
+    m_query.text = text;
+    updateFilter();
+}
+
+void ShapesFilterModel::setMachineType(QString machineType)
+{
+    m_query.machineType = machineType;
+    updateFilter();
+}
+
+void ShapesFilterModel::setSquareFilter(QString square)
+{
+    if (square == "square") {
+        m_query.square = ShapeSearchIndex::SquareFilter::Square;
+    } else if (square == "notSquare") {
+        m_query.square = ShapeSearchIndex::SquareFilter::NotSquare;
+    } else {
+        m_query.square = ShapeSearchIndex::SquareFilter::Any;
+    }
+
+    updateFilter();
+}
+
+void ShapesFilterModel::setWorkpieceDimXRange(double min, double max)
+{
+    m_query.workpieceDimX = ShapeSearchIndex::Range{min, max};
+    updateFilter();
+}
+
+void ShapesFilterModel::setWorkpieceDimYRange(double min, double max)
+{
+    m_query.workpieceDimY = ShapeSearchIndex::Range{min, max};
+    updateFilter();
+}
+
+void ShapesFilterModel::setDurationRange(double min, double max)
+{
+    m_query.duration = ShapeSearchIndex::Range{min, max};
+    updateFilter();
+}
+
+bool ShapesFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex&) const
+{
+    const auto id = m_index.id(m_model.shapeKey(sourceRow));
+
+    return id >= 0 && static_cast<std::size_t>(id) < m_accepted.size() && m_accepted[static_cast<std::size_t>(id)];
+}
+
+void ShapesFilterModel::shapesAboutToBeUpdated(QSet<QString> newShapes, QSet<QString> removedShapes)
+{
+    // Removing first because a shape can be both in removedShapes and in newShapes if it changed
+    for (const auto& key: removedShapes) {
+        m_index.remove(key);
+    }
+
+    for (const auto& key: newShapes) {
+        const auto it = m_finder.shapes().constFind(key);
+        if (it == m_finder.shapes().cend()) {
+            continue;
+        }
+
+        const auto id = static_cast<std::size_t>(m_index.insert(key, it.value()));
+        if (id >= m_accepted.size()) {
+            m_accepted.resize(id + 1, false);
+        }
+        m_accepted[id] = m_index.matches(static_cast<int>(id), m_query);
+    }
+}
+
+void ShapesFilterModel::updateFilter()
+{
+    m_accepted = m_index.search(m_query);
+    invalidateFilter();
+}
@@ -0,0 +1,50 @@
+#ifndef SHAPESFILTERMODEL_H
+#define SHAPESFILTERMODEL_H
+
+#include <vector>
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QString>
+#include "localshapesmodel.h"
+#include "core/localshapesfinder.h"
+#include "core/shapesearchindex.h"
+
+// A proxy model to search shapes by name and filter them by their properties. The result of the
+// current query is kept as a flag for each shape in a ShapeSearchIndex, which is updated
+// incrementally when shapes change
+class ShapesFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    ShapesFilterModel(LocalShapesFinder& finder, LocalShapesModel& model);
+
+    ShapesFilterModel(ShapesFilterModel&) = delete;
+
+public slots:
+    void setSearchText(QString text);
+    // An empty string means any machine type
+    void setMachineType(QString machineType);
+    // One of "any", "square" or "notSquare"
+    void setSquareFilter(QString square);
+    void setWorkpieceDimXRange(double min, double max);
+    void setWorkpieceDimYRange(double min, double max);
+    void setDurationRange(double min, double max);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private slots:
+    void shapesAboutToBeUpdated(QSet<QString> newShapes, QSet<QString> removedShapes);
+
+private:
+    void updateFilter();
+
+    LocalShapesFinder& m_finder;
+    LocalShapesModel& m_model;
+    ShapeSearchIndex m_index;
+    ShapeSearchIndex::Query m_query;
+    std::vector<bool> m_accepted; // Indexed by the id of shapes in m_index
+};
+
+#endif // SHAPESFILTERMODEL_H
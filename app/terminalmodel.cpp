@@ -0,0 +1,161 @@
+#include "terminalmodel.h"
+
+namespace {
+    QString lineToString(const TerminalLog::Line& line)
+    {
+        QString s;
+
+        switch (line.direction) {
+            case TerminalLog::Direction::Sent:      s = QStringLiteral("▶"); break;
+            case TerminalLog::Direction::Received:  s = QStringLiteral("◀"); break;
+            case TerminalLog::Direction::Info:      break;
+        }
+
+        // Immediate commands are not printable, show their code
+        for (const char c: line.text) {
+            const auto u = static_cast<unsigned char>(c);
+            if (u < 0x20 || u > 0x7E) {
+                s += QString("\\x%1").arg(u, 2, 16, QChar('0'));
+            } else {
+                s += QChar(c);
+            }
+        }
+
+        return s;
+    }
+
+    QString directionToString(TerminalLog::Direction d)
+    {
+        switch (d) {
+            case TerminalLog::Direction::Sent:      return "sent";
+            case TerminalLog::Direction::Received:  return "received";
+            case TerminalLog::Direction::Info:      return "info";
+        }
+
+        // To prevent compiler warnings
+        return "info";
+    }
+}
+
+TerminalModel::TerminalModel(int capacity, int updateIntervalMillis)
+    : m_log(capacity)
+    , m_enabled(false)
+{
+    m_updateTimer.setInterval(updateIntervalMillis);
+    m_updateTimer.setSingleShot(true);
+
+    connect(&m_updateTimer, &QTimer::timeout, this, &TerminalModel::updateView);
+}
+
+int TerminalModel::rowCount(const QModelIndex &) const
+{
+    return m_log.size();
+}
+
+QVariant TerminalModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_log.size()) {
+        return QVariant();
+    }
+
+    const auto& line = m_log.line(index.row());
+
+    switch (role) {
+        case text:      return lineToString(line);
+        case direction: return directionToString(line.direction);
+        default:        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> TerminalModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+
+    roles[text] = "text";
+    roles[direction] = "direction";
+
+    return roles;
+}
+
+bool TerminalModel::enabled() const
+{
+    return m_enabled;
+}
+
+void TerminalModel::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool TerminalModel::filterStatusPolling() const
+{
+    return m_log.filterStatusPolling();
+}
+
+void TerminalModel::setFilterStatusPolling(bool filter)
+{
+    m_log.setFilterStatusPolling(filter);
+}
+
+void TerminalModel::trafficAvailable(TrafficTap::Batch batch)
+{
+    // We might receive a batch that was sent just before disabling
+    if (!m_enabled) {
+        return;
+    }
+
+    for (const auto& chunk: batch) {
+        if (chunk.direction == TrafficTap::Direction::Sent) {
+            m_log.appendSent(chunk.data);
+        } else {
+            m_log.appendReceived(chunk.data);
+        }
+    }
+
+    scheduleUpdate();
+}
+
+void TerminalModel::appendSeparator()
+{
+    if (m_enabled) {
+        m_log.appendInfo("--------");
+        scheduleUpdate();
+    }
+}
+
+void TerminalModel::appendInfo(QString text)
+{
+    if (m_enabled) {
+        m_log.appendInfo(text.toUtf8());
+        scheduleUpdate();
+    }
+}
+
+void TerminalModel::updateView()
+{
+    const auto lines = m_log.takeCompletedLines();
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    const auto toDiscard = m_log.linesToDiscard(lines.size());
+    if (toDiscard > 0) {
+        beginRemoveRows(QModelIndex(), 0, toDiscard - 1);
+        m_log.discardOldestLines(toDiscard);
+        endRemoveRows();
+    }
+
+    const auto firstNewRow = m_log.size();
+    beginInsertRows(QModelIndex(), firstNewRow, firstNewRow + lines.size() - 1);
+    m_log.commitLines(lines);
+    endInsertRows();
+}
+
+void TerminalModel::scheduleUpdate()
+{
+    // Not restarting the timer if active, so that the view is updated at regular intervals even if
+    // data arrives continuously
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
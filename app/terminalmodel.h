@@ -0,0 +1,51 @@
+#ifndef TERMINALMODEL_H
+#define TERMINALMODEL_H
+
+#include <QAbstractListModel>
+#include <QTimer>
+#include "core/terminallog.h"
+#include "core/traffictap.h"
+
+// The model of the terminal. Data is accumulated and the view is updated at most once per frame
+class TerminalModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+private:
+    enum Roles {
+        text = Qt::UserRole,
+        direction
+    };
+
+public:
+    explicit TerminalModel(int capacity, int updateIntervalMillis);
+
+    TerminalModel(TerminalModel&) = delete;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    bool filterStatusPolling() const;
+    void setFilterStatusPolling(bool filter);
+
+public slots:
+    void trafficAvailable(TrafficTap::Batch batch);
+    void appendSeparator();
+    // Adds a line of information that is not part of the traffic with the machine
+    void appendInfo(QString text);
+
+private slots:
+    void updateView();
+
+private:
+    void scheduleUpdate();
+
+    TerminalLog m_log;
+    QTimer m_updateTimer;
+    bool m_enabled;
+};
+
+#endif // TERMINALMODEL_H
@@ -0,0 +1,201 @@
+#include "thumbnailprovider.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QSaveFile>
+#include <QSvgRenderer>
+#include <QUrl>
+
+namespace {
+    // Used if the view does not set sourceSize
+    const QSize defaultThumbnailSize(256, 256);
+}
+
+ThumbnailRunnable::ThumbnailRunnable(ThumbnailProvider& provider, QString svgFilename, QString svgHash, QSize size, std::shared_ptr<std::atomic<bool>> canceled)
+    : QObject()
+    , QRunnable()
+    , m_provider(provider)
+    , m_svgFilename(svgFilename)
+    , m_svgHash(svgHash)
+    , m_size(size)
+    , m_canceled(canceled)
+{
+}
+
+void ThumbnailRunnable::run()
+{
+    QImage image;
+    QString errorString;
+    if (!*m_canceled) {
+        image = m_provider.createThumbnail(m_svgFilename, m_svgHash, m_size, errorString);
+    }
+
+    // If the response has already been deleted the signal is not delivered
+    emit done(image, errorString);
+}
+
+ThumbnailResponse::ThumbnailResponse(ThumbnailProvider& provider, QString svgFilename, QString svgHash, QSize size)
+    : QQuickImageResponse()
+    , m_canceled(std::make_shared<std::atomic<bool>>(false))
+{
+    auto runnable = new ThumbnailRunnable(provider, svgFilename, svgHash, size, m_canceled);
+    connect(runnable, &ThumbnailRunnable::done, this, &ThumbnailResponse::thumbnailDone, Qt::QueuedConnection);
+    provider.m_pool.start(runnable);
+}
+
+ThumbnailResponse::ThumbnailResponse(QImage image)
+    : QQuickImageResponse()
+    , m_canceled(std::make_shared<std::atomic<bool>>(false))
+    , m_image(image)
+{
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+}
+
+QQuickTextureFactory* ThumbnailResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString ThumbnailResponse::errorString() const
+{
+    return m_errorString;
+}
+
+void ThumbnailResponse::cancel()
+{
+    *m_canceled = true;
+}
+
+void ThumbnailResponse::thumbnailDone(QImage image, QString errorString)
+{
+    m_image = image;
+    m_errorString = errorString;
+
+    emit finished();
+}
+
+ThumbnailProvider::ThumbnailProvider(QString cacheDir, int memoryCacheKb)
+    : QQuickAsyncImageProvider()
+    , m_cacheDir(cacheDir)
+    , m_memoryCache(memoryCacheKb)
+{
+    QDir::root().mkpath(m_cacheDir);
+}
+
+ThumbnailProvider::~ThumbnailProvider()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse* ThumbnailProvider::requestImageResponse(const QString& id, const QSize& requestedSize)
+{
+    // The path is percent-encoded, so the first / separates the hash
+    const auto separator = id.indexOf('/');
+    const auto svgHash = (separator < 0) ? QString() : id.left(separator);
+    const auto svgFilename = QUrl::fromPercentEncoding(id.mid(separator + 1).toUtf8());
+    const auto size = requestedSize.isValid() && !requestedSize.isEmpty() ? requestedSize : defaultThumbnailSize;
+
+    // Thumbnails in memory are returned immediately, the rest is done in the pool
+    const auto image = cachedImage(cacheKey(svgFilename, svgHash, size));
+    if (!image.isNull()) {
+        return new ThumbnailResponse(image);
+    }
+
+    return new ThumbnailResponse(*this, svgFilename, svgHash, size);
+}
+
+QString ThumbnailProvider::cacheKey(const QString& svgFilename, const QString& svgHash, const QSize& size)
+{
+    if (!svgHash.isEmpty()) {
+        return QString("svg:%1\n%2x%3").arg(svgHash).arg(size.width()).arg(size.height());
+    }
+
+    const QFileInfo info(svgFilename);
+    if (!info.exists()) {
+        return QString();
+    }
+
+    return QString("%1\n%2\n%3\n%4x%5").arg(info.absoluteFilePath())
+                                       .arg(info.lastModified().toMSecsSinceEpoch())
+                                       .arg(info.size())
+                                       .arg(size.width())
+                                       .arg(size.height());
+}
+
+QString ThumbnailProvider::diskCacheFilename(const QString& key) const
+{
+    const auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+    return m_cacheDir + "/" + QString::fromLatin1(hash) + ".png";
+}
+
+QImage ThumbnailProvider::cachedImage(const QString& key)
+{
+    if (key.isEmpty()) {
+        return QImage();
+    }
+
+    QMutexLocker locker(&m_cacheMutex);
+
+    const auto image = m_memoryCache.object(key);
+
+    return (image == nullptr) ? QImage() : *image;
+}
+
+void ThumbnailProvider::cacheImage(const QString& key, const QImage& image)
+{
+    QMutexLocker locker(&m_cacheMutex);
+
+    // The cost is in Kb
+    m_memoryCache.insert(key, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+}
+
+QImage ThumbnailProvider::createThumbnail(const QString& svgFilename, const QString& svgHash, const QSize& size, QString& errorString)
+{
+    const auto key = cacheKey(svgFilename, svgHash, size);
+    if (key.isEmpty()) {
+        errorString = "File " + svgFilename + " does not exist";
+        return QImage();
+    }
+
+    // The same thumbnail could have been requested more than once
+    auto image = cachedImage(key);
+    if (!image.isNull()) {
+        return image;
+    }
+
+    const auto diskFilename = diskCacheFilename(key);
+    if (image.load(diskFilename, "PNG")) {
+        cacheImage(key, image);
+        return image;
+    }
+
+    QSvgRenderer renderer(svgFilename);
+    if (!renderer.isValid()) {
+        errorString = "Invalid svg file " + svgFilename;
+        return QImage();
+    }
+
+    // Rendering preserving the aspect ratio, centered in the image
+    const auto svgSize = renderer.defaultSize().scaled(size, Qt::KeepAspectRatio);
+    image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    renderer.render(&painter, QRectF(QPointF((size.width() - svgSize.width()) / 2.0, (size.height() - svgSize.height()) / 2.0), svgSize));
+    painter.end();
+
+    // Replacing the file atomically, in case more instances write the same thumbnail
+    QSaveFile file(diskFilename);
+    if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG")) {
+        file.commit();
+    }
+
+    cacheImage(key, image);
+
+    return image;
+}
@@ -0,0 +1,100 @@
+#ifndef THUMBNAILPROVIDER_H
+#define THUMBNAILPROVIDER_H
+
+#include <atomic>
+#include <memory>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QQuickAsyncImageProvider>
+#include <QQuickImageResponse>
+#include <QRunnable>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+class ThumbnailProvider;
+
+// The job rasterizing a thumbnail in the thread pool of ThumbnailProvider. It is deleted by the
+// pool and only shares the canceled flag with the response, which can be deleted by the view
+// before the job runs. The image is delivered through the done signal, which is queued
+class ThumbnailRunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    ThumbnailRunnable(ThumbnailProvider& provider, QString svgFilename, QString svgHash, QSize size, std::shared_ptr<std::atomic<bool>> canceled);
+
+    void run() override;
+
+signals:
+    void done(QImage image, QString errorString);
+
+private:
+    ThumbnailProvider& m_provider;
+    const QString m_svgFilename;
+    const QString m_svgHash;
+    const QSize m_size;
+    const std::shared_ptr<std::atomic<bool>> m_canceled;
+};
+
+// The response to a thumbnail request
+class ThumbnailResponse : public QQuickImageResponse
+{
+    Q_OBJECT
+
+public:
+    // Starts a ThumbnailRunnable in the pool of provider
+    ThumbnailResponse(ThumbnailProvider& provider, QString svgFilename, QString svgHash, QSize size);
+
+    // Use this if the image is already available, finished is emitted asynchronously
+    ThumbnailResponse(QImage image);
+
+    QQuickTextureFactory* textureFactory() const override;
+    QString errorString() const override;
+    void cancel() override;
+
+private slots:
+    void thumbnailDone(QImage image, QString errorString);
+
+private:
+    const std::shared_ptr<std::atomic<bool>> m_canceled;
+    QImage m_image;
+    QString m_errorString;
+};
+
+// Provides thumbnails of svg files. Use image://thumbnail/<svg hash>/<percent-encoded svg path>,
+// thumbnails are rendered at the requested size (sourceSize in QML). Thumbnails are rasterized
+// once in a thread pool and stored both in an in-memory LRU cache and in an on-disk cache, keyed
+// by thumbnail size and by the hash of the content of the svg file (ShapeInfo::svgHash() in hex),
+// so that copies of a file share the thumbnail. The hash can be empty: in that case the key is
+// the path, modification time and size of the svg file
+class ThumbnailProvider : public QQuickAsyncImageProvider
+{
+public:
+    // memoryCacheKb is the maximum size of the in-memory cache
+    ThumbnailProvider(QString cacheDir, int memoryCacheKb);
+    ~ThumbnailProvider() override;
+
+    QQuickImageResponse* requestImageResponse(const QString& id, const QSize& requestedSize) override;
+
+private:
+    friend class ThumbnailResponse;
+    friend class ThumbnailRunnable;
+
+    // Returns an empty string if the svg file does not exist
+    static QString cacheKey(const QString& svgFilename, const QString& svgHash, const QSize& size);
+    QString diskCacheFilename(const QString& key) const;
+    // These are thread safe
+    QImage cachedImage(const QString& key);
+    void cacheImage(const QString& key, const QImage& image);
+    QImage createThumbnail(const QString& svgFilename, const QString& svgHash, const QSize& size, QString& errorString);
+
+    const QString m_cacheDir;
+    QMutex m_cacheMutex;
+    QCache<QString, QImage> m_memoryCache;
+    QThreadPool m_pool;
+};
+
+#endif // THUMBNAILPROVIDER_H
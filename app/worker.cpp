@@ -1,38 +1,107 @@
 #include "worker.h"
+#include <algorithm>
+#include <functional>
+#include <QBuffer>
 #include <QFile>
-#include <QMetaObject>
-#include "controller.h"
+#include <QFileInfo>
+#include <QtDebug>
+#include "core/gcodevalidator.h"
+#ifdef Q_OS_LINUX
+#include "core/nativeserialport.h"
+#endif
 
-WorkerThread::WorkerThread(Controller *controller)
-    : m_controller(controller)
-{
+namespace {
+    // Updates of the job server feed are coalesced, this is the maximum rate of status reports
+    constexpr int jobServerFeedIntervalMillis = 50;
 
-}
+    // name is either a port name (e.g. ttyUSB0) or the path of the device
+    std::unique_ptr<SerialPortInterface> createSerialPort(QString name, bool nativeSerialPort)
+    {
+#ifdef Q_OS_LINUX
+        if (nativeSerialPort) {
+            return std::make_unique<NativeSerialPort>(QFileInfo(name).isAbsolute() ? name : "/dev/" + name);
+        }
+#else
+        Q_UNUSED(nativeSerialPort)
+#endif
 
-Worker* WorkerThread::worker() const
-{
-    return m_worker.get();
-}
+        return std::make_unique<SerialPort>(name);
+    }
 
-void WorkerThread::run()
-{
-    m_worker.reset(new Worker());
+    std::unique_ptr<PortDiscovery<QSerialPortInfo>> createPortDiscovery(QString portName, unsigned long characterSendDelayUs, bool nativeSerialPort)
+    {
+        if (portName.isEmpty()) {
+            return std::make_unique<PortDiscovery<QSerialPortInfo>>(
+                QSerialPortInfo::availablePorts,
+                [nativeSerialPort](QSerialPortInfo p) -> std::unique_ptr<SerialPortInterface> {
+                    if (nativeSerialPort) {
+                        return createSerialPort(p.systemLocation(), true);
+                    }
+                    return std::make_unique<SerialPort>(p);
+                },
+                1000, 300, 5, characterSendDelayUs);
+        }
+
+        // The port might not be listed by QSerialPortInfo (e.g. a pseudo terminal), so it is
+        // opened by name
+        return std::make_unique<PortDiscovery<QSerialPortInfo>>(
+            [](){ return QList<QSerialPortInfo>{QSerialPortInfo()}; },
+            [portName, nativeSerialPort](QSerialPortInfo){ return createSerialPort(portName, nativeSerialPort); },
+            1000, 300, 5, characterSendDelayUs, false);
+    }
+
+    // Only problems that would make streaming fail are checked, the workpiece is not known here.
+    // Returns the description of the problem, empty if the G-code can be streamed
+    QString gcodeProblem(const GCodeCheck& check)
+    {
+        if (check.verdict != GCodeCheck::Verdict::Invalid) {
+            return QString();
+        }
 
-    QMetaObject::invokeMethod(m_controller, [controller = m_controller](){ controller->creationFinished(); });
+        return (check.line == 0) ? check.message : QObject::tr("Invalid G-code at line %1: %2").arg(check.line).arg(check.message);
+    }
 
-    exec();
+    // Rates at which known machines answered come first, so that they are found at the first
+    // attempt, then those in the settings. The fastest are tried first in both groups
+    QList<qint32> baudRatesToTry(const Settings& settings)
+    {
+        auto knownRates = settings.machineBaudRates();
+        auto baudRates = settings.baudRates();
 
-    m_worker.reset();
+        std::sort(knownRates.begin(), knownRates.end(), std::greater<qint32>());
+        std::sort(baudRates.begin(), baudRates.end(), std::greater<qint32>());
+
+        auto rates = knownRates;
+        for (auto rate: baudRates) {
+            if (!rates.contains(rate)) {
+                rates.append(rate);
+            }
+        }
+
+        return rates;
+    }
 }
 
-Worker::Worker()
-    : m_portDiscoverer(new PortDiscovery<QSerialPortInfo>(QSerialPortInfo::availablePorts, [](QSerialPortInfo p){ return std::make_unique<SerialPort>(p); }, 1000, 300, 5, m_settings.characterSendDelayUs()))
+Worker::Worker(QString portName, QList<qint32> baudRates)
+    : Worker(createPortDiscovery(portName, Settings().characterSendDelayUs(), Settings().nativeSerialPort()), baudRates)
+{
+}
+
+Worker::Worker(std::unique_ptr<PortDiscovery<QSerialPortInfo>>&& portDiscoverer, QList<qint32> baudRates)
+    : m_portDiscoverer(std::move(portDiscoverer))
     , m_machineCommunicator(new MachineCommunication(1000))
     , m_commandSender(new CommandSender(m_machineCommunicator.get()))
     , m_wireController(new WireController(m_machineCommunicator.get(), m_commandSender.get()))
     , m_statusMonitor(new MachineStatusMonitor(1000, 3000, m_machineCommunicator.get())) // polling every second
+    , m_trafficTap(new TrafficTap(m_machineCommunicator.get(), 50))
+    , m_jobServer(new JobServer("shaco-jobs", m_machineCommunicator.get(), m_statusMonitor.get(), jobServerFeedIntervalMillis))
+    , m_connected(false)
+    , m_streaming(false)
+    , m_guiSenderReady(false)
 {
     m_wireController->setTemperature(m_settings.wireTemperature());
+    m_commandSender->setSlowAckThresholdUs(static_cast<qint64>(m_settings.slowAckThresholdMs()) * 1000);
+    m_portDiscoverer->setBaudRates(baudRates.isEmpty() ? baudRatesToTry(m_settings) : baudRates);
 
     connect(
         m_portDiscoverer.get(), &PortDiscovery<QSerialPortInfo>::portFound,
@@ -46,6 +115,26 @@ Worker::Worker()
         m_machineCommunicator.get(), &MachineCommunication::portClosed,
         m_portDiscoverer.get(), &PortDiscovery<QSerialPortInfo>::start
     );
+
+    // The next time this machine is found at the first attempt
+    connect(m_portDiscoverer.get(), &PortDiscovery<QSerialPortInfo>::portFound, this, [](MachineInfo* info, AbstractPortDiscovery* discoverer) {
+        Settings().setMachineBaudRate(info->serialNumber(), discoverer->baudRate());
+    });
+    connect(m_machineCommunicator.get(), &MachineCommunication::machineInitialized, this, [this]() {
+        m_connected = true;
+        // The GUI prepares the cut again with the new machine
+        if (m_guiSenderReady) {
+            m_gcodeSender.reset();
+            m_guiSenderReady = false;
+        }
+    });
+    connect(m_machineCommunicator.get(), &MachineCommunication::portClosed, this, [this]() { m_connected = false; });
+    connect(m_machineCommunicator.get(), &MachineCommunication::portClosedWithError, this, [this]() { m_connected = false; });
+    connect(m_jobServer.get(), &JobServer::fileJobSubmitted, this, &Worker::fileJobSubmitted);
+    connect(m_jobServer.get(), &JobServer::streamedJobSubmitted, this, &Worker::streamedJobSubmitted);
+    // Queued because the previous GCodeSender might be listening to the same signal, and it is
+    // deleted when the next job starts
+    connect(m_statusMonitor.get(), &MachineStatusMonitor::stateChanged, this, &Worker::startNextJobIfPossible, Qt::QueuedConnection);
 }
 
 PortDiscovery<QSerialPortInfo>* Worker::portDiscoverer() const
@@ -78,14 +167,48 @@ GCodeSender* Worker::gcodeSender() const
     return m_gcodeSender.get();
 }
 
+TrafficTap* Worker::trafficTap() const
+{
+    return m_trafficTap.get();
+}
+
+JobServer* Worker::jobServer() const
+{
+    return m_jobServer.get();
+}
+
 void Worker::setGCodeFile(QUrl fileUrl)
 {
-    auto file = std::make_unique<QFile>(fileUrl.toLocalFile());
+    // The sender of a cut in progress (of the GUI or of a job) is never replaced
+    if (m_streaming) {
+        emit gcodeRefused(tr("Another cut is in progress"));
+        return;
+    }
 
-    // The old one, if existing, is deleted
-    m_gcodeSender = std::make_unique<GCodeSender>(m_machineCommunicator.get(), m_commandSender.get(), m_wireController.get(), m_statusMonitor.get(), std::move(file));
+    const auto filename = fileUrl.toLocalFile();
+    const auto problem = gcodeProblem(GCodeValidator(0.0, 0.0).validateFile(filename));
+    if (!problem.isEmpty()) {
+        // The previous file must not be streamed in place of this one
+        releaseGCodeFile();
+        emit gcodeRefused(problem);
 
-    emit gcodeSenderCreated(m_gcodeSender.get());
+        return;
+    }
+
+    createGCodeSender(std::make_unique<QFile>(filename));
+    m_guiSenderReady = true;
+}
+
+void Worker::releaseGCodeFile()
+{
+    if (!m_guiSenderReady) {
+        return;
+    }
+
+    m_gcodeSender.reset();
+    m_guiSenderReady = false;
+
+    startNextJobIfPossible();
 }
 
 void Worker::setCharacterSendDelayUs(unsigned long us)
@@ -93,3 +216,87 @@ void Worker::setCharacterSendDelayUs(unsigned long us)
     m_portDiscoverer->setCharacterSendDelayUs(us);
     m_machineCommunicator->setCharacterSendDelayUs(us);
 }
+
+void Worker::startJobServer()
+{
+    if (!m_jobServer->listen()) {
+        qWarning() << "Could not start the job server:" << m_jobServer->errorString();
+    }
+}
+
+void Worker::fileJobSubmitted(JobServer::JobId jobId, QString gcodeFilename)
+{
+    m_jobs.enqueue(Job{jobId, gcodeFilename, QByteArray()});
+
+    startNextJobIfPossible();
+}
+
+void Worker::streamedJobSubmitted(JobServer::JobId jobId, QByteArray gcode)
+{
+    m_jobs.enqueue(Job{jobId, QString(), gcode});
+
+    startNextJobIfPossible();
+}
+
+void Worker::startNextJobIfPossible()
+{
+    if (m_jobs.isEmpty() || !m_connected || m_streaming || m_guiSenderReady || m_statusMonitor->state() != MachineState::Idle) {
+        return;
+    }
+
+    const auto job = m_jobs.dequeue();
+
+    // Jobs are checked when they are about to start, files might have changed in the meantime
+    const GCodeValidator validator(0.0, 0.0);
+    const auto problem = gcodeProblem(job.gcodeFilename.isEmpty() ? validator.validate(job.gcode) : validator.validateFile(job.gcodeFilename));
+    if (!problem.isEmpty()) {
+        m_jobServer->jobEnded(job.id, GCodeSender::StreamEndReason::StreamError, problem);
+        startNextJobIfPossible();
+
+        return;
+    }
+
+    if (job.gcodeFilename.isEmpty()) {
+        auto buffer = std::make_unique<QBuffer>();
+        buffer->setData(job.gcode);
+        createGCodeSender(std::move(buffer));
+    } else {
+        createGCodeSender(std::make_unique<QFile>(job.gcodeFilename));
+    }
+
+    auto sender = m_gcodeSender.get();
+    auto jobServer = m_jobServer.get();
+    const auto jobId = job.id;
+    connect(sender, &GCodeSender::streamingStarted, jobServer, [jobServer, jobId]() { jobServer->jobStarted(jobId); });
+    connect(sender, &GCodeSender::lineAcknowledged, jobServer, [jobServer, jobId](CommandCorrelationId line) {
+        jobServer->jobProgress(jobId, static_cast<quint32>(line));
+    });
+    connect(sender, &GCodeSender::streamingEnded, jobServer, [jobServer, jobId](GCodeSender::StreamEndReason reason, QString description) {
+        jobServer->jobEnded(jobId, reason, description);
+    });
+
+    sender->streamData();
+}
+
+void Worker::createGCodeSender(std::unique_ptr<QIODevice>&& gcodeDevice)
+{
+    // The old one, if existing, is deleted
+    m_gcodeSender = std::make_unique<GCodeSender>(m_machineCommunicator.get(), m_commandSender.get(), m_wireController.get(), m_statusMonitor.get(), std::move(gcodeDevice));
+    m_streaming = false;
+
+    // Jobs are not started while streaming, whoever started it
+    connect(m_gcodeSender.get(), &GCodeSender::streamingStarted, this, [this]() {
+        m_streaming = true;
+        m_guiSenderReady = false;
+        emit streamingStarted();
+    });
+    connect(m_gcodeSender.get(), &GCodeSender::streamingEnded, this, [this](GCodeSender::StreamEndReason reason, QString description) {
+        m_streaming = false;
+        emit streamingEnded(reason, description);
+
+        // Queued because the next job deletes the sender that is emitting this signal
+        QMetaObject::invokeMethod(this, &Worker::startNextJobIfPossible, Qt::QueuedConnection);
+    });
+
+    emit gcodeSenderCreated(m_gcodeSender.get());
+}
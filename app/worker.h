@@ -2,48 +2,34 @@
 #define WORKER_H
 
 #include <memory>
-#include <QThread>
+#include <QByteArray>
+#include <QList>
+#include <QQueue>
 #include <QUrl>
 #include "core/commandsender.h"
 #include "core/gcodesender.h"
+#include "core/jobserver.h"
 #include "core/machinecommunication.h"
 #include "core/machineinfo.h"
 #include "core/machinestatusmonitor.h"
 #include "core/portdiscovery.h"
+#include "core/traffictap.h"
 #include "core/wirecontroller.h"
 #include "settings.h"
 
-class Controller;
-class Worker;
-
-// TODO-TOMMY This is not tested, see comment in controller.h
-// This simply instantiates the worker class and then invokes a method in Controller to signal that
-// object creation has finished
-class WorkerThread : public QThread
-{
-    Q_OBJECT
-public:
-    explicit WorkerThread(Controller* controller);
-
-    // Returns a valid pointer only while running. Call only after the thread has started and not
-    // after thread has been asked to stop
-    Worker* worker() const;
-
-protected:
-    void run() override;
-
-private:
-    Controller* const m_controller;
-    std::unique_ptr<Worker> m_worker;
-};
-
 // This creates all objects that live in the worker thread and exposese their pointers. It lives
-// in the worker thread, so that all its children also live in the same thread
+// in the worker thread, so that all its children also live in the same thread. It does not depend
+// on the GUI, so it is also used by shaco-cli (in the main thread)
 class Worker : public QObject
 {
     Q_OBJECT
 public:
-    explicit Worker();
+    // If portName is not empty, only that port is probed and its vendor and product identifiers
+    // are not checked (e.g. to connect to a simulator on a pseudo terminal). baudRates are tried
+    // in the given order, if empty those in the settings are used
+    explicit Worker(QString portName = QString(), QList<qint32> baudRates = QList<qint32>());
+    // The machine is searched with portDiscoverer (e.g. one with fake ports in tests)
+    Worker(std::unique_ptr<PortDiscovery<QSerialPortInfo>>&& portDiscoverer, QList<qint32> baudRates);
 
     PortDiscovery<QSerialPortInfo>* portDiscoverer() const;
     MachineCommunication* machineCommunicator() const;
@@ -51,22 +37,57 @@ public:
     WireController* wireController() const;
     MachineStatusMonitor* statusMonitor() const;
     GCodeSender* gcodeSender() const;
+    TrafficTap* trafficTap() const;
+    JobServer* jobServer() const;
 
 public slots:
+    // Files that would make streaming fail (see GCodeValidator) are refused, gcodeRefused() is
+    // emitted instead of gcodeSenderCreated(). The file is refused while streaming too. The sender
+    // belongs to the GUI until it streams or releaseGCodeFile() is called, jobs wait meanwhile
     void setGCodeFile(QUrl fileUrl);
+    // Deletes the sender created by setGCodeFile() if it has not been started
+    void releaseGCodeFile();
     void setCharacterSendDelayUs(unsigned long us);
+    // Starts accepting jobs from other programs (see JobServer). Jobs are streamed one after the
+    // other, when the machine is connected and idle
+    void startJobServer();
 
 signals:
     void gcodeSenderCreated(GCodeSender* sender);
+    void gcodeRefused(QString description);
+    // Forwarded from the current GCodeSender. Connect here instead of connecting to each sender,
+    // jobs (see startJobServer()) start streaming right after the sender is created
+    void streamingStarted();
+    // Class name needed because type registered with namespace
+    void streamingEnded(GCodeSender::StreamEndReason reason, QString description);
+
+private slots:
+    void fileJobSubmitted(JobServer::JobId jobId, QString gcodeFilename);
+    void streamedJobSubmitted(JobServer::JobId jobId, QByteArray gcode);
+    void startNextJobIfPossible();
 
 private:
+    struct Job {
+        JobServer::JobId id;
+        QString gcodeFilename; // Empty for streamed jobs
+        QByteArray gcode;
+    };
+
+    void createGCodeSender(std::unique_ptr<QIODevice>&& gcodeDevice);
+
     const Settings m_settings; // We only read settings at start, here
     std::unique_ptr<PortDiscovery<QSerialPortInfo>> m_portDiscoverer;
     std::unique_ptr<MachineCommunication> m_machineCommunicator;
     std::unique_ptr<CommandSender> m_commandSender;
     std::unique_ptr<WireController> m_wireController;
     std::unique_ptr<MachineStatusMonitor> m_statusMonitor;
+    std::unique_ptr<TrafficTap> m_trafficTap;
+    std::unique_ptr<JobServer> m_jobServer;
     std::unique_ptr<GCodeSender> m_gcodeSender;
+    bool m_connected; // A machine has been found and its port is open
+    bool m_streaming; // m_gcodeSender is streaming
+    bool m_guiSenderReady; // m_gcodeSender was created by setGCodeFile() and has not started yet
+    QQueue<Job> m_jobs;
 };
 
 #endif // WORKER_H
@@ -0,0 +1,26 @@
+#include "workerthread.h"
+#include <QMetaObject>
+#include "controller.h"
+
+WorkerThread::WorkerThread(Controller *controller)
+    : m_controller(controller)
+{
+    // The name is used in traces
+    setObjectName("Worker");
+}
+
+Worker* WorkerThread::worker() const
+{
+    return m_worker.get();
+}
+
+void WorkerThread::run()
+{
+    m_worker.reset(new Worker());
+
+    QMetaObject::invokeMethod(m_controller, [controller = m_controller](){ controller->creationFinished(); });
+
+    exec();
+
+    m_worker.reset();
+}
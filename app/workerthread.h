@@ -0,0 +1,30 @@
+#ifndef WORKERTHREAD_H
+#define WORKERTHREAD_H
+
+#include <memory>
+#include <QThread>
+#include "worker.h"
+
+class Controller;
+
+// This simply instantiates the worker class and then invokes a method in Controller to signal that
+// object creation has finished
+class WorkerThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit WorkerThread(Controller* controller);
+
+    // Returns a valid pointer only while running. Call only after the thread has started and not
+    // after thread has been asked to stop
+    Worker* worker() const;
+
+protected:
+    void run() override;
+
+private:
+    Controller* const m_controller;
+    std::unique_ptr<Worker> m_worker;
+};
+
+#endif // WORKERTHREAD_H
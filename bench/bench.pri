@@ -0,0 +1,19 @@
+# Check the config files exist
+!include(../common.pri) {
+    error("Couldn't find the common.pri file!")
+}
+
+# Benchmarks are not test cases, so they are not run by "make check". Run them by hand, e.g.
+# ./localshapesfinder_bench -o results.xml,xml
+# or run all of them with bench/runbenchmarks.sh
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT += testlib serialport concurrent network
+QT -= gui
+
+# NOTE: These paths are relative to the .pro file including this (which is in a subdirectory)
+INCLUDEPATH += ../.. ..
+unix:LIBS += -L../benchcommon -lbenchcommon -L../../core -lcore
+win32:debug:LIBS += -L../benchcommon/debug -lbenchcommon -L../../core/debug -lcore
+win32:release:LIBS += -L../benchcommon/release -lbenchcommon -L../../core/release -lcore
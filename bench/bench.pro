@@ -0,0 +1,30 @@
+TEMPLATE = subdirs
+SUBDIRS = \
+    benchcommon \
+    commandsender \
+    localshapesfinder \
+    localshapesmodel \
+    machinecommunication \
+    machineinfo \
+    machinestate \
+    shapeinfo \
+    shapesearchindex \
+    tracerecorder \
+    traffictap
+
+commandsender.depends = benchcommon
+localshapesfinder.depends = benchcommon
+localshapesmodel.depends = benchcommon
+machinecommunication.depends = benchcommon
+machineinfo.depends = benchcommon
+machinestate.depends = benchcommon
+shapeinfo.depends = benchcommon
+shapesearchindex.depends = benchcommon
+tracerecorder.depends = benchcommon
+traffictap.depends = benchcommon
+
+# NativeSerialPort is only available on Linux
+linux {
+    SUBDIRS += serialport
+    serialport.depends = benchcommon
+}
@@ -0,0 +1,21 @@
+# Check the config files exist
+!include(../../common.pri) {
+    error("Couldn't find the common.pri file!")
+}
+
+TARGET = benchcommon
+TEMPLATE = lib
+CONFIG += staticlib
+QT += serialport
+QT -= gui
+
+INCLUDEPATH += ../..
+
+HEADERS += \
+    benchserialport.h \
+    processmemory.h \
+    shapefiles.h
+SOURCES += \
+    benchserialport.cpp \
+    processmemory.cpp \
+    shapefiles.cpp
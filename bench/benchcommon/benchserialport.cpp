@@ -0,0 +1,88 @@
+#include "benchserialport.h"
+
+namespace {
+    class BenchPortDiscovery : public AbstractPortDiscovery
+    {
+    public:
+        BenchPortDiscovery(SerialPortInterface* serialPort)
+            : m_serialPort(serialPort)
+        {
+        }
+
+        std::unique_ptr<SerialPortInterface> obtainPort() override
+        {
+            return std::move(m_serialPort);
+        }
+
+        void setCharacterSendDelayUs(unsigned long) override
+        {
+        }
+
+        void start() override
+        {
+        }
+
+    private:
+        std::unique_ptr<SerialPortInterface> m_serialPort;
+    };
+}
+
+BenchSerialPort::BenchSerialPort()
+    : SerialPortInterface()
+    , m_readData()
+{
+}
+
+bool BenchSerialPort::open()
+{
+    return true;
+}
+
+qint64 BenchSerialPort::write(const QByteArray& data)
+{
+    return data.size();
+}
+
+QByteArray BenchSerialPort::readAll()
+{
+    QByteArray data;
+    data.swap(m_readData);
+
+    return data;
+}
+
+QString BenchSerialPort::errorString() const
+{
+    return QString();
+}
+
+void BenchSerialPort::close()
+{
+}
+
+void BenchSerialPort::setCharacterSendDelayUs(unsigned long)
+{
+}
+
+unsigned long BenchSerialPort::characterSendDelayUs() const
+{
+    return 0;
+}
+
+void BenchSerialPort::simulateReceivedData(QByteArray data)
+{
+    m_readData = data;
+
+    emit dataAvailable();
+}
+
+std::pair<std::unique_ptr<MachineCommunication>, BenchSerialPort*> createBenchCommunicator()
+{
+    auto serialPort = new BenchSerialPort();
+    BenchPortDiscovery portDiscoverer(serialPort);
+    auto communicator = std::make_unique<MachineCommunication>(100);
+    // Machine information is not used by MachineCommunication
+    communicator->portFound(nullptr, &portDiscoverer);
+
+    return std::make_pair(std::move(communicator), serialPort);
+}
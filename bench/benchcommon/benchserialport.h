@@ -0,0 +1,35 @@
+#ifndef BENCHSERIALPORT_H
+#define BENCHSERIALPORT_H
+
+#include <memory>
+#include <utility>
+#include "core/machinecommunication.h"
+#include "core/portdiscovery.h"
+#include "core/serialport.h"
+
+// A serial port that discards written data and returns the data set with simulateReceivedData().
+// It does as little as possible, so that benchmarks only measure the classes using it
+class BenchSerialPort : public SerialPortInterface
+{
+    Q_OBJECT
+
+public:
+    BenchSerialPort();
+
+    bool open() override;
+    qint64 write(const QByteArray& data) override;
+    QByteArray readAll() override;
+    QString errorString() const override;
+    void close() override;
+    void setCharacterSendDelayUs(unsigned long us) override;
+    unsigned long characterSendDelayUs() const override;
+    void simulateReceivedData(QByteArray data);
+
+private:
+    QByteArray m_readData;
+};
+
+// Returns a MachineCommunication using a BenchSerialPort (also returned)
+std::pair<std::unique_ptr<MachineCommunication>, BenchSerialPort*> createBenchCommunicator();
+
+#endif // BENCHSERIALPORT_H
@@ -0,0 +1,20 @@
+#include "processmemory.h"
+#include <QByteArrayList>
+#include <QFile>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const auto fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
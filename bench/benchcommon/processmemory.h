@@ -0,0 +1,9 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+// Returns the resident set size of the process in bytes or -1 if not available
+qint64 residentMemory();
+
+#endif // PROCESSMEMORY_H
@@ -0,0 +1,51 @@
+#include "shapefiles.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+
+bool createShapeFiles(QString path, int startIndex, int count)
+{
+    const auto baseTime = QDateTime(QDate(2018, 7, 26), QTime(22, 56, 56));
+
+    for (auto i = startIndex; i < (startIndex + count); ++i) {
+        // A permutation of the indexes, to have names and creation times not in file order
+        const auto scrambled = static_cast<qint64>(i) * 7919 % 1000003;
+
+        QByteArray gcodeFilename = (QString("shape-%1.gcode").arg(i)).toLatin1();
+        QByteArray svgFilename = (QString("shape-%1.svg").arg(i)).toLatin1();
+        QByteArray name = (QString("Shape %1").arg(scrambled)).toUtf8();
+        QByteArray creationTime = baseTime.addSecs(scrambled).toString(Qt::ISODateWithMs).toLatin1();
+        QByteArray content = R"(
+{
+  "version": 1,
+  "svgFilename": ")" + svgFilename + R"(",
+  "name": ")" + name + R"(",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": ")" + creationTime + R"(",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": ")" + gcodeFilename + R"("
+})";
+        QFile file(path + QString("/shape-%1.psj").arg(i));
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+            return false;
+        }
+
+        QFile gcodeFile(path + "/" + gcodeFilename);
+        QFile svgFile(path + "/" + svgFilename);
+        if (!gcodeFile.open(QIODevice::WriteOnly) || !svgFile.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+    }
+
+    return true;
+}
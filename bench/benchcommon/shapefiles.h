@@ -0,0 +1,11 @@
+#ifndef SHAPEFILES_H
+#define SHAPEFILES_H
+
+#include <QString>
+
+// Creates count synthetic shapes (.psj, .gcode and .svg files) in path. Files are named
+// shape-<i>.psj and so on, with i going from startIndex to startIndex + count - 1. Names and
+// creation times are scrambled so that sorting is not trivial. Returns false in case of errors
+bool createShapeFiles(QString path, int startIndex, int count);
+
+#endif // SHAPEFILES_H
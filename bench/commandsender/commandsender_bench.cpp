@@ -0,0 +1,92 @@
+#include <QtTest>
+#include "core/commandsender.h"
+#include "core/hdrhistogram.h"
+#include "benchcommon/benchserialport.h"
+
+namespace {
+    const int numCommands = 100000;
+    // The number of 8 bytes commands that fit in the buffer of the machine
+    const int commandsInFlight = 16;
+}
+
+class CommandSenderBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    CommandSenderBench();
+
+private Q_SLOTS:
+    // Each iteration sends numCommands commands and receives their replies, commandsInFlight at a
+    // time. Divide by numCommands to get the cost of one command
+    void sendAndAcknowledge_data();
+    void sendAndAcknowledge();
+    void recordInHdrHistogram();
+    void hdrHistogramPercentile();
+};
+
+CommandSenderBench::CommandSenderBench()
+{
+}
+
+void CommandSenderBench::sendAndAcknowledge_data()
+{
+    QTest::addColumn<qint64>("slowAckThresholdUs");
+
+    QTest::newRow("slow ack detection disabled") << Q_INT64_C(0);
+    QTest::newRow("slow ack detection enabled") << Q_INT64_C(1000000);
+}
+
+void CommandSenderBench::sendAndAcknowledge()
+{
+    QFETCH(qint64, slowAckThresholdUs);
+
+    auto communicatorAndPort = createBenchCommunicator();
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+    sender.setSlowAckThresholdUs(slowAckThresholdUs);
+
+    QByteArray replies;
+    for (auto i = 0; i < commandsInFlight; ++i) {
+        replies += "ok\r\n";
+    }
+
+    QBENCHMARK {
+        for (auto i = 0; i < numCommands / commandsInFlight; ++i) {
+            for (auto j = 0; j < commandsInFlight; ++j) {
+                sender.sendCommand("G1 X10\n");
+            }
+            serialPort->simulateReceivedData(replies);
+        }
+    }
+
+    QCOMPARE(sender.sentCommands(), 0);
+}
+
+void CommandSenderBench::recordInHdrHistogram()
+{
+    HdrHistogram histogram(60000000, 3);
+
+    QBENCHMARK {
+        for (auto i = 0; i < numCommands; ++i) {
+            histogram.record(i * 7);
+        }
+    }
+}
+
+void CommandSenderBench::hdrHistogramPercentile()
+{
+    HdrHistogram histogram(60000000, 3);
+    for (auto i = 0; i < numCommands; ++i) {
+        histogram.record(i * 7);
+    }
+
+    QBENCHMARK {
+        QVERIFY(histogram.valueAtPercentile(99.0) > 0);
+    }
+}
+
+QTEST_GUILESS_MAIN(CommandSenderBench)
+
+#include "commandsender_bench.moc"
@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = localshapesfinder_bench
+
+SOURCES += \
+        localshapesfinder_bench.cpp
@@ -0,0 +1,238 @@
+#include <memory>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QtTest>
+#include "core/localshapesfinder.h"
+#include "benchcommon/processmemory.h"
+#include "benchcommon/shapefiles.h"
+
+namespace {
+    // Creates a tree with customers directories, each one with projects directories
+    void createTree(QString path, int customers, int projects, int shapesPerProject)
+    {
+        auto index = 0;
+        for (auto c = 0; c < customers; ++c) {
+            for (auto p = 0; p < projects; ++p) {
+                const auto dir = path + QString("/customer-%1/project-%2").arg(c).arg(p);
+                QDir::root().mkpath(dir);
+                if (!createShapeFiles(dir, index, shapesPerProject)) {
+                    QFAIL("CANNOT CREATE SHAPES!!!");
+                }
+                index += shapesPerProject;
+            }
+        }
+    }
+}
+
+class LocalShapesFinderBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    LocalShapesFinderBench();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    std::unique_ptr<QTemporaryDir> m_indexDir;
+    QString m_curPath;
+    QString m_indexFilename;
+    int m_defaultThreadCount;
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void startupWithoutIndex_data();
+    void startupWithoutIndex();
+    void startupWithIndex_data();
+    void startupWithIndex();
+    void startupWithThreads_data();
+    void startupWithThreads();
+    void startupInBackground();
+    void dropShapesIntoLibrary_data();
+    void dropShapesIntoLibrary();
+    void recursiveStartup_data();
+    void recursiveStartup();
+    void memoryPerWatchedDirectory();
+};
+
+LocalShapesFinderBench::LocalShapesFinderBench()
+    : m_defaultThreadCount(QThreadPool::globalInstance()->maxThreadCount())
+{
+}
+
+void LocalShapesFinderBench::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    m_indexDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    QVERIFY(m_indexDir->isValid());
+    m_curPath = QDir(m_dir->path()).canonicalPath();
+    m_indexFilename = m_indexDir->path() + "/shapes.index";
+}
+
+void LocalShapesFinderBench::cleanup()
+{
+    m_dir.reset();
+    m_indexDir.reset();
+    QThreadPool::globalInstance()->setMaxThreadCount(m_defaultThreadCount);
+}
+
+void LocalShapesFinderBench::startupWithoutIndex_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10000 shapes") << 10000;
+    QTest::newRow("100000 shapes") << 100000;
+}
+
+void LocalShapesFinderBench::startupWithoutIndex()
+{
+    QFETCH(int, count);
+    QVERIFY(createShapeFiles(m_curPath, 0, count));
+
+    QBENCHMARK_ONCE {
+        LocalShapesFinder finder(m_curPath);
+        QCOMPARE(finder.shapes().size(), count);
+    }
+}
+
+void LocalShapesFinderBench::startupWithIndex_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10000 shapes") << 10000;
+    QTest::newRow("100000 shapes") << 100000;
+}
+
+void LocalShapesFinderBench::startupWithIndex()
+{
+    QFETCH(int, count);
+    QVERIFY(createShapeFiles(m_curPath, 0, count));
+
+    {
+        // Populating the index
+        LocalShapesFinder finder(m_curPath, m_indexFilename);
+    }
+
+    QBENCHMARK_ONCE {
+        LocalShapesFinder finder(m_curPath, m_indexFilename);
+        QCOMPARE(finder.shapes().size(), count);
+    }
+}
+
+void LocalShapesFinderBench::startupWithThreads_data()
+{
+    QTest::addColumn<int>("threads");
+
+    // Shapes are listed and parsed in the global thread pool, load time should scale with cores
+    for (auto threads = 1; threads < m_defaultThreadCount; threads *= 2) {
+        QTest::newRow(qPrintable(QString("%1 threads").arg(threads))) << threads;
+    }
+    QTest::newRow(qPrintable(QString("%1 threads (all cores)").arg(m_defaultThreadCount))) << m_defaultThreadCount;
+}
+
+void LocalShapesFinderBench::startupWithThreads()
+{
+    QFETCH(int, threads);
+    const auto count = 50000;
+    QVERIFY(createShapeFiles(m_curPath, 0, count));
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QBENCHMARK_ONCE {
+        LocalShapesFinder finder(m_curPath);
+        QCOMPARE(finder.shapes().size(), count);
+    }
+}
+
+void LocalShapesFinderBench::startupInBackground()
+{
+    const auto count = 50000;
+    QVERIFY(createShapeFiles(m_curPath, 0, count));
+
+    // Measures how long the calling thread is blocked, loading continues after the constructor
+    QElapsedTimer timer;
+    timer.start();
+    LocalShapesFinder finder(m_curPath, QString(), 0, false, true);
+    QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+    QVERIFY(spy.wait(60000));
+    QCOMPARE(finder.shapes().size(), count);
+}
+
+void LocalShapesFinderBench::dropShapesIntoLibrary_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("dropped");
+
+    QTest::newRow("1000 shapes into 50000") << 50000 << 1000;
+}
+
+void LocalShapesFinderBench::dropShapesIntoLibrary()
+{
+    QFETCH(int, count);
+    QFETCH(int, dropped);
+    QVERIFY(createShapeFiles(m_curPath, 0, count));
+
+    LocalShapesFinder finder(m_curPath);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    // Events from the watcher are only processed when the spy waits, so we only measure the
+    // time needed to update shapes, not the time needed to create files
+    QVERIFY(createShapeFiles(m_curPath, count, dropped));
+
+    QElapsedTimer timer;
+    timer.start();
+    while (finder.shapes().size() != count + dropped) {
+        QVERIFY(spy.wait(10000));
+    }
+    QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+}
+
+void LocalShapesFinderBench::recursiveStartup_data()
+{
+    QTest::addColumn<int>("customers");
+    QTest::addColumn<int>("projects");
+    QTest::addColumn<int>("shapesPerProject");
+
+    QTest::newRow("1000 directories, 10000 shapes") << 50 << 20 << 10;
+    QTest::newRow("5000 directories, 50000 shapes") << 100 << 50 << 10;
+}
+
+void LocalShapesFinderBench::recursiveStartup()
+{
+    QFETCH(int, customers);
+    QFETCH(int, projects);
+    QFETCH(int, shapesPerProject);
+    createTree(m_curPath, customers, projects, shapesPerProject);
+
+    QBENCHMARK_ONCE {
+        LocalShapesFinder finder(m_curPath, QString(), 0, true);
+        QCOMPARE(finder.shapes().size(), customers * projects * shapesPerProject);
+    }
+}
+
+void LocalShapesFinderBench::memoryPerWatchedDirectory()
+{
+    if (residentMemory() < 0) {
+        QSKIP("Memory usage is only measured on Linux");
+    }
+
+    // Only directories, no shapes
+    createTree(m_curPath, 100, 50, 0);
+
+    const auto before = residentMemory();
+    LocalShapesFinder finder(m_curPath, QString(), 0, true);
+    const auto after = residentMemory();
+
+    // Note that this does not include kernel memory used by inotify watches
+    QCOMPARE(finder.directories().size(), 100 * 50 + 100 + 1);
+    QTest::setBenchmarkResult(static_cast<qreal>(after - before) / finder.directories().size(), QTest::BytesAllocated);
+}
+
+QTEST_GUILESS_MAIN(LocalShapesFinderBench)
+
+#include "localshapesfinder_bench.moc"
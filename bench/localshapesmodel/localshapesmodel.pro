@@ -0,0 +1,13 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = localshapesmodel_bench
+
+HEADERS += \
+        ../../app/localshapesmodel.h
+
+SOURCES += \
+        localshapesmodel_bench.cpp \
+        ../../app/localshapesmodel.cpp
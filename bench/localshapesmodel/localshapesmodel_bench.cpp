@@ -0,0 +1,140 @@
+#include <memory>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "app/localshapesmodel.h"
+#include "core/localshapesfinder.h"
+#include "benchcommon/shapefiles.h"
+
+Q_DECLARE_METATYPE(LocalShapesModel::SortCriterion)
+
+namespace {
+    const int numShapes = 100000;
+}
+
+class LocalShapesModelBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    LocalShapesModelBench();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    std::unique_ptr<LocalShapesFinder> m_finder;
+    QString m_curPath;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void insertAndRemoveOneShape_data();
+    void insertAndRemoveOneShape();
+    void sortAllShapes_data();
+    void sortAllShapes();
+    void readAllRows_data();
+    void readAllRows();
+};
+
+LocalShapesModelBench::LocalShapesModelBench()
+{
+}
+
+void LocalShapesModelBench::initTestCase()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_curPath = QDir(m_dir->path()).canonicalPath();
+
+    QVERIFY(createShapeFiles(m_curPath, 0, numShapes));
+    m_finder = std::make_unique<LocalShapesFinder>(m_curPath);
+    QCOMPARE(m_finder->shapes().size(), numShapes);
+}
+
+void LocalShapesModelBench::cleanupTestCase()
+{
+    m_finder.reset();
+    m_dir.reset();
+}
+
+void LocalShapesModelBench::insertAndRemoveOneShape_data()
+{
+    QTest::addColumn<LocalShapesModel::SortCriterion>("criterion");
+
+    QTest::newRow("Newest") << LocalShapesModel::SortCriterion::Newest;
+    QTest::newRow("AZ") << LocalShapesModel::SortCriterion::AZ;
+    QTest::newRow("ZA") << LocalShapesModel::SortCriterion::ZA;
+}
+
+void LocalShapesModelBench::insertAndRemoveOneShape()
+{
+    QFETCH(LocalShapesModel::SortCriterion, criterion);
+
+    LocalShapesModel model(*m_finder);
+    model.sortShapes(criterion);
+
+    // The model is told the shape was removed even if it is still in the finder, so that we can
+    // add it back
+    const QString key = m_curPath + QString("/shape-%1.psj").arg(numShapes / 2);
+    model.shapesUpdated(QSet<QString>(), QSet<QString>{key});
+    QCOMPARE(model.rowCount(), numShapes - 1);
+
+    QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+    QBENCHMARK {
+        model.shapesUpdated(QSet<QString>{key}, QSet<QString>());
+        model.shapesUpdated(QSet<QString>(), QSet<QString>{key});
+    }
+
+    // Only single rows are inserted, the model is never reset
+    QVERIFY(insertSpy.count() > 0);
+    QCOMPARE(insertSpy.at(0).at(1).toInt(), insertSpy.at(0).at(2).toInt());
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void LocalShapesModelBench::sortAllShapes_data()
+{
+    insertAndRemoveOneShape_data();
+}
+
+void LocalShapesModelBench::sortAllShapes()
+{
+    QFETCH(LocalShapesModel::SortCriterion, criterion);
+
+    LocalShapesModel model(*m_finder);
+
+    // This is what happened on every update before models were updated incrementally
+    QBENCHMARK {
+        model.sortShapes(criterion);
+    }
+}
+
+void LocalShapesModelBench::readAllRows_data()
+{
+    QTest::addColumn<QByteArray>("role");
+
+    QTest::newRow("name") << QByteArray("name");
+    QTest::newRow("svgFilename") << QByteArray("svgFilename");
+    QTest::newRow("creationTime") << QByteArray("creationTime");
+}
+
+void LocalShapesModelBench::readAllRows()
+{
+    QFETCH(QByteArray, role);
+
+    LocalShapesModel model(*m_finder);
+    const int roleId = model.roleNames().key(role);
+
+    // What the view does while scrolling through all shapes
+    QBENCHMARK {
+        for (auto i = 0; i < model.rowCount(); ++i) {
+            const auto value = model.data(model.index(i), roleId);
+            Q_UNUSED(value);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(LocalShapesModelBench)
+
+#include "localshapesmodel_bench.moc"
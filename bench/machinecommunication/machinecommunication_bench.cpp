@@ -0,0 +1,82 @@
+#include <QList>
+#include <QtTest>
+#include "core/machinecommunication.h"
+#include "benchcommon/benchserialport.h"
+
+namespace {
+    // While streaming the machine replies ok to every line and sends a status report every second
+    const int okRepliesPerStatusReport = 10;
+    const int statusReports = 1000;
+
+    QByteArray streamingTraffic()
+    {
+        QByteArray traffic;
+        for (auto i = 0; i < statusReports; ++i) {
+            for (auto j = 0; j < okRepliesPerStatusReport; ++j) {
+                traffic += "ok\r\n";
+            }
+            traffic += "<Run|MPos:123.456,78.901,0.000|FS:1200,0|WCO:0.000,0.000,0.000>\r\n";
+        }
+
+        return traffic;
+    }
+}
+
+class MachineCommunicationBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    MachineCommunicationBench();
+
+private Q_SLOTS:
+    // Each iteration receives streamingTraffic() in chunks of the given size and splits it into
+    // messages
+    void receiveMessages_data();
+    void receiveMessages();
+};
+
+MachineCommunicationBench::MachineCommunicationBench()
+{
+}
+
+void MachineCommunicationBench::receiveMessages_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    // The serial port usually returns a few bytes at a time
+    QTest::newRow("1 byte chunks") << 1;
+    QTest::newRow("8 bytes chunks") << 8;
+    QTest::newRow("64 bytes chunks") << 64;
+    QTest::newRow("4096 bytes chunks") << 4096;
+}
+
+void MachineCommunicationBench::receiveMessages()
+{
+    QFETCH(int, chunkSize);
+
+    auto communicatorAndPort = createBenchCommunicator();
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    auto numMessages = 0;
+    connect(communicator.get(), &MachineCommunication::messageReceived, [&numMessages]() { ++numMessages; });
+
+    const auto traffic = streamingTraffic();
+    QList<QByteArray> chunks;
+    for (auto i = 0; i < traffic.size(); i += chunkSize) {
+        chunks.append(traffic.mid(i, chunkSize));
+    }
+
+    QBENCHMARK {
+        numMessages = 0;
+        for (const auto& chunk: chunks) {
+            serialPort->simulateReceivedData(chunk);
+        }
+    }
+
+    QCOMPARE(numMessages, statusReports * (okRepliesPerStatusReport + 1));
+}
+
+QTEST_GUILESS_MAIN(MachineCommunicationBench)
+
+#include "machinecommunication_bench.moc"
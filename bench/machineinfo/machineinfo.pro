@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = machineinfo_bench
+
+SOURCES += \
+        machineinfo_bench.cpp
@@ -0,0 +1,57 @@
+#include <QtTest>
+#include "core/machineinfo.h"
+
+namespace {
+    const int numParses = 100000;
+}
+
+class MachineInfoBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    MachineInfoBench();
+
+private Q_SLOTS:
+    // Each iteration parses the string numParses times. Port discovery parses the data received
+    // so far every time new data arrives, so incomplete strings are common
+    void createFromString_data();
+    void createFromString();
+};
+
+MachineInfoBench::MachineInfoBench()
+{
+}
+
+void MachineInfoBench::createFromString_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("reply to $I") << QByteArray("[PolyShaper Oranje][pn123 sn456 789]ok\r\n") << true;
+    QTest::newRow("reply to $I after startup message") << QByteArray("\r\nGrbl 1.1f ['$' for help]\r\n[PolyShaper Oranje][pn123 sn456 789]ok\r\n") << true;
+    QTest::newRow("incomplete reply") << QByteArray("[PolyShaper Oranje][pn12") << false;
+    QTest::newRow("not a PolyShaper machine") << QByteArray("[VER:1.1f.20170801:]\r\n[OPT:V,15,128]\r\nok\r\n") << false;
+}
+
+void MachineInfoBench::createFromString()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, valid);
+
+    auto parsed = 0;
+    QBENCHMARK {
+        parsed = 0;
+        for (auto i = 0; i < numParses; ++i) {
+            if (MachineInfo::createFromString(data)) {
+                ++parsed;
+            }
+        }
+    }
+
+    QCOMPARE(parsed, valid ? numParses : 0);
+}
+
+QTEST_GUILESS_MAIN(MachineInfoBench)
+
+#include "machineinfo_bench.moc"
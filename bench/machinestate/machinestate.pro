@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = machinestate_bench
+
+SOURCES += \
+        machinestate_bench.cpp
@@ -0,0 +1,57 @@
+#include <QtTest>
+#include "core/machinestate.h"
+
+namespace {
+    const int numConversions = 1000000;
+}
+
+class MachineStateBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    MachineStateBench();
+
+private Q_SLOTS:
+    // Each iteration converts the string numConversions times. States are checked in order, so
+    // the cost depends on the state
+    void string2MachineState_data();
+    void string2MachineState();
+};
+
+MachineStateBench::MachineStateBench()
+{
+}
+
+void MachineStateBench::string2MachineState_data()
+{
+    QTest::addColumn<QByteArray>("state");
+    QTest::addColumn<MachineState>("expected");
+
+    QTest::newRow("Idle") << QByteArray("Idle") << MachineState::Idle;
+    QTest::newRow("Run") << QByteArray("Run") << MachineState::Run;
+    QTest::newRow("Sleep") << QByteArray("Sleep") << MachineState::Sleep;
+    QTest::newRow("unknown") << QByteArray("Hold:0") << MachineState::Unknown;
+}
+
+void MachineStateBench::string2MachineState()
+{
+    QFETCH(QByteArray, state);
+    QFETCH(MachineState, expected);
+
+    auto matching = 0;
+    QBENCHMARK {
+        matching = 0;
+        for (auto i = 0; i < numConversions; ++i) {
+            if (::string2MachineState(state) == expected) {
+                ++matching;
+            }
+        }
+    }
+
+    QCOMPARE(matching, numConversions);
+}
+
+QTEST_GUILESS_MAIN(MachineStateBench)
+
+#include "machinestate_bench.moc"
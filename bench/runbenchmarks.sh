@@ -0,0 +1,37 @@
+#!/bin/sh
+# Runs all benchmarks and writes the results of each one in the QtTest XML format, so that results
+# of different releases can be compared by tools. Usage:
+#   runbenchmarks.sh <build directory of bench> <output directory> [extra benchmark arguments]
+# e.g. runbenchmarks.sh build/bench results/1.2.0 -iterations 10
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <build directory of bench> <output directory> [extra benchmark arguments]" >&2
+    exit 2
+fi
+
+BUILD_DIR=$1
+OUT_DIR=$2
+shift 2
+
+mkdir -p "$OUT_DIR" || exit 1
+
+FAILED=0
+FOUND=0
+for BENCH in "$BUILD_DIR"/*/*_bench; do
+    [ -x "$BENCH" ] || continue
+    FOUND=1
+    NAME=$(basename "$BENCH")
+    echo "Running $NAME"
+    # Also print results on the console
+    if ! "$BENCH" -o "$OUT_DIR/$NAME.xml,xml" -o -,txt "$@"; then
+        echo "$NAME FAILED" >&2
+        FAILED=1
+    fi
+done
+
+if [ $FOUND -eq 0 ]; then
+    echo "No benchmark found in $BUILD_DIR" >&2
+    exit 1
+fi
+
+exit $FAILED
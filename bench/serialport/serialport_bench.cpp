@@ -0,0 +1,120 @@
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+#include <QSocketNotifier>
+#include <QtTest>
+#include "core/nativeserialport.h"
+#include "core/serialport.h"
+
+namespace {
+    const QByteArray reply("ok\r\n");
+
+    // Plays the machine on the master side of a pseudo terminal: every line received is
+    // acknowledged with "ok"
+    class EchoingPseudoTerminal
+    {
+    public:
+        EchoingPseudoTerminal()
+            : m_master(::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK))
+        {
+            if (m_master == -1 || ::grantpt(m_master) == -1 || ::unlockpt(m_master) == -1) {
+                qFatal("Cannot create a pseudo terminal");
+            }
+
+            m_notifier = std::make_unique<QSocketNotifier>(m_master, QSocketNotifier::Read);
+            QObject::connect(m_notifier.get(), &QSocketNotifier::activated, [this]() { readLines(); });
+        }
+
+        ~EchoingPseudoTerminal()
+        {
+            m_notifier.reset();
+            ::close(m_master);
+        }
+
+        QString slaveName() const
+        {
+            return QString::fromLocal8Bit(::ptsname(m_master));
+        }
+
+    private:
+        void readLines()
+        {
+            char buffer[4096];
+            ssize_t n;
+            while ((n = ::read(m_master, buffer, sizeof(buffer))) > 0) {
+                for (auto i = 0; i < n; ++i) {
+                    if (buffer[i] == '\n' && ::write(m_master, reply.constData(), static_cast<size_t>(reply.size())) != reply.size()) {
+                        qFatal("Cannot write to the pseudo terminal");
+                    }
+                }
+            }
+        }
+
+        const int m_master;
+        std::unique_ptr<QSocketNotifier> m_notifier;
+    };
+}
+
+class SerialPortBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    SerialPortBench();
+
+private Q_SLOTS:
+    // Each iteration writes one line to a pseudo terminal and waits for the reply, so this is the
+    // latency added by the serial port implementation (the baud rate is ignored by pseudo
+    // terminals)
+    void roundTrip_data();
+    void roundTrip();
+};
+
+SerialPortBench::SerialPortBench()
+{
+}
+
+void SerialPortBench::roundTrip_data()
+{
+    QTest::addColumn<bool>("native");
+    QTest::addColumn<QByteArray>("line");
+
+    QTest::newRow("QSerialPort, status query") << false << QByteArray("?\n");
+    QTest::newRow("NativeSerialPort, status query") << true << QByteArray("?\n");
+    QTest::newRow("QSerialPort, G-code line") << false << QByteArray("G1 X123.456 Y78.901 F1000\n");
+    QTest::newRow("NativeSerialPort, G-code line") << true << QByteArray("G1 X123.456 Y78.901 F1000\n");
+}
+
+void SerialPortBench::roundTrip()
+{
+    QFETCH(bool, native);
+    QFETCH(QByteArray, line);
+
+    EchoingPseudoTerminal pty;
+    std::unique_ptr<SerialPortInterface> port;
+    if (native) {
+        port = std::make_unique<NativeSerialPort>(pty.slaveName());
+    } else {
+        port = std::make_unique<SerialPort>(pty.slaveName());
+    }
+    QVERIFY(port->open());
+
+    QByteArray received;
+    connect(port.get(), &SerialPortInterface::dataAvailable, [&port, &received]() { received += port->readAll(); });
+
+    QBENCHMARK {
+        received.clear();
+        QCOMPARE(port->write(line), static_cast<qint64>(line.size()));
+
+        while (received.size() < reply.size()) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+
+    QCOMPARE(received, reply);
+}
+
+QTEST_GUILESS_MAIN(SerialPortBench)
+
+#include "serialport_bench.moc"
@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = shapeinfo_bench
+
+SOURCES += \
+        shapeinfo_bench.cpp
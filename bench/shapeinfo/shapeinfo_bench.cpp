@@ -0,0 +1,173 @@
+#include <memory>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <QVector>
+#include "core/shapeinfo.h"
+#include "benchcommon/processmemory.h"
+#include "benchcommon/shapefiles.h"
+
+namespace {
+    const int numShapes = 100000;
+
+    // The checks done by ShapeInfo::createFromFile before the single-pass parser, kept here as
+    // the baseline. Only returns whether the file is a valid shape
+    bool parseWithDom(QString filename)
+    {
+        QFile file(filename);
+
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return false;
+        }
+
+        const auto doc = QJsonDocument::fromJson(file.readAll());
+        if (doc.isNull()) {
+            return false;
+        }
+
+        const auto obj = doc.object();
+        if (obj.value("version").toInt(0) != 1) {
+            return false;
+        }
+
+        for (const auto& field: {"name", "svgFilename", "machineType", "generatedBy", "gcodeFilename"}) {
+            if (!obj.value(field).isString()) {
+                return false;
+            }
+        }
+        for (const auto& field: {"square", "drawToolpath", "autoClosePath", "pointsInsideWorkpiece"}) {
+            if (!obj.value(field).isBool()) {
+                return false;
+            }
+        }
+        for (const auto& field: {"margin", "flatness", "workpieceDimX", "workpieceDimY", "speed"}) {
+            if (!obj.value(field).isDouble()) {
+                return false;
+            }
+        }
+
+        const auto creationTime = obj.value("creationTime");
+        if (!creationTime.isString() || !QDateTime::fromString(creationTime.toString(), Qt::ISODateWithMs).isValid()) {
+            return false;
+        }
+
+        return obj.value("duration").isDouble() && obj.value("duration").toInt(-1) >= 0;
+    }
+}
+
+class ShapeInfoBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShapeInfoBench();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QStringList m_filenames;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void parseAllFiles_data();
+    void parseAllFiles();
+    void memoryPerShape();
+    void copyAllShapes();
+};
+
+ShapeInfoBench::ShapeInfoBench()
+{
+}
+
+void ShapeInfoBench::initTestCase()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    QVERIFY(createShapeFiles(m_dir->path(), 0, numShapes));
+
+    const auto dir = QDir(m_dir->path());
+    for (const auto& name: dir.entryList(QStringList() << "*.psj", QDir::Files)) {
+        m_filenames.append(dir.filePath(name));
+    }
+    QCOMPARE(m_filenames.size(), numShapes);
+}
+
+void ShapeInfoBench::cleanupTestCase()
+{
+    m_filenames.clear();
+    m_dir.reset();
+}
+
+void ShapeInfoBench::parseAllFiles_data()
+{
+    QTest::addColumn<bool>("useDom");
+
+    QTest::newRow("QJsonDocument") << true;
+    QTest::newRow("single-pass parser") << false;
+}
+
+void ShapeInfoBench::parseAllFiles()
+{
+    QFETCH(bool, useDom);
+
+    auto valid = 0;
+    QBENCHMARK_ONCE {
+        valid = 0;
+        for (const auto& filename: m_filenames) {
+            if (useDom ? parseWithDom(filename) : ShapeInfo::createFromFile(filename).isValid()) {
+                ++valid;
+            }
+        }
+    }
+
+    QCOMPARE(valid, numShapes);
+}
+
+void ShapeInfoBench::memoryPerShape()
+{
+    if (residentMemory() < 0) {
+        QSKIP("Resident memory is not available on this platform");
+    }
+
+    QVector<ShapeInfo> shapes;
+    shapes.reserve(m_filenames.size());
+
+    const auto before = residentMemory();
+    for (const auto& filename: m_filenames) {
+        shapes.append(ShapeInfo::createFromFile(filename));
+    }
+    const auto after = residentMemory();
+
+    QCOMPARE(shapes.size(), numShapes);
+    QTest::setBenchmarkResult(static_cast<qreal>(after - before) / shapes.size(), QTest::BytesAllocated);
+}
+
+void ShapeInfoBench::copyAllShapes()
+{
+    // Shapes are copied from the parsed list to the map of shapes, like LocalShapesFinder does
+    QVector<ShapeInfo> shapes;
+    shapes.reserve(m_filenames.size());
+    for (const auto& filename: m_filenames) {
+        shapes.append(ShapeInfo::createFromFile(filename));
+    }
+
+    QBENCHMARK {
+        QMap<QString, ShapeInfo> map;
+        for (auto i = 0; i < shapes.size(); ++i) {
+            map.insert(m_filenames[i], shapes[i]);
+        }
+        QCOMPARE(map.size(), numShapes);
+    }
+}
+
+QTEST_GUILESS_MAIN(ShapeInfoBench)
+
+#include "shapeinfo_bench.moc"
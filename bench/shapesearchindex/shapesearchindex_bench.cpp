@@ -0,0 +1,132 @@
+#include <memory>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/localshapesfinder.h"
+#include "core/shapesearchindex.h"
+#include "benchcommon/shapefiles.h"
+
+namespace {
+    const int numShapes = 100000;
+}
+
+class ShapeSearchIndexBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShapeSearchIndexBench();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    std::unique_ptr<LocalShapesFinder> m_finder;
+    ShapeSearchIndex m_index;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void buildIndex();
+    void searchWhileTyping_data();
+    void searchWhileTyping();
+    void filterByFacets();
+    void updateOneShape();
+    void removeShapeInTheMiddle();
+};
+
+ShapeSearchIndexBench::ShapeSearchIndexBench()
+{
+}
+
+void ShapeSearchIndexBench::initTestCase()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    const auto path = QDir(m_dir->path()).canonicalPath();
+
+    QVERIFY(createShapeFiles(path, 0, numShapes));
+    m_finder = std::make_unique<LocalShapesFinder>(path);
+    QCOMPARE(m_finder->shapes().size(), numShapes);
+
+    for (auto it = m_finder->shapes().cbegin(); it != m_finder->shapes().cend(); ++it) {
+        m_index.insert(it.key(), it.value());
+    }
+}
+
+void ShapeSearchIndexBench::cleanupTestCase()
+{
+    m_finder.reset();
+    m_dir.reset();
+}
+
+void ShapeSearchIndexBench::buildIndex()
+{
+    QBENCHMARK {
+        ShapeSearchIndex index;
+        for (auto it = m_finder->shapes().cbegin(); it != m_finder->shapes().cend(); ++it) {
+            index.insert(it.key(), it.value());
+        }
+    }
+}
+
+void ShapeSearchIndexBench::searchWhileTyping_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("1 char") << "s";
+    QTest::newRow("2 chars") << "sh";
+    QTest::newRow("3 chars") << "sha";
+    QTest::newRow("whole name") << "shape 12345";
+    QTest::newRow("digits") << "9876";
+}
+
+void ShapeSearchIndexBench::searchWhileTyping()
+{
+    QFETCH(QString, text);
+
+    ShapeSearchIndex::Query query;
+    query.text = text;
+
+    QBENCHMARK {
+        const auto result = m_index.search(query);
+        Q_UNUSED(result);
+    }
+}
+
+void ShapeSearchIndexBench::filterByFacets()
+{
+    ShapeSearchIndex::Query query;
+    query.machineType = "PolyShaperOranje";
+    query.square = ShapeSearchIndex::SquareFilter::Square;
+    query.workpieceDimX = ShapeSearchIndex::Range{0.0, 500.0};
+    query.duration = ShapeSearchIndex::Range{0.0, 100.0};
+
+    QBENCHMARK {
+        const auto result = m_index.search(query);
+        Q_UNUSED(result);
+    }
+}
+
+void ShapeSearchIndexBench::updateOneShape()
+{
+    const auto it = m_finder->shapes().cbegin();
+
+    QBENCHMARK {
+        m_index.remove(it.key());
+        m_index.insert(it.key(), it.value());
+    }
+}
+
+void ShapeSearchIndexBench::removeShapeInTheMiddle()
+{
+    // Generated shapes have few distinct values, so the shape is in the middle of long lists
+    const auto it = m_finder->shapes().cbegin() + numShapes / 2;
+
+    QBENCHMARK {
+        m_index.remove(it.key());
+        m_index.insert(it.key(), it.value());
+    }
+}
+
+QTEST_GUILESS_MAIN(ShapeSearchIndexBench)
+
+#include "shapesearchindex_bench.moc"
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <QtTest>
+#include "core/tracerecorder.h"
+
+namespace {
+    const int numZones = 1000000;
+
+    // Some work that cannot be optimized away, so that the loop is not removed
+    volatile unsigned int sink = 0;
+
+    void work(int i)
+    {
+        sink = sink + static_cast<unsigned int>(i);
+    }
+}
+
+class TraceRecorderBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    TraceRecorderBench();
+
+private Q_SLOTS:
+    void cleanup();
+
+    // Each iteration runs numZones zones. The overhead of a disabled zone is the difference
+    // with the "no zone" row
+    void zones_data();
+    void zones();
+    void zonesFromManyThreads();
+    void exportJson();
+};
+
+TraceRecorderBench::TraceRecorderBench()
+{
+}
+
+void TraceRecorderBench::cleanup()
+{
+    TraceRecorder::global().setEnabled(false);
+    TraceRecorder::global().clear();
+}
+
+void TraceRecorderBench::zones_data()
+{
+    QTest::addColumn<bool>("useZone");
+    QTest::addColumn<bool>("enabled");
+
+    QTest::newRow("no zone") << false << false;
+    QTest::newRow("zone, tracing disabled") << true << false;
+    QTest::newRow("zone, tracing enabled") << true << true;
+}
+
+void TraceRecorderBench::zones()
+{
+    QFETCH(bool, useZone);
+    QFETCH(bool, enabled);
+
+    TraceRecorder::global().setEnabled(enabled);
+
+    if (useZone) {
+        QBENCHMARK {
+            for (auto i = 0; i < numZones; ++i) {
+                TRACE_ZONE("zone");
+                work(i);
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (auto i = 0; i < numZones; ++i) {
+                work(i);
+            }
+        }
+    }
+}
+
+void TraceRecorderBench::zonesFromManyThreads()
+{
+    // Threads write in their own buffers, so this should scale with the number of threads
+    TraceRecorder::global().setEnabled(true);
+    const auto numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 2);
+
+    QBENCHMARK {
+        std::vector<std::thread> threads;
+        for (auto t = 0; t < numThreads; ++t) {
+            threads.emplace_back([]() {
+                for (auto i = 0; i < numZones; ++i) {
+                    TRACE_ZONE("zone");
+                    work(i);
+                }
+            });
+        }
+        for (auto& t: threads) {
+            t.join();
+        }
+    }
+}
+
+void TraceRecorderBench::exportJson()
+{
+    // A full buffer of the main thread
+    TraceRecorder::global().setEnabled(true);
+    for (auto i = 0; i < numZones; ++i) {
+        TRACE_ZONE("zone");
+    }
+
+    QBENCHMARK {
+        QVERIFY(!TraceRecorder::global().toChromeJson().isEmpty());
+    }
+}
+
+QTEST_GUILESS_MAIN(TraceRecorderBench)
+
+#include "tracerecorder_bench.moc"
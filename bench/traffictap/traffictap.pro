@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../bench.pri) {
+    error("Couldn't find the bench.pri file!")
+}
+
+TARGET = traffictap_bench
+
+SOURCES += \
+        traffictap_bench.cpp
@@ -0,0 +1,105 @@
+#include <QThread>
+#include <QtTest>
+#include "core/commandsender.h"
+#include "core/traffictap.h"
+#include "benchcommon/benchserialport.h"
+
+namespace {
+    const int numCommands = 100000;
+    // The number of 8 bytes commands that fit in the buffer of the machine
+    const int commandsInFlight = 16;
+
+    enum class TerminalMode {
+        // The terminal is disabled, nothing is connected to MachineCommunication
+        Unsubscribed,
+        // The terminal is enabled and receives batches from the tap
+        Subscribed,
+        // What the GUI did before TrafficTap: every chunk forwarded to another thread
+        ForwardEveryChunk
+    };
+}
+
+Q_DECLARE_METATYPE(TerminalMode)
+
+class TrafficTapBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    TrafficTapBench();
+
+private Q_SLOTS:
+    // Each iteration streams numCommands commands and receives their replies, commandsInFlight at
+    // a time, with the traffic delivered to a receiver in another thread as the terminal does.
+    // Divide by numCommands to get the cost of one command
+    void streamWithTerminal_data();
+    void streamWithTerminal();
+};
+
+TrafficTapBench::TrafficTapBench()
+{
+}
+
+void TrafficTapBench::streamWithTerminal_data()
+{
+    QTest::addColumn<TerminalMode>("mode");
+
+    QTest::newRow("terminal disabled, tap unsubscribed") << TerminalMode::Unsubscribed;
+    QTest::newRow("terminal enabled, tap subscribed") << TerminalMode::Subscribed;
+    QTest::newRow("every chunk forwarded to the terminal") << TerminalMode::ForwardEveryChunk;
+}
+
+void TrafficTapBench::streamWithTerminal()
+{
+    QFETCH(TerminalMode, mode);
+
+    auto communicatorAndPort = createBenchCommunicator();
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+    TrafficTap tap(communicator.get(), 50);
+
+    // The receiver of the traffic, in another thread like the GUI
+    QThread terminalThread;
+    QObject terminal;
+    terminal.moveToThread(&terminalThread);
+    terminalThread.start();
+
+    switch (mode) {
+        case TerminalMode::Unsubscribed:
+            break;
+        case TerminalMode::Subscribed:
+            connect(&tap, &TrafficTap::trafficAvailable, &terminal, [](TrafficTap::Batch) {});
+            tap.subscribe();
+            break;
+        case TerminalMode::ForwardEveryChunk:
+            connect(communicator.get(), &MachineCommunication::dataSent, &terminal, [](QByteArray) {});
+            connect(communicator.get(), &MachineCommunication::dataReceived, &terminal, [](QByteArray) {});
+            break;
+    }
+
+    QByteArray replies;
+    for (auto i = 0; i < commandsInFlight; ++i) {
+        replies += "ok\r\n";
+    }
+
+    QBENCHMARK {
+        for (auto i = 0; i < numCommands / commandsInFlight; ++i) {
+            for (auto j = 0; j < commandsInFlight; ++j) {
+                sender.sendCommand("G1 X10\n");
+            }
+            serialPort->simulateReceivedData(replies);
+            // Lets the flush timer of the tap fire, as the event loop of the worker thread does
+            QCoreApplication::processEvents();
+        }
+    }
+
+    QCOMPARE(sender.sentCommands(), 0);
+
+    terminalThread.quit();
+    terminalThread.wait();
+}
+
+QTEST_GUILESS_MAIN(TrafficTapBench)
+
+#include "traffictap_bench.moc"
@@ -0,0 +1,25 @@
+# Check if the config file exists
+!include(../common.pri) {
+    error("Couldn't find the common.pri file!")
+}
+
+TEMPLATE = app
+TARGET = shaco-cli
+CONFIG += console
+CONFIG -= app_bundle
+QT += serialport concurrent network
+QT -= gui
+
+# Worker and Settings are shared with the GUI
+HEADERS += \
+    clirunner.h \
+    ../app/settings.h \
+    ../app/worker.h
+SOURCES += main.cpp \
+    clirunner.cpp \
+    ../app/settings.cpp \
+    ../app/worker.cpp
+
+unix:LIBS += -L../core -lcore
+win32:debug:LIBS += -L../core/debug -lcore
+win32:release:LIBS += -L../core/release -lcore
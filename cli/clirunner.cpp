@@ -0,0 +1,185 @@
+#include "clirunner.h"
+#include <QUrl>
+#include "core/gcodevalidator.h"
+#include "core/metrics.h"
+
+namespace {
+    double perSecond(qint64 value, qint64 elapsedMillis)
+    {
+        return (elapsedMillis == 0) ? 0.0 : (value * 1000.0) / elapsedMillis;
+    }
+}
+
+CliRunner::CliRunner(QString gcodeFilename, QString portName, QList<qint32> baudRates, int discoveryTimeoutMillis)
+    : CliRunner(gcodeFilename, std::make_unique<Worker>(portName, baudRates), discoveryTimeoutMillis)
+{
+}
+
+CliRunner::CliRunner(QString gcodeFilename, std::unique_ptr<Worker>&& worker, int discoveryTimeoutMillis)
+    : m_gcodeFilename(gcodeFilename)
+    , m_discoveryTimeoutMillis(discoveryTimeoutMillis)
+    , m_out(stdout)
+    , m_err(stderr)
+    , m_worker(std::move(worker))
+    , m_discoveryTimer()
+    , m_streamingTime()
+    , m_commandsSentAtStart(0)
+    , m_bytesSentAtStart(0)
+    , m_stallTimeUsAtStart(0)
+    , m_finished(false)
+{
+    m_discoveryTimer.setSingleShot(true);
+    connect(&m_discoveryTimer, &QTimer::timeout, this, &CliRunner::discoveryTimeout);
+
+    // Worker connects MachineCommunication first, so the port is already taken when we are called
+    connect(m_worker->portDiscoverer(), &AbstractPortDiscovery::portFound, this, &CliRunner::portFound);
+    connect(m_worker->machineCommunicator(), &MachineCommunication::portClosedWithError, this, &CliRunner::portClosedWithError);
+    connect(m_worker->commandSender(), &CommandSender::slowAck, this, &CliRunner::slowAck);
+    connect(m_worker.get(), &Worker::gcodeRefused, this, &CliRunner::gcodeRefused);
+}
+
+void CliRunner::start()
+{
+    const auto check = GCodeValidator(0.0, 0.0).validateFile(m_gcodeFilename);
+    if (check.verdict == GCodeCheck::Verdict::Invalid) {
+        printMessage((check.line == 0) ? check.message : QString("Invalid G-code at line %1: %2").arg(check.line).arg(check.message));
+        finish(StreamError);
+        return;
+    }
+
+    printMessage("Searching for a machine...");
+
+    m_discoveryTimer.start(m_discoveryTimeoutMillis);
+    m_worker->portDiscoverer()->start();
+}
+
+void CliRunner::portFound(MachineInfo* info)
+{
+    if (m_finished) {
+        return;
+    }
+
+    m_discoveryTimer.stop();
+    printMessage(QString("Found %1 (part number %2, serial number %3, firmware %4) at %5 baud")
+                 .arg(info->machineName(), info->partNumber(), info->serialNumber(), info->firmwareVersion())
+                 .arg(m_worker->portDiscoverer()->baudRate()));
+
+    m_worker->setGCodeFile(QUrl::fromLocalFile(m_gcodeFilename));
+    auto sender = m_worker->gcodeSender();
+    if (sender == nullptr) {
+        // The file was refused, gcodeRefused() has already been handled
+        return;
+    }
+    connect(sender, &GCodeSender::streamingStarted, this, &CliRunner::streamingStarted);
+    connect(sender, &GCodeSender::streamingEnded, this, &CliRunner::streamingEnded);
+    sender->streamData();
+}
+
+void CliRunner::streamingStarted()
+{
+    auto& registry = MetricsRegistry::global();
+    m_commandsSentAtStart = registry.counter("commandSender.commandsSent").value();
+    m_bytesSentAtStart = registry.counter("serial.bytesSent").value();
+    m_stallTimeUsAtStart = registry.counter("gcodeSender.stallTimeUs").value();
+    m_streamingTime.start();
+
+    printMessage("Streaming " + m_gcodeFilename);
+}
+
+void CliRunner::streamingEnded(GCodeSender::StreamEndReason reason, QString description)
+{
+    if (m_finished) {
+        return;
+    }
+
+    printStatistics();
+
+    switch (reason) {
+        case GCodeSender::StreamEndReason::Completed:
+            finish(Success);
+            break;
+        case GCodeSender::StreamEndReason::StreamError:
+            printMessage("Streaming failed: " + description);
+            finish(StreamError);
+            break;
+        case GCodeSender::StreamEndReason::MachineError:
+            printMessage("Streaming failed: " + description);
+            finish(MachineError);
+            break;
+        case GCodeSender::StreamEndReason::PortError:
+        case GCodeSender::StreamEndReason::UserInterrupted:
+            printMessage("Streaming failed: " + description);
+            finish(PortError);
+            break;
+    }
+}
+
+void CliRunner::gcodeRefused(QString description)
+{
+    printMessage("Streaming failed: " + description);
+    finish(StreamError);
+}
+
+void CliRunner::portClosedWithError(QString reason)
+{
+    // If commands were waiting for a reply, GCodeSender has already reported the error
+    if (m_finished) {
+        return;
+    }
+
+    printStatistics();
+    printMessage("Serial port error: " + reason);
+    finish(PortError);
+}
+
+void CliRunner::discoveryTimeout()
+{
+    printMessage(QString("No machine found in %1 seconds").arg(m_discoveryTimeoutMillis / 1000));
+    finish(MachineNotFound);
+}
+
+void CliRunner::slowAck(CommandCorrelationId correlationId, qint64 latencyUs)
+{
+    printMessage(QString("Slow reply to line %1: %2 ms").arg(correlationId).arg(latencyUs / 1000));
+}
+
+void CliRunner::printStatistics()
+{
+    if (!m_streamingTime.isValid()) {
+        return;
+    }
+
+    auto& registry = MetricsRegistry::global();
+    const auto elapsedMillis = m_streamingTime.elapsed();
+    const auto commands = registry.counter("commandSender.commandsSent").value() - m_commandsSentAtStart;
+    const auto bytes = registry.counter("serial.bytesSent").value() - m_bytesSentAtStart;
+    const auto stallTimeUs = registry.counter("gcodeSender.stallTimeUs").value() - m_stallTimeUsAtStart;
+    const auto& latencies = m_worker->commandSender()->sessionAckLatencies();
+
+    // One "name: value" pair per line, so that the output is easy to parse
+    m_out << "totalTimeMs: " << elapsedMillis << "\n"
+          << "commandsSent: " << commands << "\n"
+          << "bytesSent: " << bytes << "\n"
+          << "commandsPerSecond: " << perSecond(commands, elapsedMillis) << "\n"
+          << "bytesPerSecond: " << perSecond(bytes, elapsedMillis) << "\n"
+          << "ackLatencyP50Us: " << latencies.valueAtPercentile(50.0) << "\n"
+          << "ackLatencyP99Us: " << latencies.valueAtPercentile(99.0) << "\n"
+          << "ackLatencyMaxUs: " << latencies.max() << "\n"
+          << "stallTimeMs: " << stallTimeUs / 1000 << "\n"
+          << "baudRate: " << m_worker->portDiscoverer()->baudRate() << "\n";
+    m_out.flush();
+}
+
+void CliRunner::printMessage(const QString& message)
+{
+    m_err << message << "\n";
+    m_err.flush();
+}
+
+void CliRunner::finish(ExitCode exitCode)
+{
+    m_finished = true;
+    m_discoveryTimer.stop();
+
+    emit finished(exitCode);
+}
@@ -0,0 +1,73 @@
+#ifndef CLIRUNNER_H
+#define CLIRUNNER_H
+
+#include <memory>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTextStream>
+#include <QTimer>
+#include "app/worker.h"
+
+// Streams a G-code file to a machine without user interaction, then prints some statistics. The
+// objects are the same used by the GUI (see Worker), but here they live in the main thread
+class CliRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Exit codes of shaco-cli
+    enum ExitCode {
+        Success = 0,
+        InvalidArguments = 1,
+        MachineNotFound = 2,
+        StreamError = 3, // The G-code file could not be read or contains invalid lines
+        MachineError = 4, // The machine replied with an error or went in an unexpected state
+        PortError = 5
+    };
+
+public:
+    // If portName is empty the port is discovered as in the GUI. baudRates are tried in order, if
+    // empty those in the settings are used. discoveryTimeoutMillis is the maximum time to wait for
+    // a machine
+    CliRunner(QString gcodeFilename, QString portName, QList<qint32> baudRates, int discoveryTimeoutMillis);
+    // Streams using worker (e.g. one with fake ports in tests)
+    CliRunner(QString gcodeFilename, std::unique_ptr<Worker>&& worker, int discoveryTimeoutMillis);
+
+public slots:
+    // The G-code file is checked first, so that streaming does not fail halfway
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void portFound(MachineInfo* info);
+    void streamingStarted();
+    void streamingEnded(GCodeSender::StreamEndReason reason, QString description);
+    void gcodeRefused(QString description);
+    void portClosedWithError(QString reason);
+    void discoveryTimeout();
+    void slowAck(CommandCorrelationId correlationId, qint64 latencyUs);
+
+private:
+    void printStatistics();
+    // Messages go to stderr, statistics to stdout
+    void printMessage(const QString& message);
+    void finish(ExitCode exitCode);
+
+    const QString m_gcodeFilename;
+    const int m_discoveryTimeoutMillis;
+    QTextStream m_out;
+    QTextStream m_err;
+    const std::unique_ptr<Worker> m_worker;
+    QTimer m_discoveryTimer;
+    QElapsedTimer m_streamingTime;
+    // Values of metrics when streaming starts, statistics are the difference with values at the end
+    qint64 m_commandsSentAtStart;
+    qint64 m_bytesSentAtStart;
+    qint64 m_stallTimeUsAtStart;
+    bool m_finished;
+};
+
+#endif // CLIRUNNER_H
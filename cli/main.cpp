@@ -0,0 +1,88 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QTextStream>
+#include "clirunner.h"
+#include "core/tracerecorder.h"
+
+namespace {
+    constexpr int defaultDiscoveryTimeoutSeconds = 30;
+}
+
+int main(int argc, char *argv[])
+{
+    // The same as the GUI, so that settings are shared
+    QCoreApplication::setOrganizationName("PolyShaper");
+    QCoreApplication::setOrganizationDomain("polyshaper.eu");
+    QCoreApplication::setApplicationName("ShaCo");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCoreApplication app(argc, argv);
+
+    if (qEnvironmentVariableIsSet("SHACO_TRACE")) {
+        TraceRecorder::global().setEnabled(true);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Streams a G-code file to a PolyShaper machine and prints statistics.\n"
+        "Exit codes: 0 success, 1 invalid arguments, 2 machine not found, 3 invalid G-code file, "
+        "4 machine error, 5 serial port error");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("file", "The G-code file to stream");
+    QCommandLineOption portOption(QStringList() << "p" << "port",
+                                  "Use this port (e.g. a pseudo terminal of a simulator) instead of searching for the machine",
+                                  "name");
+    parser.addOption(portOption);
+    QCommandLineOption timeoutOption(QStringList() << "t" << "timeout",
+                                     QString("Seconds to wait for the machine (default %1)").arg(defaultDiscoveryTimeoutSeconds),
+                                     "seconds");
+    parser.addOption(timeoutOption);
+    QCommandLineOption baudRatesOption(QStringList() << "b" << "baud-rates",
+                                       "Comma-separated baud rates to try, in order (default those in the settings)",
+                                       "rates");
+    parser.addOption(baudRatesOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+    const auto args = parser.positionalArguments();
+    if (args.size() != 1) {
+        err << "Exactly one G-code file must be given" << "\n";
+        return CliRunner::InvalidArguments;
+    }
+    if (!QFileInfo(args[0]).isReadable()) {
+        err << "Cannot read " << args[0] << "\n";
+        return CliRunner::InvalidArguments;
+    }
+
+    auto timeoutSeconds = defaultDiscoveryTimeoutSeconds;
+    if (parser.isSet(timeoutOption)) {
+        bool ok;
+        timeoutSeconds = parser.value(timeoutOption).toInt(&ok);
+        if (!ok || timeoutSeconds <= 0) {
+            err << "Invalid timeout: " << parser.value(timeoutOption) << "\n";
+            return CliRunner::InvalidArguments;
+        }
+    }
+
+    QList<qint32> baudRates;
+    if (parser.isSet(baudRatesOption)) {
+        for (const auto& v: parser.value(baudRatesOption).split(',')) {
+            bool ok;
+            const auto rate = v.trimmed().toInt(&ok);
+            if (!ok || rate <= 0) {
+                err << "Invalid baud rate: " << v << "\n";
+                return CliRunner::InvalidArguments;
+            }
+            baudRates.append(rate);
+        }
+    }
+
+    CliRunner runner(args[0], parser.value(portOption), baudRates, timeoutSeconds * 1000);
+    QObject::connect(&runner, &CliRunner::finished, &app, &QCoreApplication::exit, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(&runner, "start", Qt::QueuedConnection);
+
+    return app.exec();
+}
@@ -0,0 +1,266 @@
+#include "clock.h"
+#include <limits>
+#include <QThread>
+
+Timer::Timer()
+    : QObject()
+{
+}
+
+void Timer::start(int msecs)
+{
+    setInterval(msecs);
+    start();
+}
+
+Clock* Clock::realClock()
+{
+    static RealClock clock;
+
+    return &clock;
+}
+
+Clock::~Clock()
+{
+}
+
+RealClock::RealClock(double speedup)
+    : m_speedup(speedup)
+    , m_clock()
+{
+    m_clock.start();
+}
+
+double RealClock::speedup() const
+{
+    return m_speedup;
+}
+
+qint64 RealClock::elapsedUs() const
+{
+    return static_cast<qint64>(m_clock.nsecsElapsed() / 1000 * m_speedup);
+}
+
+std::unique_ptr<Timer> RealClock::createTimer()
+{
+    return std::make_unique<RealTimer>(m_speedup);
+}
+
+void RealClock::sleepUs(unsigned long us)
+{
+    QThread::usleep(static_cast<unsigned long>(us / m_speedup));
+}
+
+VirtualClock::VirtualClock()
+    : m_nowUs(0)
+    , m_timers()
+{
+}
+
+VirtualClock::~VirtualClock()
+{
+    for (auto timer: m_timers) {
+        timer->m_clock = nullptr;
+        timer->m_active = false;
+    }
+}
+
+void VirtualClock::advance(qint64 msecs)
+{
+    const auto untilUs = m_nowUs + msecs * 1000;
+
+    while (auto timer = nextTimer(untilUs)) {
+        m_nowUs = qMax(m_nowUs, timer->m_deadlineUs);
+        fire(timer);
+    }
+
+    m_nowUs = qMax(m_nowUs, untilUs);
+}
+
+bool VirtualClock::advanceToNextTimer()
+{
+    auto timer = nextTimer(std::numeric_limits<qint64>::max());
+    if (timer == nullptr) {
+        return false;
+    }
+
+    m_nowUs = qMax(m_nowUs, timer->m_deadlineUs);
+    fire(timer);
+
+    return true;
+}
+
+int VirtualClock::activeTimers() const
+{
+    int n = 0;
+    for (auto timer: m_timers) {
+        if (timer->m_active) {
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+qint64 VirtualClock::elapsedUs() const
+{
+    return m_nowUs;
+}
+
+std::unique_ptr<Timer> VirtualClock::createTimer()
+{
+    return std::make_unique<VirtualTimer>(this);
+}
+
+void VirtualClock::sleepUs(unsigned long us)
+{
+    m_nowUs += static_cast<qint64>(us);
+}
+
+VirtualTimer* VirtualClock::nextTimer(qint64 untilUs) const
+{
+    // Timers expiring together are fired in the order in which they were created
+    VirtualTimer* next = nullptr;
+    for (auto timer: m_timers) {
+        if (timer->m_active && timer->m_deadlineUs <= untilUs && (next == nullptr || timer->m_deadlineUs < next->m_deadlineUs)) {
+            next = timer;
+        }
+    }
+
+    return next;
+}
+
+void VirtualClock::fire(VirtualTimer* timer)
+{
+    if (timer->m_singleShot) {
+        timer->m_active = false;
+    } else {
+        // A repeating timer with a 0 interval would fire forever without moving time
+        timer->m_deadlineUs = m_nowUs + qMax(timer->m_interval, 1) * 1000;
+    }
+
+    emit timer->timeout();
+}
+
+RealTimer::RealTimer(double speedup)
+    : Timer()
+    , m_speedup(speedup)
+    , m_interval(0)
+    , m_timer()
+{
+    connect(&m_timer, &QTimer::timeout, this, &Timer::timeout);
+}
+
+void RealTimer::setInterval(int msecs)
+{
+    m_interval = msecs;
+    m_timer.setInterval(qRound(msecs / m_speedup));
+}
+
+int RealTimer::interval() const
+{
+    return m_interval;
+}
+
+void RealTimer::setSingleShot(bool singleShot)
+{
+    m_timer.setSingleShot(singleShot);
+}
+
+bool RealTimer::isSingleShot() const
+{
+    return m_timer.isSingleShot();
+}
+
+bool RealTimer::isActive() const
+{
+    return m_timer.isActive();
+}
+
+int RealTimer::remainingTime() const
+{
+    const auto remaining = m_timer.remainingTime();
+
+    return remaining == -1 ? -1 : qRound(remaining * m_speedup);
+}
+
+void RealTimer::start()
+{
+    m_timer.start();
+}
+
+void RealTimer::stop()
+{
+    m_timer.stop();
+}
+
+VirtualTimer::VirtualTimer(VirtualClock* clock)
+    : Timer()
+    , m_clock(clock)
+    , m_interval(0)
+    , m_singleShot(false)
+    , m_active(false)
+    , m_deadlineUs(0)
+{
+    m_clock->m_timers.append(this);
+}
+
+VirtualTimer::~VirtualTimer()
+{
+    if (m_clock) {
+        m_clock->m_timers.removeOne(this);
+    }
+}
+
+void VirtualTimer::setInterval(int msecs)
+{
+    m_interval = msecs;
+
+    if (m_active) {
+        start();
+    }
+}
+
+int VirtualTimer::interval() const
+{
+    return m_interval;
+}
+
+void VirtualTimer::setSingleShot(bool singleShot)
+{
+    m_singleShot = singleShot;
+}
+
+bool VirtualTimer::isSingleShot() const
+{
+    return m_singleShot;
+}
+
+bool VirtualTimer::isActive() const
+{
+    return m_active;
+}
+
+int VirtualTimer::remainingTime() const
+{
+    if (!m_active) {
+        return -1;
+    }
+
+    return static_cast<int>(qMax(Q_INT64_C(0), (m_deadlineUs - m_clock->m_nowUs + 999) / 1000));
+}
+
+void VirtualTimer::start()
+{
+    if (m_clock == nullptr) {
+        return;
+    }
+
+    m_active = true;
+    m_deadlineUs = m_clock->m_nowUs + static_cast<qint64>(m_interval) * 1000;
+}
+
+void VirtualTimer::stop()
+{
+    m_active = false;
+}
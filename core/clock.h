@@ -0,0 +1,159 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <memory>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QtGlobal>
+
+class VirtualTimer;
+
+// A timer created by a Clock. It behaves like QTimer (which is used by the real clock): a single
+// shot timer is stopped when it expires, a repeating one is restarted
+class Timer : public QObject
+{
+    Q_OBJECT
+
+public:
+    Timer();
+
+    virtual void setInterval(int msecs) = 0;
+    virtual int interval() const = 0;
+    virtual void setSingleShot(bool singleShot) = 0;
+    virtual bool isSingleShot() const = 0;
+    virtual bool isActive() const = 0;
+    // Milliseconds left before the timer expires, -1 if not active
+    virtual int remainingTime() const = 0;
+
+public slots:
+    virtual void start() = 0;
+    void start(int msecs);
+    virtual void stop() = 0;
+
+signals:
+    void timeout();
+};
+
+// The source of time for core classes: all timers and sleeps go through a Clock so that tests
+// and simulations can run faster than real time (see RealClock and VirtualClock). Classes take a
+// Clock* defaulting to Clock::realClock(), which must outlive them
+class Clock
+{
+public:
+    // The clock running at real speed, shared by all classes by default
+    static Clock* realClock();
+
+public:
+    virtual ~Clock();
+
+    // Microseconds since an arbitrary point in time, never decreases
+    virtual qint64 elapsedUs() const = 0;
+    // The timer must be used in the thread in which it is created
+    virtual std::unique_ptr<Timer> createTimer() = 0;
+    // Blocks the calling thread
+    virtual void sleepUs(unsigned long us) = 0;
+};
+
+// A clock following real time, possibly faster (e.g. with speedup 10 a timer with an interval of
+// one second expires after 100 real milliseconds). Can be used from any thread
+class RealClock : public Clock
+{
+public:
+    explicit RealClock(double speedup = 1.0);
+
+    double speedup() const;
+
+    qint64 elapsedUs() const override;
+    std::unique_ptr<Timer> createTimer() override;
+    void sleepUs(unsigned long us) override;
+
+private:
+    const double m_speedup;
+    QElapsedTimer m_clock;
+};
+
+// A clock where time only moves when advance() is called: expired timers are fired in order
+// during the call, without waiting. Sleeping moves time forward without firing timers, they fire
+// at the next call of advance(). The clock and its timers must be used from a single thread
+class VirtualClock : public Clock
+{
+public:
+    VirtualClock();
+    ~VirtualClock() override;
+
+    // Moves time forward by msecs milliseconds, firing all timers expiring in the meantime. Timers
+    // started, stopped or deleted while firing are taken into account
+    void advance(qint64 msecs);
+    // Moves time to the expiration of the first active timer and fires it. Returns false (and
+    // does not move time) if no timer is active
+    bool advanceToNextTimer();
+    int activeTimers() const;
+
+    qint64 elapsedUs() const override;
+    std::unique_ptr<Timer> createTimer() override;
+    void sleepUs(unsigned long us) override;
+
+private:
+    friend class VirtualTimer;
+
+    VirtualTimer* nextTimer(qint64 untilUs) const;
+    void fire(VirtualTimer* timer);
+
+    qint64 m_nowUs;
+    QList<VirtualTimer*> m_timers;
+};
+
+// The timer of RealClock
+class RealTimer : public Timer
+{
+    Q_OBJECT
+
+public:
+    explicit RealTimer(double speedup);
+
+    void setInterval(int msecs) override;
+    int interval() const override;
+    void setSingleShot(bool singleShot) override;
+    bool isSingleShot() const override;
+    bool isActive() const override;
+    int remainingTime() const override;
+    void start() override;
+    void stop() override;
+
+private:
+    const double m_speedup;
+    int m_interval;
+    QTimer m_timer;
+};
+
+// The timer of VirtualClock
+class VirtualTimer : public Timer
+{
+    Q_OBJECT
+
+public:
+    explicit VirtualTimer(VirtualClock* clock);
+    ~VirtualTimer() override;
+
+    void setInterval(int msecs) override;
+    int interval() const override;
+    void setSingleShot(bool singleShot) override;
+    bool isSingleShot() const override;
+    bool isActive() const override;
+    int remainingTime() const override;
+    void start() override;
+    void stop() override;
+
+private:
+    friend class VirtualClock;
+
+    VirtualClock* m_clock; // nullptr if the clock has been destroyed
+    int m_interval;
+    bool m_singleShot;
+    bool m_active;
+    qint64 m_deadlineUs;
+};
+
+#endif // CLOCK_H
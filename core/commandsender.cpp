@@ -1,20 +1,83 @@
 #include "commandsender.h"
-#include <QRegularExpression>
+#include <algorithm>
+#include <limits>
+#include "tracerecorder.h"
 
 namespace {
     constexpr int grblBufferSize = 128;
-    const QRegularExpression okRegExpr("^ok$", QRegularExpression::OptimizeOnFirstUsageOption);
-    const QRegularExpression errorRegExpr("^error:([0-9]+)$", QRegularExpression::OptimizeOnFirstUsageOption);
+    // Commands are at least one byte long, so no more than this can be waiting for a reply
+    constexpr int maxSentCommands = grblBufferSize;
+    // GCodeSender keeps about 10 commands in the queue, the queue grows if more are enqueued
+    constexpr int initialCommandsToSendCapacity = 32;
+    // Replies taking longer than this are recorded as this value in session histograms
+    constexpr qint64 maxTrackedAckLatencyUs = 60000000;
+    const char* const okReply = "ok";
+    const char* const errorReplyPrefix = "error:";
+
+    // Returns the code of an error:<code> reply or -1 if message is not an error reply. This and
+    // the check of the ok reply are done on bytes, without converting to QString, to avoid
+    // allocating memory for every reply. Codes too large for an int are returned as 0
+    int errorCode(const QByteArray& message)
+    {
+        const auto prefixSize = static_cast<int>(qstrlen(errorReplyPrefix));
+        if (message.size() == prefixSize || !message.startsWith(errorReplyPrefix)) {
+            return -1;
+        }
+
+        qint64 code = 0;
+        for (auto i = prefixSize; i < message.size(); ++i) {
+            const auto c = message.at(i);
+            if (c < '0' || c > '9') {
+                return -1;
+            }
+
+            if (code <= std::numeric_limits<int>::max()) {
+                code = code * 10 + (c - '0');
+            }
+        }
+
+        return (code <= std::numeric_limits<int>::max()) ? static_cast<int>(code) : 0;
+    }
+
+    bool registerCorrelationId()
+    {
+        static bool registered = false;
+
+        if (!registered) {
+            // Needed to use slowAck in queued connections
+            qRegisterMetaType<CommandCorrelationId>("CommandCorrelationId");
+
+            registered = true;
+        }
+
+        return registered;
+    }
 }
 
+const bool CommandSender::correlationIdRegistered = registerCorrelationId();
+
+constexpr int CommandSender::maxCommandSize;
+
 CommandSenderListener::CommandSenderListener()
 {
 }
 
-CommandSender::CommandSender(MachineCommunication* communicator)
+CommandSender::CommandSender(MachineCommunication* communicator, Clock* clock)
     : m_communicator(communicator)
+    , m_sentCommands(maxSentCommands)
+    , m_listeners()
+    , m_commandsToSend(initialCommandsToSendCapacity)
     , m_sentBytes()
     , m_resettingState(false)
+    , m_nextTraceId(0)
+    , m_clock(clock)
+    , m_sessionAckLatencies(maxTrackedAckLatencyUs, 3)
+    , m_slowAckThresholdUs(0)
+    , m_bytesInFlightGauge(&MetricsRegistry::global().gauge("commandSender.bytesInFlight"))
+    , m_queuedCommandsGauge(&MetricsRegistry::global().gauge("commandSender.queuedCommands"))
+    , m_commandsSentCounter(&MetricsRegistry::global().counter("commandSender.commandsSent"))
+    , m_errorRepliesCounter(&MetricsRegistry::global().counter("commandSender.errorReplies"))
+    , m_ackLatencyHistogram(&MetricsRegistry::global().histogram("commandSender.ackLatencyUs"))
 {
     connect(m_communicator, &MachineCommunication::messageReceived, this, &CommandSender::messageReceived);
     connect(m_communicator, &MachineCommunication::portClosed, this, &CommandSender::resetState);
@@ -24,7 +87,9 @@ CommandSender::CommandSender(MachineCommunication* communicator)
 
 bool CommandSender::sendCommand(QByteArray command, CommandCorrelationId correlationId, CommandSenderListener* listener)
 {
-    if (!validateAndFixCommand(command)) {
+    TRACE_ZONE("CommandSender::sendCommand");
+
+    if (!validateCommand(command)) {
         return false;
     }
 
@@ -33,12 +98,10 @@ bool CommandSender::sendCommand(QByteArray command, CommandCorrelationId correla
         connect(listener, &QObject::destroyed, this, &CommandSender::listenerDestroyed);
     }
 
-    // Never send a new command if there are enqueued ones
-    if (m_commandsToSend.isEmpty() && canSendCommand(command)) {
-        enqueueAndSendCommand(correlationId, listener, command);
-    } else {
-        enqueueCommandToSend(correlationId, listener, command);
-    }
+    // The command is always copied in the queue, it is sent immediately if there are no other
+    // enqueued commands and the buffer of the machine has enough space
+    enqueueCommandToSend(correlationId, listener, command);
+    dequeueCommandsToSend();
 
     return true;
 }
@@ -48,15 +111,37 @@ int CommandSender::pendingCommands() const
     return m_commandsToSend.size();
 }
 
+int CommandSender::sentCommands() const
+{
+    return m_sentCommands.size();
+}
+
+const HdrHistogram& CommandSender::sessionAckLatencies() const
+{
+    return m_sessionAckLatencies;
+}
+
+void CommandSender::setSlowAckThresholdUs(qint64 thresholdUs)
+{
+    m_slowAckThresholdUs = std::max(thresholdUs, Q_INT64_C(0));
+}
+
+qint64 CommandSender::slowAckThresholdUs() const
+{
+    return m_slowAckThresholdUs;
+}
+
 void CommandSender::messageReceived(QByteArray message)
 {
-    if (okRegExpr.match(message).hasMatch()) {
+    TRACE_ZONE("CommandSender::messageReceived");
+
+    if (message == okReply) {
         dequeueSuccessfulCommand();
         dequeueCommandsToSend();
     } else {
-        auto match = errorRegExpr.match(message);
-        if (match.hasMatch()) {
-            dequeueFailedCommand(match.captured(1).toInt());
+        const auto code = errorCode(message);
+        if (code != -1) {
+            dequeueFailedCommand(code);
             dequeueCommandsToSend();
         }
     }
@@ -79,20 +164,30 @@ void CommandSender::resetState()
     callReplyLostAndResetQueue(m_commandsToSend, false);
 
     m_sentBytes = 0;
+    updateQueueGauges();
+
+    if (m_sessionAckLatencies.count() != 0) {
+        qInfo("Reply latency of %lld commands: p50 %lldus, p99 %lldus, max %lldus",
+              m_sessionAckLatencies.count(),
+              m_sessionAckLatencies.valueAtPercentile(50.0),
+              m_sessionAckLatencies.valueAtPercentile(99.0),
+              m_sessionAckLatencies.max());
+        m_sessionAckLatencies.reset();
+    }
+
     m_resettingState = false;
 }
 
-bool CommandSender::validateAndFixCommand(QByteArray& command)
+bool CommandSender::validateCommand(const QByteArray& command) const
 {
-    if (!command.endsWith('\n')) {
-        command.append('\n');
-    }
-
-    if (command.size() > grblBufferSize) {
+    // The final newline is added if missing
+    const auto hasNewline = command.endsWith('\n');
+    if (command.size() + (hasNewline ? 0 : 1) > maxCommandSize) {
         return false;
     }
 
-    if (command.indexOf('\n') != command.size() - 1) {
+    const auto newlinePos = command.indexOf('\n');
+    if (newlinePos != -1 && newlinePos != command.size() - 1) {
         return false;
     }
 
@@ -105,9 +200,13 @@ bool CommandSender::validateAndFixCommand(QByteArray& command)
 
 void CommandSender::enqueueAndSendCommand(CommandCorrelationId correlationId, CommandSenderListener* listener, QByteArray data)
 {
-    m_sentCommands.enqueue(Command{correlationId, listener, data.size()});
+    const auto traceId = m_nextTraceId++;
+    TRACE_ASYNC_BEGIN("Command waiting for reply", traceId);
+    m_sentCommands.enqueue(Command{correlationId, listener, data.size(), traceId, m_clock->elapsedUs()});
     m_sentBytes += data.size();
     m_communicator->writeData(data);
+    m_commandsSentCounter->add();
+    updateQueueGauges();
 
     if (validListener(listener)) {
         listener->commandSent(correlationId);
@@ -135,14 +234,27 @@ void CommandSender::dequeueFailedCommand(int errorCode)
     }
 
     auto command = dequeueSentCommand();
+    m_errorRepliesCounter->add();
     if (validListener(command.listener)) {
         command.listener->errorReply(command.correlationId, errorCode);
     }
 }
 
-void CommandSender::enqueueCommandToSend(CommandCorrelationId correlationId, CommandSenderListener* listener, QByteArray data)
+void CommandSender::enqueueCommandToSend(CommandCorrelationId correlationId, CommandSenderListener* listener, const QByteArray& command)
 {
-    m_commandsToSend.enqueue(CommandToSend{correlationId, listener, data});
+    auto& c = m_commandsToSend.enqueueSlot();
+    c.correlationId = correlationId;
+    c.listener = listener;
+    // This only allocates the first time the element is used or if its previous data is still
+    // referenced somewhere else
+    c.data.reserve(maxCommandSize);
+    c.data.resize(0);
+    c.data.append(command);
+    if (!c.data.endsWith('\n')) {
+        c.data.append('\n');
+    }
+
+    updateQueueGauges();
 }
 
 bool CommandSender::validListener(CommandSenderListener* listener) const
@@ -157,8 +269,18 @@ bool CommandSender::canSendCommand(const QByteArray& command)
 
 CommandSender::Command CommandSender::dequeueSentCommand()
 {
-    auto command = m_sentCommands.dequeue();
+    const auto command = m_sentCommands.head();
+    m_sentCommands.dequeue();
     m_sentBytes -= command.size;
+    TRACE_ASYNC_END("Command waiting for reply", command.traceId);
+    const auto latencyUs = m_clock->elapsedUs() - command.sentAtUs;
+    m_ackLatencyHistogram->record(latencyUs);
+    m_sessionAckLatencies.record(latencyUs);
+    updateQueueGauges();
+
+    if (m_slowAckThresholdUs > 0 && latencyUs > m_slowAckThresholdUs) {
+        emit slowAck(command.correlationId, latencyUs);
+    }
 
     return command;
 }
@@ -166,15 +288,23 @@ CommandSender::Command CommandSender::dequeueSentCommand()
 void CommandSender::dequeueCommandsToSend()
 {
     while (!m_commandsToSend.isEmpty() && canSendCommand(m_commandsToSend.head().data)) {
-        auto c = m_commandsToSend.dequeue();
-        enqueueAndSendCommand(c.correlationId, c.listener, c.data);
+        const auto& c = m_commandsToSend.head();
+        const auto correlationId = c.correlationId;
+        const auto listener = c.listener;
+        // This shares the buffer, the element can be reused by listeners before the command is sent
+        const auto data = c.data;
+        m_commandsToSend.dequeue();
+
+        enqueueAndSendCommand(correlationId, listener, data);
     }
 }
 
 template <class QueueT>
 void CommandSender::callReplyLostAndResetQueue(QueueT& queue, bool commandSent)
 {
-    for (auto& c: queue) {
+    const auto size = queue.size();
+    for (auto i = 0; i < size; ++i) {
+        const auto& c = queue.at(i);
         if (validListener(c.listener)) {
             c.listener->replyLost(c.correlationId, commandSent);
         }
@@ -182,3 +312,9 @@ void CommandSender::callReplyLostAndResetQueue(QueueT& queue, bool commandSent)
 
     queue.clear();
 }
+
+void CommandSender::updateQueueGauges()
+{
+    m_bytesInFlightGauge->set(m_sentBytes);
+    m_queuedCommandsGauge->set(m_commandsToSend.size());
+}
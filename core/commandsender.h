@@ -2,9 +2,12 @@
 #define COMMANDSENDER_H
 
 #include <QObject>
-#include <QQueue>
 #include <QSet>
+#include "clock.h"
+#include "hdrhistogram.h"
 #include "machinecommunication.h"
+#include "metrics.h"
+#include "ringqueue.h"
 
 // TODO-TOMMY Write a class like CommandSender for immediate commands. It also need something like CommandSenderListener to receive replies (use virtual inheritance of QObject for both). This is to put all immediate commands in one place, removing the ones we have in MachineCommunication
 
@@ -23,17 +26,24 @@ public:
 };
 
 // This sends commands and expects an ok or error reply. Only use to send G-CODE commands. Immediate
-// commands and other GRBL commands should be sent directly using MachineCommunication
+// commands and other GRBL commands should be sent directly using MachineCommunication. Commands
+// are copied in preallocated buffers which are reused, so that streaming does not allocate memory
 class CommandSender : public QObject
 {
     Q_OBJECT
 
+private:
+    static const bool correlationIdRegistered;
+
     struct Command {
         CommandCorrelationId correlationId;
         CommandSenderListener* listener;
         int size;
+        quint64 traceId; // Used to pair send and reply in traces
+        qint64 sentAtUs; // See Clock::elapsedUs()
     };
 
+    // Elements of m_commandsToSend are reused, data keeps its buffer of maxCommandSize bytes
     struct CommandToSend {
         CommandCorrelationId correlationId;
         CommandSenderListener* listener;
@@ -41,12 +51,29 @@ class CommandSender : public QObject
     };
 
 public:
-    explicit CommandSender(MachineCommunication* communicator);
+    // The maximum size of a command, including the final newline
+    static constexpr int maxCommandSize = 128;
+
+public:
+    // The time between sending a command and its reply is measured with clock
+    explicit CommandSender(MachineCommunication* communicator, Clock* clock = Clock::realClock());
 
     bool sendCommand(QByteArray command, CommandCorrelationId correlationId = 0, CommandSenderListener* listener = nullptr);
     // These are commands not sent yet. Those sent for which a reply has not been received yet are
     // not counted here
     int pendingCommands() const;
+    // These are commands sent for which a reply has not been received yet
+    int sentCommands() const;
+    // The time between sending a command and receiving its reply, for commands replied since the
+    // last reset (i.e. since the machine was initialized or the port was closed)
+    const HdrHistogram& sessionAckLatencies() const;
+    // slowAck is emitted when a reply arrives more than thresholdUs after the command was sent. 0
+    // (the default) disables the check
+    void setSlowAckThresholdUs(qint64 thresholdUs);
+    qint64 slowAckThresholdUs() const;
+
+signals:
+    void slowAck(CommandCorrelationId correlationId, qint64 latencyUs);
 
 private slots:
     void messageReceived(QByteArray message);
@@ -54,23 +81,34 @@ private slots:
     void resetState();
 
 private:
-    bool validateAndFixCommand(QByteArray& command);
+    bool validateCommand(const QByteArray& command) const;
     void enqueueAndSendCommand(CommandCorrelationId correlationId, CommandSenderListener* listener, QByteArray data);
     void dequeueSuccessfulCommand();
     void dequeueFailedCommand(int errorCode);
-    void enqueueCommandToSend(CommandCorrelationId correlationId, CommandSenderListener* listener, QByteArray data);
+    void enqueueCommandToSend(CommandCorrelationId correlationId, CommandSenderListener* listener, const QByteArray& command);
     bool validListener(CommandSenderListener* listener) const;
     bool canSendCommand(const QByteArray& command);
     Command dequeueSentCommand();
     void dequeueCommandsToSend();
     template <class QueueT> void callReplyLostAndResetQueue(QueueT& queue, bool commandSent);
+    void updateQueueGauges();
 
     MachineCommunication* const m_communicator;
-    QQueue<Command> m_sentCommands;
+    RingQueue<Command> m_sentCommands;
     QSet<QObject*> m_listeners;
-    QQueue<CommandToSend> m_commandsToSend;
+    RingQueue<CommandToSend> m_commandsToSend;
     int m_sentBytes;
     bool m_resettingState;
+    quint64 m_nextTraceId;
+    Clock* const m_clock;
+    HdrHistogram m_sessionAckLatencies;
+    qint64 m_slowAckThresholdUs;
+    // Metrics are in MetricsRegistry::global()
+    Gauge* const m_bytesInFlightGauge;
+    Gauge* const m_queuedCommandsGauge;
+    Counter* const m_commandsSentCounter;
+    Counter* const m_errorRepliesCounter;
+    Histogram* const m_ackLatencyHistogram;
 };
 
 #endif // COMMANDSENDER_H
@@ -0,0 +1,198 @@
+#include "contenthash.h"
+#include <cstring>
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+    const quint64 prime1 = 11400714785074694791ULL;
+    const quint64 prime2 = 14029467366897019727ULL;
+    const quint64 prime3 = 1609587929392839161ULL;
+    const quint64 prime4 = 9650029242287828579ULL;
+    const quint64 prime5 = 2870177450012600261ULL;
+
+    // Files are read in blocks of this size when they cannot be memory-mapped
+    const qint64 readBlockSize = 64 * 1024;
+
+    inline quint64 rotateLeft(quint64 x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline quint64 read64(const char* p)
+    {
+        return qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(p));
+    }
+
+    inline quint32 read32(const char* p)
+    {
+        return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p));
+    }
+
+    inline quint64 round(quint64 accumulator, quint64 input)
+    {
+        accumulator += input * prime2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * prime1;
+    }
+
+    inline quint64 mergeRound(quint64 accumulator, quint64 value)
+    {
+        accumulator ^= round(0, value);
+        return accumulator * prime1 + prime4;
+    }
+}
+
+quint64 XXHash64::hash(const char* data, qint64 length, quint64 seed)
+{
+    XXHash64 h(seed);
+    h.add(data, length);
+
+    return h.result();
+}
+
+quint64 XXHash64::hash(const QByteArray& data, quint64 seed)
+{
+    return hash(data.constData(), data.size(), seed);
+}
+
+XXHash64::XXHash64(quint64 seed)
+    : m_seed(seed)
+    , m_accumulators{seed + prime1 + prime2, seed + prime2, seed, seed - prime1}
+    , m_buffer()
+    , m_bufferSize(0)
+    , m_totalLength(0)
+{
+}
+
+void XXHash64::add(const char* data, qint64 length)
+{
+    m_totalLength += static_cast<quint64>(length);
+
+    // Completing the stripe left from the previous call
+    if (m_bufferSize != 0) {
+        const auto toCopy = static_cast<int>(qMin<qint64>(length, 32 - m_bufferSize));
+        std::memcpy(m_buffer + m_bufferSize, data, static_cast<std::size_t>(toCopy));
+        m_bufferSize += toCopy;
+        data += toCopy;
+        length -= toCopy;
+
+        if (m_bufferSize < 32) {
+            return;
+        }
+
+        processStripe(m_buffer);
+        m_bufferSize = 0;
+    }
+
+    for (; length >= 32; data += 32, length -= 32) {
+        processStripe(data);
+    }
+
+    if (length > 0) {
+        std::memcpy(m_buffer, data, static_cast<std::size_t>(length));
+        m_bufferSize = static_cast<int>(length);
+    }
+}
+
+void XXHash64::add(const QByteArray& data)
+{
+    add(data.constData(), data.size());
+}
+
+quint64 XXHash64::result() const
+{
+    quint64 h;
+
+    if (m_totalLength >= 32) {
+        h = rotateLeft(m_accumulators[0], 1) + rotateLeft(m_accumulators[1], 7) +
+            rotateLeft(m_accumulators[2], 12) + rotateLeft(m_accumulators[3], 18);
+        for (const auto accumulator: m_accumulators) {
+            h = mergeRound(h, accumulator);
+        }
+    } else {
+        h = m_seed + prime5;
+    }
+
+    h += m_totalLength;
+
+    // The bytes that do not fill a stripe
+    const char* p = m_buffer;
+    const char* const end = m_buffer + m_bufferSize;
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotateLeft(h, 27) * prime1 + prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<quint64>(read32(p)) * prime1;
+        h = rotateLeft(h, 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<quint64>(static_cast<uchar>(*p)) * prime5;
+        h = rotateLeft(h, 11) * prime1;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+void XXHash64::processStripe(const char* stripe)
+{
+    for (auto i = 0; i < 4; ++i) {
+        m_accumulators[i] = round(m_accumulators[i], read64(stripe + i * 8));
+    }
+}
+
+quint64 hashFile(const QString& filename, bool* ok)
+{
+    if (ok != nullptr) {
+        *ok = false;
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    XXHash64 h;
+
+    const auto size = file.size();
+    const auto mapped = (size > 0) ? file.map(0, size) : nullptr;
+    if (mapped != nullptr) {
+        h.add(reinterpret_cast<const char*>(mapped), size);
+        file.unmap(mapped);
+    } else {
+        // Empty files or files that cannot be mapped
+        QByteArray block(static_cast<int>(readBlockSize), Qt::Uninitialized);
+        qint64 read;
+        while ((read = file.read(block.data(), readBlockSize)) > 0) {
+            h.add(block.constData(), read);
+        }
+
+        if (read < 0) {
+            return 0;
+        }
+    }
+
+    if (ok != nullptr) {
+        *ok = true;
+    }
+
+    return h.result();
+}
+
+quint64 combineHashes(quint64 h1, quint64 h2)
+{
+    // Same as hashing the two values one after the other
+    char data[16];
+    qToLittleEndian(h1, reinterpret_cast<uchar*>(data));
+    qToLittleEndian(h2, reinterpret_cast<uchar*>(data + 8));
+
+    return XXHash64::hash(data, sizeof(data));
+}
@@ -0,0 +1,43 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+// XXH64, a fast non-cryptographic hash (see https://github.com/Cyan4973/xxHash). It is used to
+// find out whether files have the same content, it must not be used where collisions can be
+// forced on purpose. Data can be added in chunks of any size, the result is the same as hashing
+// all data at once
+class XXHash64
+{
+public:
+    static quint64 hash(const char* data, qint64 length, quint64 seed = 0);
+    static quint64 hash(const QByteArray& data, quint64 seed = 0);
+
+public:
+    explicit XXHash64(quint64 seed = 0);
+
+    void add(const char* data, qint64 length);
+    void add(const QByteArray& data);
+    // Returns the hash of all the data added so far
+    quint64 result() const;
+
+private:
+    void processStripe(const char* stripe);
+
+    const quint64 m_seed;
+    quint64 m_accumulators[4];
+    char m_buffer[32];
+    int m_bufferSize;
+    quint64 m_totalLength;
+};
+
+// Returns the hash of the content of the file. If the file cannot be read, 0 is returned and ok
+// (if not nullptr) is set to false
+quint64 hashFile(const QString& filename, bool* ok = nullptr);
+
+// Combines two hashes in a way that depends on the order of arguments
+quint64 combineHashes(quint64 h1, quint64 h2);
+
+#endif // CONTENTHASH_H
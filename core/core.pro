@@ -6,7 +6,7 @@
 TEMPLATE = lib
 TARGET = core
 CONFIG += staticlib
-QT += serialport
+QT += serialport concurrent network
 QT -= gui
 
 HEADERS += \
@@ -15,21 +15,58 @@ HEADERS += \
     machineinfo.h \
     machinecommunication.h \
     gcodesender.h \
+    gcodevalidationpool.h \
+    gcodevalidator.h \
     wirecontroller.h \
     machinestate.h \
     machinestatusmonitor.h \
+    clock.h \
     commandsender.h \
+    contenthash.h \
     immediatecommands.h \
     localshapesfinder.h \
-    shapeinfo.h
+    hdrhistogram.h \
+    jobserver.h \
+    metrics.h \
+    metricslogger.h \
+    ringqueue.h \
+    shapeinfo.h \
+    shapeindex.h \
+    shapesearchindex.h \
+    statusmirror.h \
+    stringpool.h \
+    terminallog.h \
+    tracerecorder.h \
+    traffictap.h
 SOURCES += \
     serialport.cpp \
     machineinfo.cpp \
     machinecommunication.cpp \
     gcodesender.cpp \
+    gcodevalidationpool.cpp \
+    gcodevalidator.cpp \
     wirecontroller.cpp \
     machinestate.cpp \
     machinestatusmonitor.cpp \
+    clock.cpp \
     commandsender.cpp \
+    contenthash.cpp \
     localshapesfinder.cpp \
-    shapeinfo.cpp
+    hdrhistogram.cpp \
+    jobserver.cpp \
+    metrics.cpp \
+    metricslogger.cpp \
+    shapeinfo.cpp \
+    shapeindex.cpp \
+    shapesearchindex.cpp \
+    statusmirror.cpp \
+    stringpool.cpp \
+    terminallog.cpp \
+    tracerecorder.cpp \
+    traffictap.cpp
+
+# A serial port using the Linux tty interface directly, see NativeSerialPort
+linux {
+    HEADERS += nativeserialport.h
+    SOURCES += nativeserialport.cpp
+}
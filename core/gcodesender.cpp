@@ -5,6 +5,7 @@
 #include <QString>
 #include <QThread>
 #include <QTime>
+#include "tracerecorder.h"
 
 namespace {
     // This is the maximum allowed number commands to send in commandSender
@@ -36,6 +37,10 @@ GCodeSender::GCodeSender(MachineCommunication* communicator, CommandSender* comm
     , m_device(std::move(gcodeDevice))
     , m_running(false)
     , m_startedSendingCommands(false)
+    , m_lineNumber(0)
+    , m_stall()
+    , m_stallTimeCounter(&MetricsRegistry::global().counter("gcodeSender.stallTimeUs"))
+    , m_stallsCounter(&MetricsRegistry::global().counter("gcodeSender.stalls"))
 {
     m_device->setParent(nullptr);
 
@@ -85,6 +90,14 @@ void GCodeSender::stateChanged(MachineState newState)
 
 void GCodeSender::commandSent(CommandCorrelationId)
 {
+    TRACE_ZONE("GCodeSender::commandSent");
+
+    if (m_stall.isValid()) {
+        m_stallTimeCounter->add(m_stall.nsecsElapsed() / 1000);
+        m_stallsCounter->add();
+        m_stall.invalidate();
+    }
+
     readAndSendOneCommand();
 
     while (!m_device->atEnd() && m_commandSender->pendingCommands() <= maxQueuedToSendCommands) {
@@ -92,9 +105,16 @@ void GCodeSender::commandSent(CommandCorrelationId)
     }
 }
 
-void GCodeSender::okReply(CommandCorrelationId)
+void GCodeSender::okReply(CommandCorrelationId correlationId)
 {
-    // Nothing to do here, we stop when machine goes idle again
+    emit lineAcknowledged(correlationId);
+
+    // We stop when machine goes idle again, here we only check whether the machine is starving.
+    // Pending commands are sent right after this reply, so they are not a stall
+    if (m_device && !m_device->atEnd() && m_commandSender->sentCommands() == 0 &&
+            m_commandSender->pendingCommands() == 0 && !m_stall.isValid()) {
+        m_stall.start();
+    }
 }
 
 void GCodeSender::errorReply(CommandCorrelationId, int errorCode)
@@ -113,11 +133,14 @@ void GCodeSender::replyLost(CommandCorrelationId, bool)
 
 void GCodeSender::readAndSendOneCommand()
 {
+    TRACE_ZONE("GCodeSender::readAndSendOneCommand");
+
     if (m_device && !m_device->atEnd()) {
         auto line = m_device->readLine(maxBytesInLine);
+        ++m_lineNumber;
         if (line.isEmpty()) {
             emitStreamingEndedAndReset(StreamEndReason::StreamError, tr("Could not read GCode line from input device"));
-        } else if (!m_commandSender->sendCommand(line, 0, this)) {
+        } else if (!m_commandSender->sendCommand(line, m_lineNumber, this)) {
             emitStreamingEndedAndReset(StreamEndReason::StreamError, tr("Invalid command in GCode stream"));
         }
     }
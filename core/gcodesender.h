@@ -3,12 +3,14 @@
 
 #include <functional>
 #include <memory>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QQueue>
 #include <QString>
 #include "commandsender.h"
 #include "machinecommunication.h"
 #include "machinestatusmonitor.h"
+#include "metrics.h"
 #include "wirecontroller.h"
 
 // This is meant to be used only once: do not restart streaming when it ends
@@ -40,6 +42,8 @@ signals:
     void streamingResumed();
     // Class name needed because type registered with namespace
     void streamingEnded(GCodeSender::StreamEndReason reason, QString description);
+    // Emitted when the machine replies ok to a line. Lines are numbered from 1
+    void lineAcknowledged(CommandCorrelationId lineNumber);
 
 private slots:
     void stateChanged(MachineState newState);
@@ -62,6 +66,13 @@ private:
     std::unique_ptr<QIODevice> m_device; // When reset to NULL, we have finished/interrupted streaming
     bool m_running; // Machine switched to Run state
     bool m_startedSendingCommands; // We went Idle so we started streaming
+    CommandCorrelationId m_lineNumber; // Of the last line read, the first line is 1
+    // Valid while no command is waiting for a reply but there are still lines to send, i.e.
+    // while the machine could be starving
+    QElapsedTimer m_stall;
+    // Metrics are in MetricsRegistry::global()
+    Counter* const m_stallTimeCounter;
+    Counter* const m_stallsCounter;
 };
 
 Q_DECLARE_METATYPE(GCodeSender::StreamEndReason)
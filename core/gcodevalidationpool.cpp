@@ -0,0 +1,69 @@
+#include "gcodevalidationpool.h"
+#include <QRunnable>
+#include <QThread>
+
+namespace {
+    class ValidationJob : public QRunnable
+    {
+    public:
+        ValidationJob(GCodeValidationPool& pool, QString key, quint64 tag, QString filename, double workpieceDimX, double workpieceDimY)
+            : m_pool(pool)
+            , m_key(key)
+            , m_tag(tag)
+            , m_filename(filename)
+            , m_validator(workpieceDimX, workpieceDimY)
+        {
+        }
+
+        void run() override
+        {
+            // Signals emitted from another thread are queued to the receivers
+            emit m_pool.validated(m_key, m_tag, m_validator.validateFile(m_filename));
+        }
+
+    private:
+        GCodeValidationPool& m_pool;
+        const QString m_key;
+        const quint64 m_tag;
+        const QString m_filename;
+        const GCodeValidator m_validator;
+    };
+
+    bool registerGCodeCheck()
+    {
+        static bool registered = false;
+
+        if (!registered) {
+            qRegisterMetaType<GCodeCheck>();
+
+            registered = true;
+        }
+
+        return registered;
+    }
+}
+
+GCodeValidationPool::GCodeValidationPool(int maxThreads)
+    : QObject()
+    , m_pool()
+{
+    registerGCodeCheck();
+
+    m_pool.setMaxThreadCount(maxThreads > 0 ? maxThreads : qMax(1, QThread::idealThreadCount() / 2));
+}
+
+GCodeValidationPool::~GCodeValidationPool()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void GCodeValidationPool::validate(QString key, quint64 tag, QString filename, double workpieceDimX, double workpieceDimY)
+{
+    m_pool.start(new ValidationJob(*this, key, tag, filename, workpieceDimX, workpieceDimY));
+}
+
+void GCodeValidationPool::waitForDone()
+{
+    m_pool.waitForDone();
+}
@@ -0,0 +1,34 @@
+#ifndef GCODEVALIDATIONPOOL_H
+#define GCODEVALIDATIONPOOL_H
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include "gcodevalidator.h"
+
+// Validates G-code files with GCodeValidator in a thread pool. The validated signal is emitted
+// in the thread of this object. Jobs not started yet are discarded when the pool is destroyed
+class GCodeValidationPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // By default half of the cores are used, so that validating a large library does not slow
+    // down the rest of the application
+    explicit GCodeValidationPool(int maxThreads = 0);
+    ~GCodeValidationPool() override;
+
+    // key and tag are returned with the result, they are not used otherwise
+    void validate(QString key, quint64 tag, QString filename, double workpieceDimX, double workpieceDimY);
+    // Waits until all jobs have been run, mainly useful for tests. Signals are still delivered
+    // through the event loop
+    void waitForDone();
+
+signals:
+    void validated(QString key, quint64 tag, GCodeCheck check);
+
+private:
+    QThreadPool m_pool;
+};
+
+#endif // GCODEVALIDATIONPOOL_H
@@ -0,0 +1,447 @@
+#include "gcodevalidator.h"
+#include <cstring>
+#include <QFile>
+#include "commandsender.h"
+
+namespace {
+    // Moves can exit the workpiece by this amount (in mm) without a warning, to ignore rounding
+    const double boundsTolerance = 0.001;
+    const double mmPerInch = 25.4;
+
+    // Modal groups of G and M codes (as bits, to check that a line has at most one code per
+    // group). These are the groups of GRBL 1.1
+    enum ModalGroup : unsigned int {
+        NoGroup = 0,
+        MotionGroup = 1u << 0,
+        PlaneGroup = 1u << 1,
+        DistanceGroup = 1u << 2,
+        FeedRateModeGroup = 1u << 3,
+        UnitsGroup = 1u << 4,
+        NonModalGroup = 1u << 5,
+        CoordinateSystemGroup = 1u << 6,
+        StopGroup = 1u << 7,
+        SpindleGroup = 1u << 8,
+        CoolantGroup = 1u << 9,
+        ArcDistanceGroup = 1u << 10,
+        ToolLengthOffsetGroup = 1u << 11,
+        CutterCompensationGroup = 1u << 12,
+        ControlModeGroup = 1u << 13
+    };
+
+    // Motion modes that are not moves along a line or an arc
+    const int motionModeProbe = 38;
+    const int motionModeCancel = 80;
+
+    // The state of the machine that is kept from one line to the next
+    struct MachineModel
+    {
+        int motionMode = 0;
+        bool absolute = true;
+        bool inches = false;
+        bool inverseTime = false;
+        bool feedRateSet = false;
+        double x = 0.0; // in mm
+        double y = 0.0; // in mm
+    };
+
+    // The words in a line
+    struct Line
+    {
+        unsigned int groups = 0;
+        unsigned int words = 0; // One bit per letter
+        int motionMode = -1;
+        bool axisWordsAreParameters = false; // e.g. for G92, G28 or G43.1 axis words are not a move
+        int units = -1;
+        int distance = -1;
+        int feedRateMode = -1;
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    inline unsigned int wordBit(char letter)
+    {
+        return 1u << (letter - 'A');
+    }
+
+    const unsigned int axisWords = wordBit('X') | wordBit('Y') | wordBit('Z') | wordBit('A') | wordBit('B') | wordBit('C');
+    const unsigned int arcWords = wordBit('I') | wordBit('J') | wordBit('K') | wordBit('R');
+    const unsigned int otherWords = wordBit('F') | wordBit('S') | wordBit('T') | wordBit('P') | wordBit('L') | wordBit('N');
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    bool parseNumber(const char*& p, const char* end, double& value)
+    {
+        while (p != end && isSpace(*p)) {
+            ++p;
+        }
+
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        bool digits = false;
+        double v = 0.0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            v = v * 10.0 + (*p - '0');
+            digits = true;
+        }
+        if (p != end && *p == '.') {
+            ++p;
+            double scale = 0.1;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+                v += (*p - '0') * scale;
+                scale /= 10.0;
+                digits = true;
+            }
+        }
+
+        value = negative ? -v : v;
+
+        return digits;
+    }
+
+    // The G codes supported by GRBL 1.1
+    bool parseGCode(double value, Line& line, QString& error)
+    {
+        const auto code = static_cast<int>(value);
+        const auto fraction = static_cast<int>((value - code) * 10.0 + 0.5);
+
+        ModalGroup group = NoGroup;
+        if (fraction != 0) {
+            if (code == motionModeProbe && fraction >= 2 && fraction <= 5) {
+                group = MotionGroup;
+                line.motionMode = code;
+            } else if (fraction == 1 && (code == 28 || code == 30 || code == 92)) {
+                // G28.1 and G30.1 store the current position, G92.1 resets offsets
+                group = NonModalGroup;
+                line.axisWordsAreParameters = true;
+            } else if (fraction == 1 && code == 43) {
+                group = ToolLengthOffsetGroup;
+                line.axisWordsAreParameters = true;
+            } else if (fraction == 1 && code == 91) {
+                // Incremental arc distance mode, the only one GRBL supports
+                group = ArcDistanceGroup;
+            }
+        } else if ((code >= 0 && code <= 3) || code == motionModeCancel) {
+            group = MotionGroup;
+            line.motionMode = code;
+        } else if (code >= 17 && code <= 19) {
+            group = PlaneGroup;
+        } else if (code == 20 || code == 21) {
+            group = UnitsGroup;
+            line.units = code;
+        } else if (code == 90 || code == 91) {
+            group = DistanceGroup;
+            line.distance = code;
+        } else if (code == 93 || code == 94) {
+            group = FeedRateModeGroup;
+            line.feedRateMode = code;
+        } else if (code == 4 || code == 10 || code == 28 || code == 30 || code == 53 || code == 92) {
+            group = NonModalGroup;
+            line.axisWordsAreParameters = true;
+        } else if (code >= 54 && code <= 59) {
+            group = CoordinateSystemGroup;
+        } else if (code == 40) {
+            group = CutterCompensationGroup;
+        } else if (code == 49) {
+            group = ToolLengthOffsetGroup;
+        } else if (code == 61) {
+            group = ControlModeGroup;
+        }
+
+        if (group == NoGroup) {
+            error = QString("Unsupported command G%1").arg(value);
+            return false;
+        }
+
+        if ((line.groups & group) != 0) {
+            error = "Two commands of the same modal group in one line";
+            return false;
+        }
+        line.groups |= group;
+
+        return true;
+    }
+
+    // The M codes supported by GRBL 1.1
+    bool parseMCode(double value, Line& line, QString& error)
+    {
+        const auto code = static_cast<int>(value);
+
+        ModalGroup group = NoGroup;
+        if (code != value) {
+            group = NoGroup;
+        } else if (code == 0 || code == 1 || code == 2 || code == 30) {
+            group = StopGroup;
+        } else if (code >= 3 && code <= 5) {
+            group = SpindleGroup;
+        } else if (code >= 7 && code <= 9) {
+            group = CoolantGroup;
+        }
+
+        if (group == NoGroup) {
+            error = QString("Unsupported command M%1").arg(value);
+            return false;
+        }
+
+        if ((line.groups & group) != 0) {
+            error = "Two commands of the same modal group in one line";
+            return false;
+        }
+        line.groups |= group;
+
+        return true;
+    }
+
+    // Parses the words in [begin, end) and updates the machine. Returns false if the line is
+    // invalid, outOfBounds is set to true if the line moves outside the workpiece
+    bool checkLine(const char* begin, const char* end, MachineModel& machine, double workpieceDimX,
+                   double workpieceDimY, QString& error, bool& outOfBounds)
+    {
+        Line line;
+
+        const char* p = begin;
+        while (p != end && isSpace(*p)) {
+            ++p;
+        }
+
+        // GRBL system commands (e.g. $H or $J=...) are not G-code. Lines starting with % mark the
+        // start or end of the program and are ignored
+        if (p != end && (*p == '$' || *p == '%')) {
+            return true;
+        }
+
+        while (p != end) {
+            const char c = *p;
+
+            if (isSpace(c)) {
+                ++p;
+                continue;
+            } else if (c == ';') {
+                break;
+            } else if (c == '(') {
+                const auto close = static_cast<const char*>(std::memchr(p, ')', static_cast<std::size_t>(end - p)));
+                if (close == nullptr) {
+                    error = "Comment not closed";
+                    return false;
+                }
+                p = close + 1;
+                continue;
+            }
+
+            const char letter = (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+            if (letter < 'A' || letter > 'Z') {
+                error = QString("Unexpected character '%1'").arg(QChar::fromLatin1(c));
+                return false;
+            }
+
+            ++p;
+            double value;
+            if (!parseNumber(p, end, value)) {
+                error = QString("Invalid number after %1").arg(QChar::fromLatin1(letter));
+                return false;
+            }
+
+            if (letter == 'G') {
+                if (!parseGCode(value, line, error)) {
+                    return false;
+                }
+                continue;
+            } else if (letter == 'M') {
+                if (!parseMCode(value, line, error)) {
+                    return false;
+                }
+                continue;
+            }
+
+            const auto bit = wordBit(letter);
+            if ((bit & (axisWords | arcWords | otherWords)) == 0) {
+                error = QString("Unsupported word %1").arg(QChar::fromLatin1(letter));
+                return false;
+            }
+            if ((line.words & bit) != 0) {
+                error = QString("Word %1 repeated in one line").arg(QChar::fromLatin1(letter));
+                return false;
+            }
+            line.words |= bit;
+
+            if (letter == 'X') {
+                line.x = value;
+            } else if (letter == 'Y') {
+                line.y = value;
+            }
+        }
+
+        // Modal changes take effect before the move in the same line
+        if (line.units != -1) {
+            machine.inches = (line.units == 20);
+        }
+        if (line.distance != -1) {
+            machine.absolute = (line.distance == 90);
+        }
+        if (line.feedRateMode != -1) {
+            machine.inverseTime = (line.feedRateMode == 93);
+            machine.feedRateSet = false;
+        }
+        const bool hasFeedRate = (line.words & wordBit('F')) != 0;
+        if (hasFeedRate) {
+            machine.feedRateSet = true;
+        }
+        if (line.motionMode != -1) {
+            machine.motionMode = line.motionMode;
+        }
+
+        const bool hasAxisWords = (line.words & axisWords) != 0;
+        if (!hasAxisWords || line.axisWordsAreParameters) {
+            return true;
+        }
+
+        if (machine.motionMode == motionModeCancel) {
+            error = "Axis words without a motion command";
+            return false;
+        } else if (machine.motionMode == motionModeProbe) {
+            return true;
+        }
+
+        if (machine.motionMode != 0 && (machine.inverseTime ? !hasFeedRate : !machine.feedRateSet)) {
+            error = "Feed rate not set";
+            return false;
+        }
+
+        if ((machine.motionMode == 2 || machine.motionMode == 3) && (line.words & arcWords) == 0) {
+            error = "Arc without radius or center";
+            return false;
+        }
+
+        // Only the end point of arcs is checked
+        const double scale = machine.inches ? mmPerInch : 1.0;
+        if ((line.words & wordBit('X')) != 0) {
+            machine.x = (machine.absolute ? 0.0 : machine.x) + line.x * scale;
+        }
+        if ((line.words & wordBit('Y')) != 0) {
+            machine.y = (machine.absolute ? 0.0 : machine.y) + line.y * scale;
+        }
+
+        if (workpieceDimX > 0.0 && (machine.x < -boundsTolerance || machine.x > workpieceDimX + boundsTolerance)) {
+            outOfBounds = true;
+        }
+        if (workpieceDimY > 0.0 && (machine.y < -boundsTolerance || machine.y > workpieceDimY + boundsTolerance)) {
+            outOfBounds = true;
+        }
+
+        return true;
+    }
+
+    GCodeCheck makeCheck(GCodeCheck::Verdict verdict, quint32 line, QString message)
+    {
+        GCodeCheck check;
+        check.verdict = verdict;
+        check.line = line;
+        check.message = message;
+
+        return check;
+    }
+}
+
+QDataStream& operator<<(QDataStream& stream, const GCodeCheck& check)
+{
+    stream << static_cast<quint8>(check.verdict) << check.line << check.message;
+
+    return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, GCodeCheck& check)
+{
+    quint8 verdict;
+    stream >> verdict >> check.line >> check.message;
+
+    check.verdict = (verdict <= static_cast<quint8>(GCodeCheck::Verdict::Invalid)) ?
+                static_cast<GCodeCheck::Verdict>(verdict) : GCodeCheck::Verdict::Unchecked;
+
+    return stream;
+}
+
+GCodeValidator::GCodeValidator(double workpieceDimX, double workpieceDimY)
+    : m_workpieceDimX(workpieceDimX)
+    , m_workpieceDimY(workpieceDimY)
+{
+}
+
+GCodeCheck GCodeValidator::validate(const char* data, qint64 size) const
+{
+    auto check = makeCheck(GCodeCheck::Verdict::Valid, 0, QString());
+    MachineModel machine;
+
+    const char* p = data;
+    const char* const end = data + size;
+    quint32 lineNumber = 0;
+    while (p != end) {
+        ++lineNumber;
+
+        const auto newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        const char* lineEnd = (newline == nullptr) ? end : newline;
+        const char* const next = (newline == nullptr) ? end : newline + 1;
+
+        // GCodeSender reads the file in text mode, so \r\n becomes \n
+        if (lineEnd != p && *(lineEnd - 1) == '\r') {
+            --lineEnd;
+        }
+
+        // The newline is sent too (it is added if missing)
+        if (lineEnd - p + 1 > CommandSender::maxCommandSize) {
+            return makeCheck(GCodeCheck::Verdict::Invalid, lineNumber,
+                             QString("Line longer than %1 bytes").arg(CommandSender::maxCommandSize - 1));
+        }
+
+        if (std::memchr(p, '\r', static_cast<std::size_t>(lineEnd - p)) != nullptr) {
+            return makeCheck(GCodeCheck::Verdict::Invalid, lineNumber, "Carriage return in the middle of a line");
+        }
+
+        QString error;
+        bool outOfBounds = false;
+        if (!checkLine(p, lineEnd, machine, m_workpieceDimX, m_workpieceDimY, error, outOfBounds)) {
+            return makeCheck(GCodeCheck::Verdict::Invalid, lineNumber, error);
+        }
+
+        if (outOfBounds && check.verdict == GCodeCheck::Verdict::Valid) {
+            check = makeCheck(GCodeCheck::Verdict::Warning, lineNumber, "Move outside the workpiece");
+        }
+
+        p = next;
+    }
+
+    return check;
+}
+
+GCodeCheck GCodeValidator::validate(const QByteArray& gcode) const
+{
+    return validate(gcode.constData(), gcode.size());
+}
+
+GCodeCheck GCodeValidator::validateFile(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return makeCheck(GCodeCheck::Verdict::Invalid, 0, "Cannot read file " + filename);
+    }
+
+    const auto size = file.size();
+    if (size == 0) {
+        return validate(nullptr, 0);
+    }
+
+    const auto mapped = file.map(0, size);
+    if (mapped == nullptr) {
+        return validate(file.readAll());
+    }
+
+    const auto check = validate(reinterpret_cast<const char*>(mapped), size);
+    file.unmap(mapped);
+
+    return check;
+}
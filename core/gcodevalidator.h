@@ -0,0 +1,62 @@
+#ifndef GCODEVALIDATOR_H
+#define GCODEVALIDATOR_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QMetaType>
+#include <QString>
+
+// The result of the validation of a G-code file
+struct GCodeCheck
+{
+    enum class Verdict : quint8 {
+        Unchecked,
+        Valid,
+        Warning, // The file can be streamed, but it is probably wrong (e.g. it exits the workpiece)
+        Invalid // Streaming the file would fail
+    };
+
+    Verdict verdict = Verdict::Unchecked;
+    quint32 line = 0; // The line of the first problem (starting from 1), 0 if there is none
+    QString message; // The description of the first problem
+
+    bool operator==(const GCodeCheck& other) const
+    {
+        return verdict == other.verdict && line == other.line && message == other.message;
+    }
+
+    bool operator!=(const GCodeCheck& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+Q_DECLARE_METATYPE(GCodeCheck)
+
+QDataStream& operator<<(QDataStream& stream, const GCodeCheck& check);
+QDataStream& operator>>(QDataStream& stream, GCodeCheck& check);
+
+// Checks a G-code file before it is streamed. A file is invalid if a line would be refused by
+// CommandSender (too long or with a carriage return not at the end) or by the firmware (words
+// that are not valid, modal group violations, moves without a feed rate, arcs without radius or
+// center). Commands are those of GRBL 1.1, system commands ($) and % lines are accepted. Moves
+// whose end point is outside the workpiece only give a warning. Lines are split with memchr,
+// which is vectorized by the C library
+class GCodeValidator
+{
+public:
+    // Dimensions of the workpiece in mm, the origin is in a corner. If a dimension is not
+    // positive moves are not checked along that axis
+    GCodeValidator(double workpieceDimX, double workpieceDimY);
+
+    GCodeCheck validate(const char* data, qint64 size) const;
+    GCodeCheck validate(const QByteArray& gcode) const;
+    // The file is memory-mapped if possible
+    GCodeCheck validateFile(const QString& filename) const;
+
+private:
+    const double m_workpieceDimX;
+    const double m_workpieceDimY;
+};
+
+#endif // GCODEVALIDATOR_H
@@ -0,0 +1,163 @@
+#include "hdrhistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QtAlgorithms>
+
+HdrHistogram::HdrHistogram(qint64 highestTrackableValue, int significantDigits)
+    : m_highestTrackableValue(std::max(highestTrackableValue, Q_INT64_C(2)))
+    , m_subBucketHalfCountMagnitude(0)
+    , m_subBucketHalfCount(0)
+    , m_subBucketMask(0)
+    , m_counts()
+    , m_count(0)
+    , m_sum(0)
+    , m_min(0)
+    , m_max(0)
+    , m_clampedValues(0)
+{
+    significantDigits = std::min(std::max(significantDigits, 1), 5);
+
+    // The number of sub buckets must be enough to distinguish values that differ by one unit in
+    // the last significant digit
+    const auto largestValueWithSingleUnitResolution = 2 * static_cast<qint64>(std::pow(10, significantDigits));
+    const auto subBucketCountMagnitude = static_cast<int>(std::ceil(std::log2(static_cast<double>(largestValueWithSingleUnitResolution))));
+    m_subBucketHalfCountMagnitude = std::max(subBucketCountMagnitude, 1) - 1;
+    const qint64 subBucketCount = Q_INT64_C(1) << (m_subBucketHalfCountMagnitude + 1);
+    m_subBucketHalfCount = subBucketCount / 2;
+    m_subBucketMask = subBucketCount - 1;
+
+    // Each bucket covers twice the range of the previous one
+    qint64 smallestUntrackableValue = subBucketCount;
+    int bucketsNeeded = 1;
+    while (smallestUntrackableValue <= m_highestTrackableValue) {
+        if (smallestUntrackableValue > std::numeric_limits<qint64>::max() / 2) {
+            ++bucketsNeeded;
+            break;
+        }
+        smallestUntrackableValue <<= 1;
+        ++bucketsNeeded;
+    }
+
+    m_counts.resize(static_cast<int>((bucketsNeeded + 1) * m_subBucketHalfCount));
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+}
+
+void HdrHistogram::record(qint64 value)
+{
+    value = std::max(value, Q_INT64_C(0));
+    if (value > m_highestTrackableValue) {
+        value = m_highestTrackableValue;
+        ++m_clampedValues;
+    }
+
+    ++m_counts[countsIndex(value)];
+
+    m_min = (m_count == 0) ? value : std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    ++m_count;
+    m_sum += value;
+}
+
+void HdrHistogram::reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = 0;
+    m_max = 0;
+    m_clampedValues = 0;
+}
+
+qint64 HdrHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 HdrHistogram::min() const
+{
+    return m_min;
+}
+
+qint64 HdrHistogram::max() const
+{
+    return m_max;
+}
+
+double HdrHistogram::mean() const
+{
+    return (m_count == 0) ? 0.0 : static_cast<double>(m_sum) / static_cast<double>(m_count);
+}
+
+qint64 HdrHistogram::valueAtPercentile(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    const auto countAtPercentile = std::max(static_cast<qint64>(percentile / 100.0 * m_count + 0.5), Q_INT64_C(1));
+
+    qint64 total = 0;
+    for (auto i = 0; i < m_counts.size(); ++i) {
+        total += m_counts[i];
+        if (total >= countAtPercentile) {
+            return std::min(highestEquivalentValue(valueFromIndex(i)), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+qint64 HdrHistogram::clampedValues() const
+{
+    return m_clampedValues;
+}
+
+qint64 HdrHistogram::lowestEquivalentValue(qint64 value) const
+{
+    const auto b = bucketIndex(value);
+
+    return static_cast<qint64>(subBucketIndex(value, b)) << b;
+}
+
+qint64 HdrHistogram::highestEquivalentValue(qint64 value) const
+{
+    return lowestEquivalentValue(value) + (Q_INT64_C(1) << bucketIndex(value)) - 1;
+}
+
+int HdrHistogram::bucketIndex(qint64 value) const
+{
+    // The number of bits needed to represent the value, but never less than those of a sub bucket
+    const auto bits = 64 - qCountLeadingZeroBits(static_cast<quint64>(value | m_subBucketMask));
+
+    return bits - (m_subBucketHalfCountMagnitude + 1);
+}
+
+int HdrHistogram::subBucketIndex(qint64 value, int bucketIndex) const
+{
+    return static_cast<int>(value >> bucketIndex);
+}
+
+int HdrHistogram::countsIndex(qint64 value) const
+{
+    // The first half of sub buckets of all buckets but the first overlaps with the previous bucket,
+    // so it is not stored
+    const auto b = bucketIndex(value);
+    const auto s = subBucketIndex(value, b);
+    const auto bucketBaseIndex = (b + 1) << m_subBucketHalfCountMagnitude;
+
+    return bucketBaseIndex + s - static_cast<int>(m_subBucketHalfCount);
+}
+
+qint64 HdrHistogram::valueFromIndex(int index) const
+{
+    auto b = (index >> m_subBucketHalfCountMagnitude) - 1;
+    auto s = (index & (static_cast<int>(m_subBucketHalfCount) - 1)) + static_cast<int>(m_subBucketHalfCount);
+    if (b < 0) {
+        s -= static_cast<int>(m_subBucketHalfCount);
+        b = 0;
+    }
+
+    return static_cast<qint64>(s) << b;
+}
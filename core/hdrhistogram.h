@@ -0,0 +1,56 @@
+#ifndef HDRHISTOGRAM_H
+#define HDRHISTOGRAM_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// A histogram with High Dynamic Range, as described in http://hdrhistogram.org: values between 0
+// and highestTrackableValue are recorded keeping the given number of significant digits (e.g.
+// with 3 digits, 123456 is counted as a value between 123392 and 123519). Recording a value
+// takes constant time and never allocates. Values above highestTrackableValue are recorded as
+// highestTrackableValue. This is not thread safe, see Histogram in metrics.h for a histogram that
+// can be shared among threads
+class HdrHistogram
+{
+public:
+    // significantDigits must be between 1 and 5
+    HdrHistogram(qint64 highestTrackableValue, int significantDigits);
+
+    // Negative values are recorded as 0
+    void record(qint64 value);
+    void reset();
+
+    qint64 count() const;
+    // The exact minimum and maximum recorded values (0 if empty)
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    // The highest value (with the precision of the histogram, but never more than max()) below
+    // which the given percentage (between 0 and 100) of values falls. Returns 0 if empty
+    qint64 valueAtPercentile(double percentile) const;
+    // Values which have been clamped to highestTrackableValue
+    qint64 clampedValues() const;
+
+    // The range of values that are counted together with value
+    qint64 lowestEquivalentValue(qint64 value) const;
+    qint64 highestEquivalentValue(qint64 value) const;
+
+private:
+    int bucketIndex(qint64 value) const;
+    int subBucketIndex(qint64 value, int bucketIndex) const;
+    int countsIndex(qint64 value) const;
+    qint64 valueFromIndex(int index) const;
+
+    const qint64 m_highestTrackableValue;
+    int m_subBucketHalfCountMagnitude;
+    qint64 m_subBucketHalfCount;
+    qint64 m_subBucketMask;
+    QVector<qint64> m_counts;
+    qint64 m_count;
+    qint64 m_sum;
+    qint64 m_min;
+    qint64 m_max;
+    qint64 m_clampedValues;
+};
+
+#endif // HDRHISTOGRAM_H
@@ -0,0 +1,416 @@
+#include "jobserver.h"
+#include <QFileInfo>
+#include <QtDebug>
+#include <QtEndian>
+#include "shapeinfo.h"
+
+namespace {
+    bool registerTypes()
+    {
+        static bool registered = false;
+
+        if (!registered) {
+            qRegisterMetaType<JobServer::JobId>("JobServer::JobId");
+
+            registered = true;
+        }
+
+        return registered;
+    }
+
+    QDataStream& setupStream(QDataStream& stream)
+    {
+        stream.setVersion(JobServer::dataStreamVersion);
+
+        return stream;
+    }
+
+    // Removes the final endline and the carriage return, if present
+    QByteArray trimEndline(QByteArray message)
+    {
+        while (message.endsWith('\n') || message.endsWith('\r')) {
+            message.chop(1);
+        }
+
+        return message;
+    }
+}
+
+constexpr int JobServer::dataStreamVersion;
+constexpr int JobServer::maxFrameSize;
+constexpr int JobServer::maxStreamedJobSize;
+constexpr qint64 JobServer::maxPendingBytesPerClient;
+
+const bool JobServer::typesRegistered = registerTypes();
+
+JobServer::JobServer(QString serverName, MachineCommunication* communicator, MachineStatusMonitor* statusMonitor, int feedIntervalMillis)
+    : m_serverName(serverName)
+    , m_communicator(communicator)
+    , m_statusMonitor(statusMonitor)
+    , m_server()
+    , m_clients()
+    , m_subscribers(0)
+    , m_nextJobId(1)
+    , m_feedTimer()
+{
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    m_feedTimer.setInterval(feedIntervalMillis);
+    m_feedTimer.setSingleShot(true);
+
+    connect(&m_server, &QLocalServer::newConnection, this, &JobServer::newConnection);
+    connect(&m_feedTimer, &QTimer::timeout, this, &JobServer::flushFeed);
+    connect(m_statusMonitor, &MachineStatusMonitor::stateChanged, this, &JobServer::stateChanged);
+}
+
+JobServer::~JobServer()
+{
+    // Sockets are children of the server, make sure we are not notified while being destroyed
+    for (auto socket: m_clients.keys()) {
+        socket->disconnect(this);
+    }
+}
+
+bool JobServer::listen()
+{
+    if (m_server.listen(m_serverName)) {
+        return true;
+    }
+
+    if (m_server.serverError() != QAbstractSocket::AddressInUseError) {
+        return false;
+    }
+
+    // Perhaps a socket left by a crash. If another instance is running, we cannot connect to it
+    QLocalSocket probe;
+    probe.connectToServer(m_serverName);
+    if (probe.waitForConnected(100)) {
+        return false;
+    }
+
+    QLocalServer::removeServer(m_serverName);
+
+    return m_server.listen(m_serverName);
+}
+
+QString JobServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+QString JobServer::fullServerName() const
+{
+    return m_server.fullServerName();
+}
+
+int JobServer::subscribers() const
+{
+    return m_subscribers;
+}
+
+QByteArray JobServer::frame(MessageType type, const QByteArray& fields)
+{
+    QByteArray data(static_cast<int>(sizeof(quint32)), '\0');
+    qToBigEndian(static_cast<quint32>(fields.size() + 1), reinterpret_cast<uchar*>(data.data()));
+    data.append(static_cast<char>(type));
+    data.append(fields);
+
+    return data;
+}
+
+void JobServer::jobStarted(JobServer::JobId jobId)
+{
+    flushFeed();
+
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << jobId;
+
+    sendToSubscribers(frame(MessageType::JobStarted, fields), false);
+}
+
+void JobServer::jobProgress(JobServer::JobId jobId, quint32 acknowledgedLines)
+{
+    if (m_subscribers == 0) {
+        return;
+    }
+
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << jobId << acknowledgedLines;
+
+    m_pendingProgress = frame(MessageType::JobProgress, fields);
+    scheduleFlush();
+}
+
+void JobServer::jobEnded(JobServer::JobId jobId, GCodeSender::StreamEndReason reason, QString description)
+{
+    // The last progress must arrive before the end of the job
+    flushFeed();
+
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << jobId << static_cast<quint8>(reason) << description;
+
+    sendToSubscribers(frame(MessageType::JobEnded, fields), false);
+}
+
+void JobServer::newConnection()
+{
+    while (m_server.hasPendingConnections()) {
+        auto socket = m_server.nextPendingConnection();
+        m_clients.insert(socket, Client());
+
+        connect(socket, &QLocalSocket::readyRead, this, &JobServer::readFrames);
+        connect(socket, &QLocalSocket::disconnected, this, &JobServer::clientDisconnected);
+
+        // Data might have arrived before we connected to readyRead
+        if (socket->bytesAvailable() > 0) {
+            QMetaObject::invokeMethod(this, "readFrames", Qt::QueuedConnection);
+        }
+    }
+}
+
+void JobServer::readFrames()
+{
+    // When invoked directly, sender() is null and all clients are checked
+    auto sockets = m_clients.keys();
+    if (auto s = qobject_cast<QLocalSocket*>(sender())) {
+        sockets = QList<QLocalSocket*>{s};
+    }
+
+    for (auto socket: sockets) {
+        auto it = m_clients.find(socket);
+        if (it == m_clients.end()) {
+            continue;
+        }
+
+        auto& client = it.value();
+        client.readBuffer += socket->readAll();
+
+        const auto headerSize = static_cast<int>(sizeof(quint32));
+        int start = 0;
+        bool valid = true;
+        while (valid && client.readBuffer.size() - start >= headerSize) {
+            const auto size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(client.readBuffer.constData() + start));
+            if (size == 0 || size > static_cast<quint32>(maxFrameSize)) {
+                valid = false;
+                break;
+            }
+            if (client.readBuffer.size() - start - headerSize < static_cast<int>(size)) {
+                break;
+            }
+
+            valid = processFrame(socket, client, client.readBuffer.mid(start + headerSize, static_cast<int>(size)));
+            start += headerSize + static_cast<int>(size);
+        }
+
+        if (!valid) {
+            qWarning() << "Closing job server connection after an invalid message";
+            client.readBuffer.clear();
+            socket->disconnectFromServer();
+        } else {
+            client.readBuffer.remove(0, start);
+        }
+    }
+}
+
+void JobServer::clientDisconnected()
+{
+    auto socket = qobject_cast<QLocalSocket*>(sender());
+    auto it = m_clients.find(socket);
+    if (it == m_clients.end()) {
+        return;
+    }
+
+    if (it.value().subscribed) {
+        --m_subscribers;
+        if (m_subscribers == 0) {
+            disconnect(m_communicator, &MachineCommunication::messageReceived, this, &JobServer::messageReceived);
+            m_feedTimer.stop();
+            m_pendingStatusReport.clear();
+            m_pendingProgress.clear();
+        }
+    }
+
+    m_clients.erase(it);
+    socket->deleteLater();
+}
+
+void JobServer::stateChanged(MachineState newState)
+{
+    if (m_subscribers == 0) {
+        return;
+    }
+
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << static_cast<quint8>(newState);
+
+    sendToSubscribers(frame(MessageType::StateChanged, fields), false);
+}
+
+void JobServer::messageReceived(QByteArray message)
+{
+    if (!message.startsWith('<')) {
+        return;
+    }
+
+    // Only the last one is kept
+    m_pendingStatusReport = frame(MessageType::StatusReport, trimEndline(message));
+    scheduleFlush();
+}
+
+void JobServer::flushFeed()
+{
+    m_feedTimer.stop();
+
+    if (!m_pendingProgress.isEmpty()) {
+        sendToSubscribers(m_pendingProgress, true);
+        m_pendingProgress.clear();
+    }
+
+    if (!m_pendingStatusReport.isEmpty()) {
+        sendToSubscribers(m_pendingStatusReport, true);
+        m_pendingStatusReport.clear();
+    }
+}
+
+bool JobServer::processFrame(QLocalSocket* socket, Client& client, const QByteArray& payload)
+{
+    const auto type = static_cast<MessageType>(payload[0]);
+    const auto fields = payload.mid(1);
+
+    switch (type) {
+        case MessageType::SubmitFile: {
+            QDataStream stream(fields);
+            QString filename;
+            setupStream(stream) >> filename;
+            if (stream.status() != QDataStream::Ok) {
+                return false;
+            }
+            submitFile(socket, filename);
+            return true;
+        }
+        case MessageType::BeginStream:
+            client.streaming = true;
+            client.streamedGCode.clear();
+            return true;
+        case MessageType::StreamData:
+            if (!client.streaming) {
+                return false;
+            }
+            // Keep reading to stay in sync with the client, the job is rejected at the end
+            if (client.streamedGCode.size() <= maxStreamedJobSize) {
+                client.streamedGCode += fields;
+            }
+            return true;
+        case MessageType::EndStream:
+            if (!client.streaming) {
+                return false;
+            }
+            submitStreamedJob(socket, client);
+            return true;
+        case MessageType::Subscribe:
+            subscribe(client);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void JobServer::submitFile(QLocalSocket* socket, const QString& filename)
+{
+    auto gcodeFilename = filename;
+
+    if (filename.endsWith(".psj", Qt::CaseInsensitive)) {
+        const auto info = ShapeInfo::createFromFile(filename);
+        if (!info.isValid()) {
+            reject(socket, tr("Invalid shape file: ") + filename);
+            return;
+        }
+        gcodeFilename = info.path() + "/" + info.gcodeFilename();
+    }
+
+    if (!QFileInfo(gcodeFilename).isReadable()) {
+        reject(socket, tr("Cannot read G-code file: ") + gcodeFilename);
+        return;
+    }
+
+    const auto jobId = m_nextJobId++;
+    accept(socket, jobId);
+    emit fileJobSubmitted(jobId, gcodeFilename);
+}
+
+void JobServer::submitStreamedJob(QLocalSocket* socket, Client& client)
+{
+    QByteArray gcode;
+    gcode.swap(client.streamedGCode);
+    client.streaming = false;
+
+    if (gcode.size() > maxStreamedJobSize) {
+        reject(socket, tr("G-code too large"));
+        return;
+    }
+
+    const auto jobId = m_nextJobId++;
+    accept(socket, jobId);
+    emit streamedJobSubmitted(jobId, gcode);
+}
+
+void JobServer::accept(QLocalSocket* socket, JobId jobId)
+{
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << jobId;
+
+    socket->write(frame(MessageType::JobAccepted, fields));
+}
+
+void JobServer::reject(QLocalSocket* socket, const QString& reason)
+{
+    QByteArray fields;
+    QDataStream stream(&fields, QIODevice::WriteOnly);
+    setupStream(stream) << reason;
+
+    socket->write(frame(MessageType::JobRejected, fields));
+}
+
+void JobServer::subscribe(Client& client)
+{
+    if (client.subscribed) {
+        return;
+    }
+
+    client.subscribed = true;
+    ++m_subscribers;
+
+    if (m_subscribers == 1) {
+        connect(m_communicator, &MachineCommunication::messageReceived, this, &JobServer::messageReceived);
+    }
+}
+
+void JobServer::sendToSubscribers(const QByteArray& data, bool skipSlowClients)
+{
+    // Writing might cause a disconnection, which modifies m_clients
+    QList<QLocalSocket*> sockets;
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        if (it.value().subscribed) {
+            sockets.append(it.key());
+        }
+    }
+
+    for (auto socket: sockets) {
+        if (skipSlowClients && socket->bytesToWrite() > maxPendingBytesPerClient) {
+            continue;
+        }
+
+        socket->write(data);
+    }
+}
+
+void JobServer::scheduleFlush()
+{
+    if (!m_feedTimer.isActive()) {
+        m_feedTimer.start();
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <memory>
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "gcodesender.h"
+#include "machinecommunication.h"
+#include "machinestate.h"
+#include "machinestatusmonitor.h"
+
+// A local socket (a Unix domain socket or a named pipe on Windows) through which other programs
+// running as the same user can submit jobs and follow their execution.
+//
+// Every message is a frame: a quint32 with the size of the payload followed by the payload. The
+// payload starts with a quint8 with the message type, followed by the fields serialized with
+// QDataStream (version dataStreamVersion, big endian). Client to server messages:
+//   SubmitFile   QString filename (.gcode, or .psj to stream the G-code of the shape). Replies
+//                JobAccepted or JobRejected
+//   BeginStream  Starts a job whose G-code is sent with StreamData messages, nothing is written to
+//                disk
+//   StreamData   Raw G-code (not serialized with QDataStream)
+//   EndStream    Ends the G-code started with BeginStream. Replies JobAccepted or JobRejected
+//   Subscribe    Starts receiving events
+// Server to client messages:
+//   JobAccepted  quint32 jobId
+//   JobRejected  QString reason
+//   StateChanged quint8 MachineState
+//   JobStarted   quint32 jobId
+//   JobProgress  quint32 jobId, quint32 number of lines acknowledged by the machine
+//   JobEnded     quint32 jobId, quint8 GCodeSender::StreamEndReason, QString description. Sent
+//                without JobStarted if the G-code is refused before streaming
+//   StatusReport The status report as received from the machine, without the final endline
+//
+// Status reports and progress are coalesced: only the last ones are sent, at most once every
+// feedIntervalMillis milliseconds, so high rate updates cost little and slow clients never fall
+// behind (events are not sent to clients that are not reading them). Status reports are only
+// collected while there are subscribers. The server must live in the same thread as
+// MachineCommunication, which should not be the GUI thread. Jobs are not executed here: whoever
+// executes them must call jobStarted(), jobProgress() and jobEnded()
+class JobServer : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const bool typesRegistered;
+
+public:
+    using JobId = quint32;
+
+    enum class MessageType : quint8 {
+        SubmitFile = 0x01,
+        BeginStream = 0x02,
+        StreamData = 0x03,
+        EndStream = 0x04,
+        Subscribe = 0x05,
+        JobAccepted = 0x81,
+        JobRejected = 0x82,
+        StateChanged = 0x90,
+        JobStarted = 0x91,
+        JobProgress = 0x92,
+        JobEnded = 0x93,
+        StatusReport = 0x94
+    };
+
+    static constexpr int dataStreamVersion = QDataStream::Qt_5_6;
+    // Larger frames cause the connection to be closed
+    static constexpr int maxFrameSize = 1024 * 1024;
+    // Larger streamed jobs are rejected
+    static constexpr int maxStreamedJobSize = 64 * 1024 * 1024;
+    // Coalesced events are not sent to clients with more than this bytes still to be written
+    static constexpr qint64 maxPendingBytesPerClient = 64 * 1024;
+
+public:
+    JobServer(QString serverName, MachineCommunication* communicator, MachineStatusMonitor* statusMonitor, int feedIntervalMillis);
+    ~JobServer() override;
+
+    // Returns false if the server could not be started (see errorString()). A stale socket with
+    // the same name (e.g. left by a crash) is removed
+    bool listen();
+    QString errorString() const;
+    QString fullServerName() const;
+    int subscribers() const;
+
+    // Builds a frame, used by clients too
+    static QByteArray frame(MessageType type, const QByteArray& fields = QByteArray());
+
+public slots:
+    void jobStarted(JobServer::JobId jobId);
+    void jobProgress(JobServer::JobId jobId, quint32 acknowledgedLines);
+    void jobEnded(JobServer::JobId jobId, GCodeSender::StreamEndReason reason, QString description);
+
+signals:
+    void fileJobSubmitted(JobServer::JobId jobId, QString gcodeFilename);
+    void streamedJobSubmitted(JobServer::JobId jobId, QByteArray gcode);
+
+private slots:
+    void newConnection();
+    void readFrames();
+    void clientDisconnected();
+    void stateChanged(MachineState newState);
+    void messageReceived(QByteArray message);
+    void flushFeed();
+
+private:
+    struct Client {
+        QByteArray readBuffer;
+        bool subscribed = false;
+        bool streaming = false;
+        QByteArray streamedGCode;
+    };
+
+    bool processFrame(QLocalSocket* socket, Client& client, const QByteArray& payload);
+    void submitFile(QLocalSocket* socket, const QString& filename);
+    void submitStreamedJob(QLocalSocket* socket, Client& client);
+    void accept(QLocalSocket* socket, JobId jobId);
+    void reject(QLocalSocket* socket, const QString& reason);
+    void subscribe(Client& client);
+    void sendToSubscribers(const QByteArray& data, bool skipSlowClients);
+    void scheduleFlush();
+
+    const QString m_serverName;
+    MachineCommunication* const m_communicator;
+    MachineStatusMonitor* const m_statusMonitor;
+    QLocalServer m_server;
+    QHash<QLocalSocket*, Client> m_clients;
+    int m_subscribers;
+    JobId m_nextJobId;
+    QTimer m_feedTimer;
+    // Coalesced events, empty if nothing new
+    QByteArray m_pendingStatusReport;
+    QByteArray m_pendingProgress;
+};
+
+#endif // JOBSERVER_H
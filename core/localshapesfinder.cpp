@@ -1,20 +1,134 @@
 #include "localshapesfinder.h"
+#include <algorithm>
+#include <functional>
+#include <QDebug>
 #include <QDir>
+#include <QDirIterator>
 #include <QFile>
+#include <QVector>
+#include <QtConcurrent>
+#include "contenthash.h"
+#include "tracerecorder.h"
 
-LocalShapesFinder::LocalShapesFinder(QString path)
+namespace {
+    // How often directories that cannot be watched are checked for changes
+    const int pollIntervalMillis = 5000;
+    // Results of G-code validation are grouped for this time before being notified
+    const int checkedShapesIntervalMillis = 200;
+    // Saving the index rewrites it entirely, so results of G-code validation are saved when the
+    // validation ends, or after this time if it takes longer
+    const int checkedShapesSaveIntervalMillis = 30000;
+
+    // Checks that the files of the shape exist. Files in scanned directories are looked up in
+    // dirFiles (names of files by directory), to avoid hitting the filesystem for each shape
+    bool filesExist(const ShapeInfo& info, const QHash<QString, const QSet<QString>*>& dirFiles)
+    {
+        const auto files = dirFiles.value(info.path(), nullptr);
+        const auto fileExists = [&info, files](const QString& filename) {
+            if (files != nullptr && !filename.contains('/')) {
+                return files->contains(filename);
+            }
+
+            return QFile::exists(info.path() + "/" + filename);
+        };
+
+        return fileExists(info.gcodeFilename()) && fileExists(info.svgFilename());
+    }
+
+    // Parses the shape and computes the hashes of its files, metadata is set to the metadata of
+    // the files. If a shape with the same .psj content is in the index, it is not parsed again
+    ShapeInfo loadAndHashShape(const QString& psjFilename, const FileMetadata& psjMetadata, const ShapeIndex* index, ShapeFilesMetadata& metadata)
+    {
+        TRACE_ZONE("loadAndHashShape");
+
+        metadata = ShapeFilesMetadata{psjMetadata, FileMetadata(), FileMetadata()};
+
+        QFile file(psjFilename);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return ShapeInfo();
+        }
+
+        const auto content = file.readAll();
+        const auto psjHash = XXHash64::hash(content);
+
+        ShapeInfo info;
+        const auto copy = (index != nullptr) ? index->lookupByPsjHash(psjHash) : ShapeInfo();
+        if (copy.isValid()) {
+            const QFileInfo fileInfo(psjFilename);
+            info = copy.withLocation(fileInfo.canonicalPath(), fileInfo.fileName());
+        } else {
+            info = ShapeInfo::createFromData(psjFilename, content);
+        }
+
+        if (!info.isValid()) {
+            return info;
+        }
+
+        // Taken before hashing, so that files modified while hashing are loaded again later
+        metadata = ShapeFilesMetadata::fromShape(psjMetadata, info);
+
+        // Missing files are checked later, here the hash is simply 0
+        const auto gcodeHash = hashFile(info.path() + "/" + info.gcodeFilename());
+        const auto svgHash = hashFile(info.path() + "/" + info.svgFilename());
+
+        return info.withContentHashes(psjHash, gcodeHash, svgHash);
+    }
+
+    bool isSameOrSubdirectory(const QString& dir, const QString& parent)
+    {
+        return dir == parent || (dir.startsWith(parent) && dir.at(parent.size()) == '/');
+    }
+}
+
+LocalShapesFinder::LocalShapesFinder(QString path, QString indexFilename, int debounceMillis, bool recursive, bool loadInBackground)
     : m_path(path)
+    , m_recursive(recursive)
+    , m_loadInBackground(loadInBackground)
+    , m_index(indexFilename.isEmpty() ? nullptr : new ShapeIndex(indexFilename))
+    , m_indexChanged(false)
+    , m_pendingValidations(0)
+    , m_scanning(false)
+    , m_fullLoadPending(false)
+    , m_pendingFullLoadUsesIndex(false)
+    , m_validationPool()
 {
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(debounceMillis);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &LocalShapesFinder::updateShapes);
+
+    m_pollTimer.setInterval(pollIntervalMillis);
+    connect(&m_pollTimer, &QTimer::timeout, this, &LocalShapesFinder::pollUnwatchedDirectories);
+
+    m_checkedShapesTimer.setSingleShot(true);
+    m_checkedShapesTimer.setInterval(checkedShapesIntervalMillis);
+    connect(&m_checkedShapesTimer, &QTimer::timeout, this, &LocalShapesFinder::flushCheckedShapes);
+    m_indexSaveTimer.setSingleShot(true);
+    m_indexSaveTimer.setInterval(checkedShapesSaveIntervalMillis);
+    connect(&m_indexSaveTimer, &QTimer::timeout, this, &LocalShapesFinder::saveIndexIfChanged);
+    connect(&m_validationPool, &GCodeValidationPool::validated, this, &LocalShapesFinder::gcodeValidated);
+    connect(&m_scanWatcher, &QFutureWatcher<ScanResult>::finished, this, &LocalShapesFinder::scanFinished);
+
     // Creating directory if it doesn't exist
     QDir::root().mkpath(m_path);
 
-    // Adding now to make sure it has been created
-    m_watcher.addPath(m_path);
-
     connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &LocalShapesFinder::directoryChanged);
 
-    // Load initial dir content
-    reload();
+    if (m_index) {
+        m_index->load();
+    }
+
+    // Load initial dir content, shapes that did not change are taken from the index. This also
+    // starts watching directories
+    loadAllShapes(true);
+}
+
+LocalShapesFinder::~LocalShapesFinder()
+{
+    // The scan uses this object (e.g. to list directories)
+    m_scanWatcher.waitForFinished();
+
+    // Results of G-code validation might not have been saved yet
+    saveIndexIfChanged();
 }
 
 const QMap<QString, ShapeInfo>& LocalShapesFinder::shapes() const
@@ -22,94 +136,644 @@ const QMap<QString, ShapeInfo>& LocalShapesFinder::shapes() const
     return m_shapes;
 }
 
+QStringList LocalShapesFinder::directories() const
+{
+    return m_dirs.keys();
+}
+
 void LocalShapesFinder::reload()
 {
-    QDir dir(m_path);
+    loadAllShapes(false);
+}
+
+bool LocalShapesFinder::isLoading() const
+{
+    return m_scanning;
+}
 
-    if (dirRemoved(dir)) {
+void LocalShapesFinder::directoryChanged(const QString& path)
+{
+    m_changedDirs.insert(path);
+
+    if (m_debounceTimer.interval() == 0) {
+        updateShapes();
+    } else if (!m_debounceTimer.isActive()) {
+        // Not restarting the timer if already active, so that a long burst of changes does not
+        // delay the update indefinitely
+        m_debounceTimer.start();
+    }
+}
+
+void LocalShapesFinder::updateShapes()
+{
+    TRACE_ZONE("LocalShapesFinder::updateShapes");
+
+    if (m_scanning) {
+        // Changed directories are scanned when the running scan ends
+        return;
+    }
+
+    if (dirRemoved()) {
         return;
     }
 
+    // Only rescanning directories we know of (others have already been removed)
+    QStringList changedDirs;
+    for (const auto& dir: m_changedDirs) {
+        if (m_dirs.contains(dir)) {
+            changedDirs.append(dir);
+        }
+    }
+    m_changedDirs.clear();
+
+    if (changedDirs.isEmpty()) {
+        return;
+    }
+
+    if (!m_loadInBackground) {
+        applyChanges(scanChanges(changedDirs, m_dirs, m_shapes, m_index.get()));
+        return;
+    }
+
+    // The scan works on copies, which are cheap because containers are implicitly shared
+    startScan([this, changedDirs, dirs = m_dirs, shapes = m_shapes, index = indexSnapshot()]() {
+        return scanChanges(changedDirs, dirs, shapes, index.get());
+    });
+}
+
+void LocalShapesFinder::scanFinished()
+{
+    m_scanning = false;
+    const auto result = m_scanWatcher.result();
+    if (result.fullLoad) {
+        applyFullLoad(result);
+    } else {
+        applyChanges(result);
+    }
+
+    // Requests received while scanning
+    if (m_fullLoadPending) {
+        m_fullLoadPending = false;
+        loadAllShapes(m_pendingFullLoadUsesIndex);
+    } else if (!m_changedDirs.isEmpty()) {
+        updateShapes();
+    }
+}
+
+void LocalShapesFinder::pollUnwatchedDirectories()
+{
+    if (m_unwatchedDirs.isEmpty()) {
+        m_pollTimer.stop();
+        return;
+    }
+
+    m_changedDirs.unite(m_unwatchedDirs);
+    updateShapes();
+}
+
+void LocalShapesFinder::gcodeValidated(QString key, quint64 gcodeHash, GCodeCheck check)
+{
+    --m_pendingValidations;
+    storeGCodeCheck(key, gcodeHash, check);
+
+    if (m_pendingValidations == 0) {
+        m_indexSaveTimer.stop();
+        saveIndexIfChanged();
+    }
+}
+
+void LocalShapesFinder::storeGCodeCheck(const QString& key, quint64 gcodeHash, const GCodeCheck& check)
+{
+    // The shape could have been removed or changed in the meantime
+    const auto it = m_shapes.find(key);
+    if (it == m_shapes.end() || it.value().gcodeHash() != gcodeHash ||
+            it.value().gcodeCheck().verdict != GCodeCheck::Verdict::Unchecked) {
+        return;
+    }
+
+    it.value() = it.value().withGCodeCheck(check);
+
+    if (m_index && m_index->update(key, it.value())) {
+        m_indexChanged = true;
+        if (!m_indexSaveTimer.isActive()) {
+            m_indexSaveTimer.start();
+        }
+    }
+
+    m_checkedShapes.insert(key);
+    if (!m_checkedShapesTimer.isActive()) {
+        m_checkedShapesTimer.start();
+    }
+}
+
+void LocalShapesFinder::flushCheckedShapes()
+{
+    if (!m_checkedShapes.isEmpty()) {
+        emit shapesChecked(m_checkedShapes);
+        m_checkedShapes.clear();
+    }
+}
+
+void LocalShapesFinder::loadAllShapes(bool useIndex)
+{
+    TRACE_ZONE("LocalShapesFinder::loadAllShapes");
+
+    if (m_scanning) {
+        // The index is only used if all requests allow it
+        m_pendingFullLoadUsesIndex = useIndex && (m_pendingFullLoadUsesIndex || !m_fullLoadPending);
+        m_fullLoadPending = true;
+        return;
+    }
+
+    if (dirRemoved()) {
+        return;
+    }
+
+    if (!m_loadInBackground) {
+        applyFullLoad(scanAll(useIndex, m_index.get()));
+        return;
+    }
+
+    startScan([this, useIndex, index = indexSnapshot()]() {
+        return scanAll(useIndex, index.get());
+    });
+}
+
+void LocalShapesFinder::startScan(std::function<ScanResult()> scan)
+{
+    m_scanning = true;
+    m_scanWatcher.setFuture(QtConcurrent::run(scan));
+}
+
+std::shared_ptr<const ShapeIndex> LocalShapesFinder::indexSnapshot() const
+{
+    if (!m_index) {
+        return nullptr;
+    }
+
+    return std::make_shared<const ShapeIndex>(*m_index);
+}
+
+LocalShapesFinder::ScanResult LocalShapesFinder::scanAll(bool useIndex, const ShapeIndex* index) const
+{
+    ScanResult result{true, useIndex, walk(QDir(m_path).canonicalPath()), QVector<DirContent>(), QVector<ScannedFile>(), QVector<LoadedShape>()};
+
+    for (const auto& content: result.contents) {
+        result.toLoad += content.shapes;
+    }
+
+    result.loadedShapes = loadShapes(result.toLoad, useIndex ? index : nullptr);
+
+    return result;
+}
+
+LocalShapesFinder::ScanResult LocalShapesFinder::scanChanges(const QStringList& changedDirs, const DirsMetadata& dirs, const QMap<QString, ShapeInfo>& shapes, const ShapeIndex* index) const
+{
+    const std::function<DirContent(const QString&)> list = [this](const QString& dir) {
+        return listDirContent(dir);
+    };
+
+    ScanResult result{false, true, QtConcurrent::blockingMapped<QVector<DirContent>>(changedDirs, list), QVector<DirContent>(), QVector<ScannedFile>(), QVector<LoadedShape>()};
+
+    for (const auto& content: result.contents) {
+        const auto dirIt = dirs.constFind(content.path);
+        if (!content.exists || dirIt == dirs.cend()) {
+            continue;
+        }
+
+        // Only loading new files, files that changed and files that were not valid (e.g. because
+        // the gcode file was not there yet)
+        const auto& files = dirIt.value();
+        QVector<ScannedFile> unchanged;
+        for (const auto& f: content.shapes) {
+            const auto it = files.constFind(f.key);
+            if (it == files.cend() || it.value().psj != f.metadata || !shapes.contains(f.key)) {
+                result.toLoad.append(f);
+            } else {
+                unchanged.append(f);
+            }
+        }
+
+        // The G-code and SVG files of a shape can change even if its .psj file did not
+        const std::function<bool(const ScannedFile&)> otherFilesChanged = [&files, &shapes](const ScannedFile& f) {
+            return ShapeFilesMetadata::fromShape(f.metadata, shapes.value(f.key)) != files.value(f.key);
+        };
+        result.toLoad += QtConcurrent::blockingFiltered(unchanged, otherFilesChanged);
+
+        for (const auto& subdir: content.subdirs) {
+            if (!dirs.contains(subdir)) {
+                result.newDirsContents += walk(subdir);
+            }
+        }
+    }
+
+    for (const auto& content: result.newDirsContents) {
+        result.toLoad += content.shapes;
+    }
+
+    result.loadedShapes = loadShapes(result.toLoad, index);
+
+    return result;
+}
+
+void LocalShapesFinder::applyFullLoad(const ScanResult& result)
+{
     const auto initialShapes = m_shapes.keys().toSet();
 
-    m_shapes.clear(); // This is needed so that loadNewShapes loads all shapes
-    m_shapes = loadNewShapes(listAllShapesInDir(dir));
+    if (m_index && !result.useIndex) {
+        // Everything is reloaded, also the index must be rebuilt
+        m_index->clear();
+        m_indexChanged = true;
+    }
+
+    const auto loadedMetadata = metadataOfLoadedShapes(result);
+    DirsMetadata dirs;
+    QSet<QString> allFiles;
+    for (const auto& content: result.contents) {
+        auto& files = dirs[content.path];
+
+        for (const auto& f: content.shapes) {
+            files.insert(f.key, loadedMetadata.value(f.key));
+            allFiles.insert(f.key);
+        }
+    }
+
+    m_shapes = storeLoadedShapes(result.toLoad, result.loadedShapes, result.contents);
+
+    // Updating watched directories
+    QStringList oldDirs;
+    for (const auto& dir: m_dirs.keys()) {
+        if (!dirs.contains(dir)) {
+            oldDirs.append(dir);
+        }
+    }
+    unwatchDirectories(oldDirs);
+    QStringList newDirs;
+    for (const auto& dir: dirs.keys()) {
+        if (!m_dirs.contains(dir)) {
+            newDirs.append(dir);
+        }
+    }
+    m_dirs = dirs;
+    watchDirectories(newDirs);
+
+    if (m_index) {
+        // Removing entries of files that no longer exist
+        if (m_index->retainOnly(allFiles)) {
+            m_indexChanged = true;
+        }
+
+        saveIndexIfChanged();
+    }
+
+    validateGCode(m_shapes.keys().toSet());
 
     if (!initialShapes.isEmpty() || !m_shapes.isEmpty()) {
         emit shapesUpdated(m_shapes.keys().toSet(), initialShapes);
     }
 }
 
-void LocalShapesFinder::directoryChanged()
+void LocalShapesFinder::applyChanges(const ScanResult& result)
 {
-    QDir dir(m_path);
+    const auto loadedMetadata = metadataOfLoadedShapes(result);
+    QSet<QString> newShapes;
+    QSet<QString> removedShapes;
+    for (const auto& content: result.contents) {
+        if (!content.exists) {
+            removeDirectory(content.path, removedShapes);
+            continue;
+        }
 
-    if (dirRemoved(dir)) {
-        return;
+        // The directory could have been removed as a subdirectory of another one
+        if (!m_dirs.contains(content.path)) {
+            continue;
+        }
+
+        auto& files = m_dirs[content.path];
+        QSet<QString> currentFiles;
+        currentFiles.reserve(content.shapes.size());
+        for (const auto& f: content.shapes) {
+            currentFiles.insert(f.key);
+
+            // Files that were not loaded did not change
+            const auto it = loadedMetadata.constFind(f.key);
+            if (it != loadedMetadata.cend()) {
+                files.insert(f.key, it.value());
+            }
+        }
+
+        for (auto it = files.begin(); it != files.end();) {
+            if (currentFiles.contains(it.key())) {
+                ++it;
+                continue;
+            }
+
+            if (m_shapes.remove(it.key()) != 0) {
+                removedShapes.insert(it.key());
+            }
+
+            if (m_index) {
+                m_index->remove(it.key());
+                m_indexChanged = true;
+            }
+
+            it = files.erase(it);
+        }
+
+        // Subdirectories that were removed (new ones have been walked by the scan)
+        const auto currentSubdirs = content.subdirs.toSet();
+        for (const auto& dir: m_dirs.keys()) {
+            const auto relative = dir.mid(content.path.size() + 1);
+            const bool isChild = isSameOrSubdirectory(dir, content.path) && dir != content.path && !relative.contains('/');
+
+            if (isChild && !currentSubdirs.contains(dir)) {
+                removeDirectory(dir, removedShapes);
+            }
+        }
     }
 
-    const auto initialShapes = m_shapes.keys().toSet();
-    const auto currentShapes = listAllShapesInDir(dir);
+    QStringList newDirs;
+    for (const auto& content: result.newDirsContents) {
+        auto& files = m_dirs[content.path];
+
+        for (const auto& f: content.shapes) {
+            files.insert(f.key, loadedMetadata.value(f.key));
+        }
+
+        newDirs.append(content.path);
+    }
+    watchDirectories(newDirs);
+
+    const auto loadedShapes = storeLoadedShapes(result.toLoad, result.loadedShapes, result.contents + result.newDirsContents);
+
+    for (const auto& f: result.toLoad) {
+        const bool wasLoaded = m_shapes.contains(f.key);
+        const auto it = loadedShapes.constFind(f.key);
+
+        if (it != loadedShapes.cend()) {
+            const auto contentHash = it.value().contentHash();
+            if (wasLoaded && contentHash != 0 && m_shapes.value(f.key).contentHash() == contentHash) {
+                // The file was rewritten with the same content (e.g. imported again), nothing
+                // to report
+                m_shapes.insert(f.key, it.value());
+                continue;
+            }
+
+            // A modified shape is reported as removed and new
+            if (wasLoaded) {
+                removedShapes.insert(f.key);
+            }
+            newShapes.insert(f.key);
+            m_shapes.insert(f.key, it.value());
+        } else if (wasLoaded) {
+            removedShapes.insert(f.key);
+            m_shapes.remove(f.key);
+        }
+    }
+
+    saveIndexIfChanged();
+    validateGCode(newShapes);
+
+    if (!newShapes.isEmpty() || !removedShapes.isEmpty()) {
+        emit shapesUpdated(newShapes, removedShapes);
+    }
+}
+
+LocalShapesFinder::DirContent LocalShapesFinder::listDirContent(const QString& dirPath) const
+{
+    DirContent content;
+    content.path = dirPath;
+    content.exists = QFileInfo(dirPath).isDir();
+
+    if (!content.exists) {
+        return content;
+    }
+
+    // Listing the directory only once. Only symbolic links need to be resolved to get the
+    // canonical path of a file, for the others it is enough to use the canonical directory path
+    const auto filters = m_recursive ? (QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot) : QDir::Files;
+    QDirIterator it(dirPath, filters);
+    while (it.hasNext()) {
+        it.next();
+        const auto info = it.fileInfo();
+        const auto name = info.fileName();
+
+        if (info.isDir()) {
+            // Not following links to directories, to avoid cycles
+            if (!info.isSymLink()) {
+                content.subdirs.append(dirPath + "/" + name);
+            }
+
+            continue;
+        }
 
-    const auto newShapes = loadNewShapes(currentShapes);
-    m_shapes.unite(newShapes);
+        content.files.insert(name);
 
-    const auto missingShapes = initialShapes - currentShapes;
-    for (const auto& toRemove: missingShapes) {
-        m_shapes.remove(toRemove);
+        if (info.suffix().compare("psj", Qt::CaseInsensitive) == 0) {
+            const auto canonicalFilePath = info.isSymLink() ? info.canonicalFilePath() : (dirPath + "/" + name);
+
+            if (!canonicalFilePath.isEmpty()) {
+                content.shapes.append(ScannedFile{canonicalFilePath, info, FileMetadata()});
+            }
+        }
     }
 
-    if (!newShapes.isEmpty() || !missingShapes.isEmpty()) {
-        emit shapesUpdated(m_shapes.keys().toSet() - initialShapes, missingShapes);
+    // Metadata is used to find out which files changed, getting it in parallel
+    QtConcurrent::blockingMap(content.shapes, [](ScannedFile& f) {
+        f.metadata = FileMetadata::fromFileInfo(f.info);
+    });
+
+    return content;
+}
+
+QVector<LocalShapesFinder::DirContent> LocalShapesFinder::walk(const QString& dirPath) const
+{
+    const std::function<DirContent(const QString&)> list = [this](const QString& dir) {
+        return listDirContent(dir);
+    };
+
+    QVector<DirContent> contents;
+    QStringList level{dirPath};
+    while (!level.isEmpty()) {
+        const auto levelContents = QtConcurrent::blockingMapped<QVector<DirContent>>(level, list);
+
+        level.clear();
+        for (const auto& content: levelContents) {
+            if (content.exists) {
+                level += content.subdirs;
+                contents.append(content);
+            }
+        }
     }
+
+    return contents;
 }
 
-QSet<QString> LocalShapesFinder::listAllShapesInDir(QDir dir) const
+QVector<LocalShapesFinder::LoadedShape> LocalShapesFinder::loadShapes(const QVector<ScannedFile>& toLoad, const ShapeIndex* index)
 {
-    QSet<QString> allShapes;
+    const std::function<LoadedShape(const ScannedFile&)> load = [index](const ScannedFile& f) {
+        LoadedShape loaded{ShapeInfo(), ShapeFilesMetadata(), false};
 
-    for (const auto& info: dir.entryInfoList(QStringList() << "*.psj", QDir::Files)) {
-        allShapes.insert(info.canonicalFilePath());
+        if (index != nullptr) {
+            // The G-code and SVG files are those of the indexed shape, if the .psj file changed
+            // the lookup fails anyway
+            const auto indexed = index->shape(f.key);
+            if (indexed.isValid()) {
+                loaded.metadata = ShapeFilesMetadata::fromShape(f.metadata, indexed);
+                loaded.info = index->lookup(f.key, loaded.metadata);
+            }
+        }
+
+        if (!loaded.info.isValid()) {
+            loaded.info = loadAndHashShape(f.key, f.metadata, index, loaded.metadata);
+            loaded.parsed = true;
+        }
+
+        return loaded;
+    };
+
+    return QtConcurrent::blockingMapped<QVector<LoadedShape>>(toLoad, load);
+}
+
+QHash<QString, ShapeFilesMetadata> LocalShapesFinder::metadataOfLoadedShapes(const ScanResult& result)
+{
+    QHash<QString, ShapeFilesMetadata> metadata;
+    metadata.reserve(result.toLoad.size());
+    for (auto i = 0; i < result.toLoad.size(); ++i) {
+        metadata.insert(result.toLoad[i].key, result.loadedShapes[i].metadata);
     }
 
-    return allShapes;
+    return metadata;
 }
 
-QMap<QString, ShapeInfo> LocalShapesFinder::loadNewShapes(QSet<QString> currentShapes) const
+QMap<QString, ShapeInfo> LocalShapesFinder::storeLoadedShapes(const QVector<ScannedFile>& toLoad, const QVector<LoadedShape>& loadedShapes, const QVector<DirContent>& contents)
 {
-    QMap<QString, ShapeInfo> newValidShapes;
+    QHash<QString, const QSet<QString>*> dirFiles;
+    for (const auto& content: contents) {
+        dirFiles.insert(content.path, &content.files);
+    }
 
-    for (const auto& shapeFile: currentShapes) {
-        if (!m_shapes.contains(shapeFile)) {
-            auto shapeInfo = ShapeInfo::createFromFile(shapeFile);
+    QMap<QString, ShapeInfo> validShapes;
+    for (auto i = 0; i < toLoad.size(); ++i) {
+        const auto& f = toLoad[i];
+        const auto& loaded = loadedShapes[i];
 
-            if (!validShape(shapeInfo)) {
-                continue;
+        if (m_index && loaded.parsed && loaded.info.isValid()) {
+            m_index->insert(f.key, loaded.metadata, loaded.info);
+            m_indexChanged = true;
+        }
+
+        if (!loaded.info.isValid() || !filesExist(loaded.info, dirFiles)) {
+            continue;
+        }
+
+        validShapes.insert(f.key, loaded.info);
+    }
+
+    return validShapes;
+}
+
+void LocalShapesFinder::removeDirectory(const QString& dirPath, QSet<QString>& removedShapes)
+{
+    QStringList removedDirs;
+
+    for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+        if (!isSameOrSubdirectory(it.key(), dirPath)) {
+            ++it;
+            continue;
+        }
+
+        for (auto fileIt = it.value().cbegin(); fileIt != it.value().cend(); ++fileIt) {
+            if (m_shapes.remove(fileIt.key()) != 0) {
+                removedShapes.insert(fileIt.key());
             }
 
-            newValidShapes[shapeFile] = shapeInfo;
+            if (m_index) {
+                m_index->remove(fileIt.key());
+                m_indexChanged = true;
+            }
         }
+
+        removedDirs.append(it.key());
+        it = m_dirs.erase(it);
     }
 
-    return newValidShapes;
+    unwatchDirectories(removedDirs);
 }
 
-bool LocalShapesFinder::dirRemoved(QDir& dir)
+void LocalShapesFinder::watchDirectories(const QStringList& dirs)
 {
-    if (!dir.exists()) {
+    if (dirs.isEmpty()) {
+        return;
+    }
+
+    // On Linux there is one inotify watch per directory. If we run out of watches, the remaining
+    // directories are polled
+    const auto failed = m_watcher.addPaths(dirs);
+    if (failed.isEmpty()) {
+        return;
+    }
+
+    if (m_unwatchedDirs.isEmpty()) {
+        qWarning() << "Cannot watch" << failed.size() << "directories for changes, checking them every"
+                   << pollIntervalMillis << "ms. On Linux, consider raising /proc/sys/fs/inotify/max_user_watches";
+    }
+
+    m_unwatchedDirs.unite(failed.toSet());
+    if (!m_pollTimer.isActive()) {
+        m_pollTimer.start();
+    }
+}
+
+void LocalShapesFinder::unwatchDirectories(const QStringList& dirs)
+{
+    QStringList watched;
+    for (const auto& dir: dirs) {
+        if (!m_unwatchedDirs.remove(dir)) {
+            watched.append(dir);
+        }
+    }
+
+    if (!watched.isEmpty()) {
+        m_watcher.removePaths(watched);
+    }
+}
+
+bool LocalShapesFinder::dirRemoved()
+{
+    if (!QDir(m_path).exists()) {
         if (!m_shapes.isEmpty()) {
             emit shapesUpdated(QSet<QString>(), m_shapes.keys().toSet());
         }
         m_shapes.clear();
+        unwatchDirectories(m_dirs.keys());
+        m_dirs.clear();
+        m_changedDirs.clear();
         return true;
     }
 
     return false;
 }
 
-bool LocalShapesFinder::validShape(ShapeInfo& info) const
+void LocalShapesFinder::validateGCode(const QSet<QString>& keys)
+{
+    for (const auto& key: keys) {
+        const auto it = m_shapes.constFind(key);
+        if (it == m_shapes.cend() || it.value().gcodeCheck().verdict != GCodeCheck::Verdict::Unchecked) {
+            continue;
+        }
+
+        const auto& info = it.value();
+        m_validationPool.validate(key, info.gcodeHash(), info.path() + "/" + info.gcodeFilename(),
+                                  info.workpieceDimX(), info.workpieceDimY());
+        ++m_pendingValidations;
+    }
+}
+
+void LocalShapesFinder::saveIndexIfChanged()
 {
-    return info.isValid() &&
-           QFile::exists(info.path() + "/" + info.gcodeFilename()) &&
-           QFile::exists(info.path() + "/" + info.svgFilename());
+    if (m_index && m_indexChanged) {
+        m_index->save();
+        m_indexChanged = false;
+    }
 }
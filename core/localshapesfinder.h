@@ -1,11 +1,22 @@
 #ifndef LOCALSHAPESFINDER_H
 #define LOCALSHAPESFINDER_H
 
+#include <functional>
+#include <memory>
 #include <QDir>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QMap>
 #include <QObject>
 #include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include "gcodevalidationpool.h"
+#include "shapeindex.h"
 #include "shapeinfo.h"
 
 class LocalShapesFinder : public QObject
@@ -13,29 +24,142 @@ class LocalShapesFinder : public QObject
     Q_OBJECT
 
 public:
-    // path must be absolute!!!
-    explicit LocalShapesFinder(QString path);
+    // path must be absolute!!! If indexFilename is not empty, parsed shapes are stored in a
+    // ShapeIndex in that file, so that at start only shapes that changed need to be parsed.
+    // Changes in the directory notified within debounceMillis from the first one are processed
+    // together (if 0 changes are processed immediately). If recursive is true, shapes are also
+    // searched in all subdirectories (symbolic links to directories are not followed). The G-code
+    // files of shapes are validated in background (see ShapeInfo::gcodeCheck()), results are
+    // stored in the index. If loadInBackground is false, directories are scanned and shapes are
+    // loaded before the constructor (or reload()) returns and when changes are notified. If it is
+    // true, the scan runs in the thread pool and shapes are updated when it finishes, so that the
+    // calling thread (e.g. the GUI) is not blocked: shapes() is empty until the first scan ends
+    explicit LocalShapesFinder(QString path, QString indexFilename = QString(), int debounceMillis = 0, bool recursive = false, bool loadInBackground = false);
+    // Waits for a running scan to finish
+    ~LocalShapesFinder() override;
 
     const QMap<QString, ShapeInfo>& shapes() const;
+    // The canonical paths of all directories that have been scanned
+    QStringList directories() const;
 
+    // Reloads all shapes from scratch (the index is not used, but it is updated)
     void reload();
+    // True while a scan is running in background
+    bool isLoading() const;
 
 private slots:
-    void directoryChanged();
+    void directoryChanged(const QString& path);
+    void updateShapes();
+    void scanFinished();
+    void pollUnwatchedDirectories();
+    void gcodeValidated(QString key, quint64 gcodeHash, GCodeCheck check);
+    void flushCheckedShapes();
+    void saveIndexIfChanged();
 
 signals:
-    // Note: newShapes and removedShapes might be partially overlapping if reload() is called
+    // Note: newShapes and removedShapes are partially overlapping if reload() is called or if
+    // shapes are modified (modified shapes are both removed and new)
     void shapesUpdated(QSet<QString> newShapes, QSet<QString> removedShapes);
+    // Emitted when the G-code check of shapes changes. Results are grouped, so this is not
+    // emitted for every shape
+    void shapesChecked(QSet<QString> shapes);
 
 private:
-    QSet<QString> listAllShapesInDir(QDir dir) const;
-    QMap<QString, ShapeInfo> loadNewShapes(QSet<QString> currentShapes) const;
-    bool dirRemoved(QDir& dir);
-    bool validShape(ShapeInfo& info) const;
+    struct ScannedFile
+    {
+        QString key; // The canonical path of the file
+        QFileInfo info;
+        FileMetadata metadata; // Of the .psj file only
+    };
+
+    struct DirContent
+    {
+        QString path; // The canonical path of the directory when it was first found
+        bool exists;
+        QVector<ScannedFile> shapes; // The .psj files
+        QSet<QString> files; // Names of all files in the directory
+        QStringList subdirs; // Only filled if recursive
+    };
+
+    // The result of loading a shape
+    struct LoadedShape
+    {
+        ShapeInfo info;
+        ShapeFilesMetadata metadata;
+        bool parsed; // false if info was taken from the index
+    };
+
+    // The result of a scan. Scans only read the filesystem and copies of the state of this object,
+    // so that they can run in another thread. Results are applied in the thread of this object
+    struct ScanResult
+    {
+        bool fullLoad; // true if all shapes were loaded, false if only changed directories
+        bool useIndex;
+        // All directories for full loads, the changed ones otherwise
+        QVector<DirContent> contents;
+        // New subdirectories of changed directories, with their subdirectories
+        QVector<DirContent> newDirsContents;
+        QVector<ScannedFile> toLoad;
+        QVector<LoadedShape> loadedShapes; // One for each element of toLoad
+    };
+
+    using DirsMetadata = QHash<QString, QHash<QString, ShapeFilesMetadata>>;
+
+    void loadAllShapes(bool useIndex);
+    // Runs scan in the thread pool, the result is applied by scanFinished()
+    void startScan(std::function<ScanResult()> scan);
+    // A copy of the index that can be read by a scan while this one is modified, nullptr if no
+    // index is used
+    std::shared_ptr<const ShapeIndex> indexSnapshot() const;
+    ScanResult scanAll(bool useIndex, const ShapeIndex* index) const;
+    ScanResult scanChanges(const QStringList& changedDirs, const DirsMetadata& dirs, const QMap<QString, ShapeInfo>& shapes, const ShapeIndex* index) const;
+    void applyFullLoad(const ScanResult& result);
+    void applyChanges(const ScanResult& result);
+    DirContent listDirContent(const QString& dirPath) const;
+    // Lists dirPath and all its subdirectories. Directories of the same depth are listed in parallel
+    QVector<DirContent> walk(const QString& dirPath) const;
+    // Loads shapes in parallel. Shapes that did not change are taken from index, if not nullptr
+    static QVector<LoadedShape> loadShapes(const QVector<ScannedFile>& toLoad, const ShapeIndex* index);
+    // The metadata of the files of loaded shapes, by .psj file
+    static QHash<QString, ShapeFilesMetadata> metadataOfLoadedShapes(const ScanResult& result);
+    // Stores parsed shapes in the index and returns the valid ones
+    QMap<QString, ShapeInfo> storeLoadedShapes(const QVector<ScannedFile>& toLoad, const QVector<LoadedShape>& loadedShapes, const QVector<DirContent>& contents);
+    // Removes dirPath and its subdirectories with their shapes
+    void removeDirectory(const QString& dirPath, QSet<QString>& removedShapes);
+    void watchDirectories(const QStringList& dirs);
+    void unwatchDirectories(const QStringList& dirs);
+    bool dirRemoved();
+    void storeGCodeCheck(const QString& key, quint64 gcodeHash, const GCodeCheck& check);
+    // Starts the validation of the G-code of the given shapes, if not already validated
+    void validateGCode(const QSet<QString>& keys);
 
     const QString m_path;
+    const bool m_recursive;
+    const bool m_loadInBackground;
     QFileSystemWatcher m_watcher;
+    QTimer m_debounceTimer;
+    // Directories that could not be added to the watcher (e.g. because of the inotify limit)
+    // are checked periodically
+    QTimer m_pollTimer;
+    QSet<QString> m_changedDirs;
+    QSet<QString> m_unwatchedDirs;
     QMap<QString, ShapeInfo> m_shapes;
+    // For each directory, the metadata of the files of all shapes found in the last scan, also
+    // the invalid ones (for which only the metadata of the .psj file is known)
+    DirsMetadata m_dirs;
+    const std::unique_ptr<ShapeIndex> m_index; // nullptr if no index is used
+    bool m_indexChanged;
+    int m_pendingValidations; // Started by validateGCode() and not yet notified
+    QSet<QString> m_checkedShapes;
+    QTimer m_checkedShapesTimer; // Only to group shapesChecked notifications
+    QTimer m_indexSaveTimer; // Saves results of G-code validation while it is running
+    QFutureWatcher<ScanResult> m_scanWatcher;
+    bool m_scanning;
+    // Set if a full load is requested while a scan is running, it starts when the scan ends
+    bool m_fullLoadPending;
+    bool m_pendingFullLoadUsesIndex;
+    // Declared last so that it is destroyed first, waiting for running jobs
+    GCodeValidationPool m_validationPool;
 };
 
 #endif // LOCALSHAPESFINDER_H
@@ -1,12 +1,15 @@
 #include "machinecommunication.h"
-#include <QThread>
 #include "immediatecommands.h"
+#include "tracerecorder.h"
 
-MachineCommunication::MachineCommunication(unsigned int hardResetDelay)
+MachineCommunication::MachineCommunication(unsigned int hardResetDelay, Clock* clock)
     : QObject()
     , m_hardResetDelay(hardResetDelay)
+    , m_clock(clock)
     , m_serialPort()
     , m_machineInfo(nullptr)
+    , m_bytesSentCounter(&MetricsRegistry::global().counter("serial.bytesSent"))
+    , m_bytesReceivedCounter(&MetricsRegistry::global().counter("serial.bytesReceived"))
 {
 }
 
@@ -29,6 +32,8 @@ void MachineCommunication::portFound(MachineInfo* info, AbstractPortDiscovery* p
 
 void MachineCommunication::writeData(QByteArray data)
 {
+    TRACE_ZONE("MachineCommunication::writeData");
+
     if (!m_serialPort) {
         return;
     }
@@ -36,6 +41,7 @@ void MachineCommunication::writeData(QByteArray data)
     auto res = m_serialPort->write(data);
 
     if (res != -1) {
+        m_bytesSentCounter->add(res);
         emit dataSent(data);
     }
 }
@@ -81,7 +87,7 @@ void MachineCommunication::hardReset()
     writeData(QByteArray(1, ImmediateCommands::hardReset));
 
     // This is needed to give the machine time to start
-    QThread::msleep(m_hardResetDelay);
+    m_clock->sleepUs(m_hardResetDelay * 1000ul);
 
     emit machineInitialized();
 }
@@ -95,10 +101,13 @@ void MachineCommunication::setCharacterSendDelayUs(unsigned long us)
 
 void MachineCommunication::readData()
 {
+    TRACE_ZONE("MachineCommunication::readData");
+
     auto data = m_serialPort->readAll();
     m_messageBuffer += data;
 
     if (!data.isEmpty()) {
+        m_bytesReceivedCounter->add(data.size());
         emit dataReceived(data);
 
         for (auto message: extractMessages()) {
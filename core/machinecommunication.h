@@ -4,8 +4,10 @@
 #include <memory>
 #include <QList>
 #include <QObject>
+#include "clock.h"
 #include "portdiscovery.h"
 #include "machineinfo.h"
+#include "metrics.h"
 #include "serialport.h"
 
 class MachineCommunication : public QObject
@@ -13,7 +15,8 @@ class MachineCommunication : public QObject
     Q_OBJECT
 
 public:
-    MachineCommunication(unsigned int hardResetDelay);
+    // hardResetDelay is in milliseconds, waited using clock
+    MachineCommunication(unsigned int hardResetDelay, Clock* clock = Clock::realClock());
 
     const MachineInfo* machineInfo() const; // returns nullptr before a machine is initialized
 
@@ -47,9 +50,13 @@ private:
     QList<QByteArray> extractMessages();
 
     const unsigned int m_hardResetDelay;
+    Clock* const m_clock;
     std::unique_ptr<SerialPortInterface> m_serialPort;
     QByteArray m_messageBuffer;
     const MachineInfo* m_machineInfo;
+    // Metrics are in MetricsRegistry::global()
+    Counter* const m_bytesSentCounter;
+    Counter* const m_bytesReceivedCounter;
 };
 
 #endif // MACHINECOMMUNICATION_H
@@ -1,26 +1,51 @@
 #include "machinestatusmonitor.h"
 #include <QRegularExpression>
 #include "immediatecommands.h"
+#include "tracerecorder.h"
 
 namespace {
     const QRegularExpression statusRegExpr("^<(.*)>$", QRegularExpression::OptimizeOnFirstUsageOption);
+    // A message received when less than this fraction of the watchdog delay is left is a near miss
+    constexpr int watchdogNearMissDivisor = 4;
+
+    bool registerMachineState()
+    {
+        static bool registered = false;
+
+        if (!registered) {
+            qRegisterMetaType<MachineState>();
+
+            registered = true;
+        }
+
+        return registered;
+    }
 }
 
-MachineStatusMonitor::MachineStatusMonitor(int statusPollingInterval, int watchdogDelay, MachineCommunication *communicator)
+// Needed to deliver stateChanged to objects living in other threads
+const bool MachineStatusMonitor::machineStateRegistered = registerMachineState();
+
+MachineStatusMonitor::MachineStatusMonitor(int statusPollingInterval, int watchdogDelay, MachineCommunication *communicator, Clock* clock)
     : m_communicator(communicator)
+    , m_clock(clock)
+    , m_timer(clock->createTimer())
+    , m_watchdog(clock->createTimer())
     , m_state(MachineState::Unknown)
+    , m_pollSentAtUs(-1)
+    , m_pollRoundTripHistogram(&MetricsRegistry::global().histogram("statusMonitor.pollRoundTripUs"))
+    , m_watchdogNearMissesCounter(&MetricsRegistry::global().counter("statusMonitor.watchdogNearMisses"))
 {
-    m_timer.setInterval(statusPollingInterval);
-    m_timer.setSingleShot(false);
-    m_watchdog.setInterval(watchdogDelay);
-    m_watchdog.setSingleShot(true);
+    m_timer->setInterval(statusPollingInterval);
+    m_timer->setSingleShot(false);
+    m_watchdog->setInterval(watchdogDelay);
+    m_watchdog->setSingleShot(true);
 
     connect(m_communicator, &MachineCommunication::machineInitialized, this, &MachineStatusMonitor::machineInitialized);
     connect(m_communicator, &MachineCommunication::messageReceived, this, &MachineStatusMonitor::messageReceived);
     connect(m_communicator, &MachineCommunication::portClosed, this, &MachineStatusMonitor::portClosed);
     connect(m_communicator, &MachineCommunication::portClosedWithError, this, &MachineStatusMonitor::portClosed);
-    connect(&m_timer, &QTimer::timeout, this, &MachineStatusMonitor::sendStatusReportQuery);
-    connect(&m_watchdog, &QTimer::timeout, this, &MachineStatusMonitor::watchdogTimerExpired);
+    connect(m_timer.get(), &Timer::timeout, this, &MachineStatusMonitor::sendStatusReportQuery);
+    connect(m_watchdog.get(), &Timer::timeout, this, &MachineStatusMonitor::watchdogTimerExpired);
 }
 
 MachineState MachineStatusMonitor::state() const
@@ -34,21 +59,38 @@ void MachineStatusMonitor::machineInitialized()
 
     sendStatusReportQuery();
 
-    m_timer.start();
-    m_watchdog.start();
+    m_timer->start();
+    m_watchdog->start();
 }
 
 void MachineStatusMonitor::sendStatusReportQuery()
 {
+    TRACE_ZONE("MachineStatusMonitor::sendStatusReportQuery");
+
+    // If the previous query was not answered, the round trip is measured from the first one
+    if (m_pollSentAtUs == -1) {
+        m_pollSentAtUs = m_clock->elapsedUs();
+    }
+
     m_communicator->writeData(QByteArray(1, ImmediateCommands::statusReportQuery));
 }
 
 void MachineStatusMonitor::messageReceived(QByteArray message)
 {
-    m_watchdog.start();
+    TRACE_ZONE("MachineStatusMonitor::messageReceived");
+
+    if (m_watchdog->isActive() && m_watchdog->remainingTime() < m_watchdog->interval() / watchdogNearMissDivisor) {
+        m_watchdogNearMissesCounter->add();
+    }
+    m_watchdog->start();
 
     const auto match = statusRegExpr.match(message);
     if (match.hasMatch()) {
+        if (m_pollSentAtUs != -1) {
+            m_pollRoundTripHistogram->record(m_clock->elapsedUs() - m_pollSentAtUs);
+            m_pollSentAtUs = -1;
+        }
+
         const auto parts = match.captured(1).toLatin1().split('|');
 
         setNewState(string2MachineState(parts[0]));
@@ -57,6 +99,7 @@ void MachineStatusMonitor::messageReceived(QByteArray message)
 
 void MachineStatusMonitor::portClosed()
 {
+    m_pollSentAtUs = -1;
     setNewState(MachineState::Unknown);
 }
 
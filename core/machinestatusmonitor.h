@@ -1,18 +1,25 @@
 #ifndef MACHINESTATUSMONITOR_H
 #define MACHINESTATUSMONITOR_H
 
+#include <memory>
 #include <QObject>
-#include <QTimer>
+#include "clock.h"
 #include "machinecommunication.h"
 #include "machinestate.h"
+#include "metrics.h"
 
 class MachineStatusMonitor : public QObject
 {
     Q_OBJECT
+
+private:
+    static const bool machineStateRegistered;
+
 public:
     // statusPollingInterval is in milliseconds, as well as watchdogDelay (if no answer is received
-    // within wathcdogDelay milliseconds, the port is closed)
-    explicit MachineStatusMonitor(int statusPollingInterval, int watchdogDelay, MachineCommunication* communicator);
+    // within wathcdogDelay milliseconds, the port is closed). Timers are created by clock, which
+    // also measures the round trip of queries
+    explicit MachineStatusMonitor(int statusPollingInterval, int watchdogDelay, MachineCommunication* communicator, Clock* clock = Clock::realClock());
 
     MachineState state() const;
 
@@ -30,9 +37,16 @@ private:
     void setNewState(MachineState newState);
 
     MachineCommunication* const m_communicator;
-    QTimer m_timer;
-    QTimer m_watchdog;
+    Clock* const m_clock;
+    const std::unique_ptr<Timer> m_timer;
+    const std::unique_ptr<Timer> m_watchdog;
     MachineState m_state;
+    // When a status query was sent (see Clock::elapsedUs()), -1 after the reply is received
+    qint64 m_pollSentAtUs;
+    // Metrics are in MetricsRegistry::global()
+    Histogram* const m_pollRoundTripHistogram;
+    // Messages received when the watchdog was about to expire
+    Counter* const m_watchdogNearMissesCounter;
 };
 
 #endif // MACHINESTATUSMONITOR_H
@@ -0,0 +1,174 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace {
+    int bucketIndex(qint64 value)
+    {
+        int index = 0;
+        while (value > 0 && index < Histogram::numBuckets - 1) {
+            value >>= 1;
+            ++index;
+        }
+
+        return index;
+    }
+
+    // The largest value that falls in the bucket
+    qint64 bucketUpperBound(int index)
+    {
+        if (index == 0) {
+            return 0;
+        } else if (index >= 63) {
+            return std::numeric_limits<qint64>::max();
+        }
+
+        return (Q_INT64_C(1) << index) - 1;
+    }
+
+    template <class MetricT>
+    MetricT& getOrCreate(std::map<QString, std::unique_ptr<MetricT>>& metrics, const QString& name)
+    {
+        auto& metric = metrics[name];
+        if (!metric) {
+            metric.reset(new MetricT());
+        }
+
+        return *metric;
+    }
+}
+
+Counter::Counter()
+    : m_value(0)
+{
+}
+
+Gauge::Gauge()
+    : m_value(0)
+{
+}
+
+double HistogramSnapshot::mean() const
+{
+    return (count == 0) ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+}
+
+qint64 HistogramSnapshot::percentile(double fraction) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const auto rank = static_cast<qint64>(std::ceil(std::min(std::max(fraction, 0.0), 1.0) * count));
+    qint64 seen = 0;
+    for (auto i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) {
+            return std::min(bucketUpperBound(i), max);
+        }
+    }
+
+    return max;
+}
+
+constexpr int Histogram::numBuckets;
+
+Histogram::Histogram()
+    : m_count(0)
+    , m_sum(0)
+    , m_min(std::numeric_limits<qint64>::max())
+    , m_max(0)
+{
+    for (auto& b: m_buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(qint64 value)
+{
+    value = std::max(value, Q_INT64_C(0));
+
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto curMin = m_min.load(std::memory_order_relaxed);
+    while (value < curMin && !m_min.compare_exchange_weak(curMin, value, std::memory_order_relaxed)) {
+    }
+    auto curMax = m_max.load(std::memory_order_relaxed);
+    while (value > curMax && !m_max.compare_exchange_weak(curMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const
+{
+    HistogramSnapshot s;
+    s.count = m_count.load(std::memory_order_relaxed);
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.min = (s.count == 0) ? 0 : m_min.load(std::memory_order_relaxed);
+    s.max = m_max.load(std::memory_order_relaxed);
+    s.buckets.reserve(numBuckets);
+    for (const auto& b: m_buckets) {
+        s.buckets.append(b.load(std::memory_order_relaxed));
+    }
+
+    return s;
+}
+
+MetricsRegistry& MetricsRegistry::global()
+{
+    static MetricsRegistry registry;
+
+    return registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : m_mutex()
+    , m_counters()
+    , m_gauges()
+    , m_histograms()
+{
+}
+
+Counter& MetricsRegistry::counter(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+
+    return getOrCreate(m_counters, name);
+}
+
+Gauge& MetricsRegistry::gauge(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+
+    return getOrCreate(m_gauges, name);
+}
+
+Histogram& MetricsRegistry::histogram(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+
+    return getOrCreate(m_histograms, name);
+}
+
+MetricsSnapshot MetricsRegistry::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    MetricsSnapshot s;
+    s.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    for (const auto& c: m_counters) {
+        s.counters.insert(c.first, c.second->value());
+    }
+    for (const auto& g: m_gauges) {
+        s.gauges.insert(g.first, g.second->value());
+    }
+    for (const auto& h: m_histograms) {
+        s.histograms.insert(h.first, h.second->snapshot());
+    }
+
+    return s;
+}
@@ -0,0 +1,127 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// A value that only grows (e.g. the number of bytes sent). Can be updated from any thread
+class Counter
+{
+public:
+    Counter();
+
+    void add(qint64 n = 1)
+    {
+        m_value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    qint64 value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<qint64> m_value;
+};
+
+// A value that can go up and down (e.g. the length of a queue). Can be updated from any thread
+class Gauge
+{
+public:
+    Gauge();
+
+    void set(qint64 v)
+    {
+        m_value.store(v, std::memory_order_relaxed);
+    }
+
+    qint64 value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<qint64> m_value;
+};
+
+struct HistogramSnapshot
+{
+    qint64 count = 0;
+    qint64 sum = 0;
+    qint64 min = 0;
+    qint64 max = 0;
+    // Number of values in each bucket, see Histogram
+    QVector<qint64> buckets;
+
+    double mean() const;
+    // An upper bound of the value below which the given fraction (between 0 and 1) of values
+    // falls. It is exact only to a power of two, but never more than max
+    qint64 percentile(double fraction) const;
+};
+
+// The distribution of non-negative values (e.g. latencies in microseconds). Bucket 0 holds 0,
+// bucket i holds values in [2^(i - 1), 2^i). Can be updated from any thread, a snapshot taken
+// while values are recorded may be slightly inconsistent (e.g. count and sum may differ by one
+// value)
+class Histogram
+{
+public:
+    static constexpr int numBuckets = 64;
+
+public:
+    Histogram();
+
+    // Negative values are recorded as 0
+    void record(qint64 value);
+    HistogramSnapshot snapshot() const;
+
+private:
+    std::array<std::atomic<qint64>, numBuckets> m_buckets;
+    std::atomic<qint64> m_count;
+    std::atomic<qint64> m_sum;
+    std::atomic<qint64> m_min;
+    std::atomic<qint64> m_max;
+};
+
+struct MetricsSnapshot
+{
+    qint64 timestampMs = 0; // Since the epoch
+    QMap<QString, qint64> counters;
+    QMap<QString, qint64> gauges;
+    QMap<QString, HistogramSnapshot> histograms;
+};
+
+// Holds metrics by name. Metrics are created on first request and never removed, so references
+// can be kept and used without looking them up again: only lookups take a lock. Names use the
+// form "component.metric", units are part of the name when not obvious (e.g. "ackLatencyUs")
+class MetricsRegistry
+{
+public:
+    // The registry used by core classes
+    static MetricsRegistry& global();
+
+public:
+    MetricsRegistry();
+
+    Counter& counter(const QString& name);
+    Gauge& gauge(const QString& name);
+    Histogram& histogram(const QString& name);
+
+    MetricsSnapshot snapshot() const;
+
+private:
+    mutable QMutex m_mutex;
+    // std::map because QMap needs copyable values
+    std::map<QString, std::unique_ptr<Counter>> m_counters;
+    std::map<QString, std::unique_ptr<Gauge>> m_gauges;
+    std::map<QString, std::unique_ptr<Histogram>> m_histograms;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,83 @@
+#include "metricslogger.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+MetricsLogger::MetricsLogger(MetricsRegistry& registry, QString filename, int intervalMillis, qint64 maxFileBytes)
+    : m_registry(registry)
+    , m_filename(filename)
+    , m_maxFileBytes(maxFileBytes)
+    , m_timer()
+{
+    m_timer.setInterval(intervalMillis);
+    m_timer.setSingleShot(false);
+
+    connect(&m_timer, &QTimer::timeout, this, &MetricsLogger::writeSnapshot);
+}
+
+QByteArray MetricsLogger::snapshotToJson(const MetricsSnapshot& snapshot)
+{
+    QJsonObject counters;
+    for (auto it = snapshot.counters.cbegin(); it != snapshot.counters.cend(); ++it) {
+        counters.insert(it.key(), it.value());
+    }
+
+    QJsonObject gauges;
+    for (auto it = snapshot.gauges.cbegin(); it != snapshot.gauges.cend(); ++it) {
+        gauges.insert(it.key(), it.value());
+    }
+
+    QJsonObject histograms;
+    for (auto it = snapshot.histograms.cbegin(); it != snapshot.histograms.cend(); ++it) {
+        const auto& h = it.value();
+        histograms.insert(it.key(), QJsonObject{
+            {"count", h.count},
+            {"sum", h.sum},
+            {"min", h.min},
+            {"max", h.max},
+            {"p50", h.percentile(0.5)},
+            {"p90", h.percentile(0.9)},
+            {"p99", h.percentile(0.99)}
+        });
+    }
+
+    const QJsonObject obj{
+        {"timestampMs", snapshot.timestampMs},
+        {"counters", counters},
+        {"gauges", gauges},
+        {"histograms", histograms}
+    };
+
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+void MetricsLogger::start()
+{
+    m_timer.start();
+}
+
+void MetricsLogger::stop()
+{
+    m_timer.stop();
+}
+
+bool MetricsLogger::writeSnapshot()
+{
+    const QFileInfo info(m_filename);
+    QDir().mkpath(info.absolutePath());
+
+    if (info.exists() && info.size() > m_maxFileBytes) {
+        const auto oldFilename = m_filename + ".old";
+        QFile::remove(oldFilename);
+        QFile::rename(m_filename, oldFilename);
+    }
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+
+    return file.write(snapshotToJson(m_registry.snapshot()) + "\n") != -1;
+}
@@ -0,0 +1,36 @@
+#ifndef METRICSLOGGER_H
+#define METRICSLOGGER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "metrics.h"
+
+// Periodically appends a snapshot of a MetricsRegistry to a file, one JSON object per line.
+// Histograms are written as count, sum, min, max and some percentiles. When the file grows
+// beyond maxFileBytes it is renamed by appending ".old" to its name (replacing the previous one)
+// and a new file is started
+class MetricsLogger : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsLogger(MetricsRegistry& registry, QString filename, int intervalMillis, qint64 maxFileBytes = 10 * 1024 * 1024);
+
+    static QByteArray snapshotToJson(const MetricsSnapshot& snapshot);
+
+public slots:
+    void start();
+    void stop();
+    // Writes a snapshot now. Returns false if the file could not be written
+    bool writeSnapshot();
+
+private:
+    MetricsRegistry& m_registry;
+    const QString m_filename;
+    const qint64 m_maxFileBytes;
+    QTimer m_timer;
+};
+
+#endif // METRICSLOGGER_H
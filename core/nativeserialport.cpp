@@ -0,0 +1,334 @@
+#include "nativeserialport.h"
+#include <cerrno>
+#include <fcntl.h>
+// termios2 (from the kernel headers, incompatible with termios.h) allows any baud rate
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QPointer>
+#include <QtDebug>
+#include "tracerecorder.h"
+
+namespace {
+    // The maximum number of buffers passed to a single writev
+    constexpr int maxWriteBuffers = 64;
+    constexpr int readChunkSize = 4096;
+}
+
+NativeSerialPort::NativeSerialPort(const QString& deviceName, Clock* clock)
+    : SerialPortInterface()
+    , m_deviceName(deviceName)
+    , m_clock(clock)
+    , m_fd(-1)
+    , m_readNotifier()
+    , m_writeNotifier()
+    , m_readBuffer()
+    , m_pendingWrites()
+    , m_pendingOffset(0)
+    , m_errorString()
+    , m_characterSendDelayUs(0)
+    , m_lowLatency(false)
+{
+}
+
+NativeSerialPort::~NativeSerialPort()
+{
+    close();
+}
+
+bool NativeSerialPort::open()
+{
+    if (m_fd != -1) {
+        m_errorString = tr("Port already open");
+        return false;
+    }
+
+    m_fd = ::open(QFile::encodeName(m_deviceName).constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd == -1) {
+        fail(qt_error_string(errno));
+        return false;
+    }
+
+    termios2 options;
+    if (::ioctl(m_fd, TCGETS2, &options) == -1) {
+        fail(qt_error_string(errno));
+        return false;
+    }
+
+    // The same settings as SerialPort: 8N1 with hardware flow control. Raw mode as set by
+    // cfmakeraw()
+    options.c_iflag &= ~static_cast<tcflag_t>(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    options.c_oflag &= ~static_cast<tcflag_t>(OPOST);
+    options.c_lflag &= ~static_cast<tcflag_t>(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    options.c_cflag &= ~static_cast<tcflag_t>(CSIZE | PARENB | CSTOPB | CBAUD);
+    options.c_cflag |= CS8 | CLOCAL | CREAD | CRTSCTS | BOTHER;
+    options.c_ispeed = static_cast<speed_t>(baudRate());
+    options.c_ospeed = static_cast<speed_t>(baudRate());
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+    if (::ioctl(m_fd, TCSETS2, &options) == -1) {
+        fail(qt_error_string(errno));
+        return false;
+    }
+
+    m_lowLatency = setLowLatency();
+    setFtdiLatencyTimer();
+
+    ::ioctl(m_fd, TCFLSH, TCIOFLUSH);
+
+    m_readNotifier = std::make_unique<QSocketNotifier>(m_fd, QSocketNotifier::Read);
+    connect(m_readNotifier.get(), &QSocketNotifier::activated, this, &NativeSerialPort::readyRead);
+    m_writeNotifier = std::make_unique<QSocketNotifier>(m_fd, QSocketNotifier::Write);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier.get(), &QSocketNotifier::activated, this, &NativeSerialPort::readyWrite);
+
+    return true;
+}
+
+qint64 NativeSerialPort::write(const QByteArray& data)
+{
+    TRACE_ZONE("NativeSerialPort::write");
+
+    if (m_fd == -1) {
+        m_errorString = tr("Port not open");
+        return -1;
+    }
+
+    // Nothing can be sent before what is already queued
+    if (m_characterSendDelayUs != 0 && m_pendingWrites.isEmpty()) {
+        return writeWithCharacterDelay(data);
+    }
+
+    m_pendingWrites.append(data);
+    if (!writePending()) {
+        return -1;
+    }
+
+    return data.size();
+}
+
+QByteArray NativeSerialPort::readAll()
+{
+    if (m_fd != -1 && !readFromDevice()) {
+        fail(qt_error_string(errno));
+    }
+
+    QByteArray data;
+    data.swap(m_readBuffer);
+
+    return data;
+}
+
+QString NativeSerialPort::errorString() const
+{
+    return m_errorString;
+}
+
+void NativeSerialPort::close()
+{
+    m_readNotifier.reset();
+    m_writeNotifier.reset();
+    m_pendingWrites.clear();
+    m_pendingOffset = 0;
+
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void NativeSerialPort::setCharacterSendDelayUs(unsigned long us)
+{
+    m_characterSendDelayUs = us;
+}
+
+unsigned long NativeSerialPort::characterSendDelayUs() const
+{
+    return m_characterSendDelayUs;
+}
+
+bool NativeSerialPort::lowLatency() const
+{
+    return m_lowLatency;
+}
+
+qint64 NativeSerialPort::bytesToWrite() const
+{
+    qint64 bytes = -m_pendingOffset;
+    for (const auto& d: m_pendingWrites) {
+        bytes += d.size();
+    }
+
+    return bytes;
+}
+
+void NativeSerialPort::readyRead()
+{
+    TRACE_ZONE("NativeSerialPort::readyRead");
+
+    const auto ok = readFromDevice();
+    const auto error = errno;
+
+    // The port might be deleted by whoever receives the signal
+    QPointer<NativeSerialPort> guard(this);
+    if (!m_readBuffer.isEmpty()) {
+        emit dataAvailable();
+    }
+
+    if (guard && !ok) {
+        fail(qt_error_string(error));
+    }
+}
+
+void NativeSerialPort::readyWrite()
+{
+    writePending();
+}
+
+bool NativeSerialPort::readFromDevice()
+{
+    char buffer[readChunkSize];
+
+    while (true) {
+        const auto n = ::read(m_fd, buffer, sizeof(buffer));
+
+        if (n > 0) {
+            m_readBuffer.append(buffer, static_cast<int>(n));
+        } else if (n == 0) {
+            // With VMIN and VTIME set to 0 this means that everything has been read, but a hung
+            // up tty (e.g. the adapter has been unplugged) reads 0 bytes too
+            if (hungUp()) {
+                errno = EIO;
+                return false;
+            }
+
+            return true;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+}
+
+bool NativeSerialPort::hungUp() const
+{
+    pollfd fd{m_fd, POLLIN, 0};
+
+    return ::poll(&fd, 1, 0) == 1 && (fd.revents & (POLLHUP | POLLERR)) != 0;
+}
+
+bool NativeSerialPort::writePending()
+{
+    while (!m_pendingWrites.isEmpty()) {
+        iovec buffers[maxWriteBuffers];
+        int numBuffers = 0;
+        for (auto i = 0; i < m_pendingWrites.size() && numBuffers < maxWriteBuffers; ++i) {
+            const auto offset = (i == 0) ? m_pendingOffset : 0;
+            buffers[numBuffers].iov_base = const_cast<char*>(m_pendingWrites[i].constData() + offset);
+            buffers[numBuffers].iov_len = static_cast<size_t>(m_pendingWrites[i].size() - offset);
+            ++numBuffers;
+        }
+
+        auto n = ::writev(m_fd, buffers, numBuffers);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Resumed by readyWrite()
+                m_writeNotifier->setEnabled(true);
+                return true;
+            }
+
+            fail(qt_error_string(errno));
+            return false;
+        }
+
+        // Removes what has been written
+        while (n > 0) {
+            const auto left = m_pendingWrites.first().size() - m_pendingOffset;
+            if (n >= left) {
+                n -= left;
+                m_pendingWrites.removeFirst();
+                m_pendingOffset = 0;
+            } else {
+                m_pendingOffset += static_cast<int>(n);
+                n = 0;
+            }
+        }
+    }
+
+    m_writeNotifier->setEnabled(false);
+
+    return true;
+}
+
+qint64 NativeSerialPort::writeWithCharacterDelay(const QByteArray& data)
+{
+    // See SerialPort::write() for why characters are sent one at a time
+    qint64 retval = 0;
+    for (int i = 0; i < data.size(); ++i) {
+        const auto r = ::write(m_fd, data.constData() + i, 1);
+
+        if (r == -1) {
+            if (errno == EINTR) {
+                --i;
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // The delay cannot be respected without blocking, the rest is sent when possible
+                m_pendingWrites.append(data.mid(i));
+                m_writeNotifier->setEnabled(true);
+                return data.size();
+            }
+
+            fail(qt_error_string(errno));
+            return -1;
+        }
+
+        ++retval;
+        m_clock->sleepUs(m_characterSendDelayUs);
+    }
+
+    return retval;
+}
+
+bool NativeSerialPort::setLowLatency()
+{
+    serial_struct serial;
+    if (::ioctl(m_fd, TIOCGSERIAL, &serial) == -1) {
+        return false;
+    }
+
+    serial.flags |= ASYNC_LOW_LATENCY;
+
+    return ::ioctl(m_fd, TIOCSSERIAL, &serial) != -1;
+}
+
+void NativeSerialPort::setFtdiLatencyTimer()
+{
+    // The default of 16 milliseconds delays every reply of the machine
+    const auto deviceName = QFileInfo(QFileInfo(m_deviceName).canonicalFilePath()).fileName();
+    QFile latencyTimer("/sys/bus/usb-serial/devices/" + deviceName + "/latency_timer");
+
+    if (!latencyTimer.exists()) {
+        return;
+    }
+
+    if (!latencyTimer.open(QIODevice::WriteOnly) || latencyTimer.write("1") != 1) {
+        qWarning() << "Could not set the latency timer of" << m_deviceName << ":" << latencyTimer.errorString();
+    }
+}
+
+void NativeSerialPort::fail(const QString& reason)
+{
+    m_errorString = reason;
+    close();
+
+    QMetaObject::invokeMethod(this, "errorOccurred", Qt::QueuedConnection);
+}
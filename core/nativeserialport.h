@@ -0,0 +1,73 @@
+#ifndef NATIVESERIALPORT_H
+#define NATIVESERIALPORT_H
+
+#include <memory>
+#include <QByteArray>
+#include <QList>
+#include <QSocketNotifier>
+#include <QString>
+#include "clock.h"
+#include "serialport.h"
+
+// A serial port using the Linux tty interface directly, without the buffering of QSerialPort. The
+// port is set in raw mode (VMIN and VTIME are 0, the descriptor is non-blocking) with any baud
+// rate supported by the driver (e.g. 250000, which has no termios constant) and incoming
+// data is notified by a QSocketNotifier as soon as it arrives. Writes go straight to the
+// descriptor: what cannot be written immediately is queued and written with a single writev when
+// the descriptor becomes writable. When opening, the driver is asked for low latency
+// (ASYNC_LOW_LATENCY) and the latency timer of FTDI adapters is set to 1 millisecond: both are
+// optional and skipped if not supported (e.g. on pseudo terminals or without the permission to
+// write to sysfs). Errors are signalled with a queued errorOccurred(), so the port is never
+// deleted by the receiver of the signal while inside one of its functions. Only available on
+// Linux
+class NativeSerialPort : public SerialPortInterface
+{
+    Q_OBJECT
+
+public:
+    // deviceName is the path of the device (e.g. /dev/ttyUSB0 or /dev/pts/3). The delay between
+    // characters is waited using clock
+    explicit NativeSerialPort(const QString& deviceName, Clock* clock = Clock::realClock());
+    ~NativeSerialPort() override;
+
+    bool open() override;
+    qint64 write(const QByteArray& data) override;
+    QByteArray readAll() override;
+    QString errorString() const override;
+    void close() override;
+    void setCharacterSendDelayUs(unsigned long us) override;
+    unsigned long characterSendDelayUs() const override;
+
+    // Whether the driver accepted ASYNC_LOW_LATENCY when the port was opened
+    bool lowLatency() const;
+    // Bytes waiting for the descriptor to become writable
+    qint64 bytesToWrite() const;
+
+private slots:
+    void readyRead();
+    void readyWrite();
+
+private:
+    // Returns false in case of errors
+    bool readFromDevice();
+    bool hungUp() const;
+    bool writePending();
+    qint64 writeWithCharacterDelay(const QByteArray& data);
+    bool setLowLatency();
+    void setFtdiLatencyTimer();
+    void fail(const QString& reason);
+
+    const QString m_deviceName;
+    Clock* const m_clock;
+    int m_fd;
+    std::unique_ptr<QSocketNotifier> m_readNotifier;
+    std::unique_ptr<QSocketNotifier> m_writeNotifier;
+    QByteArray m_readBuffer;
+    QList<QByteArray> m_pendingWrites;
+    int m_pendingOffset; // Bytes of the first pending write which have already been written
+    QString m_errorString;
+    unsigned long m_characterSendDelayUs;
+    bool m_lowLatency;
+};
+
+#endif // NATIVESERIALPORT_H
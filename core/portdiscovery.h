@@ -7,8 +7,8 @@
 #include <QObject>
 #include <QList>
 #include <QSerialPort>
-#include <QTimer>
 #include <QtDebug>
+#include "clock.h"
 #include "machineinfo.h"
 #include "serialport.h"
 #include "immediatecommands.h"
@@ -25,6 +25,11 @@ public:
 
     virtual std::unique_ptr<SerialPortInterface> obtainPort() = 0;
     virtual void setCharacterSendDelayUs(unsigned long us) = 0;
+    // The baud rates to try on each port, in order. The next one is used when the machine does not
+    // answer, an empty list means only SerialPortInterface::defaultBaudRate
+    virtual void setBaudRates(QList<qint32> baudRates) = 0;
+    // The baud rate of the port of the last machine found
+    virtual qint32 baudRate() const = 0;
 
 public slots:
     virtual void start() = 0;
@@ -48,9 +53,13 @@ public:
 public:
     // scanDelayMillis is how much to wait between two consecutive scans in milliseconds,
     // portReadInterval is for how long to attempt to read from a possibly matching port in
-    // milliseconds and maxReadAttemptsPerPort is how many attempts to do before moving to another
-    // port. characterSendDelayUs is the value to set on every opened serial port
-    PortDiscovery(PortListingFuncT portListingFunc, SerialPortFactoryT serialPortFactory, int scanDelayMillis, int portPollInterval, int maxReadAttemptsPerPort, unsigned long characterSendDelayUs)
+    // milliseconds and maxReadAttemptsPerPort is how many attempts to do before moving to the next
+    // baud rate (see setBaudRates()) or to another port. characterSendDelayUs is the value to set
+    // on every opened serial port. If checkVendorAndProduct is false all listed ports are probed,
+    // not only those with the vendor and product identifiers of the machine (e.g. to connect to a
+    // simulator on a pseudo terminal).
+    // The timer used to wait is created by clock
+    PortDiscovery(PortListingFuncT portListingFunc, SerialPortFactoryT serialPortFactory, int scanDelayMillis, int portPollInterval, int maxReadAttemptsPerPort, unsigned long characterSendDelayUs, bool checkVendorAndProduct = true, Clock* clock = Clock::realClock())
         : AbstractPortDiscovery()
         , m_portListingFunc(portListingFunc)
         , m_serialPortFactory(serialPortFactory)
@@ -58,11 +67,16 @@ public:
         , m_portPollInterval(portPollInterval)
         , m_maxReadAttemptsPerPort(maxReadAttemptsPerPort)
         , m_characterSendDelayUs(characterSendDelayUs)
+        , m_checkVendorAndProduct(checkVendorAndProduct)
+        , m_timer(clock->createTimer())
         , m_currentPortAttempt(0)
+        , m_baudRates{SerialPortInterface::defaultBaudRate}
+        , m_currentBaudRate(0)
+        , m_foundBaudRate(SerialPortInterface::defaultBaudRate)
         , m_searchingPort(false)
     {
-        m_timer.setSingleShot(true);
-        connect(&m_timer, &QTimer::timeout, this, &PortDiscovery::timeout);
+        m_timer->setSingleShot(true);
+        connect(m_timer.get(), &Timer::timeout, this, &PortDiscovery::timeout);
     }
 
     // This returns an open serial port for the found machine after the portFound signal is emitted.
@@ -78,6 +92,16 @@ public:
         m_characterSendDelayUs = us;
     }
 
+    void setBaudRates(QList<qint32> baudRates) override
+    {
+        m_baudRates = baudRates.isEmpty() ? QList<qint32>{SerialPortInterface::defaultBaudRate} : baudRates;
+    }
+
+    qint32 baudRate() const override
+    {
+        return m_foundBaudRate;
+    }
+
     void start() override
     {
         emit startedDiscoveringPort();
@@ -110,8 +134,10 @@ private:
         while (!m_portsQueue.isEmpty() && !candidateFound) {
             auto p = m_portsQueue.takeFirst();
 
-            if (vendorAndProductMatch(p)) {
+            if (!m_checkVendorAndProduct || vendorAndProductMatch(p)) {
                 qDebug() << "Found a port with matching vendor and product identifier";
+                m_currentPortInfo = p;
+                m_currentBaudRate = 0;
                 initializePort(p);
 
                 // m_serialPort might be reset in case of errors
@@ -125,7 +151,7 @@ private:
         }
 
         if (!candidateFound) {
-            m_timer.start(m_scanDelayMillis);
+            m_timer->start(m_scanDelayMillis);
         }
     }
 
@@ -138,6 +164,7 @@ private:
                 this, &PortDiscovery<SerialPortInfo>::serialPortError);
 
         m_serialPort->setCharacterSendDelayUs(m_characterSendDelayUs);
+        m_serialPort->setBaudRate(m_baudRates.value(m_currentBaudRate, SerialPortInterface::defaultBaudRate));
         m_serialPort->open();
 
         // m_serialPort might be reset in case of errors
@@ -159,11 +186,36 @@ private:
         m_currentPortAttempt++;
 
         if (m_currentPortAttempt > m_maxReadAttemptsPerPort) {
-            // Failure with this port, close and wait
-            moveToNextPortOrScheduleRescan();
+            if (m_currentBaudRate + 1 < m_baudRates.size()) {
+                retryWithNextBaudRate();
+            } else {
+                // Failure with this port, close and wait
+                moveToNextPortOrScheduleRescan();
+            }
         } else {
             m_serialPort->write("$I\n");
-            m_timer.start(m_portPollInterval);
+            m_timer->start(m_portPollInterval);
+        }
+    }
+
+    // The machine might be using a slower baud rate, the port is opened again
+    void retryWithNextBaudRate()
+    {
+        m_serialPort.reset();
+        m_currentPortAttempt = 0;
+        m_receivedData.clear();
+        ++m_currentBaudRate;
+
+        {
+            // Errors when opening only delete the port
+            SearchingPortRAII searchingPortRAII(m_searchingPort);
+            initializePort(m_currentPortInfo);
+        }
+
+        if (m_serialPort) {
+            askFirmwareVersion();
+        } else {
+            moveToNextPortOrScheduleRescan();
         }
     }
 
@@ -175,7 +227,7 @@ private:
 
         if (!m_searchingPort) {
             if (m_portsQueue.isEmpty()) {
-                m_timer.start(m_scanDelayMillis);
+                m_timer->start(m_scanDelayMillis);
             } else {
                 searchPort();
             }
@@ -190,13 +242,14 @@ private:
     void dataAvailable()
     {
         m_receivedData += m_serialPort->readAll();
-        qDebug() << "Message received from machine:" << m_receivedData;
+        qDebug() << "Message received from machine at" << m_serialPort->baudRate() << "baud:" << m_receivedData;
 
         auto info = MachineInfo::createFromString(m_receivedData);
         if (info) {
             m_machineInfo = std::move(info);
+            m_foundBaudRate = m_serialPort->baudRate();
             emit portFound(m_machineInfo.get(), this);
-            m_timer.stop();
+            m_timer->stop();
         }
     }
 
@@ -206,10 +259,15 @@ private:
     const int m_portPollInterval;
     const int m_maxReadAttemptsPerPort;
     int m_characterSendDelayUs;
-    QTimer m_timer;
+    const bool m_checkVendorAndProduct;
+    const std::unique_ptr<Timer> m_timer;
     std::unique_ptr<SerialPortInterface> m_serialPort;
     QByteArray m_receivedData;
     int m_currentPortAttempt;
+    QList<qint32> m_baudRates;
+    int m_currentBaudRate; // Index in m_baudRates
+    SerialPortInfo m_currentPortInfo; // Needed to open the port again with another baud rate
+    qint32 m_foundBaudRate;
     QList<SerialPortInfo> m_portsQueue;
     bool m_searchingPort;
     std::unique_ptr<MachineInfo> m_machineInfo;
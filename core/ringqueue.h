@@ -0,0 +1,122 @@
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+
+#include <algorithm>
+#include <utility>
+#include <QVector>
+#include <QtGlobal>
+
+// A FIFO queue stored in a circular buffer. All elements are created in the constructor and are
+// never destroyed by dequeue() or clear(), so an element obtained with enqueueSlot() keeps the
+// buffers of the value it last had (e.g. the memory reserved by a QByteArray) and filling it does
+// not allocate. The capacity is doubled if the queue is full, this only happens if more elements
+// than expected are queued: capacity is never reduced, so in steady state there are no
+// allocations
+template <class T>
+class RingQueue
+{
+public:
+    explicit RingQueue(int capacity)
+        : m_elements(std::max(capacity, 1))
+        , m_head(0)
+        , m_size(0)
+    {
+    }
+
+    int size() const
+    {
+        return m_size;
+    }
+
+    int capacity() const
+    {
+        return m_elements.size();
+    }
+
+    bool isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    // Adds a copy of value at the end of the queue
+    void enqueue(const T& value)
+    {
+        enqueueSlot() = value;
+    }
+
+    // Adds an element at the end of the queue and returns it. The element is not reset, it has the
+    // value it had when it was last dequeued (or a default-constructed one)
+    T& enqueueSlot()
+    {
+        if (m_size == m_elements.size()) {
+            grow();
+        }
+
+        return m_elements[index(m_size++)];
+    }
+
+    // The first element, the queue must not be empty
+    T& head()
+    {
+        Q_ASSERT(m_size != 0);
+        return m_elements[m_head];
+    }
+
+    const T& head() const
+    {
+        Q_ASSERT(m_size != 0);
+        return m_elements[m_head];
+    }
+
+    // Removes the first element, the queue must not be empty. Use head() before to read it
+    void dequeue()
+    {
+        Q_ASSERT(m_size != 0);
+        m_head = index(1);
+        --m_size;
+    }
+
+    // The i-th element from the head
+    T& at(int i)
+    {
+        Q_ASSERT(i >= 0 && i < m_size);
+        return m_elements[index(i)];
+    }
+
+    const T& at(int i) const
+    {
+        Q_ASSERT(i >= 0 && i < m_size);
+        return m_elements[index(i)];
+    }
+
+    void clear()
+    {
+        m_head = 0;
+        m_size = 0;
+    }
+
+private:
+    int index(int i) const
+    {
+        return (m_head + i) % m_elements.size();
+    }
+
+    void grow()
+    {
+        // Elements are moved so that the queued ones start from the beginning, the others are
+        // moved too to keep their buffers
+        QVector<T> elements(m_elements.size() * 2);
+        for (auto i = 0; i < m_elements.size(); ++i) {
+            elements[i] = std::move(m_elements[index(i)]);
+        }
+
+        m_elements.swap(elements);
+        m_head = 0;
+    }
+
+    QVector<T> m_elements;
+    int m_head;
+    int m_size;
+};
+
+#endif // RINGQUEUE_H
@@ -1,15 +1,39 @@
 #include "serialport.h"
 #include <QtDebug>
-#include <QThread>
+#include "tracerecorder.h"
+
+constexpr qint32 SerialPortInterface::defaultBaudRate;
 
 SerialPortInterface::SerialPortInterface()
     : QObject()
+    , m_baudRate(defaultBaudRate)
+{
+}
+
+void SerialPortInterface::setBaudRate(qint32 baudRate)
 {
+    m_baudRate = baudRate;
 }
 
-SerialPort::SerialPort(const QSerialPortInfo& portInfo)
+qint32 SerialPortInterface::baudRate() const
+{
+    return m_baudRate;
+}
+
+SerialPort::SerialPort(const QSerialPortInfo& portInfo, Clock* clock)
     : SerialPortInterface()
     , m_serialPort(portInfo)
+    , m_clock(clock)
+    , m_characterSendDelayUs(0)
+{
+    connect(&m_serialPort, &QSerialPort::readyRead, this, &SerialPort::dataAvailable);
+    connect(&m_serialPort, &QSerialPort::errorOccurred, this, &SerialPort::signalErrorOccurred);
+}
+
+SerialPort::SerialPort(const QString& name, Clock* clock)
+    : SerialPortInterface()
+    , m_serialPort(name)
+    , m_clock(clock)
     , m_characterSendDelayUs(0)
 {
     connect(&m_serialPort, &QSerialPort::readyRead, this, &SerialPort::dataAvailable);
@@ -18,7 +42,7 @@ SerialPort::SerialPort(const QSerialPortInfo& portInfo)
 
 bool SerialPort::open()
 {
-    m_serialPort.setBaudRate(QSerialPort::Baud115200);
+    m_serialPort.setBaudRate(baudRate());
     m_serialPort.setFlowControl(QSerialPort::HardwareControl);
 
     auto retval = m_serialPort.open(QIODevice::ReadWrite);
@@ -28,6 +52,8 @@ bool SerialPort::open()
 
 qint64 SerialPort::write(const QByteArray& data)
 {
+    TRACE_ZONE("SerialPort::write");
+
     // Suggestion taken from GrblController (https://github.com/zapmaker/GrblHoming/blob/master/rs232.cpp
     // at row 180): "On very fast PCs running Windows we have to slow down the sending of bytes to grbl
     // because grbl loses bytes due to its interrupt service routine (ISR) taking too many clock
@@ -46,7 +72,7 @@ qint64 SerialPort::write(const QByteArray& data)
         }
 
         if (m_characterSendDelayUs != 0) {
-            QThread::usleep(m_characterSendDelayUs);
+            m_clock->sleepUs(m_characterSendDelayUs);
         }
     }
 
@@ -6,11 +6,15 @@
 #include <QIODevice>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include "clock.h"
 
 class SerialPortInterface : public QObject
 {
     Q_OBJECT
 
+public:
+    static constexpr qint32 defaultBaudRate = 115200;
+
 public:
     // Instances are inside unique_ptr, parent must be nullptr
     SerialPortInterface();
@@ -22,10 +26,16 @@ public:
     virtual void close() = 0;
     virtual void setCharacterSendDelayUs(unsigned long us) = 0;
     virtual unsigned long characterSendDelayUs() const = 0;
+    // The baud rate used by the next call to open(), defaultBaudRate if never set
+    virtual void setBaudRate(qint32 baudRate);
+    virtual qint32 baudRate() const;
 
 signals:
     void dataAvailable();
     void errorOccurred();
+
+private:
+    qint32 m_baudRate;
 };
 
 class SerialPort : public SerialPortInterface
@@ -33,7 +43,10 @@ class SerialPort : public SerialPortInterface
     Q_OBJECT
 
 public:
-    SerialPort(const QSerialPortInfo& portInfo);
+    // The delay between characters is waited using clock
+    SerialPort(const QSerialPortInfo& portInfo, Clock* clock = Clock::realClock());
+    // name can also be the path of the device (e.g. a pseudo terminal not listed among ports)
+    SerialPort(const QString& name, Clock* clock = Clock::realClock());
 
     bool open() override;
     qint64 write(const QByteArray& data) override;
@@ -48,6 +61,7 @@ private:
 
 private:
     QSerialPort m_serialPort;
+    Clock* const m_clock;
     unsigned long m_characterSendDelayUs;
 };
 
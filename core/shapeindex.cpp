@@ -0,0 +1,229 @@
+#include "shapeindex.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const quint32 indexMagic = 0x50534958; // "PSIX"
+    // Increment this whenever the format changes (e.g. when ShapeInfo changes), old indexes are
+    // then discarded
+    const quint32 indexFormatVersion = 4;
+    const auto streamVersion = QDataStream::Qt_5_9;
+
+    void writeMetadata(QDataStream& stream, const FileMetadata& metadata)
+    {
+        stream << metadata.size << metadata.modificationTime << metadata.inode;
+    }
+
+    void readMetadata(QDataStream& stream, FileMetadata& metadata)
+    {
+        stream >> metadata.size >> metadata.modificationTime >> metadata.inode;
+    }
+}
+
+FileMetadata FileMetadata::fromFileInfo(const QFileInfo& info)
+{
+#ifdef Q_OS_UNIX
+    // A single stat call gives everything we need
+    struct stat st;
+    if (::stat(QFile::encodeName(info.absoluteFilePath()).constData(), &st) == 0) {
+#ifdef Q_OS_LINUX
+        const qint64 modificationTime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#else
+        const qint64 modificationTime = info.lastModified().toMSecsSinceEpoch();
+#endif
+
+        return FileMetadata{static_cast<qint64>(st.st_size), modificationTime, static_cast<quint64>(st.st_ino)};
+    }
+#endif
+
+    return FileMetadata{info.size(), info.lastModified().toMSecsSinceEpoch(), 0};
+}
+
+ShapeFilesMetadata ShapeFilesMetadata::fromShape(const FileMetadata& psj, const ShapeInfo& info)
+{
+    return ShapeFilesMetadata{psj,
+                              FileMetadata::fromFileInfo(QFileInfo(info.path() + "/" + info.gcodeFilename())),
+                              FileMetadata::fromFileInfo(QFileInfo(info.path() + "/" + info.svgFilename()))};
+}
+
+ShapeIndex::ShapeIndex(QString filename)
+    : m_filename(filename)
+{
+}
+
+QString ShapeIndex::filename() const
+{
+    return m_filename;
+}
+
+bool ShapeIndex::load()
+{
+    clear();
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // Decoding directly from the file, which is read in blocks
+    QDataStream stream(&file);
+    stream.setVersion(streamVersion);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> count;
+
+    if (magic != indexMagic || version != indexFormatVersion) {
+        return false;
+    }
+
+    m_entries.reserve(static_cast<int>(count));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString psjFilename;
+        Entry entry;
+        stream >> psjFilename;
+        readMetadata(stream, entry.metadata.psj);
+        readMetadata(stream, entry.metadata.gcode);
+        readMetadata(stream, entry.metadata.svg);
+        stream >> entry.info;
+
+        insert(psjFilename, entry.metadata, entry.info);
+    }
+
+    const bool ok = (stream.status() == QDataStream::Ok);
+    if (!ok) {
+        clear();
+    }
+
+    return ok;
+}
+
+bool ShapeIndex::save() const
+{
+    QDir::root().mkpath(QFileInfo(m_filename).absolutePath());
+
+    // Writing to a temporary file which replaces the index only if everything succeeded
+    QSaveFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(streamVersion);
+
+    stream << indexMagic << indexFormatVersion << static_cast<quint32>(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        stream << it.key();
+        writeMetadata(stream, it.value().metadata.psj);
+        writeMetadata(stream, it.value().metadata.gcode);
+        writeMetadata(stream, it.value().metadata.svg);
+        stream << it.value().info;
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+int ShapeIndex::size() const
+{
+    return m_entries.size();
+}
+
+ShapeInfo ShapeIndex::lookup(const QString& psjFilename, const ShapeFilesMetadata& metadata) const
+{
+    const auto it = m_entries.constFind(psjFilename);
+
+    if (it == m_entries.cend() || it.value().metadata != metadata) {
+        return ShapeInfo();
+    }
+
+    return it.value().info;
+}
+
+ShapeInfo ShapeIndex::shape(const QString& psjFilename) const
+{
+    return m_entries.value(psjFilename).info;
+}
+
+ShapeInfo ShapeIndex::lookupByPsjHash(quint64 psjHash) const
+{
+    if (psjHash == 0) {
+        return ShapeInfo();
+    }
+
+    const auto it = m_psjHashes.constFind(psjHash);
+
+    return (it == m_psjHashes.cend()) ? ShapeInfo() : m_entries.value(it.value()).info;
+}
+
+void ShapeIndex::insert(const QString& psjFilename, const ShapeFilesMetadata& metadata, const ShapeInfo& info)
+{
+    const auto it = m_entries.find(psjFilename);
+    if (it != m_entries.end()) {
+        removeHash(psjFilename, it.value().info);
+        it.value() = Entry{metadata, info};
+    } else {
+        m_entries.insert(psjFilename, Entry{metadata, info});
+    }
+
+    if (info.psjHash() != 0) {
+        m_psjHashes.insert(info.psjHash(), psjFilename);
+    }
+}
+
+bool ShapeIndex::update(const QString& psjFilename, const ShapeInfo& info)
+{
+    const auto it = m_entries.constFind(psjFilename);
+    if (it == m_entries.cend()) {
+        return false;
+    }
+
+    const auto metadata = it.value().metadata;
+    insert(psjFilename, metadata, info);
+
+    return true;
+}
+
+void ShapeIndex::remove(const QString& psjFilename)
+{
+    const auto it = m_entries.find(psjFilename);
+    if (it != m_entries.end()) {
+        removeHash(psjFilename, it.value().info);
+        m_entries.erase(it);
+    }
+}
+
+bool ShapeIndex::retainOnly(const QSet<QString>& psjFilenames)
+{
+    const auto initialSize = m_entries.size();
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (psjFilenames.contains(it.key())) {
+            ++it;
+        } else {
+            removeHash(it.key(), it.value().info);
+            it = m_entries.erase(it);
+        }
+    }
+
+    return m_entries.size() != initialSize;
+}
+
+void ShapeIndex::clear()
+{
+    m_entries.clear();
+    m_psjHashes.clear();
+}
+
+void ShapeIndex::removeHash(const QString& psjFilename, const ShapeInfo& info)
+{
+    if (info.psjHash() != 0) {
+        m_psjHashes.remove(info.psjHash(), psjFilename);
+    }
+}
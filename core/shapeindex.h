@@ -0,0 +1,107 @@
+#ifndef SHAPEINDEX_H
+#define SHAPEINDEX_H
+
+#include <QFileInfo>
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
+#include <QString>
+#include "shapeinfo.h"
+
+// The metadata of a file, used to know whether a file has changed since it was indexed
+struct FileMetadata
+{
+    // Returns metadata for the given file. The inode is only available on unix, it is 0 elsewhere
+    static FileMetadata fromFileInfo(const QFileInfo& info);
+
+    qint64 size;
+    qint64 modificationTime; // milliseconds since epoch
+    quint64 inode;
+
+    bool operator==(const FileMetadata& other) const
+    {
+        return size == other.size && modificationTime == other.modificationTime && inode == other.inode;
+    }
+
+    bool operator!=(const FileMetadata& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// The metadata of all files of a shape: the .psj file and the G-code and SVG files it refers to. A
+// shape must be loaded again if any of them changes (e.g. the content hashes and the G-code check
+// depend on the G-code file)
+struct ShapeFilesMetadata
+{
+    // Takes the metadata of the G-code and SVG files of info from the filesystem. Missing files
+    // have the metadata given by FileMetadata::fromFileInfo() for non-existing files
+    static ShapeFilesMetadata fromShape(const FileMetadata& psj, const ShapeInfo& info);
+
+    FileMetadata psj;
+    FileMetadata gcode;
+    FileMetadata svg;
+
+    bool operator==(const ShapeFilesMetadata& other) const
+    {
+        return psj == other.psj && gcode == other.gcode && svg == other.svg;
+    }
+
+    bool operator!=(const ShapeFilesMetadata& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// A persistent index of parsed shapes. For each .psj file the parsed ShapeInfo is stored together
+// with the metadata of the files of the shape when it was parsed, so that the shape only needs to
+// be parsed again if the metadata of one of its files changes. The index is stored in a binary
+// file which is decoded entirely when loaded
+class ShapeIndex
+{
+public:
+    explicit ShapeIndex(QString filename);
+
+    QString filename() const;
+
+    // Replaces the content of the index with that of the file. Returns false if the file does not
+    // exist or is not a valid index: in this case the index is empty
+    bool load();
+    // Returns false in case of errors
+    bool save() const;
+
+    int size() const;
+    // Returns an invalid ShapeInfo if the file is not in the index or if the given metadata differs
+    // from the one stored in the index
+    ShapeInfo lookup(const QString& psjFilename, const ShapeFilesMetadata& metadata) const;
+    // Returns the stored shape whatever its metadata, or an invalid ShapeInfo if the file is not
+    // in the index. Used to know the G-code and SVG files of the shape before calling lookup()
+    ShapeInfo shape(const QString& psjFilename) const;
+    // Returns a shape whose .psj file has the given content hash (see ShapeInfo::psjHash()) or an
+    // invalid ShapeInfo if there is none. The shape can have a different path or psjFilename
+    ShapeInfo lookupByPsjHash(quint64 psjHash) const;
+    void insert(const QString& psjFilename, const ShapeFilesMetadata& metadata, const ShapeInfo& info);
+    // Replaces the shape of an entry, keeping the metadata. Returns false if there is no entry
+    // for the file
+    bool update(const QString& psjFilename, const ShapeInfo& info);
+    void remove(const QString& psjFilename);
+    // Removes all files not in psjFilenames. Returns true if something was removed
+    bool retainOnly(const QSet<QString>& psjFilenames);
+    void clear();
+
+private:
+    struct Entry
+    {
+        ShapeFilesMetadata metadata;
+        ShapeInfo info;
+    };
+
+    void removeHash(const QString& psjFilename, const ShapeInfo& info);
+
+    const QString m_filename;
+    QHash<QString, Entry> m_entries;
+    // From the hash of the .psj file to the files with that content
+    QMultiHash<quint64, QString> m_psjHashes;
+};
+
+#endif // SHAPEINDEX_H
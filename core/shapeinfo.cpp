@@ -1,122 +1,546 @@
 #include "shapeinfo.h"
-#include <functional>
+#include <cstring>
+#include <QByteArray>
 #include <QFile>
 #include <QFileInfo>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include "contenthash.h"
+#include "stringpool.h"
 
 namespace {
-    class MissingFieldException {};
-    class InvalidFieldTypeException {};
+    // The fields of a .psj file, version 1
+    enum class Field {
+        Version,
+        Name,
+        SvgFilename,
+        Square,
+        MachineType,
+        DrawToolpath,
+        Margin,
+        GeneratedBy,
+        CreationTime,
+        Flatness,
+        WorkpieceDimX,
+        WorkpieceDimY,
+        AutoClosePath,
+        Duration,
+        PointsInsideWorkpiece,
+        Speed,
+        GcodeFilename,
+        Unknown
+    };
 
-    template <class T>
-    T extractField(const QJsonObject& obj, QString fieldName, bool (QJsonValue::*check_f)() const,
-                   std::function<T(const QJsonValue&)> conv_f)
+    const struct {
+        const char* name;
+        Field field;
+    } knownFields[] = {
+        {"version", Field::Version},
+        {"name", Field::Name},
+        {"svgFilename", Field::SvgFilename},
+        {"square", Field::Square},
+        {"machineType", Field::MachineType},
+        {"drawToolpath", Field::DrawToolpath},
+        {"margin", Field::Margin},
+        {"generatedBy", Field::GeneratedBy},
+        {"creationTime", Field::CreationTime},
+        {"flatness", Field::Flatness},
+        {"workpieceDimX", Field::WorkpieceDimX},
+        {"workpieceDimY", Field::WorkpieceDimY},
+        {"autoClosePath", Field::AutoClosePath},
+        {"duration", Field::Duration},
+        {"pointsInsideWorkpiece", Field::PointsInsideWorkpiece},
+        {"speed", Field::Speed},
+        {"gcodeFilename", Field::GcodeFilename}
+    };
+
+    const unsigned int allFieldsMask = (1u << static_cast<unsigned int>(Field::Unknown)) - 1;
+
+    // Nesting limit for values of unknown fields
+    const int maxDepth = 64;
+
+    struct PsjFields
+    {
+        unsigned int version = 0;
+        QString name;
+        QString svgFilename;
+        bool square = false;
+        QString machineType;
+        bool drawToolpath = false;
+        double margin = 0.0;
+        QString generatedBy;
+        QDateTime creationTime;
+        double flatness = 0.0;
+        double workpieceDimX = 0.0;
+        double workpieceDimY = 0.0;
+        bool autoClosePath = false;
+        unsigned int duration = 0;
+        bool pointsInsideWorkpiece = false;
+        double speed = 0.0;
+        QString gcodeFilename;
+    };
+
+    // A single-pass parser for .psj files. It only accepts a JSON object, values of known fields
+    // are stored directly in PsjFields, values of unknown fields are validated and skipped. Any
+    // error (invalid JSON, wrong type, missing field) makes parse() return false
+    class PsjParser
     {
-        const auto& value = obj.value(fieldName);
-        if (value.isUndefined()) {
-            throw MissingFieldException();
+    public:
+        PsjParser(const char* begin, const char* end)
+            : m_cur(begin)
+            , m_end(end)
+        {
         }
-        if (!(value.*check_f)()) {
-            throw InvalidFieldTypeException();
+
+        bool parse(PsjFields& fields)
+        {
+            unsigned int foundFields = 0;
+
+            // A leading UTF-8 byte order mark is allowed, like QJsonDocument does
+            skipByteOrderMark();
+
+            skipWhitespaces();
+            if (!consume('{')) {
+                return false;
+            }
+
+            skipWhitespaces();
+            if (!consume('}')) {
+                do {
+                    skipWhitespaces();
+
+                    Field field;
+                    if (!parseKey(field)) {
+                        return false;
+                    }
+
+                    skipWhitespaces();
+                    if (!consume(':')) {
+                        return false;
+                    }
+                    skipWhitespaces();
+
+                    if (!parseFieldValue(field, fields)) {
+                        return false;
+                    }
+                    if (field != Field::Unknown) {
+                        foundFields |= 1u << static_cast<unsigned int>(field);
+                    }
+
+                    skipWhitespaces();
+                } while (consume(','));
+
+                if (!consume('}')) {
+                    return false;
+                }
+            }
+
+            skipWhitespaces();
+
+            return m_cur == m_end && foundFields == allFieldsMask;
         }
 
-        return conv_f(value);
-    }
+    private:
+        void skipByteOrderMark()
+        {
+            if (m_end - m_cur >= 3 && m_cur[0] == '\xEF' && m_cur[1] == '\xBB' && m_cur[2] == '\xBF') {
+                m_cur += 3;
+            }
+        }
+
+        bool atEnd() const
+        {
+            return m_cur == m_end;
+        }
+
+        bool consume(char c)
+        {
+            if (atEnd() || *m_cur != c) {
+                return false;
+            }
+
+            ++m_cur;
+            return true;
+        }
+
+        void skipWhitespaces()
+        {
+            while (!atEnd() && (*m_cur == ' ' || *m_cur == '\n' || *m_cur == '\r' || *m_cur == '\t')) {
+                ++m_cur;
+            }
+        }
+
+        bool parseKey(Field& field)
+        {
+            // Keys without escape sequences are compared without decoding them
+            const char* start = m_cur + 1;
+            QString decoded;
+            bool escaped;
+            if (!parseString(&decoded, escaped)) {
+                return false;
+            }
+
+            QByteArray key;
+            const char* keyData = start;
+            auto keyLength = static_cast<std::size_t>(m_cur - 1 - start);
+            if (escaped) {
+                key = decoded.toUtf8();
+                keyData = key.constData();
+                keyLength = static_cast<std::size_t>(key.size());
+            }
+
+            field = Field::Unknown;
+            for (const auto& f: knownFields) {
+                if (std::strlen(f.name) == keyLength && std::memcmp(f.name, keyData, keyLength) == 0) {
+                    field = f.field;
+                    break;
+                }
+            }
+
+            return true;
+        }
+
+        bool parseFieldValue(Field field, PsjFields& fields)
+        {
+            switch (field) {
+                case Field::Version:
+                    return parseUnsignedInt(fields.version) && fields.version == 1;
+                case Field::Name:
+                    return parseString(fields.name);
+                case Field::SvgFilename:
+                    return parseString(fields.svgFilename);
+                case Field::Square:
+                    return parseBool(fields.square);
+                case Field::MachineType:
+                    return parseString(fields.machineType);
+                case Field::DrawToolpath:
+                    return parseBool(fields.drawToolpath);
+                case Field::Margin:
+                    return parseNumber(fields.margin);
+                case Field::GeneratedBy:
+                    return parseString(fields.generatedBy);
+                case Field::CreationTime: {
+                    QString creationTime;
+                    if (!parseString(creationTime)) {
+                        return false;
+                    }
+                    fields.creationTime = QDateTime::fromString(creationTime, Qt::ISODateWithMs);
+                    return fields.creationTime.isValid();
+                }
+                case Field::Flatness:
+                    return parseNumber(fields.flatness);
+                case Field::WorkpieceDimX:
+                    return parseNumber(fields.workpieceDimX);
+                case Field::WorkpieceDimY:
+                    return parseNumber(fields.workpieceDimY);
+                case Field::AutoClosePath:
+                    return parseBool(fields.autoClosePath);
+                case Field::Duration:
+                    return parseUnsignedInt(fields.duration);
+                case Field::PointsInsideWorkpiece:
+                    return parseBool(fields.pointsInsideWorkpiece);
+                case Field::Speed:
+                    return parseNumber(fields.speed);
+                case Field::GcodeFilename:
+                    return parseString(fields.gcodeFilename);
+                case Field::Unknown:
+                    return skipValue(0);
+            }
+
+            return false;
+        }
+
+        bool parseString(QString& value)
+        {
+            bool escaped;
+            return parseString(&value, escaped);
+        }
+
+        // If value is nullptr the string is only validated
+        bool parseString(QString* value, bool& escaped)
+        {
+            escaped = false;
+            if (!consume('"')) {
+                return false;
+            }
+
+            const char* start = m_cur;
+            while (!atEnd() && *m_cur != '"' && *m_cur != '\\') {
+                if (static_cast<unsigned char>(*m_cur) < 0x20) {
+                    return false;
+                }
+                ++m_cur;
+            }
+
+            if (atEnd()) {
+                return false;
+            }
+
+            if (*m_cur == '"') {
+                if (value != nullptr) {
+                    *value = QString::fromUtf8(start, static_cast<int>(m_cur - start));
+                }
+                ++m_cur;
+                return true;
+            }
+
+            // Slow path, the string contains escape sequences
+            escaped = true;
+            QByteArray utf8(start, static_cast<int>(m_cur - start));
+            while (!atEnd() && *m_cur != '"') {
+                const char c = *m_cur++;
+
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    return false;
+                } else if (c != '\\') {
+                    utf8.append(c);
+                } else if (!parseEscapeSequence(utf8)) {
+                    return false;
+                }
+            }
+
+            if (!consume('"')) {
+                return false;
+            }
+
+            if (value != nullptr) {
+                *value = QString::fromUtf8(utf8);
+            }
+            return true;
+        }
+
+        bool parseEscapeSequence(QByteArray& utf8)
+        {
+            if (atEnd()) {
+                return false;
+            }
+
+            switch (*m_cur++) {
+                case '"': utf8.append('"'); return true;
+                case '\\': utf8.append('\\'); return true;
+                case '/': utf8.append('/'); return true;
+                case 'b': utf8.append('\b'); return true;
+                case 'f': utf8.append('\f'); return true;
+                case 'n': utf8.append('\n'); return true;
+                case 'r': utf8.append('\r'); return true;
+                case 't': utf8.append('\t'); return true;
+                case 'u': break;
+                default: return false;
+            }
+
+            unsigned int codePoint;
+            if (!parseHex4(codePoint)) {
+                return false;
+            }
+
+            // Surrogate pairs
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                unsigned int low;
+                if (!consume('\\') || !consume('u') || !parseHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                return false;
+            }
+
+            utf8.append(QString::fromUcs4(&codePoint, 1).toUtf8());
+            return true;
+        }
+
+        bool parseHex4(unsigned int& value)
+        {
+            value = 0;
+            for (auto i = 0; i < 4; ++i) {
+                if (atEnd()) {
+                    return false;
+                }
+
+                const char c = *m_cur++;
+                value <<= 4;
+                if (c >= '0' && c <= '9') {
+                    value |= static_cast<unsigned int>(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    value |= static_cast<unsigned int>(c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    value |= static_cast<unsigned int>(c - 'A' + 10);
+                } else {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool parseNumber(double& value)
+        {
+            // Validating the JSON number syntax, the conversion is then locale independent
+            const char* start = m_cur;
+
+            consume('-');
+            if (consume('0')) {
+                // No leading zeros
+            } else if (!skipDigits()) {
+                return false;
+            }
+            if (consume('.') && !skipDigits()) {
+                return false;
+            }
+            if (consume('e') || consume('E')) {
+                if (!consume('+')) {
+                    consume('-');
+                }
+                if (!skipDigits()) {
+                    return false;
+                }
+            }
+
+            bool ok;
+            value = QByteArray::fromRawData(start, static_cast<int>(m_cur - start)).toDouble(&ok);
+
+            return ok;
+        }
+
+        // Like QJsonValue::toInt, numbers with a fractional part are not accepted
+        bool parseUnsignedInt(unsigned int& value)
+        {
+            double d;
+            if (!parseNumber(d) || d < 0.0 || d > 2147483647.0 || static_cast<double>(static_cast<int>(d)) != d) {
+                return false;
+            }
+
+            value = static_cast<unsigned int>(d);
+            return true;
+        }
+
+        bool parseBool(bool& value)
+        {
+            if (parseLiteral("true")) {
+                value = true;
+                return true;
+            } else if (parseLiteral("false")) {
+                value = false;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool parseLiteral(const char* literal)
+        {
+            const auto length = std::strlen(literal);
+            if (static_cast<std::size_t>(m_end - m_cur) < length || std::memcmp(m_cur, literal, length) != 0) {
+                return false;
+            }
+
+            m_cur += length;
+            return true;
+        }
+
+        bool skipDigits()
+        {
+            const char* start = m_cur;
+            while (!atEnd() && *m_cur >= '0' && *m_cur <= '9') {
+                ++m_cur;
+            }
+
+            return m_cur != start;
+        }
+
+        bool skipValue(int depth)
+        {
+            if (atEnd() || depth > maxDepth) {
+                return false;
+            }
+
+            switch (*m_cur) {
+                case '"': {
+                    bool escaped;
+                    return parseString(nullptr, escaped);
+                }
+                case '{':
+                    return skipContainer('}', true, depth);
+                case '[':
+                    return skipContainer(']', false, depth);
+                case 't':
+                    return parseLiteral("true");
+                case 'f':
+                    return parseLiteral("false");
+                case 'n':
+                    return parseLiteral("null");
+                default: {
+                    double d;
+                    return parseNumber(d);
+                }
+            }
+        }
+
+        bool skipContainer(char close, bool isObject, int depth)
+        {
+            ++m_cur;
+            skipWhitespaces();
+            if (consume(close)) {
+                return true;
+            }
+
+            do {
+                skipWhitespaces();
+
+                if (isObject) {
+                    bool escaped;
+                    if (!parseString(nullptr, escaped)) {
+                        return false;
+                    }
+                    skipWhitespaces();
+                    if (!consume(':')) {
+                        return false;
+                    }
+                    skipWhitespaces();
+                }
+
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+
+                skipWhitespaces();
+            } while (consume(','));
+
+            return consume(close);
+        }
+
+        const char* m_cur;
+        const char* const m_end;
+    };
 }
 
 ShapeInfo ShapeInfo::createFromFile(QString filename)
 {
     QFile file(filename);
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return ShapeInfo();
-    }
-
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-
-    if (doc.isNull()) {
+    if (!file.open(QIODevice::ReadOnly)) {
         return ShapeInfo();
     }
 
-    const auto& obj = doc.object();
+    return createFromData(filename, file.readAll());
+}
 
-    const auto version = static_cast<unsigned int>(obj.value("version").toInt(0));
-    if (version != 1u) {
+ShapeInfo ShapeInfo::createFromData(QString filename, const QByteArray& content)
+{
+    PsjFields f;
+    PsjParser parser(content.constData(), content.constData() + content.size());
+    if (!parser.parse(f)) {
         return ShapeInfo();
     }
 
     const auto fileInfo = QFileInfo(filename);
-    const auto path = fileInfo.canonicalPath();
-    const auto psjFilename = fileInfo.fileName();
-
-    try {
-        return ShapeInfo(
-            version,
-            path,
-            psjFilename,
-            extractField<QString>(obj, "name", &QJsonValue::isString, [](const QJsonValue& v){return v.toString();}),
-            extractField<QString>(obj, "svgFilename", &QJsonValue::isString, [](const QJsonValue& v){return v.toString();}),
-            extractField<bool>(obj, "square", &QJsonValue::isBool, [](const QJsonValue& v){return v.toBool();}),
-            extractField<QString>(obj, "machineType", &QJsonValue::isString, [](const QJsonValue& v){return v.toString();}),
-            extractField<bool>(obj, "drawToolpath", &QJsonValue::isBool, [](const QJsonValue& v){return v.toBool();}),
-            extractField<double>(obj, "margin", &QJsonValue::isDouble, [](const QJsonValue& v){return v.toDouble();}),
-            extractField<QString>(obj, "generatedBy", &QJsonValue::isString, [](const QJsonValue& v){return v.toString();}),
-            extractField<QDateTime>(obj, "creationTime", &QJsonValue::isString, [](const QJsonValue& v){
-                auto date = QDateTime::fromString(v.toString(), Qt::ISODateWithMs);
-                if (!date.isValid()) {
-                    throw InvalidFieldTypeException();
-                }
-                return date;
-            }),
-            extractField<double>(obj, "flatness", &QJsonValue::isDouble, [](const QJsonValue& v){return v.toDouble();}),
-            extractField<double>(obj, "workpieceDimX", &QJsonValue::isDouble, [](const QJsonValue& v){
-                return v.toDouble();
-            }),
-            extractField<double>(obj, "workpieceDimY", &QJsonValue::isDouble, [](const QJsonValue& v){
-                return v.toDouble();
-            }),
-            extractField<bool>(obj, "autoClosePath", &QJsonValue::isBool, [](const QJsonValue& v){return v.toBool();}),
-            extractField<unsigned int>(obj, "duration", &QJsonValue::isDouble, [](const QJsonValue& v){
-                auto durationInt = v.toInt(-1);
-                if (durationInt < 0) {
-                    throw InvalidFieldTypeException();
-                }
-                return static_cast<unsigned int>(durationInt);
-            }),
-            extractField<bool>(obj, "pointsInsideWorkpiece", &QJsonValue::isBool, [](const QJsonValue& v){
-                return v.toBool();
-            }),
-            extractField<double>(obj, "speed", &QJsonValue::isDouble, [](const QJsonValue& v){return v.toDouble();}),
-            extractField<QString>(obj, "gcodeFilename", &QJsonValue::isString, [](const QJsonValue& v){
-                return v.toString();
-            }));
-    } catch (MissingFieldException&) {
-        return ShapeInfo();
-    } catch (InvalidFieldTypeException&) {
-        return ShapeInfo();
-    }
+
+    return ShapeInfo(f.version, fileInfo.canonicalPath(), fileInfo.fileName(), f.name, f.svgFilename,
+                     f.square, f.machineType, f.drawToolpath, f.margin, f.generatedBy,
+                     f.creationTime, f.flatness, f.workpieceDimX, f.workpieceDimY, f.autoClosePath,
+                     f.duration, f.pointsInsideWorkpiece, f.speed, f.gcodeFilename);
 }
 
 ShapeInfo::ShapeInfo()
-    : m_isValid(false)
-    , m_version(0)
-    , m_name()
-    , m_svgFilename()
-    , m_square(false)
-    , m_machineType()
-    , m_drawToolpath(false)
-    , m_margin(0.0)
-    , m_generatedBy()
-    , m_creationTime()
-    , m_flatness(0.0)
-    , m_workpieceDimX(0.0)
-    , m_workpieceDimY(0.0)
-    , m_autoClosePath(false)
-    , m_duration(0)
-    , m_pointsInsideWorkpiece(false)
-    , m_speed(0.0)
-    , m_gcodeFilename()
+    : m_parsed(invalidParsed())
+    , m_data(invalidData())
 {
 }
 
@@ -126,25 +550,142 @@ ShapeInfo::ShapeInfo(unsigned int version, QString path, QString psjFilename, QS
                      double workpieceDimX, double workpieceDimY, bool autoClosePath,
                      unsigned int duration, bool pointsInsideWorkpiece, double speed,
                      QString gcodeFilename)
-    : m_isValid(true)
-    , m_version(version)
-    , m_path(path)
-    , m_psjFilename(psjFilename)
-    , m_name(name)
-    , m_svgFilename(svgFilename)
-    , m_square(square)
-    , m_machineType(machineType)
-    , m_drawToolpath(drawToolpath)
-    , m_margin(margin)
-    , m_generatedBy(generatedBy)
-    , m_creationTime(creationTime)
-    , m_flatness(flatness)
-    , m_workpieceDimX(workpieceDimX)
-    , m_workpieceDimY(workpieceDimY)
-    , m_autoClosePath(autoClosePath)
-    , m_duration(duration)
-    , m_pointsInsideWorkpiece(pointsInsideWorkpiece)
-    , m_speed(speed)
-    , m_gcodeFilename(gcodeFilename)
+    : m_parsed()
+    , m_data()
+{
+    auto& pool = StringPool::global();
+
+    auto parsed = std::make_shared<Parsed>();
+    parsed->name = name;
+    parsed->svgFilename = svgFilename;
+    parsed->machineType = pool.intern(machineType);
+    parsed->generatedBy = pool.intern(generatedBy);
+    parsed->gcodeFilename = gcodeFilename;
+    parsed->creationTime = creationTime;
+    parsed->margin = margin;
+    parsed->flatness = flatness;
+    parsed->workpieceDimX = workpieceDimX;
+    parsed->workpieceDimY = workpieceDimY;
+    parsed->speed = speed;
+    parsed->version = version;
+    parsed->duration = duration;
+    parsed->isValid = true;
+    parsed->square = square;
+    parsed->drawToolpath = drawToolpath;
+    parsed->autoClosePath = autoClosePath;
+    parsed->pointsInsideWorkpiece = pointsInsideWorkpiece;
+
+    auto data = std::make_shared<Data>();
+    data->path = pool.intern(path);
+    data->psjFilename = psjFilename;
+    data->psjHash = 0;
+    data->gcodeHash = 0;
+    data->svgHash = 0;
+
+    m_parsed = std::move(parsed);
+    m_data = std::move(data);
+}
+
+quint64 ShapeInfo::contentHash() const
+{
+    if (psjHash() == 0) {
+        return 0;
+    }
+
+    return combineHashes(combineHashes(psjHash(), gcodeHash()), svgHash());
+}
+
+ShapeInfo ShapeInfo::withContentHashes(quint64 psjHash, quint64 gcodeHash, quint64 svgHash) const
+{
+    auto data = std::make_shared<Data>(*m_data);
+    if (data->psjHash != psjHash || data->gcodeHash != gcodeHash) {
+        data->gcodeCheck = GCodeCheck();
+    }
+    data->psjHash = psjHash;
+    data->gcodeHash = gcodeHash;
+    data->svgHash = svgHash;
+
+    ShapeInfo info;
+    info.m_parsed = m_parsed;
+    info.m_data = std::move(data);
+
+    return info;
+}
+
+ShapeInfo ShapeInfo::withGCodeCheck(GCodeCheck check) const
+{
+    auto data = std::make_shared<Data>(*m_data);
+    data->gcodeCheck = check;
+
+    ShapeInfo info;
+    info.m_parsed = m_parsed;
+    info.m_data = std::move(data);
+
+    return info;
+}
+
+ShapeInfo ShapeInfo::withLocation(QString path, QString psjFilename) const
+{
+    auto data = std::make_shared<Data>(*m_data);
+    data->path = StringPool::global().intern(path);
+    data->psjFilename = psjFilename;
+
+    ShapeInfo info;
+    info.m_parsed = m_parsed;
+    info.m_data = std::move(data);
+
+    return info;
+}
+
+const std::shared_ptr<const ShapeInfo::Parsed>& ShapeInfo::invalidParsed()
+{
+    static const std::shared_ptr<const Parsed> parsed = std::make_shared<const Parsed>(Parsed{});
+
+    return parsed;
+}
+
+const std::shared_ptr<const ShapeInfo::Data>& ShapeInfo::invalidData()
 {
+    static const std::shared_ptr<const Data> data = std::make_shared<const Data>(Data{});
+
+    return data;
+}
+
+QDataStream& operator<<(QDataStream& stream, const ShapeInfo& info)
+{
+    stream << info.isValid() << info.version() << info.path() << info.psjFilename() << info.name()
+           << info.svgFilename() << info.square() << info.machineType() << info.drawToolpath()
+           << info.margin() << info.generatedBy() << info.creationTime() << info.flatness()
+           << info.workpieceDimX() << info.workpieceDimY() << info.autoClosePath()
+           << info.duration() << info.pointsInsideWorkpiece() << info.speed()
+           << info.gcodeFilename() << info.psjHash() << info.gcodeHash() << info.svgHash()
+           << info.gcodeCheck();
+
+    return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, ShapeInfo& info)
+{
+    ShapeInfo::Parsed p{};
+    ShapeInfo::Data d{};
+    stream >> p.isValid >> p.version >> d.path >> d.psjFilename >> p.name >> p.svgFilename
+           >> p.square >> p.machineType >> p.drawToolpath >> p.margin >> p.generatedBy
+           >> p.creationTime >> p.flatness >> p.workpieceDimX >> p.workpieceDimY
+           >> p.autoClosePath >> p.duration >> p.pointsInsideWorkpiece >> p.speed
+           >> p.gcodeFilename >> d.psjHash >> d.gcodeHash >> d.svgHash >> d.gcodeCheck;
+
+    if (p.isValid) {
+        // Interning strings as the constructor does
+        auto& pool = StringPool::global();
+        d.path = pool.intern(d.path);
+        p.machineType = pool.intern(p.machineType);
+        p.generatedBy = pool.intern(p.generatedBy);
+
+        info.m_parsed = std::make_shared<const ShapeInfo::Parsed>(std::move(p));
+        info.m_data = std::make_shared<const ShapeInfo::Data>(std::move(d));
+    } else {
+        info = ShapeInfo();
+    }
+
+    return stream;
 }
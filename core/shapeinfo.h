@@ -1,13 +1,26 @@
 #ifndef SHAPEINFO_H
 #define SHAPEINFO_H
 
+#include <memory>
+#include <QByteArray>
+#include <QDataStream>
 #include <QDateTime>
 #include <QString>
+#include "gcodevalidator.h"
 
+// A cheap handle to the immutable data of a shape: copies share the same data. The data parsed
+// from the .psj file is kept apart from the location, hashes and G-code check, so that shapes
+// derived from this one with the with*() functions share it. Values that are the same for many
+// shapes (path, machineType and generatedBy) are interned in StringPool::global() so that all
+// shapes share a single copy
 class ShapeInfo
 {
+    friend QDataStream& operator>>(QDataStream& stream, ShapeInfo& info);
+
 public:
     static ShapeInfo createFromFile(QString filename);
+    // Like createFromFile, but content is the content of the file, already read
+    static ShapeInfo createFromData(QString filename, const QByteArray& content);
 
 public:
     ShapeInfo();
@@ -23,125 +36,186 @@ private:
 public:
     bool isValid() const
     {
-        return m_isValid;
+        return m_parsed->isValid;
     }
 
     unsigned int version() const
     {
-        return m_version;
+        return m_parsed->version;
     }
 
     QString path() const // The canonical file path containing the loaded file
     {
-        return m_path;
+        return m_data->path;
     }
 
     QString psjFilename() const
     {
-        return m_psjFilename;
+        return m_data->psjFilename;
     }
 
     QString name() const
     {
-        return m_name;
+        return m_parsed->name;
     }
 
     QString svgFilename() const
     {
-        return m_svgFilename;
+        return m_parsed->svgFilename;
     }
 
     bool square() const
     {
-        return m_square;
+        return m_parsed->square;
     }
 
     QString machineType() const
     {
-        return m_machineType;
+        return m_parsed->machineType;
     }
 
     bool drawToolpath() const
     {
-        return m_drawToolpath;
+        return m_parsed->drawToolpath;
     }
 
     double margin() const // in mm
     {
-        return m_margin;
+        return m_parsed->margin;
     }
 
     QString generatedBy() const
     {
-        return m_generatedBy;
+        return m_parsed->generatedBy;
     }
 
     QDateTime creationTime() const
     {
-        return m_creationTime;
+        return m_parsed->creationTime;
     }
 
     double flatness() const
     {
-        return m_flatness;
+        return m_parsed->flatness;
     }
 
     double workpieceDimX() const // in mm
     {
-        return m_workpieceDimX;
+        return m_parsed->workpieceDimX;
     }
 
     double workpieceDimY() const // in mm
     {
-        return m_workpieceDimY;
+        return m_parsed->workpieceDimY;
     }
 
     bool autoClosePath() const
     {
-        return m_autoClosePath;
+        return m_parsed->autoClosePath;
     }
 
     unsigned int duration() const // in seconds
     {
-        return m_duration;
+        return m_parsed->duration;
     }
 
     bool pointsInsideWorkpiece() const
     {
-        return m_pointsInsideWorkpiece;
+        return m_parsed->pointsInsideWorkpiece;
     }
 
     double speed() const // in mm/min
     {
-        return m_speed;
+        return m_parsed->speed;
     }
 
     QString gcodeFilename() const
     {
-        return m_gcodeFilename;
+        return m_parsed->gcodeFilename;
+    }
+
+    // Hashes of the content of the .psj, .gcode and .svg files (see XXHash64). They are 0 if not
+    // computed, createFromFile does not compute them
+    quint64 psjHash() const
+    {
+        return m_data->psjHash;
+    }
+
+    quint64 gcodeHash() const
+    {
+        return m_data->gcodeHash;
+    }
+
+    quint64 svgHash() const
+    {
+        return m_data->svgHash;
+    }
+
+    // A hash of the content of all the files of the shape. Shapes with the same content hash are
+    // copies of the same shape. Returns 0 if file hashes were not computed
+    quint64 contentHash() const;
+
+    // The result of the validation of the G-code file, see LocalShapesFinder
+    GCodeCheck gcodeCheck() const
+    {
+        return m_data->gcodeCheck;
     }
 
+    // Returns a copy of this shape with the given hashes. The G-code check is kept only if the
+    // .psj and .gcode hashes do not change (the check also depends on the workpiece size)
+    ShapeInfo withContentHashes(quint64 psjHash, quint64 gcodeHash, quint64 svgHash) const;
+    // Returns a copy of this shape with the given G-code check
+    ShapeInfo withGCodeCheck(GCodeCheck check) const;
+    // Returns a copy of this shape as if it was loaded from psjFilename in path. Used for shapes
+    // whose .psj file has the same content of this one. Other data is shared
+    ShapeInfo withLocation(QString path, QString psjFilename) const;
+
 private:
-    bool m_isValid;
-    unsigned int m_version;
-    QString m_path;
-    QString m_psjFilename;
-    QString m_name;
-    QString m_svgFilename;
-    bool m_square;
-    QString m_machineType;
-    bool m_drawToolpath;
-    double m_margin;
-    QString m_generatedBy;
-    QDateTime m_creationTime;
-    double m_flatness;
-    double m_workpieceDimX;
-    double m_workpieceDimY;
-    bool m_autoClosePath;
-    unsigned int m_duration;
-    bool m_pointsInsideWorkpiece;
-    double m_speed;
-    QString m_gcodeFilename;
+    // The content of the .psj file
+    struct Parsed
+    {
+        QString name;
+        QString svgFilename;
+        QString machineType;
+        QString generatedBy;
+        QString gcodeFilename;
+        QDateTime creationTime;
+        double margin;
+        double flatness;
+        double workpieceDimX;
+        double workpieceDimY;
+        double speed;
+        unsigned int version;
+        unsigned int duration;
+        bool isValid;
+        bool square;
+        bool drawToolpath;
+        bool autoClosePath;
+        bool pointsInsideWorkpiece;
+    };
+
+    // Where the shape was loaded from and what is known about the content of its files
+    struct Data
+    {
+        QString path;
+        QString psjFilename;
+        GCodeCheck gcodeCheck;
+        quint64 psjHash;
+        quint64 gcodeHash;
+        quint64 svgHash;
+    };
+
+    // Shared by all invalid shapes
+    static const std::shared_ptr<const Parsed>& invalidParsed();
+    static const std::shared_ptr<const Data>& invalidData();
+
+    std::shared_ptr<const Parsed> m_parsed;
+    std::shared_ptr<const Data> m_data;
 };
 
+// Used to store shapes in ShapeIndex. Also the validity flag, content hashes and the G-code check
+// are stored
+QDataStream& operator<<(QDataStream& stream, const ShapeInfo& info);
+QDataStream& operator>>(QDataStream& stream, ShapeInfo& info);
+
 #endif // SHAPEINFO_H
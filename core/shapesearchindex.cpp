@@ -0,0 +1,293 @@
+#include "shapesearchindex.h"
+#include <algorithm>
+#include <utility>
+
+ShapeSearchIndex::ShapeSearchIndex()
+{
+}
+
+int ShapeSearchIndex::size() const
+{
+    return m_ids.size();
+}
+
+int ShapeSearchIndex::insert(const QString& key, const ShapeInfo& info)
+{
+    remove(key);
+
+    const auto name = info.name().toCaseFolded();
+    const auto workpieceDimX = info.workpieceDimX();
+    const auto workpieceDimY = info.workpieceDimY();
+    const auto duration = static_cast<double>(info.duration());
+
+    int id;
+    if (m_freeIds.isEmpty()) {
+        id = m_keys.size();
+
+        m_keys.append(key);
+        m_names.append(name);
+        m_machineTypes.append(info.machineType());
+        m_square.push_back(info.square());
+        m_workpieceDimX.append(workpieceDimX);
+        m_workpieceDimY.append(workpieceDimY);
+        m_durations.append(duration);
+        m_used.push_back(true);
+        m_nameTrigrams.append(QVector<Trigram>());
+        m_trigramPositions.append(QVector<int>());
+        m_machineTypePositions.append(-1);
+        m_squarePositions.append(-1);
+    } else {
+        id = m_freeIds.takeLast();
+
+        m_keys[id] = key;
+        m_names[id] = name;
+        m_machineTypes[id] = info.machineType();
+        m_square[static_cast<std::size_t>(id)] = info.square();
+        m_workpieceDimX[id] = workpieceDimX;
+        m_workpieceDimY[id] = workpieceDimY;
+        m_durations[id] = duration;
+        m_used[static_cast<std::size_t>(id)] = true;
+    }
+
+    m_ids.insert(key, id);
+
+    m_nameTrigrams[id] = trigrams(name);
+    appendToTrigramLists(id);
+    appendToList(m_machineTypeIndex[info.machineType()], m_machineTypePositions, id);
+    appendToList(info.square() ? m_squareIndex : m_notSquareIndex, m_squarePositions, id);
+    m_workpieceDimXIndex.emplace(workpieceDimX, id);
+    m_workpieceDimYIndex.emplace(workpieceDimY, id);
+    m_durationIndex.emplace(duration, id);
+
+    return id;
+}
+
+void ShapeSearchIndex::remove(const QString& key)
+{
+    const auto it = m_ids.find(key);
+    if (it == m_ids.end()) {
+        return;
+    }
+
+    const auto id = it.value();
+    m_ids.erase(it);
+
+    removeFromTrigramLists(id);
+
+    auto machineTypeIt = m_machineTypeIndex.find(m_machineTypes[id]);
+    removeFromList(machineTypeIt.value(), m_machineTypePositions, id);
+    if (machineTypeIt.value().isEmpty()) {
+        m_machineTypeIndex.erase(machineTypeIt);
+    }
+
+    removeFromList(m_square[static_cast<std::size_t>(id)] ? m_squareIndex : m_notSquareIndex, m_squarePositions, id);
+    m_workpieceDimXIndex.erase(std::make_pair(m_workpieceDimX[id], id));
+    m_workpieceDimYIndex.erase(std::make_pair(m_workpieceDimY[id], id));
+    m_durationIndex.erase(std::make_pair(m_durations[id], id));
+
+    m_keys[id].clear();
+    m_names[id].clear();
+    m_machineTypes[id].clear();
+    m_nameTrigrams[id].clear();
+    m_trigramPositions[id].clear();
+    m_used[static_cast<std::size_t>(id)] = false;
+    m_freeIds.append(id);
+}
+
+void ShapeSearchIndex::clear()
+{
+    *this = ShapeSearchIndex();
+}
+
+int ShapeSearchIndex::id(const QString& key) const
+{
+    return m_ids.value(key, -1);
+}
+
+bool ShapeSearchIndex::matches(int id, const Query& query) const
+{
+    if (id < 0 || id >= m_keys.size() || !m_used[static_cast<std::size_t>(id)]) {
+        return false;
+    }
+
+    const bool squareOk = query.square == SquareFilter::Any ||
+                          (query.square == SquareFilter::Square) == m_square[static_cast<std::size_t>(id)];
+
+    return (query.text.isEmpty() || m_names[id].contains(query.text.toCaseFolded())) &&
+           (query.machineType.isEmpty() || m_machineTypes[id] == query.machineType) &&
+           squareOk &&
+           query.workpieceDimX.contains(m_workpieceDimX[id]) &&
+           query.workpieceDimY.contains(m_workpieceDimY[id]) &&
+           query.duration.contains(m_durations[id]);
+}
+
+std::vector<bool> ShapeSearchIndex::search(const Query& query) const
+{
+    auto result = m_used;
+
+    if (!query.text.isEmpty()) {
+        intersectWithText(result, query.text);
+    }
+
+    if (!query.machineType.isEmpty()) {
+        intersectWithList(result, m_machineTypeIndex.value(query.machineType));
+    }
+
+    if (query.square == SquareFilter::Square) {
+        intersectWithList(result, m_squareIndex);
+    } else if (query.square == SquareFilter::NotSquare) {
+        intersectWithList(result, m_notSquareIndex);
+    }
+
+    if (!query.workpieceDimX.isUnbounded()) {
+        intersectWithRange(result, m_workpieceDimXIndex, query.workpieceDimX);
+    }
+
+    if (!query.workpieceDimY.isUnbounded()) {
+        intersectWithRange(result, m_workpieceDimYIndex, query.workpieceDimY);
+    }
+
+    if (!query.duration.isUnbounded()) {
+        intersectWithRange(result, m_durationIndex, query.duration);
+    }
+
+    return result;
+}
+
+QVector<ShapeSearchIndex::Trigram> ShapeSearchIndex::trigrams(const QString& text)
+{
+    QVector<Trigram> t;
+
+    for (auto i = 0; i + 2 < text.size(); ++i) {
+        t.append((static_cast<Trigram>(text[i].unicode()) << 32) |
+                 (static_cast<Trigram>(text[i + 1].unicode()) << 16) |
+                 static_cast<Trigram>(text[i + 2].unicode()));
+    }
+
+    // A shape must appear only once in the list of a trigram
+    std::sort(t.begin(), t.end());
+    t.erase(std::unique(t.begin(), t.end()), t.end());
+
+    return t;
+}
+
+void ShapeSearchIndex::appendToList(QVector<int>& list, QVector<int>& positions, int id)
+{
+    positions[id] = list.size();
+    list.append(id);
+}
+
+void ShapeSearchIndex::removeFromList(QVector<int>& list, QVector<int>& positions, int id)
+{
+    // Order is not important, replacing the element with the last one
+    const auto pos = positions[id];
+    const auto last = list.last();
+    list[pos] = last;
+    positions[last] = pos;
+    list.removeLast();
+    positions[id] = -1;
+}
+
+void ShapeSearchIndex::appendToTrigramLists(int id)
+{
+    const auto& nameTrigrams = m_nameTrigrams[id];
+    auto& positions = m_trigramPositions[id];
+
+    positions.resize(nameTrigrams.size());
+    for (auto i = 0; i < nameTrigrams.size(); ++i) {
+        auto& list = m_trigrams[nameTrigrams[i]];
+        positions[i] = list.size();
+        list.append(id);
+    }
+}
+
+void ShapeSearchIndex::removeFromTrigramLists(int id)
+{
+    // Copies (which are cheap) because positions of other ids are modified in the loop
+    const auto nameTrigrams = m_nameTrigrams.at(id);
+    const auto positions = m_trigramPositions.at(id);
+
+    for (auto i = 0; i < nameTrigrams.size(); ++i) {
+        const auto t = nameTrigrams[i];
+        auto listIt = m_trigrams.find(t);
+        auto& list = listIt.value();
+        const auto pos = positions[i];
+        const auto last = list.last();
+
+        // Like removeFromList(), but the position of the moved id is the one of this trigram,
+        // found with a binary search as trigrams of names are sorted
+        list[pos] = last;
+        if (last != id) {
+            const auto& lastTrigrams = m_nameTrigrams[last];
+            const auto j = std::lower_bound(lastTrigrams.cbegin(), lastTrigrams.cend(), t) - lastTrigrams.cbegin();
+            m_trigramPositions[last][static_cast<int>(j)] = pos;
+        }
+        list.removeLast();
+
+        if (list.isEmpty()) {
+            m_trigrams.erase(listIt);
+        }
+    }
+}
+
+void ShapeSearchIndex::intersectWithText(std::vector<bool>& result, const QString& text) const
+{
+    const auto folded = text.toCaseFolded();
+    const auto queryTrigrams = trigrams(folded);
+
+    if (queryTrigrams.isEmpty()) {
+        // Text too short to use trigrams, checking all names
+        for (auto id = 0; id < m_names.size(); ++id) {
+            if (result[static_cast<std::size_t>(id)]) {
+                result[static_cast<std::size_t>(id)] = m_names[id].contains(folded);
+            }
+        }
+
+        return;
+    }
+
+    // Candidates are shapes in the shortest list, the actual match is then checked on the name
+    const QVector<int>* candidates = nullptr;
+    for (const auto t: queryTrigrams) {
+        const auto it = m_trigrams.constFind(t);
+        if (it == m_trigrams.cend()) {
+            std::fill(result.begin(), result.end(), false);
+            return;
+        }
+
+        if (candidates == nullptr || it.value().size() < candidates->size()) {
+            candidates = &(it.value());
+        }
+    }
+
+    std::vector<bool> matching(result.size(), false);
+    for (const auto id: *candidates) {
+        const auto i = static_cast<std::size_t>(id);
+        matching[i] = result[i] && m_names[id].contains(folded);
+    }
+
+    result = std::move(matching);
+}
+
+void ShapeSearchIndex::intersectWithList(std::vector<bool>& result, const QVector<int>& list) const
+{
+    std::vector<bool> matching(result.size(), false);
+    for (const auto id: list) {
+        const auto i = static_cast<std::size_t>(id);
+        matching[i] = result[i];
+    }
+
+    result = std::move(matching);
+}
+
+void ShapeSearchIndex::intersectWithRange(std::vector<bool>& result, const RangeIndex& index, const Range& range) const
+{
+    std::vector<bool> matching(result.size(), false);
+    const auto begin = index.lower_bound(std::make_pair(range.min, std::numeric_limits<int>::min()));
+    for (auto it = begin; it != index.cend() && it->first <= range.max; ++it) {
+        const auto i = static_cast<std::size_t>(it->second);
+        matching[i] = result[i];
+    }
+
+    result = std::move(matching);
+}
@@ -0,0 +1,117 @@
+#ifndef SHAPESEARCHINDEX_H
+#define SHAPESEARCHINDEX_H
+
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include "shapeinfo.h"
+
+// An index to search shapes by name and to filter them by some of their properties. Names are
+// indexed by trigrams, properties have one index each (facets). Shapes are identified by a key
+// (the .psj path) and, internally, by an integer id which is reused when shapes are removed.
+// The index can be updated incrementally, inserting or removing a shape does not depend on the
+// number of shapes (apart from logarithmic factors for ranges)
+class ShapeSearchIndex
+{
+public:
+    // A range of values, bounds are included
+    struct Range
+    {
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+
+        bool isUnbounded() const
+        {
+            return min == -std::numeric_limits<double>::infinity() &&
+                   max == std::numeric_limits<double>::infinity();
+        }
+
+        bool contains(double v) const
+        {
+            return v >= min && v <= max;
+        }
+    };
+
+    enum class SquareFilter {
+        Any,
+        Square,
+        NotSquare
+    };
+
+    struct Query
+    {
+        QString text; // Searched in names, case insensitive. Empty matches everything
+        QString machineType; // Empty matches everything
+        SquareFilter square = SquareFilter::Any;
+        Range workpieceDimX;
+        Range workpieceDimY;
+        Range duration;
+    };
+
+public:
+    ShapeSearchIndex();
+
+    int size() const;
+    // If the shape is already in the index it is replaced. Returns the id of the shape
+    int insert(const QString& key, const ShapeInfo& info);
+    void remove(const QString& key);
+    void clear();
+
+    // Returns -1 if the shape is not in the index
+    int id(const QString& key) const;
+    // Returns true if the shape with the given id matches the query
+    bool matches(int id, const Query& query) const;
+    // Returns a vector of flags indexed by id, true for shapes matching the query. The vector
+    // may be shorter than the largest id of shapes inserted after the search
+    std::vector<bool> search(const Query& query) const;
+
+private:
+    using Trigram = quint64;
+    // Pairs of value and id, so that each element is unique and can be removed without scanning
+    // ids with the same value
+    using RangeIndex = std::set<std::pair<double, int>>;
+
+    static QVector<Trigram> trigrams(const QString& text);
+    // Lists of ids are unordered. The position of each id in the list is stored in positions
+    // (indexed by id), so that it can be removed by replacing it with the last one
+    static void appendToList(QVector<int>& list, QVector<int>& positions, int id);
+    static void removeFromList(QVector<int>& list, QVector<int>& positions, int id);
+    void appendToTrigramLists(int id);
+    void removeFromTrigramLists(int id);
+    void intersectWithText(std::vector<bool>& result, const QString& text) const;
+    void intersectWithList(std::vector<bool>& result, const QVector<int>& list) const;
+    void intersectWithRange(std::vector<bool>& result, const RangeIndex& index, const Range& range) const;
+
+    // Columns indexed by id
+    QVector<QString> m_keys;
+    QVector<QString> m_names; // Case folded
+    QVector<QString> m_machineTypes;
+    std::vector<bool> m_square;
+    QVector<double> m_workpieceDimX;
+    QVector<double> m_workpieceDimY;
+    QVector<double> m_durations;
+    std::vector<bool> m_used;
+    // The trigrams of each name (sorted) and the position of the id in the list of each trigram
+    QVector<QVector<Trigram>> m_nameTrigrams;
+    QVector<QVector<int>> m_trigramPositions;
+    // The position of each id in the list of its machine type and in the square or not square list
+    QVector<int> m_machineTypePositions;
+    QVector<int> m_squarePositions;
+    QVector<int> m_freeIds;
+    QHash<QString, int> m_ids;
+    // The indexes
+    QHash<Trigram, QVector<int>> m_trigrams;
+    QHash<QString, QVector<int>> m_machineTypeIndex;
+    QVector<int> m_squareIndex;
+    QVector<int> m_notSquareIndex;
+    RangeIndex m_workpieceDimXIndex;
+    RangeIndex m_workpieceDimYIndex;
+    RangeIndex m_durationIndex;
+};
+
+#endif // SHAPESEARCHINDEX_H
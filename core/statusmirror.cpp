@@ -0,0 +1,76 @@
+#include "statusmirror.h"
+
+StatusMirror::StatusMirror(float initialTemperature)
+    : QObject()
+    , m_wireOn(false)
+    , m_temperature(initialTemperature)
+    , m_machineState(MachineState::Unknown)
+{
+}
+
+void StatusMirror::trackWireController(WireController* wireController)
+{
+    connect(wireController, &WireController::wireOn, this, &StatusMirror::setWireOn);
+    connect(wireController, &WireController::wireOff, this, &StatusMirror::setWireOff);
+    connect(wireController, &WireController::temperatureChanged, this, &StatusMirror::setTemperature);
+}
+
+void StatusMirror::trackStatusMonitor(MachineStatusMonitor* statusMonitor)
+{
+    connect(statusMonitor, &MachineStatusMonitor::stateChanged, this, &StatusMirror::setMachineState);
+}
+
+bool StatusMirror::wireOn() const
+{
+    return m_wireOn;
+}
+
+float StatusMirror::temperature() const
+{
+    return m_temperature;
+}
+
+MachineState StatusMirror::machineState() const
+{
+    return m_machineState;
+}
+
+void StatusMirror::setWireOn()
+{
+    if (m_wireOn) {
+        return;
+    }
+
+    m_wireOn = true;
+    emit wireOnChanged();
+}
+
+void StatusMirror::setWireOff()
+{
+    if (!m_wireOn) {
+        return;
+    }
+
+    m_wireOn = false;
+    emit wireOnChanged();
+}
+
+void StatusMirror::setTemperature(float temperature)
+{
+    if (m_temperature == temperature) {
+        return;
+    }
+
+    m_temperature = temperature;
+    emit temperatureChanged();
+}
+
+void StatusMirror::setMachineState(MachineState state)
+{
+    if (m_machineState == state) {
+        return;
+    }
+
+    m_machineState = state;
+    emit machineStateChanged();
+}
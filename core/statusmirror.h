@@ -0,0 +1,46 @@
+#ifndef STATUSMIRROR_H
+#define STATUSMIRROR_H
+
+#include <QObject>
+#include "machinestate.h"
+#include "machinestatusmonitor.h"
+#include "wirecontroller.h"
+
+// Keeps a copy of the state of objects that live in another thread (wire on/off, temperature and
+// machine state), so that it can be read without blocking on that thread. The copy is updated
+// through queued signals, so it might lag slightly behind. The setters can also be called directly
+// to record a change that has been requested but not notified yet. Signals are only emitted when
+// the mirrored value actually changes
+class StatusMirror : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StatusMirror(float initialTemperature);
+
+    // These connect the signals of the given object to the setters below. Call from the thread in
+    // which this object lives
+    void trackWireController(WireController* wireController);
+    void trackStatusMonitor(MachineStatusMonitor* statusMonitor);
+
+    bool wireOn() const;
+    float temperature() const;
+    MachineState machineState() const;
+
+public slots:
+    void setWireOn();
+    void setWireOff();
+    void setTemperature(float temperature);
+    void setMachineState(MachineState state);
+
+signals:
+    void wireOnChanged();
+    void temperatureChanged();
+    void machineStateChanged();
+
+private:
+    bool m_wireOn;
+    float m_temperature;
+    MachineState m_machineState;
+};
+
+#endif // STATUSMIRROR_H
@@ -0,0 +1,45 @@
+#include "stringpool.h"
+#include <QMutexLocker>
+
+StringPool& StringPool::global()
+{
+    static StringPool pool;
+
+    return pool;
+}
+
+StringPool::StringPool()
+    : m_mutex()
+    , m_strings()
+{
+}
+
+QString StringPool::intern(const QString& str)
+{
+    if (str.isNull()) {
+        return str;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_strings.constFind(str);
+    if (it == m_strings.constEnd()) {
+        it = m_strings.insert(str);
+    }
+
+    return *it;
+}
+
+int StringPool::size() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_strings.size();
+}
+
+void StringPool::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_strings.clear();
+}
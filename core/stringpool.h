@@ -0,0 +1,31 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+// A set of strings used to share the data of equal strings (interning). Strings are never
+// removed from the pool unless clear() is called, so it should only be used for values that
+// repeat often and have few distinct values. All methods are thread safe
+class StringPool
+{
+public:
+    // The pool used by ShapeInfo
+    static StringPool& global();
+
+public:
+    StringPool();
+
+    // Returns a string equal to str that shares data with all the equal strings previously
+    // interned. Null strings are returned as they are
+    QString intern(const QString& str);
+    int size() const;
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    QSet<QString> m_strings;
+};
+
+#endif // STRINGPOOL_H
@@ -0,0 +1,163 @@
+#include "terminallog.h"
+#include <algorithm>
+#include "immediatecommands.h"
+
+TerminalLog::TerminalLog(int capacity)
+    : m_capacity(std::max(1, capacity))
+    , m_lines()
+    , m_first(0)
+    , m_size(0)
+    , m_filterStatusPolling(false)
+{
+}
+
+int TerminalLog::capacity() const
+{
+    return m_capacity;
+}
+
+int TerminalLog::size() const
+{
+    return m_size;
+}
+
+const TerminalLog::Line& TerminalLog::line(int i) const
+{
+    return m_lines[(m_first + i) % m_capacity];
+}
+
+bool TerminalLog::filterStatusPolling() const
+{
+    return m_filterStatusPolling;
+}
+
+void TerminalLog::setFilterStatusPolling(bool filter)
+{
+    m_filterStatusPolling = filter;
+}
+
+void TerminalLog::appendSent(const QByteArray& data)
+{
+    // Sent data interrupts any partially received line
+    completePartialReceivedLine();
+
+    int start = 0;
+    int endline;
+    while ((endline = data.indexOf('\n', start)) != -1) {
+        addCompletedLine(Direction::Sent, data.mid(start, endline - start));
+        start = endline + 1;
+    }
+
+    if (start < data.size()) {
+        addCompletedLine(Direction::Sent, data.mid(start));
+    }
+}
+
+void TerminalLog::appendReceived(const QByteArray& data)
+{
+    m_partialReceivedLine += data;
+
+    int start = 0;
+    int endline;
+    while ((endline = m_partialReceivedLine.indexOf('\n', start)) != -1) {
+        auto text = m_partialReceivedLine.mid(start, endline - start);
+        if (text.endsWith('\r')) {
+            text.chop(1);
+        }
+        addCompletedLine(Direction::Received, text);
+        start = endline + 1;
+    }
+
+    m_partialReceivedLine.remove(0, start);
+}
+
+void TerminalLog::appendInfo(const QByteArray& text)
+{
+    completePartialReceivedLine();
+
+    addCompletedLine(Direction::Info, text);
+}
+
+QVector<TerminalLog::Line> TerminalLog::takeCompletedLines()
+{
+    QVector<Line> lines;
+    lines.swap(m_completedLines);
+
+    if (lines.size() > m_capacity) {
+        lines.erase(lines.begin(), lines.begin() + (lines.size() - m_capacity));
+    }
+
+    return lines;
+}
+
+int TerminalLog::linesToDiscard(int numLines) const
+{
+    return std::min(m_size, std::max(0, m_size + numLines - m_capacity));
+}
+
+void TerminalLog::discardOldestLines(int numLines)
+{
+    numLines = std::min(m_size, std::max(0, numLines));
+
+    m_first = (m_first + numLines) % m_capacity;
+    m_size -= numLines;
+}
+
+void TerminalLog::commitLines(const QVector<Line>& lines)
+{
+    // m_lines grows up to capacity, then lines are overwritten
+    for (const auto& l: lines) {
+        if (m_lines.size() < m_capacity) {
+            m_lines.append(l);
+            ++m_size;
+        } else if (m_size < m_capacity) {
+            m_lines[(m_first + m_size) % m_capacity] = l;
+            ++m_size;
+        } else {
+            m_lines[m_first] = l;
+            m_first = (m_first + 1) % m_capacity;
+        }
+    }
+}
+
+void TerminalLog::clear()
+{
+    m_lines.clear();
+    m_first = 0;
+    m_size = 0;
+    m_partialReceivedLine.clear();
+    m_completedLines.clear();
+}
+
+void TerminalLog::completePartialReceivedLine()
+{
+    if (!m_partialReceivedLine.isEmpty()) {
+        addCompletedLine(Direction::Received, m_partialReceivedLine);
+        m_partialReceivedLine.clear();
+    }
+}
+
+void TerminalLog::addCompletedLine(Direction direction, QByteArray text)
+{
+    if (m_filterStatusPolling && isStatusPollingLine(direction, text)) {
+        return;
+    }
+
+    m_completedLines.append(Line{direction, text});
+
+    // Avoid accumulating more lines than we can store if nobody takes them
+    if (m_completedLines.size() > 2 * m_capacity) {
+        m_completedLines.erase(m_completedLines.begin(), m_completedLines.begin() + m_capacity);
+    }
+}
+
+bool TerminalLog::isStatusPollingLine(Direction direction, const QByteArray& text) const
+{
+    if (direction == Direction::Sent) {
+        return text.size() == 1 && text[0] == ImmediateCommands::statusReportQuery;
+    } else if (direction == Direction::Received) {
+        return text.startsWith('<') && text.endsWith('>');
+    }
+
+    return false;
+}
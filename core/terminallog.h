@@ -0,0 +1,69 @@
+#ifndef TERMINALLOG_H
+#define TERMINALLOG_H
+
+#include <QByteArray>
+#include <QVector>
+
+// A fixed-capacity ring buffer of terminal lines. Data is appended in chunks as sent to or received
+// from the machine and split into lines. Each chunk that is sent is a command (or an immediate
+// command), so its last line is completed immediately, while received data is accumulated until an
+// endline is found. Lines are not stored directly when data is appended: completed lines are kept
+// apart until takeCompletedLines() is called, so that users can know how many lines will be added
+// and removed before modifying the buffer (see linesToDiscard() and commitLines()). When the buffer is full the oldest
+// lines are discarded, so the cost of adding a line does not depend on the number of stored lines
+class TerminalLog
+{
+public:
+    enum class Direction {
+        Sent,
+        Received,
+        Info
+    };
+
+    struct Line {
+        Direction direction;
+        QByteArray text; // Without the terminating endline
+    };
+
+public:
+    explicit TerminalLog(int capacity);
+
+    int capacity() const;
+    int size() const;
+    // 0 is the oldest line. i must be in [0, size())
+    const Line& line(int i) const;
+
+    // If true, status report queries and status reports are discarded
+    bool filterStatusPolling() const;
+    void setFilterStatusPolling(bool filter);
+
+    void appendSent(const QByteArray& data);
+    void appendReceived(const QByteArray& data);
+    void appendInfo(const QByteArray& text);
+
+    // Returns the lines completed since the last call. Only the last capacity() lines are returned
+    QVector<Line> takeCompletedLines();
+    // Returns how many of the stored lines must be discarded to commit numLines lines
+    int linesToDiscard(int numLines) const;
+    // Removes the numLines oldest lines
+    void discardOldestLines(int numLines);
+    // Stores lines (usually those returned by takeCompletedLines()), overwriting the oldest ones
+    // if needed
+    void commitLines(const QVector<Line>& lines);
+    void clear();
+
+private:
+    void completePartialReceivedLine();
+    void addCompletedLine(Direction direction, QByteArray text);
+    bool isStatusPollingLine(Direction direction, const QByteArray& text) const;
+
+    const int m_capacity;
+    QVector<Line> m_lines;
+    int m_first;
+    int m_size;
+    bool m_filterStatusPolling;
+    QByteArray m_partialReceivedLine;
+    QVector<Line> m_completedLines;
+};
+
+#endif // TERMINALLOG_H
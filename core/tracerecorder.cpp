@@ -0,0 +1,266 @@
+#include "tracerecorder.h"
+#include <algorithm>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+namespace {
+    std::atomic<quint64> nextRecorderUid{1};
+    std::atomic<quint64> nextThreadUid{1};
+
+    // The buffer of the last recorder used by this thread. Looking it up in the recorder would
+    // need the mutex
+    struct ThreadCache
+    {
+        quint64 recorderUid = 0;
+        void* buffer = nullptr;
+    };
+
+    thread_local ThreadCache threadCache;
+    thread_local const quint64 threadUid = nextThreadUid.fetch_add(1, std::memory_order_relaxed);
+
+    // Tells the recorders when this thread exits, so that its buffers can be given to new threads
+    struct ThreadLiveness
+    {
+        ~ThreadLiveness()
+        {
+            // The release store publishes the last events written by this thread
+            alive->store(false, std::memory_order_release);
+        }
+
+        const std::shared_ptr<std::atomic<bool>> alive = std::make_shared<std::atomic<bool>>(true);
+    };
+
+    thread_local ThreadLiveness threadLiveness;
+
+    QString currentThreadName()
+    {
+        const auto thread = QThread::currentThread();
+        if (!thread->objectName().isEmpty()) {
+            return thread->objectName();
+        } else if (QCoreApplication::instance() && QCoreApplication::instance()->thread() == thread) {
+            return "Main thread";
+        }
+
+        return QString("Thread %1").arg(threadUid);
+    }
+
+    void appendJsonString(QByteArray& json, const QByteArray& str)
+    {
+        json.append('"');
+        for (const char c: str) {
+            if (c == '"' || c == '\\') {
+                json.append('\\').append(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                json.append("\\u00").append(QByteArray::number(static_cast<int>(c), 16).rightJustified(2, '0'));
+            } else {
+                json.append(c);
+            }
+        }
+        json.append('"');
+    }
+
+    // Chrome expects timestamps in microseconds
+    QByteArray toMicroseconds(qint64 ns)
+    {
+        return QByteArray::number(static_cast<double>(ns) / 1000.0, 'f', 3);
+    }
+}
+
+TraceRecorder& TraceRecorder::global()
+{
+    static TraceRecorder recorder;
+
+    return recorder;
+}
+
+TraceRecorder::ThreadBuffer::ThreadBuffer(int size, quint64 tid, QString name, std::shared_ptr<const std::atomic<bool>> ownerAlive)
+    : events(new Event[size])
+    , size(size)
+    , tid(tid)
+    , name(name)
+    , ownerAlive(ownerAlive)
+    , written(0)
+    , clearedUpTo(0)
+{
+}
+
+TraceRecorder::TraceRecorder(int eventsPerThread)
+    : m_uid(nextRecorderUid.fetch_add(1, std::memory_order_relaxed))
+    , m_eventsPerThread(std::max(eventsPerThread, 1))
+    , m_enabled(false)
+    , m_clock()
+    , m_buffersMutex()
+    , m_buffers()
+    , m_eventsOfFinishedThreads(0)
+{
+    m_clock.start();
+}
+
+TraceRecorder::~TraceRecorder()
+{
+}
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 TraceRecorder::now() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+void TraceRecorder::recordZone(const char* name, qint64 startNs)
+{
+    const auto endNs = now();
+    record('X', name, startNs, endNs - startNs, 0);
+}
+
+void TraceRecorder::recordInstant(const char* name)
+{
+    record('i', name, now(), 0, 0);
+}
+
+void TraceRecorder::recordAsyncBegin(const char* name, quint64 id)
+{
+    record('b', name, now(), 0, id);
+}
+
+void TraceRecorder::recordAsyncEnd(const char* name, quint64 id)
+{
+    record('e', name, now(), 0, id);
+}
+
+void TraceRecorder::clear()
+{
+    QMutexLocker locker(&m_buffersMutex);
+
+    for (const auto& buffer: m_buffers) {
+        buffer->clearedUpTo.store(buffer->written.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
+
+qint64 TraceRecorder::recordedEvents() const
+{
+    QMutexLocker locker(&m_buffersMutex);
+
+    auto count = m_eventsOfFinishedThreads;
+    for (const auto& buffer: m_buffers) {
+        count += buffer->written.load(std::memory_order_acquire);
+    }
+
+    return count;
+}
+
+QByteArray TraceRecorder::toChromeJson() const
+{
+    QMutexLocker locker(&m_buffersMutex);
+
+    QByteArray json = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    json.append(R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"ShaCo"}})");
+
+    std::vector<Event> events;
+    for (const auto& buffer: m_buffers) {
+        const auto tid = QByteArray::number(buffer->tid);
+
+        json.append(R"(,{"name":"thread_name","ph":"M","pid":1,"tid":)").append(tid).append(R"(,"args":{"name":)");
+        appendJsonString(json, buffer->name.toUtf8());
+        json.append("}}");
+
+        // The owning thread can write while we copy. Events that may have been overwritten during
+        // the copy are dropped, so the rest is consistent
+        const auto end = buffer->written.load(std::memory_order_acquire);
+        const auto begin = std::max(end - buffer->size, buffer->clearedUpTo.load(std::memory_order_acquire));
+        events.clear();
+        for (auto i = begin; i < end; ++i) {
+            events.push_back(buffer->events[i % buffer->size]);
+        }
+        const auto firstValid = std::max(begin, buffer->written.load(std::memory_order_acquire) - buffer->size);
+
+        for (auto i = firstValid - begin; i < static_cast<qint64>(events.size()); ++i) {
+            const auto& e = events[i];
+
+            json.append(R"(,{"name":)");
+            appendJsonString(json, e.name);
+            json.append(R"(,"cat":"shaco","ph":")").append(e.phase).append(R"(","pid":1,"tid":)").append(tid);
+            json.append(R"(,"ts":)").append(toMicroseconds(e.timestampNs));
+            if (e.phase == 'X') {
+                json.append(R"(,"dur":)").append(toMicroseconds(e.durationNs));
+            } else if (e.phase == 'i') {
+                json.append(R"(,"s":"t")");
+            } else {
+                json.append(R"(,"id":"0x)").append(QByteArray::number(e.id, 16)).append('"');
+            }
+            json.append('}');
+        }
+    }
+
+    json.append("]}");
+
+    return json;
+}
+
+bool TraceRecorder::saveChromeJson(const QString& filename) const
+{
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(toChromeJson());
+
+    return file.commit();
+}
+
+void TraceRecorder::record(char phase, const char* name, qint64 timestampNs, qint64 durationNs, quint64 id)
+{
+    auto buffer = threadBuffer();
+
+    // Only this thread writes, so a relaxed load is enough. The release store publishes the event
+    const auto index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % buffer->size] = Event{name, timestampNs, durationNs, id, phase};
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::threadBuffer()
+{
+    if (threadCache.recorderUid != m_uid) {
+        threadCache.buffer = registerThread();
+        threadCache.recorderUid = m_uid;
+    }
+
+    return static_cast<ThreadBuffer*>(threadCache.buffer);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::registerThread()
+{
+    QMutexLocker locker(&m_buffersMutex);
+
+    // The thread may have already used this recorder before switching to another one
+    for (const auto& buffer: m_buffers) {
+        if (buffer->tid == threadUid) {
+            return buffer.get();
+        }
+    }
+
+    // The thread that owned the buffer will not write anymore, the acquire load makes its last
+    // events visible before they are discarded
+    for (const auto& buffer: m_buffers) {
+        if (!buffer->ownerAlive->load(std::memory_order_acquire)) {
+            m_eventsOfFinishedThreads += buffer->written.load(std::memory_order_relaxed);
+            buffer->tid = threadUid;
+            buffer->name = currentThreadName();
+            buffer->ownerAlive = threadLiveness.alive;
+            buffer->clearedUpTo.store(0, std::memory_order_relaxed);
+            buffer->written.store(0, std::memory_order_release);
+
+            return buffer.get();
+        }
+    }
+
+    m_buffers.emplace_back(new ThreadBuffer(m_eventsPerThread, threadUid, currentThreadName(), threadLiveness.alive));
+
+    return m_buffers.back().get();
+}
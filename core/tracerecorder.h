@@ -0,0 +1,159 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+
+// Records timed events from any thread and exports them in the Chrome trace event format (open
+// the file with chrome://tracing or https://ui.perfetto.dev). Each thread writes into its own
+// ring buffer without locks: only the first event of a thread takes a mutex, to register the
+// buffer. When a buffer is full the oldest events of that thread are overwritten. The buffer of a
+// thread that finished keeps its events until a new thread takes it over, so threads that come and
+// go (e.g. those of QThreadPool) do not make the memory grow. Recording is
+// disabled by default; when disabled, recording an event costs a relaxed atomic load. Event
+// names must be string literals (or anyway must outlive the recorder), they are not copied
+class TraceRecorder
+{
+public:
+    // The recorder used by the TRACE_* macros
+    static TraceRecorder& global();
+
+public:
+    explicit TraceRecorder(int eventsPerThread = 65536);
+    ~TraceRecorder();
+
+    bool isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled);
+    // Nanoseconds since the recorder was created
+    qint64 now() const;
+
+    // A zone of code that started at startNs and ends now
+    void recordZone(const char* name, qint64 startNs);
+    // An event without duration
+    void recordInstant(const char* name);
+    // Begin and end of an operation that may span threads or event loop iterations (e.g. a
+    // command waiting for the ack). Events with the same name and id are paired
+    void recordAsyncBegin(const char* name, quint64 id);
+    void recordAsyncEnd(const char* name, quint64 id);
+
+    // Discards all the events recorded so far. Can be called while other threads record events
+    void clear();
+    // Total number of recorded events (also those overwritten in full or reused buffers)
+    qint64 recordedEvents() const;
+    // Events can be exported while other threads record new ones: events recorded during the
+    // export may be missing
+    QByteArray toChromeJson() const;
+    bool saveChromeJson(const QString& filename) const;
+
+private:
+    struct Event
+    {
+        const char* name;
+        qint64 timestampNs;
+        qint64 durationNs; // For zones only
+        quint64 id; // For async events only
+        char phase; // As in the Chrome trace event format: 'X', 'i', 'b' or 'e'
+    };
+
+    struct ThreadBuffer
+    {
+        ThreadBuffer(int size, quint64 tid, QString name, std::shared_ptr<const std::atomic<bool>> ownerAlive);
+
+        const std::unique_ptr<Event[]> events;
+        const int size;
+        // The owner fields change when the buffer is taken over by a new thread, always with the
+        // mutex held
+        quint64 tid;
+        QString name;
+        // Set to false when the owning thread exits
+        std::shared_ptr<const std::atomic<bool>> ownerAlive;
+        // Only modified by the owning thread. An event is readable once written is past it
+        std::atomic<qint64> written;
+        // Events before this are discarded
+        std::atomic<qint64> clearedUpTo;
+    };
+
+    void record(char phase, const char* name, qint64 timestampNs, qint64 durationNs, quint64 id);
+    ThreadBuffer* threadBuffer();
+    ThreadBuffer* registerThread();
+
+    // Used to tell recorders apart in the per-thread cache, addresses could be reused
+    const quint64 m_uid;
+    const int m_eventsPerThread;
+    std::atomic<bool> m_enabled;
+    QElapsedTimer m_clock;
+    mutable QMutex m_buffersMutex;
+    // Buffers of threads that finished are reused instead of being removed
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    // Events written in buffers before they were taken over by a new thread
+    qint64 m_eventsOfFinishedThreads;
+};
+
+// Records the time from construction to destruction as a zone, if the recorder is enabled
+class TraceZone
+{
+public:
+    TraceZone(TraceRecorder& recorder, const char* name)
+        : m_recorder(recorder.isEnabled() ? &recorder : nullptr)
+        , m_name(name)
+        , m_startNs(m_recorder ? m_recorder->now() : 0)
+    {
+    }
+
+    ~TraceZone()
+    {
+        if (m_recorder) {
+            m_recorder->recordZone(m_name, m_startNs);
+        }
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    TraceRecorder* const m_recorder;
+    const char* const m_name;
+    const qint64 m_startNs;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+// Records the rest of the enclosing scope as a zone in the global recorder
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(TraceRecorder::global(), name)
+
+#define TRACE_INSTANT(name) \
+    do { \
+        auto& traceRecorder = TraceRecorder::global(); \
+        if (traceRecorder.isEnabled()) { \
+            traceRecorder.recordInstant(name); \
+        } \
+    } while (false)
+
+#define TRACE_ASYNC_BEGIN(name, id) \
+    do { \
+        auto& traceRecorder = TraceRecorder::global(); \
+        if (traceRecorder.isEnabled()) { \
+            traceRecorder.recordAsyncBegin(name, id); \
+        } \
+    } while (false)
+
+#define TRACE_ASYNC_END(name, id) \
+    do { \
+        auto& traceRecorder = TraceRecorder::global(); \
+        if (traceRecorder.isEnabled()) { \
+            traceRecorder.recordAsyncEnd(name, id); \
+        } \
+    } while (false)
+
+#endif // TRACERECORDER_H
@@ -0,0 +1,97 @@
+#include "traffictap.h"
+
+namespace {
+    bool registerBatch()
+    {
+        static bool registered = false;
+
+        if (!registered) {
+            qRegisterMetaType<TrafficTap::Batch>();
+
+            registered = true;
+        }
+
+        return registered;
+    }
+}
+
+const bool TrafficTap::batchRegistered = registerBatch();
+
+TrafficTap::TrafficTap(MachineCommunication* communicator, int flushIntervalMillis)
+    : m_communicator(communicator)
+    , m_subscribers(0)
+{
+    m_flushTimer.setInterval(flushIntervalMillis);
+    m_flushTimer.setSingleShot(true);
+
+    connect(&m_flushTimer, &QTimer::timeout, this, &TrafficTap::flush);
+}
+
+int TrafficTap::subscribers() const
+{
+    return m_subscribers;
+}
+
+void TrafficTap::subscribe()
+{
+    ++m_subscribers;
+
+    if (m_subscribers == 1) {
+        connect(m_communicator, &MachineCommunication::dataSent, this, &TrafficTap::dataSent);
+        connect(m_communicator, &MachineCommunication::dataReceived, this, &TrafficTap::dataReceived);
+    }
+}
+
+void TrafficTap::unsubscribe()
+{
+    if (m_subscribers == 0) {
+        return;
+    }
+
+    --m_subscribers;
+
+    if (m_subscribers == 0) {
+        disconnect(m_communicator, &MachineCommunication::dataSent, this, &TrafficTap::dataSent);
+        disconnect(m_communicator, &MachineCommunication::dataReceived, this, &TrafficTap::dataReceived);
+
+        m_flushTimer.stop();
+        m_pending.clear();
+    }
+}
+
+void TrafficTap::dataSent(QByteArray data)
+{
+    append(Direction::Sent, data);
+}
+
+void TrafficTap::dataReceived(QByteArray data)
+{
+    append(Direction::Received, data);
+}
+
+void TrafficTap::flush()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    Batch batch;
+    batch.swap(m_pending);
+
+    emit trafficAvailable(batch);
+}
+
+void TrafficTap::append(Direction direction, const QByteArray& data)
+{
+    if (!m_pending.isEmpty() && m_pending.last().direction == direction) {
+        m_pending.last().data += data;
+    } else {
+        m_pending.append(Chunk{direction, data});
+    }
+
+    // Not restarting the timer if active, so that batches are delivered at regular intervals even
+    // if data flows continuously
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
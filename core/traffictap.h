@@ -0,0 +1,67 @@
+#ifndef TRAFFICTAP_H
+#define TRAFFICTAP_H
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include "machinecommunication.h"
+
+// Collects data sent to and received from the machine and delivers it in batches, at most once
+// every flushIntervalMillis milliseconds. Data is only collected while there is at least one
+// subscriber: without subscribers the tap is not even connected to MachineCommunication, so
+// streaming pays nothing for it. Lives in the same thread as MachineCommunication, batches can be
+// delivered to other threads
+class TrafficTap : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const bool batchRegistered;
+
+public:
+    enum class Direction {
+        Sent,
+        Received
+    };
+
+    struct Chunk {
+        Direction direction;
+        QByteArray data;
+    };
+
+    // Consecutive chunks in the same direction are merged
+    using Batch = QVector<Chunk>;
+
+public:
+    explicit TrafficTap(MachineCommunication* communicator, int flushIntervalMillis);
+
+    int subscribers() const;
+
+public slots:
+    void subscribe();
+    // Pending data is discarded when the last subscriber leaves
+    void unsubscribe();
+
+signals:
+    // Class name needed because type registered with namespace
+    void trafficAvailable(TrafficTap::Batch batch);
+
+private slots:
+    void dataSent(QByteArray data);
+    void dataReceived(QByteArray data);
+    void flush();
+
+private:
+    void append(Direction direction, const QByteArray& data);
+
+    MachineCommunication* const m_communicator;
+    QTimer m_flushTimer;
+    int m_subscribers;
+    Batch m_pending;
+};
+
+Q_DECLARE_METATYPE(TrafficTap::Batch)
+
+#endif // TRAFFICTAP_H
@@ -0,0 +1,61 @@
+import QtQuick 2.4
+import QtQuick.Controls 2.2
+import QtQuick.Layouts 1.3
+
+ColumnLayout {
+    id: root
+
+    signal back
+
+    // Metrics are only refreshed while they are shown
+    onVisibleChanged: controller.setDiagnosticsActive(visible)
+
+    ListView {
+        id: metricsList
+
+        Layout.fillHeight: true
+        Layout.fillWidth: true
+        Layout.margins: 3
+        clip: true
+        model: controller.metricsModel
+
+        delegate: RowLayout {
+            width: metricsList.width
+
+            Text {
+                Layout.fillWidth: false
+                Layout.preferredWidth: metricsList.width / 3
+                text: model.name
+                font.bold: true
+                elide: Text.ElideRight
+            }
+
+            Text {
+                Layout.fillWidth: true
+                text: model.value
+                elide: Text.ElideRight
+            }
+        }
+
+        ScrollBar.vertical: ScrollBar {}
+    }
+
+    RowLayout {
+        Layout.fillHeight: false
+        Layout.preferredHeight: 50
+        Layout.fillWidth: true
+
+        Button {
+            Layout.fillHeight: true
+            Layout.fillWidth: false
+            Layout.margins: 3
+            text: qsTr("Back")
+
+            onClicked: root.back()
+        }
+
+        Item {
+            Layout.fillWidth: true
+        }
+    }
+}
@@ -21,6 +21,11 @@ ColumnLayout {
         Layout.margins: 3
     }
 
+    SearchControl {
+        Layout.fillWidth: true
+        Layout.fillHeight: false
+    }
+
     SortControl {
         Layout.fillWidth: true
         Layout.fillHeight: false
@@ -61,7 +66,9 @@ ColumnLayout {
             Layout.fillHeight: true
             Layout.margins: 3
             text: qsTr("Start cutting")
-            enabled: controller.connected && shapesView.selectedItem !== null
+            // Shapes whose G-code would be refused by the machine cannot be cut
+            enabled: controller.connected && shapesView.selectedItem !== null &&
+                     shapesView.selectedItem.gcodeStatus !== "invalid"
             visible: !controller.streamingGCode
 
             onClicked: {
@@ -0,0 +1,41 @@
+import QtQuick 2.4
+import QtQuick.Controls 2.2
+import QtQuick.Layouts 1.3
+
+RowLayout {
+    id:root
+
+    Text {
+        Layout.fillHeight: true
+        Layout.fillWidth: false
+        text: qsTr("Search: ")
+    }
+
+    TextField {
+        id: searchField
+
+        Layout.fillHeight: true
+        Layout.fillWidth: true
+        placeholderText: qsTr("Shape name")
+        selectByMouse: true
+
+        // Filtering is fast, so the query is updated as the user types
+        onTextChanged: controller.changeLocalShapesSearch(text)
+    }
+
+    ComboBox {
+        id: squareComboBox
+
+        Layout.fillHeight: true
+        Layout.fillWidth: false
+        textRole: "name"
+
+        model: ListModel {
+            ListElement { filter: "any"; name: qsTr("Any panel") }
+            ListElement { filter: "square"; name: qsTr("Square panel") }
+            ListElement { filter: "notSquare"; name: qsTr("Rectangular panel") }
+        }
+
+        onActivated: controller.changeLocalShapesSquareFilter(model.get(currentIndex).filter)
+    }
+}
@@ -27,6 +27,9 @@ ColumnLayout{
         property double panelX: 0.0
         property double panelY: 0.0
         property string otherInfo: ""
+        // Bound to the current item because the check of the G-code can end after the selection
+        property string gcodeStatus: (grid.currentItem !== null) ? grid.currentItem.shapeGCodeStatus : ""
+        property string gcodeProblem: (grid.currentItem !== null) ? grid.currentItem.shapeGCodeProblem : ""
     }
 
     GridView {
@@ -56,6 +59,8 @@ ColumnLayout{
             height: grid.cellSize
 
             property real internalSize: grid.cellSize - 2 * grid.borderWidth
+            property string shapeGCodeStatus: gcodeStatus
+            property string shapeGCodeProblem: gcodeProblem
 
             Image {
                 id: itemImage
@@ -63,7 +68,10 @@ ColumnLayout{
                 y: grid.borderWidth
                 width: parent.internalSize
                 height: parent.internalSize / 7 * 6
-                source: "file:" + svgFilename
+                // Thumbnails are rasterized in background and cached, see ThumbnailProvider
+                source: thumbnailSource
+                sourceSize.width: width
+                sourceSize.height: height
                 fillMode: Image.PreserveAspectFit
                 horizontalAlignment: Image.AlignHCenter
                 verticalAlignment: Image.AlignVCenter
@@ -79,6 +87,23 @@ ColumnLayout{
                 horizontalAlignment: Text.AlignHCenter
             }
 
+            Rectangle {
+                x: grid.borderWidth
+                y: grid.borderWidth
+                width: 24
+                height: 24
+                radius: 12
+                visible: gcodeStatus === "invalid" || gcodeStatus === "warning"
+                color: (gcodeStatus === "invalid") ? "#d01010" : "#e0a000"
+
+                Text {
+                    anchors.centerIn: parent
+                    text: "!"
+                    color: "white"
+                    font.bold: true
+                }
+            }
+
             MouseArea {
                 hoverEnabled: true
                 anchors.fill: parent
@@ -95,7 +120,8 @@ ColumnLayout{
                     theShape.panelX = workpieceDimX
                     theShape.panelY = workpieceDimY
                     theShape.otherInfo = "Working time: " + ShaCoUtils.secondsToMMSS(duration) + "<br>Panel size: " +
-                            ShaCoUtils.panelSize(workpieceDimX, workpieceDimY);
+                            ShaCoUtils.panelSize(workpieceDimX, workpieceDimY) +
+                            ((gcodeProblem !== "") ? "<br>G-code: " + gcodeProblem : "");
                 }
 
                 onPositionChanged: {
@@ -104,12 +130,13 @@ ColumnLayout{
                     detailsDialog.detailsX = parent.x + mouse.x
                     detailsDialog.detailsY = (parent.y - grid.visibleArea.yPosition * grid.contentHeight) + mouse.y
 
-                    detailsDialog.imageSource = "file:" + svgFilename
+                    detailsDialog.imageSource = thumbnailSource
                     detailsDialog.shapeName = "<b>" + name + "<\b>"
                     detailsDialog.shapeDescription = "Generated by " + generatedBy + " on " + creationTime +
                             " for " + machineType
                     detailsDialog.shapeOtherInfo = "Working time: " + ShaCoUtils.secondsToMMSS(duration) +
-                            "<br>Panel size: " + ShaCoUtils.panelSize(workpieceDimX, workpieceDimY);
+                            "<br>Panel size: " + ShaCoUtils.panelSize(workpieceDimX, workpieceDimY) +
+                            ((gcodeProblem !== "") ? "<br>G-code: " + gcodeProblem : "");
                 }
 
                 onExited: timer.stop()
@@ -159,6 +186,8 @@ ColumnLayout{
                 Layout.fillWidth: false
                 Layout.preferredHeight: 240
                 Layout.preferredWidth: 240
+                sourceSize.width: 240
+                sourceSize.height: 240
                 fillMode: Image.PreserveAspectFit
                 Layout.alignment: Qt.AlignHCenter
             }
@@ -8,8 +8,6 @@ ColumnLayout {
 
     signal back
 
-    property int bufferSize: 10000
-
     QtObject {
         id: privateProps
 
@@ -31,58 +29,31 @@ ColumnLayout {
          visible: false
     }
 
-    Connections {
-        target: controller
-        onDataSent:
-            if (terminalEnabled.checked) {
-                textArea.appendText("▶" + data)
-                textAreaScroll.toEnd()
-            }
-        onDataReceived:
-            if (terminalEnabled.checked) {
-                textArea.appendText("◀" + data)
-                textAreaScroll.toEnd()
-            }
-        onPortClosedWithError:
-            if (terminalEnabled.checked) {
-                textArea.appendText("--------\n")
-                textAreaScroll.toEnd()
-            }
-        onPortClosed:
-            if (terminalEnabled.checked) {
-                textArea.appendText("--------\n")
-                textAreaScroll.toEnd()
-            }
-    }
+    ListView {
+        id: terminalLines
 
-    ScrollView {
         Layout.fillHeight: true
         Layout.fillWidth: true
         Layout.margins: 3
+        clip: true
+        model: controller.terminalModel
+
+        // Only creates delegates for visible lines, the model can be very large
+        delegate: Text {
+            width: terminalLines.width
+            text: model.text
+            elide: Text.ElideRight
+        }
 
-        Flickable {
-            id: textAreaScroll
-            clip: true
-
-            function toEnd() {
-                contentY = -Math.min(height - contentHeight, 0)
-            }
-
-            TextArea {
-                id: textArea
-                horizontalAlignment: Text.AlignLeft
-                verticalAlignment: Text.AlignTop
-                readOnly: true
+        ScrollBar.vertical: ScrollBar {}
 
-                function appendText(toAppend) {
-                    text += toAppend
+        property bool followTail: true
 
-                    if (text.length > bufferSize) {
-                        text = text.substr(-bufferSize)
-                    }
-                }
+        onMovementEnded: followTail = atYEnd
+        onCountChanged:
+            if (followTail) {
+                positionViewAtEnd()
             }
-        }
     }
 
     Button {
@@ -92,10 +63,22 @@ ColumnLayout {
         Layout.fillWidth: true
         Layout.margins: 3
         checkable: true
-        checked: false
+        checked: controller.terminalEnabled
         enabled: true
 
         text: checked ? qsTr("Terminal Enabled") : qsTr("Enable Terminal")
+
+        onCheckedChanged: controller.terminalEnabled = checked
+    }
+
+    CheckBox {
+        Layout.fillHeight: false
+        Layout.fillWidth: true
+        Layout.margins: 3
+        checked: controller.terminalFilterStatusPolling
+        text: qsTr("Hide status polling")
+
+        onCheckedChanged: controller.terminalFilterStatusPolling = checked
     }
 
     RowLayout {
@@ -173,6 +156,31 @@ ColumnLayout {
         }
     }
 
+    RowLayout {
+        Layout.fillHeight: false
+        Layout.preferredHeight: 50
+        Layout.fillWidth: true
+
+        CheckBox {
+            Layout.fillHeight: true
+            Layout.fillWidth: true
+            Layout.margins: 3
+            checked: controller.tracingEnabled
+            text: qsTr("Record trace")
+
+            onCheckedChanged: controller.tracingEnabled = checked
+        }
+
+        Button {
+            Layout.fillHeight: true
+            Layout.fillWidth: false
+            Layout.margins: 3
+            text: qsTr("Save trace...")
+
+            onClicked: traceFileDialog.open()
+        }
+    }
+
     RowLayout {
         Layout.fillHeight: false
         Layout.preferredHeight: 50
@@ -191,4 +199,14 @@ ColumnLayout {
             Layout.fillWidth: true
         }
     }
+
+    FileDialog {
+        id: traceFileDialog
+        title: qsTr("Save the trace")
+        folder: shortcuts.home
+        selectExisting: false
+        nameFilters: ["Trace files (*.json)", "All files (*)"]
+
+        onAccepted: controller.saveTrace(fileUrl)
+    }
 }
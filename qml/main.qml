@@ -179,6 +179,9 @@ Window {
                 if (stack.currentItem !== terminalView && event.key === Qt.Key_T && event.modifiers === Qt.ControlModifier) {
                     stack.push(terminalView)
                     event.accepted = true
+                } else if (stack.currentItem !== diagnosticsView && event.key === Qt.Key_D && event.modifiers === Qt.ControlModifier) {
+                    stack.push(diagnosticsView)
+                    event.accepted = true
                 }
         }
     }
@@ -210,7 +213,10 @@ Window {
     CutPreparationView {
         id: cutPreparationView
         visible: false
-        onBack: stack.pop()
+        onBack: {
+            controller.releaseGCodeFile()
+            stack.pop()
+        }
         onStartCutRequested: {
             controller.startStreamingGCode()
             stack.push(cutView)
@@ -260,4 +266,15 @@ Window {
                 root.statusText = qsTr("Terminal")
             }
     }
+
+    DiagnosticsView {
+        id: diagnosticsView
+        visible: false
+        onBack: stack.pop()
+
+        onVisibleChanged:
+            if (visible) {
+                root.statusText = qsTr("Diagnostics")
+            }
+    }
 }
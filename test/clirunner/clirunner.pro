@@ -0,0 +1,17 @@
+# Check the config files exist
+!include(../test.pri) {
+    error("Couldn't find the test.pri file!")
+}
+
+TARGET = clirunner_test
+
+# CliRunner and Worker are not in a library
+HEADERS += \
+        ../../cli/clirunner.h \
+        ../../app/settings.h \
+        ../../app/worker.h
+SOURCES += \
+        clirunner_test.cpp \
+        ../../cli/clirunner.cpp \
+        ../../app/settings.cpp \
+        ../../app/worker.cpp
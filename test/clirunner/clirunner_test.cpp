@@ -0,0 +1,161 @@
+#include <memory>
+#include <QCoreApplication>
+#include <QList>
+#include <QSerialPortInfo>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QtTest>
+#include "cli/clirunner.h"
+#include "testcommon/testserialport.h"
+
+class CliRunnerTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    CliRunnerTest();
+
+private:
+    // The worker finds the machine on a single fake port, which is stored in m_serialPort when
+    // it is created
+    std::unique_ptr<Worker> createWorker();
+    std::unique_ptr<QTemporaryFile> createGCodeFile(QByteArray gcode);
+    void findMachine();
+    void sendState(QByteArray state);
+    void sendReplies(QByteArray reply, int numReplies);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void exitWithSuccessAfterStreamingTheFile();
+    void exitWithStreamErrorWithoutSearchingTheMachineIfTheGCodeIsInvalid();
+    void exitWithMachineErrorIfTheMachineRepliesWithAnError();
+
+private:
+    TestSerialPort* m_serialPort;
+};
+
+CliRunnerTest::CliRunnerTest()
+    : m_serialPort(nullptr)
+{
+}
+
+std::unique_ptr<Worker> CliRunnerTest::createWorker()
+{
+    auto portDiscoverer = std::make_unique<PortDiscovery<QSerialPortInfo>>(
+        [](){ return QList<QSerialPortInfo>{QSerialPortInfo()}; },
+        [this](QSerialPortInfo) {
+            m_serialPort = new TestSerialPort();
+            return std::unique_ptr<SerialPortInterface>(m_serialPort);
+        },
+        1000, 300, 5, 0, false);
+
+    return std::make_unique<Worker>(std::move(portDiscoverer), QList<qint32>());
+}
+
+std::unique_ptr<QTemporaryFile> CliRunnerTest::createGCodeFile(QByteArray gcode)
+{
+    auto file = std::make_unique<QTemporaryFile>();
+    if (!file->open()) {
+        return nullptr;
+    }
+
+    file->write(gcode);
+    file->close();
+
+    return file;
+}
+
+void CliRunnerTest::findMachine()
+{
+    m_serialPort->simulateReceivedData("[PolyShaper Oranje][pn123 sn456 789]ok\r\n");
+}
+
+void CliRunnerTest::sendState(QByteArray state)
+{
+    m_serialPort->simulateReceivedData("<" + state + "|MPos:0.000,0.000,0.000|FS:0,0|WCO:0.000,0.000,0.000>\r\n");
+}
+
+void CliRunnerTest::sendReplies(QByteArray reply, int numReplies)
+{
+    for (auto i = 0; i < numReplies; ++i) {
+        m_serialPort->simulateReceivedData(reply + "\r\n");
+    }
+}
+
+void CliRunnerTest::initTestCase()
+{
+    // Baud rates of found machines are saved, this keeps them away from the settings of ShaCo
+    QCoreApplication::setOrganizationName("PolyShaperTest");
+    QCoreApplication::setApplicationName("clirunner_test");
+}
+
+void CliRunnerTest::init()
+{
+    m_serialPort = nullptr;
+}
+
+void CliRunnerTest::exitWithSuccessAfterStreamingTheFile()
+{
+    auto gcodeFile = createGCodeFile("G01 X10 F100\nG01 Y10\n");
+    QVERIFY(gcodeFile);
+    CliRunner runner(gcodeFile->fileName(), createWorker(), 10000);
+
+    QSignalSpy finishedSpy(&runner, &CliRunner::finished);
+
+    runner.start();
+    QVERIFY(m_serialPort != nullptr);
+    findMachine();
+    sendState("Idle");
+    sendState("Run");
+    // Replies to commands of the wire controller and to our lines, more replies are ignored
+    sendReplies("ok", 10);
+    QCOMPARE(finishedSpy.count(), 0);
+    sendState("Idle");
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.at(0).at(0).toInt(), static_cast<int>(CliRunner::Success));
+    QVERIFY(m_serialPort->writtenData().contains("G01 X10 F100\n"));
+    QVERIFY(m_serialPort->writtenData().contains("G01 Y10\n"));
+}
+
+void CliRunnerTest::exitWithStreamErrorWithoutSearchingTheMachineIfTheGCodeIsInvalid()
+{
+    // A move without a feed rate
+    auto gcodeFile = createGCodeFile("G01 X10\n");
+    QVERIFY(gcodeFile);
+    CliRunner runner(gcodeFile->fileName(), createWorker(), 10000);
+
+    QSignalSpy finishedSpy(&runner, &CliRunner::finished);
+
+    runner.start();
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.at(0).at(0).toInt(), static_cast<int>(CliRunner::StreamError));
+    QVERIFY(m_serialPort == nullptr);
+}
+
+void CliRunnerTest::exitWithMachineErrorIfTheMachineRepliesWithAnError()
+{
+    auto gcodeFile = createGCodeFile("G01 X10 F100\n");
+    QVERIFY(gcodeFile);
+    CliRunner runner(gcodeFile->fileName(), createWorker(), 10000);
+
+    QSignalSpy finishedSpy(&runner, &CliRunner::finished);
+
+    runner.start();
+    QVERIFY(m_serialPort != nullptr);
+    findMachine();
+    sendState("Idle");
+    sendState("Run");
+    // Commands of the wire controller are replied with an error too, but only errors of our
+    // lines end streaming
+    sendReplies("error:20", 10);
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.at(0).at(0).toInt(), static_cast<int>(CliRunner::MachineError));
+}
+
+QTEST_GUILESS_MAIN(CliRunnerTest)
+
+#include "clirunner_test.moc"
@@ -0,0 +1,273 @@
+#include <memory>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QtTest>
+#include "core/clock.h"
+
+class ClockTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ClockTest();
+
+private Q_SLOTS:
+    void startVirtualTimeFromZero();
+    void doNotFireVirtualTimersBeforeTheirInterval();
+    void fireSingleShotVirtualTimersOnce();
+    void fireRepeatingVirtualTimersAtEachInterval();
+    void fireVirtualTimersInOrderOfExpiration();
+    void notifyTheTimeOfExpirationWhenFiringVirtualTimers();
+    void doNotFireStoppedVirtualTimers();
+    void restartVirtualTimersWhenTheIntervalChanges();
+    void computeTheRemainingTimeOfVirtualTimers();
+    void advanceToTheNextVirtualTimer();
+    void doNotAdvanceIfNoVirtualTimerIsActive();
+    void moveVirtualTimeWhenSleepingWithoutFiringTimers();
+    void allowDeletingVirtualTimersWhileFiring();
+    void allowDeletingTheVirtualClockBeforeItsTimers();
+    void runRealTimersFasterWithASpeedup();
+    void sleepLessWithASpeedup();
+};
+
+ClockTest::ClockTest()
+{
+}
+
+void ClockTest::startVirtualTimeFromZero()
+{
+    VirtualClock clock;
+
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(0));
+
+    clock.advance(10);
+
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(10000));
+}
+
+void ClockTest::doNotFireVirtualTimersBeforeTheirInterval()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    timer->start(100);
+    clock.advance(99);
+
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(timer->isActive());
+}
+
+void ClockTest::fireSingleShotVirtualTimersOnce()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    timer->setSingleShot(true);
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    timer->start(100);
+    clock.advance(1000);
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!timer->isActive());
+    QCOMPARE(clock.activeTimers(), 0);
+}
+
+void ClockTest::fireRepeatingVirtualTimersAtEachInterval()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    timer->start(100);
+    clock.advance(1050);
+
+    QCOMPARE(spy.count(), 10);
+    QVERIFY(timer->isActive());
+}
+
+void ClockTest::fireVirtualTimersInOrderOfExpiration()
+{
+    VirtualClock clock;
+    auto timer1 = clock.createTimer();
+    auto timer2 = clock.createTimer();
+    timer1->setSingleShot(true);
+    timer2->setSingleShot(true);
+    QList<int> fired;
+    connect(timer1.get(), &Timer::timeout, [&fired]() { fired.append(1); });
+    connect(timer2.get(), &Timer::timeout, [&fired]() { fired.append(2); });
+
+    timer1->start(200);
+    timer2->start(100);
+    clock.advance(300);
+
+    QCOMPARE(fired, (QList<int>{2, 1}));
+}
+
+void ClockTest::notifyTheTimeOfExpirationWhenFiringVirtualTimers()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    QList<qint64> times;
+    connect(timer.get(), &Timer::timeout, [&clock, &times]() { times.append(clock.elapsedUs()); });
+
+    timer->start(30);
+    clock.advance(100);
+
+    QCOMPARE(times, (QList<qint64>{30000, 60000, 90000}));
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(100000));
+}
+
+void ClockTest::doNotFireStoppedVirtualTimers()
+{
+    VirtualClock clock;
+    auto timer1 = clock.createTimer();
+    auto timer2 = clock.createTimer();
+    QSignalSpy spy(timer2.get(), &Timer::timeout);
+    // The first timer stops the second one, which expires at the same time
+    connect(timer1.get(), &Timer::timeout, timer2.get(), &Timer::stop);
+
+    timer1->start(100);
+    timer2->start(100);
+    clock.advance(1000);
+
+    QCOMPARE(spy.count(), 0);
+}
+
+void ClockTest::restartVirtualTimersWhenTheIntervalChanges()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    timer->start(100);
+    clock.advance(80);
+    timer->setInterval(50);
+    clock.advance(40);
+
+    QCOMPARE(spy.count(), 0);
+
+    clock.advance(10);
+
+    QCOMPARE(spy.count(), 1);
+}
+
+void ClockTest::computeTheRemainingTimeOfVirtualTimers()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+
+    QCOMPARE(timer->remainingTime(), -1);
+
+    timer->start(100);
+    clock.advance(30);
+
+    QCOMPARE(timer->remainingTime(), 70);
+    QCOMPARE(timer->interval(), 100);
+}
+
+void ClockTest::advanceToTheNextVirtualTimer()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    timer->setSingleShot(true);
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    timer->start(3 * 60 * 60 * 1000);
+
+    QVERIFY(clock.advanceToNextTimer());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(3) * 60 * 60 * 1000 * 1000);
+}
+
+void ClockTest::doNotAdvanceIfNoVirtualTimerIsActive()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    timer->setInterval(100);
+
+    QVERIFY(!clock.advanceToNextTimer());
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(0));
+}
+
+void ClockTest::moveVirtualTimeWhenSleepingWithoutFiringTimers()
+{
+    VirtualClock clock;
+    auto timer = clock.createTimer();
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+    timer->start(1);
+
+    QElapsedTimer realTime;
+    realTime.start();
+    clock.sleepUs(10000000);
+
+    QVERIFY(realTime.elapsed() < 1000);
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(10000000));
+    QCOMPARE(spy.count(), 0);
+
+    // The timer is late, it fires as soon as time moves
+    clock.advance(0);
+
+    QCOMPARE(spy.count(), 1);
+}
+
+void ClockTest::allowDeletingVirtualTimersWhileFiring()
+{
+    VirtualClock clock;
+    auto timer1 = clock.createTimer();
+    auto timer2 = clock.createTimer();
+    connect(timer1.get(), &Timer::timeout, [&timer2]() { timer2.reset(); });
+
+    timer1->start(100);
+    timer2->start(100);
+    clock.advance(1000);
+
+    QVERIFY(!timer2);
+    QCOMPARE(clock.activeTimers(), 1);
+}
+
+void ClockTest::allowDeletingTheVirtualClockBeforeItsTimers()
+{
+    auto clock = std::make_unique<VirtualClock>();
+    auto timer = clock->createTimer();
+    timer->start(100);
+
+    clock.reset();
+
+    QVERIFY(!timer->isActive());
+}
+
+void ClockTest::runRealTimersFasterWithASpeedup()
+{
+    RealClock clock(10.0);
+    auto timer = clock.createTimer();
+    timer->setSingleShot(true);
+    QSignalSpy spy(timer.get(), &Timer::timeout);
+
+    QElapsedTimer realTime;
+    realTime.start();
+    timer->start(2000);
+
+    QCOMPARE(timer->interval(), 2000);
+    QVERIFY(spy.wait(1000));
+    QVERIFY(realTime.elapsed() < 1000);
+    // Coarse timers may expire up to 5% earlier
+    QVERIFY(clock.elapsedUs() >= Q_INT64_C(1900000));
+}
+
+void ClockTest::sleepLessWithASpeedup()
+{
+    RealClock clock(100.0);
+
+    QElapsedTimer realTime;
+    realTime.start();
+    const auto start = clock.elapsedUs();
+    clock.sleepUs(5000000);
+
+    QVERIFY(realTime.elapsed() < 1000);
+    QVERIFY(clock.elapsedUs() - start >= Q_INT64_C(5000000));
+}
+
+QTEST_GUILESS_MAIN(ClockTest)
+
+#include "clock_test.moc"
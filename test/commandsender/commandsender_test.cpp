@@ -4,9 +4,12 @@
 #include <QList>
 #include <QPair>
 #include <QSignalSpy>
+#include <QThread>
 #include <QtTest>
+#include "core/clock.h"
 #include "core/commandsender.h"
 #include "core/machinecommunication.h"
+#include "core/metrics.h"
 #include "testcommon/testmachineinfo.h"
 #include "testcommon/testportdiscovery.h"
 #include "testcommon/testserialport.h"
@@ -109,6 +112,13 @@ private Q_SLOTS:
     void callCommandSentWhenACommandIsSent();
     void doNotCallCommandSentOfListenerIfListerWasDeleted();
     void discardNestedCallsToResetState();
+    void returnTheNumberOfSentCommands();
+    void updateMetricsWhenCommandsAreSentAndAcknowledged();
+    void recordReplyLatenciesOfTheSession();
+    void resetReplyLatenciesWhenPortClosed();
+    void emitSlowAckWhenReplyTakesLongerThanTheThreshold();
+    void doNotEmitSlowAckWhenThresholdIsZero();
+    void measureReplyLatenciesWithTheGivenClock();
 };
 
 CommandSenderTest::CommandSenderTest()
@@ -841,6 +851,137 @@ void CommandSenderTest::discardNestedCallsToResetState()
     communicator->closePortWithError("bla bla bla");
 }
 
+void CommandSenderTest::returnTheNumberOfSentCommands()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+
+    // Sending 16 time 8 bytes = 128 bytes, then one more command that is not sent
+    for (auto i = 0; i < 17; ++i) {
+        sender.sendCommand("0123456\n");
+    }
+    QCOMPARE(sender.sentCommands(), 16);
+
+    serialPort->simulateReceivedData("ok\r\nok\r\n");
+
+    QCOMPARE(sender.sentCommands(), 15);
+}
+
+void CommandSenderTest::updateMetricsWhenCommandsAreSentAndAcknowledged()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+    // Metrics are global, other tests change them too
+    auto& registry = MetricsRegistry::global();
+    const auto commandsSent = registry.counter("commandSender.commandsSent").value();
+    const auto errorReplies = registry.counter("commandSender.errorReplies").value();
+    const auto acks = registry.histogram("commandSender.ackLatencyUs").snapshot().count;
+
+    for (auto i = 0; i < 17; ++i) {
+        sender.sendCommand("0123456\n");
+    }
+
+    QCOMPARE(registry.counter("commandSender.commandsSent").value(), commandsSent + 16);
+    QCOMPARE(registry.gauge("commandSender.bytesInFlight").value(), Q_INT64_C(128));
+    QCOMPARE(registry.gauge("commandSender.queuedCommands").value(), Q_INT64_C(1));
+
+    serialPort->simulateReceivedData("ok\r\nerror:3\r\n");
+
+    QCOMPARE(registry.counter("commandSender.commandsSent").value(), commandsSent + 17);
+    QCOMPARE(registry.counter("commandSender.errorReplies").value(), errorReplies + 1);
+    QCOMPARE(registry.histogram("commandSender.ackLatencyUs").snapshot().count, acks + 2);
+    QCOMPARE(registry.gauge("commandSender.bytesInFlight").value(), Q_INT64_C(120));
+    QCOMPARE(registry.gauge("commandSender.queuedCommands").value(), Q_INT64_C(0));
+}
+
+void CommandSenderTest::recordReplyLatenciesOfTheSession()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+
+    sender.sendCommand("first\n");
+    sender.sendCommand("second\n");
+    QThread::msleep(5);
+    serialPort->simulateReceivedData("ok\r\nerror:3\r\n");
+
+    QCOMPARE(sender.sessionAckLatencies().count(), Q_INT64_C(2));
+    QVERIFY(sender.sessionAckLatencies().min() >= 5000);
+}
+
+void CommandSenderTest::resetReplyLatenciesWhenPortClosed()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+
+    sender.sendCommand("first\n");
+    serialPort->simulateReceivedData("ok\r\n");
+    communicator->closePort();
+
+    QCOMPARE(sender.sessionAckLatencies().count(), Q_INT64_C(0));
+}
+
+void CommandSenderTest::emitSlowAckWhenReplyTakesLongerThanTheThreshold()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+    sender.setSlowAckThresholdUs(5000);
+    QSignalSpy spy(&sender, &CommandSender::slowAck);
+
+    sender.sendCommand("fast\n", 1);
+    serialPort->simulateReceivedData("ok\r\n");
+    sender.sendCommand("slow\n", 2);
+    QThread::msleep(10);
+    serialPort->simulateReceivedData("error:3\r\n");
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<CommandCorrelationId>(), 2ul);
+    QVERIFY(spy.at(0).at(1).toLongLong() >= 10000);
+}
+
+void CommandSenderTest::doNotEmitSlowAckWhenThresholdIsZero()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    CommandSender sender(communicator.get());
+    QSignalSpy spy(&sender, &CommandSender::slowAck);
+
+    QCOMPARE(sender.slowAckThresholdUs(), Q_INT64_C(0));
+    sender.sendCommand("slow\n", 1);
+    QThread::msleep(2);
+    serialPort->simulateReceivedData("ok\r\n");
+
+    QCOMPARE(spy.count(), 0);
+}
+
+void CommandSenderTest::measureReplyLatenciesWithTheGivenClock()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    VirtualClock clock;
+    CommandSender sender(communicator.get(), &clock);
+    sender.setSlowAckThresholdUs(5000);
+    QSignalSpy spy(&sender, &CommandSender::slowAck);
+
+    sender.sendCommand("slow\n", 1);
+    clock.advance(7);
+    serialPort->simulateReceivedData("ok\r\n");
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toLongLong(), Q_INT64_C(7000));
+}
+
 QTEST_GUILESS_MAIN(CommandSenderTest)
 
 #include "commandsender_test.moc"
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <cstdlib>
+#include <QByteArray>
+#include <QtTest>
+#include "core/commandsender.h"
+#include "core/machinecommunication.h"
+#include "testcommon/testmachineinfo.h"
+#include "testcommon/testportdiscovery.h"
+
+// Allocations are counted by replacing the malloc functions of glibc, the replacements are used by
+// Qt and by operator new too. This is why this test is in a separate executable and only built on
+// Linux
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+}
+
+namespace {
+    std::atomic<qint64> allocations(0);
+}
+
+extern "C" void* malloc(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+namespace {
+    // A serial port that discards written data, so that it does not allocate
+    class DiscardingSerialPort : public SerialPortInterface
+    {
+    public:
+        bool open() override
+        {
+            return true;
+        }
+
+        qint64 write(const QByteArray& data) override
+        {
+            return data.size();
+        }
+
+        QByteArray readAll() override
+        {
+            return QByteArray();
+        }
+
+        QString errorString() const override
+        {
+            return QString();
+        }
+
+        void close() override
+        {
+        }
+
+        void setCharacterSendDelayUs(unsigned long) override
+        {
+        }
+
+        unsigned long characterSendDelayUs() const override
+        {
+            return 0;
+        }
+    };
+
+    // A listener that does not allocate when called
+    class CountingListener : public CommandSenderListener
+    {
+    public:
+        void commandSent(CommandCorrelationId) override
+        {
+            ++sent;
+        }
+
+        void okReply(CommandCorrelationId) override
+        {
+            ++replies;
+        }
+
+        void errorReply(CommandCorrelationId, int) override
+        {
+            ++replies;
+        }
+
+        void replyLost(CommandCorrelationId, bool) override
+        {
+        }
+
+        int sent = 0;
+        int replies = 0;
+    };
+
+    // Commands of 7 bytes, more than can be sent before a reply so that some are queued
+    constexpr int commandsPerBatch = 20;
+    constexpr int warmUpBatches = 10;
+    constexpr int measuredBatches = 1000;
+}
+
+class CommandSenderAllocationsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    CommandSenderAllocationsTest();
+
+private Q_SLOTS:
+    void doNotAllocateWhenStreamingAfterWarmUp_data();
+    void doNotAllocateWhenStreamingAfterWarmUp();
+};
+
+CommandSenderAllocationsTest::CommandSenderAllocationsTest()
+{
+}
+
+void CommandSenderAllocationsTest::doNotAllocateWhenStreamingAfterWarmUp_data()
+{
+    QTest::addColumn<QByteArray>("command");
+    QTest::addColumn<QByteArray>("reply");
+
+    QTest::newRow("ok replies") << QByteArray("G1 X10\n") << QByteArray("ok");
+    QTest::newRow("error replies") << QByteArray("G1 X10\n") << QByteArray("error:20");
+    QTest::newRow("newline added") << QByteArray("G1 X10") << QByteArray("ok");
+}
+
+void CommandSenderAllocationsTest::doNotAllocateWhenStreamingAfterWarmUp()
+{
+    QFETCH(QByteArray, command);
+    QFETCH(QByteArray, reply);
+
+    TestMachineInfo info;
+    TestPortDiscovery portDiscoverer(new DiscardingSerialPort());
+    MachineCommunication communicator(0);
+    communicator.portFound(&info, &portDiscoverer);
+    CommandSender sender(&communicator);
+    CountingListener listener;
+
+    // Replies are given directly to CommandSender, MachineCommunication allocates to split them
+    auto streamBatches = [&](int numBatches) {
+        for (auto i = 0; i < numBatches; ++i) {
+            for (auto j = 0; j < commandsPerBatch; ++j) {
+                sender.sendCommand(command, static_cast<CommandCorrelationId>(j), &listener);
+            }
+            for (auto j = 0; j < commandsPerBatch; ++j) {
+                emit communicator.messageReceived(reply);
+            }
+        }
+    };
+
+    streamBatches(warmUpBatches);
+
+    const auto allocationsBefore = allocations.load();
+    streamBatches(measuredBatches);
+    const auto allocationsAfter = allocations.load();
+
+    QCOMPARE(allocationsAfter - allocationsBefore, Q_INT64_C(0));
+    QCOMPARE(listener.sent, (warmUpBatches + measuredBatches) * commandsPerBatch);
+    QCOMPARE(listener.replies, (warmUpBatches + measuredBatches) * commandsPerBatch);
+    QCOMPARE(sender.pendingCommands(), 0);
+    QCOMPARE(sender.sentCommands(), 0);
+}
+
+QTEST_GUILESS_MAIN(CommandSenderAllocationsTest)
+
+#include "commandsenderallocations_test.moc"
@@ -0,0 +1,94 @@
+#include <QByteArray>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/contenthash.h"
+
+class ContentHashTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ContentHashTest();
+
+private Q_SLOTS:
+    void computeReferenceHashes();
+    void useTheSeed();
+    void computeTheSameHashWhenDataIsAddedInChunks();
+    void hashTheContentOfFiles();
+    void returnZeroIfFileCannotBeRead();
+    void combineHashesDependingOnOrder();
+};
+
+ContentHashTest::ContentHashTest()
+{
+}
+
+void ContentHashTest::computeReferenceHashes()
+{
+    // Values from the reference implementation
+    QCOMPARE(XXHash64::hash(QByteArray()), Q_UINT64_C(0xef46db3751d8e999));
+    QCOMPARE(XXHash64::hash(QByteArray("abc")), Q_UINT64_C(0x44bc2cf5ad770999));
+    QCOMPARE(XXHash64::hash(QByteArray("Nobody inspects the spammish repetition")), Q_UINT64_C(0xfbcea83c8a378bf1));
+}
+
+void ContentHashTest::useTheSeed()
+{
+    QVERIFY(XXHash64::hash(QByteArray("abc"), 1) != XXHash64::hash(QByteArray("abc"), 0));
+}
+
+void ContentHashTest::computeTheSameHashWhenDataIsAddedInChunks()
+{
+    QByteArray data;
+    for (auto i = 0; i < 1000; ++i) {
+        data.append(static_cast<char>(i * 7 + 3));
+    }
+
+    for (auto chunkSize: {1, 3, 8, 31, 32, 33, 100}) {
+        XXHash64 h;
+        for (auto pos = 0; pos < data.size(); pos += chunkSize) {
+            h.add(data.mid(pos, chunkSize));
+        }
+
+        QCOMPARE(h.result(), XXHash64::hash(data));
+    }
+}
+
+void ContentHashTest::hashTheContentOfFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray content = "G1 X10 Y10\nG1 X20 Y0\n";
+
+    QFile file(dir.path() + "/a.gcode");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+    file.close();
+    QFile emptyFile(dir.path() + "/b.gcode");
+    QVERIFY(emptyFile.open(QIODevice::WriteOnly));
+    emptyFile.close();
+
+    bool ok = false;
+    QCOMPARE(hashFile(file.fileName(), &ok), XXHash64::hash(content));
+    QVERIFY(ok);
+    QCOMPARE(hashFile(emptyFile.fileName(), &ok), XXHash64::hash(QByteArray()));
+    QVERIFY(ok);
+}
+
+void ContentHashTest::returnZeroIfFileCannotBeRead()
+{
+    bool ok = true;
+
+    QCOMPARE(hashFile("jdsflkjhesriohvuiehhrewiuq u3982hns.ffgsaf", &ok), Q_UINT64_C(0));
+    QVERIFY(!ok);
+}
+
+void ContentHashTest::combineHashesDependingOnOrder()
+{
+    QVERIFY(combineHashes(1, 2) != combineHashes(2, 1));
+    QCOMPARE(combineHashes(1, 2), combineHashes(1, 2));
+}
+
+QTEST_GUILESS_MAIN(ContentHashTest)
+
+#include "contenthash_test.moc"
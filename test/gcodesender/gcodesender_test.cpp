@@ -7,6 +7,7 @@
 #include "core/gcodesender.h"
 #include "core/machinecommunication.h"
 #include "core/machinestatusmonitor.h"
+#include "core/metrics.h"
 #include "core/wirecontroller.h"
 #include "testcommon/testmachineinfo.h"
 #include "testcommon/testportdiscovery.h"
@@ -89,8 +90,10 @@ private Q_SLOTS:
     void openStreamAsText();
     void endStreamingWithErrorIfAttemptingToSendAnInvalidCommand();
     void sendAllCommandsAndStopIfGCodeIsShort();
+    void emitTheNumberOfAcknowledgedLines();
     void stopEnqueingCommandsIfMoreThan10ArePending();
     void doNotEmitStreamingEndedIfThereArePendingCommands();
+    void doNotCountAStallIfTheNextLineIsWaitingToBeSent();
     void emitStreamingEndedSignalWithErrorAndResetIfItIsNotPossibleToReadTheGCodeStream();
     void doNotStartIfMachineIsNotIdle();
     void emitStreamingEndedSignalWithSuccessOnlyAfterAllRepliesAreReceivedAndMachineIsIdleAgain();
@@ -324,6 +327,26 @@ void GCodeSenderTest::sendAllCommandsAndStopIfGCodeIsShort()
     QCOMPARE(endSpy.at(0).at(1).toString(), tr("Success"));
 }
 
+void GCodeSenderTest::emitTheNumberOfAcknowledgedLines()
+{
+    auto r = createRequirements();
+
+    auto buffer = new TestBuffer();
+    buffer->buffer() = "G01 X100\nG01 Y32\nG01 Z123\n";
+    GCodeSender fileSender(r.communicator.get(), r.commandSender.get(), r.wireController.get(), r.statusMonitor.get(), std::unique_ptr<QIODevice>(buffer));
+
+    QSignalSpy spy(&fileSender, &GCodeSender::lineAcknowledged);
+
+    fileSender.streamData();
+    sendState(r.serialPort, "Run");
+    // 3 commands from wire controller, then our 3 commands
+    sendAcks(r.serialPort, 5);
+
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(0).value<CommandCorrelationId>(), 1ul);
+    QCOMPARE(spy.at(1).at(0).value<CommandCorrelationId>(), 2ul);
+}
+
 void GCodeSenderTest::stopEnqueingCommandsIfMoreThan10ArePending()
 {
     auto r = createRequirements();
@@ -358,6 +381,30 @@ void GCodeSenderTest::doNotEmitStreamingEndedIfThereArePendingCommands()
     QCOMPARE(spy.count(), 0);
 }
 
+void GCodeSenderTest::doNotCountAStallIfTheNextLineIsWaitingToBeSent()
+{
+    auto r = createRequirements();
+
+    auto buffer = new TestBuffer();
+    // Lines of 100 bytes, only one at a time fits in the machine buffer. When a line is
+    // acknowledged no command is waiting for a reply, but the next one is sent right away
+    for (auto i = 0; i < 5; ++i) {
+        buffer->buffer() += "G01 X10 (" + QByteArray(89, 'a') + ")\n";
+    }
+    GCodeSender fileSender(r.communicator.get(), r.commandSender.get(), r.wireController.get(), r.statusMonitor.get(), std::unique_ptr<QIODevice>(buffer));
+
+    auto& stalls = MetricsRegistry::global().counter("gcodeSender.stalls");
+    const auto stallsAtStart = stalls.value();
+
+    fileSender.streamData();
+    sendState(r.serialPort, "Run");
+    // 3 commands from wire controller, then our 5 commands
+    sendAcks(r.serialPort, 8);
+
+    QCOMPARE(r.commandSender->sentCommands(), 0);
+    QCOMPARE(stalls.value(), stallsAtStart);
+}
+
 void GCodeSenderTest::emitStreamingEndedSignalWithErrorAndResetIfItIsNotPossibleToReadTheGCodeStream()
 {
     auto r = createRequirements();
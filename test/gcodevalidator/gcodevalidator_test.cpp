@@ -0,0 +1,422 @@
+#include <QByteArray>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/commandsender.h"
+#include "core/gcodevalidationpool.h"
+#include "core/gcodevalidator.h"
+
+class GCodeValidatorTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    GCodeValidatorTest();
+
+private Q_SLOTS:
+    void acceptValidGCode();
+    void acceptEmptyGCode();
+    void acceptLinesEndingWithCarriageReturnAndNewline();
+    void acceptLastLineWithoutNewline();
+    void acceptLowercaseWordsAndComments();
+    void acceptArcsWithCenter();
+    void acceptAllGrblCommands_data();
+    void acceptAllGrblCommands();
+    void acceptGrblSystemCommandsAndProgramMarkers();
+    void doNotTreatAxisWordsOfToolLengthOffsetAsMoves();
+    void acceptLinesOf127Bytes();
+    void refuseLinesOf128Bytes();
+    void refuseCarriageReturnInTheMiddleOfALine();
+    void refuseMovesWithoutFeedRate();
+    void refuseCommandsOfTheSameModalGroup();
+    void refuseRepeatedWords();
+    void refuseUnexpectedCharacters();
+    void refuseUnsupportedCommands();
+    void refuseCommandsGrblDoesNotSupport_data();
+    void refuseCommandsGrblDoesNotSupport();
+    void refuseArcsWithoutRadiusOrCenter();
+    void refuseAxisWordsAfterG80();
+    void reportOnlyTheFirstProblem();
+    void warnIfMovesExitTheWorkpiece();
+    void warnIfIncrementalMovesExitTheWorkpiece();
+    void convertInchesToMillimeters();
+    void doNotCheckBoundsIfDimensionIsNotPositive();
+    void validateFiles();
+    void refuseFilesThatCannotBeRead();
+    void validateFilesInBackground();
+    void saveAndLoadChecks();
+};
+
+GCodeValidatorTest::GCodeValidatorTest()
+{
+}
+
+namespace {
+    GCodeCheck makeCheck(GCodeCheck::Verdict verdict, quint32 line = 0, QString message = QString())
+    {
+        GCodeCheck check;
+        check.verdict = verdict;
+        check.line = line;
+        check.message = message;
+
+        return check;
+    }
+
+    QByteArray lineOfLength(int length)
+    {
+        // length includes the newline
+        const QByteArray start = "G1 F1 (";
+        return start + QByteArray(length - start.size() - 2, 'a') + ")\n";
+    }
+}
+
+void GCodeValidatorTest::acceptValidGCode()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G21\nG90\nG0 X0 Y0\nG1 X10 Y10 F1000\nG1 X20\nM3\nM5\n")),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptEmptyGCode()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray()), makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptLinesEndingWithCarriageReturnAndNewline()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G21\r\nG1 X10 Y10 F100\r\n")), makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptLastLineWithoutNewline()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G21\nG1 X10 Y5 F100")), makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptLowercaseWordsAndComments()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("g1 x10 y5 f100\nG1 (a comment) X5 ; another comment\n(only a comment)\n")),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptArcsWithCenter()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G1 F10\nG2 X10 Y10 I5 J5\nG3 X20 Y20 R10\n")),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptAllGrblCommands_data()
+{
+    QTest::addColumn<QByteArray>("gcode");
+
+    // Non-modal commands
+    QTest::newRow("G4") << QByteArray("G4 P0.5\n");
+    QTest::newRow("G10 L2") << QByteArray("G10 L2 P1 X10 Y10\n");
+    QTest::newRow("G10 L20") << QByteArray("G10 L20 P1 X0 Y0\n");
+    QTest::newRow("G28") << QByteArray("G28 X500\n");
+    QTest::newRow("G28.1") << QByteArray("G28.1\n");
+    QTest::newRow("G30") << QByteArray("G30\n");
+    QTest::newRow("G30.1") << QByteArray("G30.1\n");
+    QTest::newRow("G53") << QByteArray("G53 G0 X500\n");
+    QTest::newRow("G92") << QByteArray("G92 X-100 Y-100\n");
+    QTest::newRow("G92.1") << QByteArray("G92.1\n");
+    // Motion modes
+    QTest::newRow("G0") << QByteArray("G0 X10\n");
+    QTest::newRow("G1") << QByteArray("G1 X10 F100\n");
+    QTest::newRow("G2") << QByteArray("G2 X10 Y10 R10 F100\n");
+    QTest::newRow("G3") << QByteArray("G3 X10 Y10 I5 J5 F100\n");
+    QTest::newRow("G38.2") << QByteArray("G38.2 Z-10 F100\n");
+    QTest::newRow("G38.3") << QByteArray("G38.3 Z-10 F100\n");
+    QTest::newRow("G38.4") << QByteArray("G38.4 Z-10 F100\n");
+    QTest::newRow("G38.5") << QByteArray("G38.5 Z-10 F100\n");
+    QTest::newRow("G80") << QByteArray("G80\n");
+    // Other modal groups
+    QTest::newRow("G93") << QByteArray("G93 G1 X10 F2\n");
+    QTest::newRow("G94") << QByteArray("G94\n");
+    QTest::newRow("G20") << QByteArray("G20\n");
+    QTest::newRow("G21") << QByteArray("G21\n");
+    QTest::newRow("G90") << QByteArray("G90\n");
+    QTest::newRow("G91") << QByteArray("G91\n");
+    QTest::newRow("G91.1") << QByteArray("G91.1\n");
+    QTest::newRow("G17") << QByteArray("G17\n");
+    QTest::newRow("G18") << QByteArray("G18\n");
+    QTest::newRow("G19") << QByteArray("G19\n");
+    QTest::newRow("G43.1") << QByteArray("G43.1 Z2\n");
+    QTest::newRow("G49") << QByteArray("G49\n");
+    QTest::newRow("G40") << QByteArray("G40\n");
+    QTest::newRow("G54") << QByteArray("G54\n");
+    QTest::newRow("G55") << QByteArray("G55\n");
+    QTest::newRow("G56") << QByteArray("G56\n");
+    QTest::newRow("G57") << QByteArray("G57\n");
+    QTest::newRow("G58") << QByteArray("G58\n");
+    QTest::newRow("G59") << QByteArray("G59\n");
+    QTest::newRow("G61") << QByteArray("G61\n");
+    // M codes
+    QTest::newRow("M0") << QByteArray("M0\n");
+    QTest::newRow("M1") << QByteArray("M1\n");
+    QTest::newRow("M2") << QByteArray("M2\n");
+    QTest::newRow("M30") << QByteArray("M30\n");
+    QTest::newRow("M3") << QByteArray("M3 S1000\n");
+    QTest::newRow("M4") << QByteArray("M4 S1000\n");
+    QTest::newRow("M5") << QByteArray("M5\n");
+    QTest::newRow("M7") << QByteArray("M7\n");
+    QTest::newRow("M8") << QByteArray("M8\n");
+    QTest::newRow("M9") << QByteArray("M9\n");
+    // A common preamble, one command per modal group
+    QTest::newRow("preamble") << QByteArray("G17 G21 G40 G49 G80 G90 G91.1 G94 G54 G61\n");
+}
+
+void GCodeValidatorTest::acceptAllGrblCommands()
+{
+    QFETCH(QByteArray, gcode);
+
+    // No workpiece, to only check commands
+    GCodeValidator validator(0.0, 0.0);
+
+    QCOMPARE(validator.validate(gcode), makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptGrblSystemCommandsAndProgramMarkers()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("%\n$H\n$X\n  $J=G91 X10 F100\nG1 X10 F100\n%\n")),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::doNotTreatAxisWordsOfToolLengthOffsetAsMoves()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    // G80 is the motion mode, axis words would be refused if they were a move
+    QCOMPARE(validator.validate(QByteArray("G80\nG43.1 Z200\nG28.1 X500\n")),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::acceptLinesOf127Bytes()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(lineOfLength(CommandSender::maxCommandSize - 1)),
+             makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::refuseLinesOf128Bytes()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate("G21\n" + lineOfLength(CommandSender::maxCommandSize)),
+             makeCheck(GCodeCheck::Verdict::Invalid, 2, "Line longer than 127 bytes"));
+}
+
+void GCodeValidatorTest::refuseCarriageReturnInTheMiddleOfALine()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G21\rG1 X10\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Carriage return in the middle of a line"));
+}
+
+void GCodeValidatorTest::refuseMovesWithoutFeedRate()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G0 X10\nG1 X20\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 2, "Feed rate not set"));
+}
+
+void GCodeValidatorTest::refuseCommandsOfTheSameModalGroup()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G0 G1 X10\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Two commands of the same modal group in one line"));
+    QCOMPARE(validator.validate(QByteArray("M3 M5\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Two commands of the same modal group in one line"));
+}
+
+void GCodeValidatorTest::refuseRepeatedWords()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G0 X1 X2\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Word X repeated in one line"));
+}
+
+void GCodeValidatorTest::refuseUnexpectedCharacters()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G1 F10 X5 #\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Unexpected character '#'"));
+}
+
+void GCodeValidatorTest::refuseUnsupportedCommands()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G5 X1\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 1, "Unsupported command G5"));
+}
+
+void GCodeValidatorTest::refuseCommandsGrblDoesNotSupport_data()
+{
+    QTest::addColumn<QByteArray>("gcode");
+    QTest::addColumn<QString>("message");
+
+    QTest::newRow("G41") << QByteArray("G41\n") << "Unsupported command G41";
+    QTest::newRow("G43") << QByteArray("G43 H1\n") << "Unsupported command G43";
+    QTest::newRow("G64") << QByteArray("G64\n") << "Unsupported command G64";
+    QTest::newRow("G90.1") << QByteArray("G90.1\n") << "Unsupported command G90.1";
+    QTest::newRow("G28.2") << QByteArray("G28.2\n") << "Unsupported command G28.2";
+    QTest::newRow("M6") << QByteArray("M6 T1\n") << "Unsupported command M6";
+}
+
+void GCodeValidatorTest::refuseCommandsGrblDoesNotSupport()
+{
+    QFETCH(QByteArray, gcode);
+    QFETCH(QString, message);
+
+    GCodeValidator validator(0.0, 0.0);
+
+    QCOMPARE(validator.validate(gcode), makeCheck(GCodeCheck::Verdict::Invalid, 1, message));
+}
+
+void GCodeValidatorTest::refuseArcsWithoutRadiusOrCenter()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G1 F10\nG2 X10 Y10\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 2, "Arc without radius or center"));
+}
+
+void GCodeValidatorTest::refuseAxisWordsAfterG80()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G80\nX5\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 2, "Axis words without a motion command"));
+}
+
+void GCodeValidatorTest::reportOnlyTheFirstProblem()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    // The warning comes first, but errors are more important
+    QCOMPARE(validator.validate(QByteArray("G0 X200\nG0 X1 X2\nG5\n")),
+             makeCheck(GCodeCheck::Verdict::Invalid, 2, "Word X repeated in one line"));
+}
+
+void GCodeValidatorTest::warnIfMovesExitTheWorkpiece()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G0 X10\nG1 X200 F10\nG1 X300\n")),
+             makeCheck(GCodeCheck::Verdict::Warning, 2, "Move outside the workpiece"));
+}
+
+void GCodeValidatorTest::warnIfIncrementalMovesExitTheWorkpiece()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G91\nG0 X60\nG0 X60\n")),
+             makeCheck(GCodeCheck::Verdict::Warning, 3, "Move outside the workpiece"));
+}
+
+void GCodeValidatorTest::convertInchesToMillimeters()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G20\nG0 X3\n")), makeCheck(GCodeCheck::Verdict::Valid));
+    QCOMPARE(validator.validate(QByteArray("G20\nG0 X5\n")),
+             makeCheck(GCodeCheck::Verdict::Warning, 2, "Move outside the workpiece"));
+}
+
+void GCodeValidatorTest::doNotCheckBoundsIfDimensionIsNotPositive()
+{
+    GCodeValidator validator(0.0, 100.0);
+
+    QCOMPARE(validator.validate(QByteArray("G0 X1000\n")), makeCheck(GCodeCheck::Verdict::Valid));
+    QCOMPARE(validator.validate(QByteArray("G0 Y1000\n")),
+             makeCheck(GCodeCheck::Verdict::Warning, 1, "Move outside the workpiece"));
+}
+
+void GCodeValidatorTest::validateFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.path() + "/a.gcode");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("G21\nG1 X10 F100\nG1 X20 X30\n");
+    file.close();
+    QFile emptyFile(dir.path() + "/b.gcode");
+    QVERIFY(emptyFile.open(QIODevice::WriteOnly));
+    emptyFile.close();
+
+    GCodeValidator validator(100.0, 100.0);
+
+    QCOMPARE(validator.validateFile(file.fileName()),
+             makeCheck(GCodeCheck::Verdict::Invalid, 3, "Word X repeated in one line"));
+    QCOMPARE(validator.validateFile(emptyFile.fileName()), makeCheck(GCodeCheck::Verdict::Valid));
+}
+
+void GCodeValidatorTest::refuseFilesThatCannotBeRead()
+{
+    GCodeValidator validator(100.0, 100.0);
+
+    const auto check = validator.validateFile("jdsflkjhesriohvuiehhrewiuq u3982hns.gcode");
+
+    QCOMPARE(check.verdict, GCodeCheck::Verdict::Invalid);
+    QCOMPARE(check.line, 0u);
+}
+
+void GCodeValidatorTest::validateFilesInBackground()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.path() + "/a.gcode");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("G1 X10\n");
+    file.close();
+
+    GCodeValidationPool pool;
+    QSignalSpy spy(&pool, &GCodeValidationPool::validated);
+
+    pool.validate("theKey", 17, file.fileName(), 100.0, 100.0);
+
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("theKey"));
+    QCOMPARE(spy.at(0).at(1).value<quint64>(), Q_UINT64_C(17));
+    QCOMPARE(spy.at(0).at(2).value<GCodeCheck>(), makeCheck(GCodeCheck::Verdict::Invalid, 1, "Feed rate not set"));
+}
+
+void GCodeValidatorTest::saveAndLoadChecks()
+{
+    const auto check = makeCheck(GCodeCheck::Verdict::Warning, 12, "Move outside the workpiece");
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << check;
+    QDataStream in(data);
+    GCodeCheck loaded;
+    in >> loaded;
+
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QCOMPARE(loaded, check);
+}
+
+QTEST_GUILESS_MAIN(GCodeValidatorTest)
+
+#include "gcodevalidator_test.moc"
@@ -0,0 +1,148 @@
+#include <QtTest>
+#include "core/hdrhistogram.h"
+
+class HdrHistogramTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    HdrHistogramTest();
+
+private Q_SLOTS:
+    void beEmptyAtStart();
+    void recordExactMinMaxAndMean();
+    void countSmallValuesExactly();
+    void keepTheRequestedSignificantDigits();
+    void computePercentiles();
+    void neverReturnPercentilesAboveTheMaximum();
+    void clampValuesAboveTheHighestTrackableValue();
+    void recordNegativeValuesAsZero();
+    void forgetValuesWhenReset();
+};
+
+HdrHistogramTest::HdrHistogramTest()
+{
+}
+
+void HdrHistogramTest::beEmptyAtStart()
+{
+    HdrHistogram histogram(1000000, 3);
+
+    QCOMPARE(histogram.count(), Q_INT64_C(0));
+    QCOMPARE(histogram.min(), Q_INT64_C(0));
+    QCOMPARE(histogram.max(), Q_INT64_C(0));
+    QCOMPARE(histogram.mean(), 0.0);
+    QCOMPARE(histogram.valueAtPercentile(50.0), Q_INT64_C(0));
+}
+
+void HdrHistogramTest::recordExactMinMaxAndMean()
+{
+    HdrHistogram histogram(1000000, 3);
+
+    histogram.record(123456);
+    histogram.record(17);
+    histogram.record(1000);
+
+    QCOMPARE(histogram.count(), Q_INT64_C(3));
+    QCOMPARE(histogram.min(), Q_INT64_C(17));
+    QCOMPARE(histogram.max(), Q_INT64_C(123456));
+    QCOMPARE(histogram.mean(), 41491.0);
+}
+
+void HdrHistogramTest::countSmallValuesExactly()
+{
+    HdrHistogram histogram(1000000, 3);
+
+    for (auto v = 0; v < 2048; ++v) {
+        QCOMPARE(histogram.lowestEquivalentValue(v), static_cast<qint64>(v));
+        QCOMPARE(histogram.highestEquivalentValue(v), static_cast<qint64>(v));
+    }
+}
+
+void HdrHistogramTest::keepTheRequestedSignificantDigits()
+{
+    HdrHistogram histogram(60000000, 3);
+
+    QCOMPARE(histogram.lowestEquivalentValue(123456), Q_INT64_C(123392));
+    QCOMPARE(histogram.highestEquivalentValue(123456), Q_INT64_C(123519));
+    for (qint64 v = 1; v < 60000000; v = v * 3 + 1) {
+        const auto lowest = histogram.lowestEquivalentValue(v);
+        const auto highest = histogram.highestEquivalentValue(v);
+        QVERIFY(lowest <= v);
+        QVERIFY(highest >= v);
+        QVERIFY((highest - lowest) * 1000 <= v);
+    }
+}
+
+void HdrHistogramTest::computePercentiles()
+{
+    HdrHistogram histogram(60000000, 3);
+
+    for (auto i = 1; i <= 100000; ++i) {
+        histogram.record(i);
+    }
+
+    // Percentiles are exact up to the precision of the histogram
+    QCOMPARE(histogram.valueAtPercentile(0.0), Q_INT64_C(1));
+    QCOMPARE(histogram.valueAtPercentile(50.0), Q_INT64_C(50015));
+    QCOMPARE(histogram.valueAtPercentile(90.0), Q_INT64_C(90047));
+    QCOMPARE(histogram.valueAtPercentile(99.0), Q_INT64_C(99007));
+    QCOMPARE(histogram.valueAtPercentile(99.9), Q_INT64_C(99903));
+    QCOMPARE(histogram.valueAtPercentile(100.0), Q_INT64_C(100000));
+}
+
+void HdrHistogramTest::neverReturnPercentilesAboveTheMaximum()
+{
+    HdrHistogram histogram(60000000, 3);
+
+    histogram.record(123456);
+
+    QCOMPARE(histogram.valueAtPercentile(50.0), Q_INT64_C(123456));
+    QCOMPARE(histogram.valueAtPercentile(100.0), Q_INT64_C(123456));
+}
+
+void HdrHistogramTest::clampValuesAboveTheHighestTrackableValue()
+{
+    HdrHistogram histogram(1000, 2);
+
+    histogram.record(5);
+    histogram.record(1000);
+    histogram.record(5000);
+
+    QCOMPARE(histogram.count(), Q_INT64_C(3));
+    QCOMPARE(histogram.clampedValues(), Q_INT64_C(1));
+    QCOMPARE(histogram.max(), Q_INT64_C(1000));
+    QCOMPARE(histogram.valueAtPercentile(100.0), Q_INT64_C(1000));
+}
+
+void HdrHistogramTest::recordNegativeValuesAsZero()
+{
+    HdrHistogram histogram(1000, 2);
+
+    histogram.record(-10);
+
+    QCOMPARE(histogram.count(), Q_INT64_C(1));
+    QCOMPARE(histogram.min(), Q_INT64_C(0));
+    QCOMPARE(histogram.valueAtPercentile(100.0), Q_INT64_C(0));
+}
+
+void HdrHistogramTest::forgetValuesWhenReset()
+{
+    HdrHistogram histogram(1000, 2);
+    histogram.record(5);
+    histogram.record(5000);
+
+    histogram.reset();
+
+    QCOMPARE(histogram.count(), Q_INT64_C(0));
+    QCOMPARE(histogram.clampedValues(), Q_INT64_C(0));
+    QCOMPARE(histogram.max(), Q_INT64_C(0));
+    QCOMPARE(histogram.valueAtPercentile(100.0), Q_INT64_C(0));
+    histogram.record(7);
+    QCOMPARE(histogram.min(), Q_INT64_C(7));
+    QCOMPARE(histogram.valueAtPercentile(50.0), Q_INT64_C(7));
+}
+
+QTEST_GUILESS_MAIN(HdrHistogramTest)
+
+#include "hdrhistogram_test.moc"
@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <memory>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QList>
+#include <QLocalSocket>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+#include "core/jobserver.h"
+#include "core/machinestatusmonitor.h"
+#include "testcommon/testmachineinfo.h"
+#include "testcommon/testserialport.h"
+#include "testcommon/utils.h"
+
+namespace {
+    struct Frame {
+        JobServer::MessageType type;
+        QByteArray fields;
+    };
+
+    // A client of the job server, collects all received frames
+    class TestClient
+    {
+    public:
+        TestClient()
+        {
+            QObject::connect(&m_socket, &QLocalSocket::readyRead, [this]() { readFrames(); });
+        }
+
+        bool connectToServer(const QString& name)
+        {
+            m_socket.connectToServer(name);
+
+            return m_socket.waitForConnected(1000);
+        }
+
+        void send(JobServer::MessageType type, const QByteArray& fields = QByteArray())
+        {
+            m_socket.write(JobServer::frame(type, fields));
+        }
+
+        QLocalSocket::LocalSocketState state() const
+        {
+            return m_socket.state();
+        }
+
+        const QList<Frame>& frames() const
+        {
+            return m_frames;
+        }
+
+        int count(JobServer::MessageType type) const
+        {
+            int n = 0;
+            for (const auto& f: m_frames) {
+                if (f.type == type) {
+                    ++n;
+                }
+            }
+
+            return n;
+        }
+
+    private:
+        void readFrames()
+        {
+            m_buffer += m_socket.readAll();
+
+            while (m_buffer.size() >= 4) {
+                const auto size = static_cast<int>(qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(m_buffer.constData())));
+                if (m_buffer.size() < 4 + size) {
+                    return;
+                }
+
+                m_frames.append(Frame{static_cast<JobServer::MessageType>(m_buffer[4]), m_buffer.mid(5, size - 1)});
+                m_buffer.remove(0, 4 + size);
+            }
+        }
+
+        QLocalSocket m_socket;
+        QByteArray m_buffer;
+        QList<Frame> m_frames;
+    };
+
+    QByteArray serialize(const QString& s)
+    {
+        QByteArray fields;
+        QDataStream stream(&fields, QIODevice::WriteOnly);
+        stream.setVersion(JobServer::dataStreamVersion);
+        stream << s;
+
+        return fields;
+    }
+
+    template <class T>
+    T deserialize(QDataStream& stream)
+    {
+        T value;
+        stream >> value;
+
+        return value;
+    }
+
+    QString serverName()
+    {
+        return QString("shaco-jobserver-test-%1").arg(QCoreApplication::applicationPid());
+    }
+}
+
+class JobServerTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    JobServerTest();
+
+private:
+    TestMachineInfo m_info;
+
+private Q_SLOTS:
+    void buildFramesWithSizeAndType();
+    void acceptReadableGCodeFiles();
+    void rejectUnreadableGCodeFiles();
+    void acceptShapeFilesAndSubmitTheirGCode();
+    void rejectInvalidShapeFiles();
+    void assignIncreasingJobIds();
+    void submitStreamedGCode();
+    void closeTheConnectionOnInvalidFrames();
+    void closeTheConnectionOnStreamDataWithoutBeginStream();
+    void sendStateChangesToSubscribers();
+    void coalesceStatusReports();
+    void doNotCollectStatusReportsWithoutSubscribers();
+    void sendTheLastProgressBeforeTheEndOfTheJob();
+    void forgetSubscribersWhenTheyDisconnect();
+};
+
+JobServerTest::JobServerTest()
+{
+}
+
+void JobServerTest::buildFramesWithSizeAndType()
+{
+    const auto f = JobServer::frame(JobServer::MessageType::StreamData, "G1");
+
+    QCOMPARE(f, QByteArray("\x00\x00\x00\x03\x03G1", 7));
+}
+
+void JobServerTest::acceptReadableGCodeFiles()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::fileJobSubmitted);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto filename = dir.path() + "/job.gcode";
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("G1 X10\n");
+    file.close();
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::SubmitFile, serialize(filename));
+
+    QTRY_COMPARE(client.frames().size(), 1);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobAccepted);
+    QDataStream stream(client.frames()[0].fields);
+    stream.setVersion(JobServer::dataStreamVersion);
+    const auto jobId = deserialize<JobServer::JobId>(stream);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<JobServer::JobId>(), jobId);
+    QCOMPARE(spy.at(0).at(1).toString(), filename);
+}
+
+void JobServerTest::rejectUnreadableGCodeFiles()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::fileJobSubmitted);
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    // This file should not exists...
+    client.send(JobServer::MessageType::SubmitFile, serialize("jdsflkjhesriohvuiehhrewiuq u3982hns.gcode"));
+
+    QTRY_COMPARE(client.frames().size(), 1);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobRejected);
+    QDataStream stream(client.frames()[0].fields);
+    stream.setVersion(JobServer::dataStreamVersion);
+    QVERIFY(deserialize<QString>(stream).contains("jdsflkjhesriohvuiehhrewiuq u3982hns.gcode"));
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(client.state(), QLocalSocket::ConnectedState);
+}
+
+void JobServerTest::acceptShapeFilesAndSubmitTheirGCode()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::fileJobSubmitted);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile gcode(dir.path() + "/polyshaper-000.gcode");
+    QVERIFY(gcode.open(QIODevice::WriteOnly));
+    gcode.write("G1 X10\n");
+    gcode.close();
+    QFile psj(dir.path() + "/polyshaper-000.psj");
+    QVERIFY(psj.open(QIODevice::WriteOnly));
+    psj.write(R"(
+{
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})");
+    psj.close();
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::SubmitFile, serialize(psj.fileName()));
+
+    QTRY_COMPARE(client.frames().size(), 1);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobAccepted);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(QFileInfo(spy.at(0).at(1).toString()).canonicalFilePath(), QFileInfo(gcode.fileName()).canonicalFilePath());
+}
+
+void JobServerTest::rejectInvalidShapeFiles()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::fileJobSubmitted);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile psj(dir.path() + "/invalid.psj");
+    QVERIFY(psj.open(QIODevice::WriteOnly));
+    psj.write("not json");
+    psj.close();
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::SubmitFile, serialize(psj.fileName()));
+
+    QTRY_COMPARE(client.frames().size(), 1);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobRejected);
+    QCOMPARE(spy.count(), 0);
+}
+
+void JobServerTest::assignIncreasingJobIds()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::streamedJobSubmitted);
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    for (auto i = 0; i < 2; ++i) {
+        client.send(JobServer::MessageType::BeginStream);
+        client.send(JobServer::MessageType::StreamData, "G1 X10\n");
+        client.send(JobServer::MessageType::EndStream);
+    }
+
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(spy.at(1).at(0).value<JobServer::JobId>() > spy.at(0).at(0).value<JobServer::JobId>());
+}
+
+void JobServerTest::submitStreamedGCode()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::streamedJobSubmitted);
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::BeginStream);
+    client.send(JobServer::MessageType::StreamData, "G1 X10\nG1 ");
+    client.send(JobServer::MessageType::StreamData, "Y20\n");
+
+    // Nothing is submitted before the end of the stream
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 0);
+
+    client.send(JobServer::MessageType::EndStream);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toByteArray(), "G1 X10\nG1 Y20\n");
+    QTRY_COMPARE(client.frames().size(), 1);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobAccepted);
+}
+
+void JobServerTest::closeTheConnectionOnInvalidFrames()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(static_cast<JobServer::MessageType>(0x42));
+
+    QTRY_COMPARE(client.state(), QLocalSocket::UnconnectedState);
+}
+
+void JobServerTest::closeTheConnectionOnStreamDataWithoutBeginStream()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+    QSignalSpy spy(&server, &JobServer::streamedJobSubmitted);
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::StreamData, "G1 X10\n");
+    client.send(JobServer::MessageType::EndStream);
+
+    QTRY_COMPARE(client.state(), QLocalSocket::UnconnectedState);
+    QCOMPARE(spy.count(), 0);
+}
+
+void JobServerTest::sendStateChangesToSubscribers()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+
+    TestClient subscriber;
+    QVERIFY(subscriber.connectToServer(serverName()));
+    subscriber.send(JobServer::MessageType::Subscribe);
+    TestClient other;
+    QVERIFY(other.connectToServer(serverName()));
+    QTRY_COMPARE(server.subscribers(), 1);
+
+    serialPort->simulateReceivedData("<Idle|MPos:0.000,0.000,0.000|FS:0,0|WCO:0.000,0.000,0.000>\r\n");
+
+    QTRY_COMPARE(subscriber.count(JobServer::MessageType::StateChanged), 1);
+    const auto it = std::find_if(subscriber.frames().cbegin(), subscriber.frames().cend(), [](const Frame& f) {
+        return f.type == JobServer::MessageType::StateChanged;
+    });
+    QDataStream stream(it->fields);
+    stream.setVersion(JobServer::dataStreamVersion);
+    QCOMPARE(deserialize<quint8>(stream), static_cast<quint8>(MachineState::Idle));
+    QTest::qWait(100);
+    QCOMPARE(other.frames().size(), 0);
+}
+
+void JobServerTest::coalesceStatusReports()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::Subscribe);
+    QTRY_COMPARE(server.subscribers(), 1);
+
+    for (auto i = 0; i < 10; ++i) {
+        serialPort->simulateReceivedData(QString("<Run|MPos:%1.000,0.000,0.000|FS:0,0>\r\n").arg(i).toLatin1());
+    }
+    // Not a status report
+    serialPort->simulateReceivedData("ok\r\n");
+
+    QTRY_COMPARE(client.count(JobServer::MessageType::StatusReport), 1);
+    QTest::qWait(150);
+    QCOMPARE(client.count(JobServer::MessageType::StatusReport), 1);
+    QCOMPARE(client.frames().last().type, JobServer::MessageType::StatusReport);
+    QCOMPARE(client.frames().last().fields, "<Run|MPos:9.000,0.000,0.000|FS:0,0>");
+}
+
+void JobServerTest::doNotCollectStatusReportsWithoutSubscribers()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+
+    serialPort->simulateReceivedData("<Run|MPos:0.000,0.000,0.000|FS:0,0>\r\n");
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::Subscribe);
+    QTRY_COMPARE(server.subscribers(), 1);
+
+    QTest::qWait(150);
+    QCOMPARE(client.count(JobServer::MessageType::StatusReport), 0);
+}
+
+void JobServerTest::sendTheLastProgressBeforeTheEndOfTheJob()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    // A long interval, progress must be sent anyway when the job ends
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 10000);
+    QVERIFY(server.listen());
+
+    TestClient client;
+    QVERIFY(client.connectToServer(serverName()));
+    client.send(JobServer::MessageType::Subscribe);
+    QTRY_COMPARE(server.subscribers(), 1);
+
+    server.jobStarted(7);
+    server.jobProgress(7, 10);
+    server.jobProgress(7, 20);
+    server.jobEnded(7, GCodeSender::StreamEndReason::Completed, "done");
+
+    QTRY_COMPARE(client.frames().size(), 3);
+    QCOMPARE(client.frames()[0].type, JobServer::MessageType::JobStarted);
+    QCOMPARE(client.frames()[1].type, JobServer::MessageType::JobProgress);
+    QDataStream progress(client.frames()[1].fields);
+    progress.setVersion(JobServer::dataStreamVersion);
+    QCOMPARE(deserialize<JobServer::JobId>(progress), 7u);
+    QCOMPARE(deserialize<quint32>(progress), 20u);
+    QCOMPARE(client.frames()[2].type, JobServer::MessageType::JobEnded);
+    QDataStream ended(client.frames()[2].fields);
+    ended.setVersion(JobServer::dataStreamVersion);
+    QCOMPARE(deserialize<JobServer::JobId>(ended), 7u);
+    QCOMPARE(deserialize<quint8>(ended), static_cast<quint8>(GCodeSender::StreamEndReason::Completed));
+    QCOMPARE(deserialize<QString>(ended), QString("done"));
+}
+
+void JobServerTest::forgetSubscribersWhenTheyDisconnect()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    MachineStatusMonitor statusMonitor(10000, 10000, communicator.get());
+    JobServer server(serverName(), communicator.get(), &statusMonitor, 50);
+    QVERIFY(server.listen());
+
+    {
+        TestClient client;
+        QVERIFY(client.connectToServer(serverName()));
+        client.send(JobServer::MessageType::Subscribe);
+        QTRY_COMPARE(server.subscribers(), 1);
+    }
+
+    QTRY_COMPARE(server.subscribers(), 0);
+}
+
+QTEST_GUILESS_MAIN(JobServerTest)
+
+#include "jobserver_test.moc"
@@ -1,11 +1,13 @@
 #include <memory>
 #include <QFile>
 #include <QFileSystemWatcher>
+#include <QSaveFile>
 #include <QSignalSpy>
 #include <QSysInfo>
 #include <QTemporaryDir>
 #include <QtTest>
 #include "core/localshapesfinder.h"
+#include "core/shapeindex.h"
 
 class LocalShapesFinderTest : public QObject
 {
@@ -32,7 +34,15 @@ private Q_SLOTS:
     void skipPsjFilesWithoutACorrespondingGCodeFile();
     void skipPsjFilesWithoutACorrespondingSvgFile();
     void emitSignalWhenShapesAreFirstFound();
-    void onlyLoadNewFilesWhenDirectoryChanges();
+    void onlyLoadNewAndModifiedFilesWhenDirectoryChanges();
+    void doNotReloadFilesThatDidNotChange();
+    void emitSignalWhenShapesAreModified();
+    void loadShapesWhenMissingFilesAreCreated();
+    void coalesceChangesWithinTheDebounceInterval();
+    void doNotLookIntoSubdirectoriesIfNotRecursive();
+    void loadFilesFromSubdirectoriesIfRecursive();
+    void loadFilesFromNewSubdirectoriesIfRecursive();
+    void removeShapesInRemovedSubdirectoriesIfRecursive();
     void emitSignalWhenNewShapesAreFound();
     void removeShapesThatNoLongerExist();
     void emitSignalWhenShapesAreRemoved();
@@ -43,6 +53,21 @@ private Q_SLOTS:
     void createDirectoryIfNotExistingAtStart();
     void whenRescanIsCalledByHandReloadEverythingFromTheBeginning();
     void whenRescanIsCalledByHandSignalThatAllShapesWereReloaded();
+    void useTheCanonicalPathOfSymbolicLinks();
+    void takeShapesThatDidNotChangeFromTheIndex();
+    void parseAgainShapesThatChangedSinceTheyWereIndexed();
+    void parseAgainShapesWhoseGCodeChangedSinceTheyWereIndexed();
+    void reloadShapesWhoseGCodeFileIsReplaced();
+    void doNotUseTheIndexWhenRescanIsCalledByHand();
+    void giveCopiesOfAShapeTheSameContentHash();
+    void takeCopiesOfIndexedShapesFromTheIndex();
+    void doNotReportShapesRewrittenWithTheSameContent();
+    void validateTheGCodeOfShapesInBackground();
+    void storeGCodeChecksInTheIndex();
+    void saveGCodeChecksWhenTheValidationEnds();
+    void loadShapesInBackgroundIfRequested();
+    void processChangesNotifiedWhileLoadingInBackground();
+    void reloadAfterTheRunningScanWhenLoadingInBackground();
 };
 
 LocalShapesFinderTest::LocalShapesFinderTest()
@@ -284,7 +309,7 @@ void LocalShapesFinderTest::emitSignalWhenShapesAreFirstFound()
     QCOMPARE(newShapes, expectedNewShapes);
 }
 
-void LocalShapesFinderTest::onlyLoadNewFilesWhenDirectoryChanges()
+void LocalShapesFinderTest::onlyLoadNewAndModifiedFilesWhenDirectoryChanges()
 {
     LocalShapesFinder finder(m_curPath);
 
@@ -296,19 +321,108 @@ void LocalShapesFinderTest::onlyLoadNewFilesWhenDirectoryChanges()
     QCOMPARE(finder.shapes().size(), 3);
 
     // New files and rescan
-    createFiles(1, 3, "psj", "another"); // 1 and 2 not reloaded, 3 added
+    createFiles(1, 3, "psj", "another"); // 1 and 2 modified (their size changes), 3 added
 
     // This is needed to process events from QFileWatcher
     QCoreApplication::processEvents();
 
     QCOMPARE(finder.shapes().size(), 4);
 
-    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-1.psj"].generatedBy(), "first");
-    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-2.psj"].generatedBy(), "first");
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-0.psj"].generatedBy(), "first");
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-1.psj"].generatedBy(), "another");
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-2.psj"].generatedBy(), "another");
     QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-3.psj"));
     QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-3.psj"].generatedBy(), "another");
 }
 
+void LocalShapesFinderTest::doNotReloadFilesThatDidNotChange()
+{
+    createFiles(0, 1, "psj", "UNO");
+    const QString filename = m_curPath + "/tmpTest-0.psj";
+    const auto modificationTime = QFileInfo(filename).lastModified();
+
+    LocalShapesFinder finder(m_curPath);
+
+    // Same size and modification time, the file is considered unchanged
+    createFiles(0, 1, "psj", "DUE");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(modificationTime, QFileDevice::FileModificationTime));
+    file.close();
+    createFiles(1, 1);
+
+    // This is needed to process events from QFileWatcher
+    QCoreApplication::processEvents();
+
+    QCOMPARE(finder.shapes().size(), 2);
+    QCOMPARE(finder.shapes()[filename].generatedBy(), "UNO");
+}
+
+void LocalShapesFinderTest::emitSignalWhenShapesAreModified()
+{
+    createFiles(0, 2, "psj", "first");
+
+    LocalShapesFinder finder(m_curPath);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    createFiles(1, 2, "psj", "another"); // 1 modified, 2 added
+
+    QVERIFY(spy.wait(500));
+
+    // Collect all shapes (on windows we might receive multiple signals)
+    QSet<QString> newShapes;
+    QSet<QString> removedShapes;
+    for (auto s: spy) {
+        newShapes.unite(s.at(0).value<QSet<QString>>());
+        removedShapes.unite(s.at(1).value<QSet<QString>>());
+    }
+    QCOMPARE(newShapes, (QSet<QString>{m_curPath + "/tmpTest-1.psj", m_curPath + "/tmpTest-2.psj"}));
+    QCOMPARE(removedShapes, QSet<QString>{m_curPath + "/tmpTest-1.psj"});
+}
+
+void LocalShapesFinderTest::loadShapesWhenMissingFilesAreCreated()
+{
+    createFiles(0, 1);
+    QVERIFY(QFile::remove(m_curPath + "/tmpTest-0.gcode"));
+
+    LocalShapesFinder finder(m_curPath);
+
+    QCOMPARE(finder.shapes().size(), 0);
+
+    // The psj file did not change, but now it is valid
+    QFile gcodeFile(m_curPath + "/tmpTest-0.gcode");
+    QVERIFY(gcodeFile.open(QIODevice::WriteOnly));
+    gcodeFile.close();
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+    QVERIFY(spy.wait(500));
+
+    QCOMPARE(finder.shapes().size(), 1);
+}
+
+void LocalShapesFinderTest::coalesceChangesWithinTheDebounceInterval()
+{
+    LocalShapesFinder finder(m_curPath, QString(), 2000);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    createFiles(0, 2);
+    QCoreApplication::processEvents();
+    createFiles(2, 2);
+    QCoreApplication::processEvents();
+
+    // Nothing happens before the interval expires
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(finder.shapes().size(), 0);
+
+    QVERIFY(spy.wait(3000));
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(finder.shapes().size(), 4);
+    QCOMPARE(spy.at(0).at(0).value<QSet<QString>>().size(), 4);
+}
+
 void LocalShapesFinderTest::emitSignalWhenNewShapesAreFound()
 {
     LocalShapesFinder finder(m_curPath);
@@ -571,6 +685,411 @@ void LocalShapesFinderTest::whenRescanIsCalledByHandSignalThatAllShapesWereReloa
     QCOMPARE(missingShapes, expectedSet);
 }
 
+void LocalShapesFinderTest::useTheCanonicalPathOfSymbolicLinks()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("Symbolic links are only tested on unix");
+#endif
+    QTemporaryDir otherDir;
+    const auto otherPath = QDir(otherDir.path()).canonicalPath();
+    createFilesInPath(otherPath, 0, 1);
+    createFiles(1, 2);
+    QVERIFY(QFile::link(otherPath + "/tmpTest-0.psj", m_curPath + "/link.psj"));
+
+    LocalShapesFinder finder(m_curPath);
+
+    QCOMPARE(finder.shapes().size(), 3);
+    QVERIFY(finder.shapes().contains(otherPath + "/tmpTest-0.psj"));
+    QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-1.psj"));
+    QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-2.psj"));
+}
+
+void LocalShapesFinderTest::takeShapesThatDidNotChangeFromTheIndex()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 2);
+    const QString filename = m_curPath + "/tmpTest-0.psj";
+    const auto modificationTime = QFileInfo(filename).lastModified();
+
+    {
+        LocalShapesFinder finder(m_curPath, indexFilename);
+        QCOMPARE(finder.shapes().size(), 2);
+    }
+    QVERIFY(QFile::exists(indexFilename));
+
+    // Changing the content without changing size and modification time: the shape is not parsed
+    // again and the one in the index is used
+    createFiles(0, 1, "psj", "3DPlugin");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(modificationTime, QFileDevice::FileModificationTime));
+    file.close();
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+
+    QCOMPARE(finder.shapes().size(), 2);
+    QCOMPARE(finder.shapes()[filename].generatedBy(), "2DPlugin");
+}
+
+void LocalShapesFinderTest::parseAgainShapesThatChangedSinceTheyWereIndexed()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 2);
+
+    {
+        LocalShapesFinder finder(m_curPath, indexFilename);
+        QCOMPARE(finder.shapes().size(), 2);
+    }
+
+    // The size changes, so the file is parsed again
+    createFiles(0, 1, "psj", "Another plugin");
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+
+    QCOMPARE(finder.shapes().size(), 2);
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-0.psj"].generatedBy(), "Another plugin");
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-1.psj"].generatedBy(), "2DPlugin");
+}
+
+void LocalShapesFinderTest::parseAgainShapesWhoseGCodeChangedSinceTheyWereIndexed()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 2);
+    const QString key = m_curPath + "/tmpTest-0.psj";
+
+    quint64 oldGCodeHash = 0;
+    {
+        LocalShapesFinder finder(m_curPath, indexFilename);
+        oldGCodeHash = finder.shapes()[key].gcodeHash();
+    }
+
+    // Only the G-code file changes, the .psj file is the same
+    QFile gcodeFile(m_curPath + "/tmpTest-0.gcode");
+    QVERIFY(gcodeFile.open(QIODevice::WriteOnly));
+    gcodeFile.write("G1 X10\n");
+    gcodeFile.close();
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+
+    QCOMPARE(finder.shapes().size(), 2);
+    QVERIFY(finder.shapes()[key].gcodeHash() != oldGCodeHash);
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-1.psj"].gcodeHash(), oldGCodeHash);
+}
+
+void LocalShapesFinderTest::reloadShapesWhoseGCodeFileIsReplaced()
+{
+    createFiles(0, 2);
+    const QString key = m_curPath + "/tmpTest-0.psj";
+
+    LocalShapesFinder finder(m_curPath);
+    const auto oldGCodeHash = finder.shapes()[key].gcodeHash();
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    // The file is replaced atomically, like editors do. The .psj file does not change
+    QSaveFile gcodeFile(m_curPath + "/tmpTest-0.gcode");
+    QVERIFY(gcodeFile.open(QIODevice::WriteOnly));
+    gcodeFile.write("G1 X10\n");
+    QVERIFY(gcodeFile.commit());
+
+    QTRY_VERIFY(finder.shapes()[key].gcodeHash() != oldGCodeHash);
+    QCOMPARE(finder.shapes().size(), 2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QSet<QString>>(), QSet<QString>{key});
+    QCOMPARE(spy.at(0).at(1).value<QSet<QString>>(), QSet<QString>{key});
+}
+
+void LocalShapesFinderTest::doNotUseTheIndexWhenRescanIsCalledByHand()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 1);
+    const QString filename = m_curPath + "/tmpTest-0.psj";
+    const auto modificationTime = QFileInfo(filename).lastModified();
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+
+    createFiles(0, 1, "psj", "3DPlugin");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(modificationTime, QFileDevice::FileModificationTime));
+    file.close();
+
+    finder.reload();
+
+    QCOMPARE(finder.shapes()[filename].generatedBy(), "3DPlugin");
+}
+
+void LocalShapesFinderTest::giveCopiesOfAShapeTheSameContentHash()
+{
+    createFiles(0, 2);
+    QVERIFY(QFile::copy(m_curPath + "/tmpTest-0.psj", m_curPath + "/copy.psj"));
+
+    LocalShapesFinder finder(m_curPath);
+
+    QCOMPARE(finder.shapes().size(), 3);
+    const auto original = finder.shapes()[m_curPath + "/tmpTest-0.psj"];
+    const auto copy = finder.shapes()[m_curPath + "/copy.psj"];
+    const auto other = finder.shapes()[m_curPath + "/tmpTest-1.psj"];
+    QVERIFY(original.contentHash() != 0);
+    QCOMPARE(copy.contentHash(), original.contentHash());
+    QVERIFY(other.contentHash() != original.contentHash());
+    QCOMPARE(copy.psjFilename(), "copy.psj");
+}
+
+void LocalShapesFinderTest::takeCopiesOfIndexedShapesFromTheIndex()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 1);
+
+    {
+        LocalShapesFinder finder(m_curPath, indexFilename);
+        QCOMPARE(finder.shapes().size(), 1);
+    }
+
+    QDir(m_curPath).mkdir("sub");
+    createFilesInPath(m_curPath + "/sub", 0, 1);
+
+    LocalShapesFinder finder(m_curPath, indexFilename, 0, true);
+
+    QCOMPARE(finder.shapes().size(), 2);
+    const auto copy = finder.shapes()[m_curPath + "/sub/tmpTest-0.psj"];
+    QVERIFY(copy.isValid());
+    QCOMPARE(copy.path(), m_curPath + "/sub");
+    QCOMPARE(copy.psjFilename(), "tmpTest-0.psj");
+    QCOMPARE(copy.contentHash(), finder.shapes()[m_curPath + "/tmpTest-0.psj"].contentHash());
+}
+
+void LocalShapesFinderTest::doNotReportShapesRewrittenWithTheSameContent()
+{
+    createFiles(0, 1);
+
+    LocalShapesFinder finder(m_curPath);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    // Same content but a different modification time, tmpTest-1 is new
+    createFiles(0, 2);
+
+    QVERIFY(spy.wait(500));
+
+    // Collect all shapes (on windows we might receive multiple signals)
+    QSet<QString> newShapes;
+    QSet<QString> removedShapes;
+    for (auto s: spy) {
+        newShapes.unite(s.at(0).value<QSet<QString>>());
+        removedShapes.unite(s.at(1).value<QSet<QString>>());
+    }
+    QCOMPARE(newShapes, QSet<QString>{m_curPath + "/tmpTest-1.psj"});
+    QCOMPARE(removedShapes, QSet<QString>());
+    QCOMPARE(finder.shapes().size(), 2);
+}
+
+void LocalShapesFinderTest::doNotLookIntoSubdirectoriesIfNotRecursive()
+{
+    QDir(m_curPath).mkpath("a/b");
+    createFiles(0, 1);
+    createFilesInPath(m_curPath + "/a", 1, 1);
+
+    LocalShapesFinder finder(m_curPath);
+
+    QCOMPARE(finder.shapes().size(), 1);
+    QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-0.psj"));
+    QCOMPARE(finder.directories(), QStringList{m_curPath});
+}
+
+void LocalShapesFinderTest::loadFilesFromSubdirectoriesIfRecursive()
+{
+    QDir(m_curPath).mkpath("a/b");
+    QDir(m_curPath).mkpath("c");
+    createFiles(0, 1);
+    createFilesInPath(m_curPath + "/a", 1, 1);
+    createFilesInPath(m_curPath + "/a/b", 2, 2);
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, true);
+
+    QCOMPARE(finder.shapes().size(), 4);
+    QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-0.psj"));
+    QVERIFY(finder.shapes().contains(m_curPath + "/a/tmpTest-1.psj"));
+    QVERIFY(finder.shapes().contains(m_curPath + "/a/b/tmpTest-2.psj"));
+    QVERIFY(finder.shapes().contains(m_curPath + "/a/b/tmpTest-3.psj"));
+
+    auto dirs = finder.directories();
+    dirs.sort();
+    QCOMPARE(dirs, (QStringList{m_curPath, m_curPath + "/a", m_curPath + "/a/b", m_curPath + "/c"}));
+}
+
+void LocalShapesFinderTest::loadFilesFromNewSubdirectoriesIfRecursive()
+{
+    QDir(m_curPath).mkpath("a");
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, true);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    // A file in an existing subdirectory
+    createFilesInPath(m_curPath + "/a", 0, 1);
+    QVERIFY(spy.wait(500));
+
+    QVERIFY(finder.shapes().contains(m_curPath + "/a/tmpTest-0.psj"));
+
+    // A new directory tree with files
+    QDir(m_curPath).mkpath("b/c");
+    createFilesInPath(m_curPath + "/b/c", 1, 1);
+
+    // Wait until the new tree is found (on some systems we get more signals)
+    for (auto i = 0; i < 5 && !finder.shapes().contains(m_curPath + "/b/c/tmpTest-1.psj"); ++i) {
+        spy.wait(500);
+    }
+
+    QCOMPARE(finder.shapes().size(), 2);
+    QVERIFY(finder.shapes().contains(m_curPath + "/b/c/tmpTest-1.psj"));
+}
+
+void LocalShapesFinderTest::removeShapesInRemovedSubdirectoriesIfRecursive()
+{
+    QDir(m_curPath).mkpath("a/b");
+    createFiles(0, 1);
+    createFilesInPath(m_curPath + "/a", 1, 1);
+    createFilesInPath(m_curPath + "/a/b", 2, 1);
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, true);
+
+    QCOMPARE(finder.shapes().size(), 3);
+
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    QVERIFY(QDir(m_curPath + "/a").removeRecursively());
+    QVERIFY(spy.wait(500));
+    for (auto i = 0; i < 5 && finder.shapes().size() != 1; ++i) {
+        spy.wait(500);
+    }
+
+    // Collect all removed shapes (we might receive multiple signals)
+    QSet<QString> removedShapes;
+    for (auto s: spy) {
+        QVERIFY(s.at(0).value<QSet<QString>>().isEmpty());
+        removedShapes.unite(s.at(1).value<QSet<QString>>());
+    }
+    QCOMPARE(removedShapes, (QSet<QString>{m_curPath + "/a/tmpTest-1.psj", m_curPath + "/a/b/tmpTest-2.psj"}));
+    QCOMPARE(finder.shapes().size(), 1);
+    QCOMPARE(finder.directories(), QStringList{m_curPath});
+}
+
+void LocalShapesFinderTest::validateTheGCodeOfShapesInBackground()
+{
+    createFiles(0, 2);
+    QFile gcodeFile(m_curPath + "/tmpTest-1.gcode");
+    QVERIFY(gcodeFile.open(QIODevice::WriteOnly));
+    gcodeFile.write("G21\nG1 X10 X20 F100\n");
+    gcodeFile.close();
+
+    LocalShapesFinder finder(m_curPath);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesChecked);
+
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QSet<QString>>(),
+             (QSet<QString>{m_curPath + "/tmpTest-0.psj", m_curPath + "/tmpTest-1.psj"}));
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-0.psj"].gcodeCheck().verdict, GCodeCheck::Verdict::Valid);
+    const auto check = finder.shapes()[m_curPath + "/tmpTest-1.psj"].gcodeCheck();
+    QCOMPARE(check.verdict, GCodeCheck::Verdict::Invalid);
+    QCOMPARE(check.line, 2u);
+}
+
+void LocalShapesFinderTest::storeGCodeChecksInTheIndex()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 1);
+
+    {
+        LocalShapesFinder finder(m_curPath, indexFilename);
+        QSignalSpy spy(&finder, &LocalShapesFinder::shapesChecked);
+        QVERIFY(spy.wait());
+    }
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesChecked);
+
+    // The check is already known, so it is not repeated
+    QCOMPARE(finder.shapes()[m_curPath + "/tmpTest-0.psj"].gcodeCheck().verdict, GCodeCheck::Verdict::Valid);
+    QVERIFY(!spy.wait(500));
+}
+
+void LocalShapesFinderTest::saveGCodeChecksWhenTheValidationEnds()
+{
+    QTemporaryDir indexDir;
+    const QString indexFilename = indexDir.path() + "/shapes.index";
+    createFiles(0, 2);
+
+    LocalShapesFinder finder(m_curPath, indexFilename);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesChecked);
+    QVERIFY(spy.wait());
+
+    // The index is read while the finder is still alive
+    ShapeIndex index(indexFilename);
+    QVERIFY(index.load());
+    QCOMPARE(index.shape(m_curPath + "/tmpTest-0.psj").gcodeCheck().verdict, GCodeCheck::Verdict::Valid);
+    QCOMPARE(index.shape(m_curPath + "/tmpTest-1.psj").gcodeCheck().verdict, GCodeCheck::Verdict::Valid);
+}
+
+void LocalShapesFinderTest::loadShapesInBackgroundIfRequested()
+{
+    createFiles(0, 3);
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, false, true);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    // Shapes are only available when the scan ends
+    QVERIFY(finder.isLoading());
+    QVERIFY(finder.shapes().isEmpty());
+
+    QVERIFY(spy.wait());
+    QVERIFY(!finder.isLoading());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QSet<QString>>(),
+             (QSet<QString>{m_curPath + "/tmpTest-0.psj", m_curPath + "/tmpTest-1.psj", m_curPath + "/tmpTest-2.psj"}));
+    QVERIFY(spy.at(0).at(1).value<QSet<QString>>().isEmpty());
+    QCOMPARE(finder.shapes().size(), 3);
+}
+
+void LocalShapesFinderTest::processChangesNotifiedWhileLoadingInBackground()
+{
+    createFiles(0, 3);
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, false, true);
+
+    // The change could be notified before or after the end of the first scan, in both cases the
+    // new shape must be found
+    createFiles(3, 1);
+
+    QTRY_COMPARE(finder.shapes().size(), 4);
+    QTRY_VERIFY(!finder.isLoading());
+    QVERIFY(finder.shapes().contains(m_curPath + "/tmpTest-3.psj"));
+}
+
+void LocalShapesFinderTest::reloadAfterTheRunningScanWhenLoadingInBackground()
+{
+    createFiles(0, 3);
+
+    LocalShapesFinder finder(m_curPath, QString(), 0, false, true);
+    QSignalSpy spy(&finder, &LocalShapesFinder::shapesUpdated);
+
+    finder.reload();
+
+    // The first scan reports new shapes, the reload reports all of them as removed and new
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(!finder.isLoading());
+    const QSet<QString> allShapes{m_curPath + "/tmpTest-0.psj", m_curPath + "/tmpTest-1.psj", m_curPath + "/tmpTest-2.psj"};
+    QCOMPARE(spy.at(0).at(0).value<QSet<QString>>(), allShapes);
+    QCOMPARE(spy.at(1).at(0).value<QSet<QString>>(), allShapes);
+    QCOMPARE(spy.at(1).at(1).value<QSet<QString>>(), allShapes);
+}
+
 QTEST_GUILESS_MAIN(LocalShapesFinderTest)
 
 #include "localshapesfinder_test.moc"
@@ -4,6 +4,7 @@
 #include <QSignalSpy>
 #include <QString>
 #include <QtTest>
+#include "core/clock.h"
 #include "core/machinecommunication.h"
 #include "core/portdiscovery.h"
 #include "core/serialport.h"
@@ -37,6 +38,7 @@ private Q_SLOTS:
     void sendResumeFeedHoldWhenAskedTo();
     void sendSoftResetWhenAskedTo();
     void doHardResetWhenAskedTo();
+    void waitForTheHardResetDelayUsingTheClock();
     void emitCommandReceivedWhenACommandIsReceived();
     void doNotEmitCommandReceivedIfDataHasNotEndline();
     void sendCompleteCommandWhenReceivedInMultipleParts();
@@ -311,6 +313,28 @@ void MachineCommunicationTest::doHardResetWhenAskedTo()
     QCOMPARE(machineInitializedSpy.count(), 2);
 }
 
+void MachineCommunicationTest::waitForTheHardResetDelayUsingTheClock()
+{
+    auto serialPort = new TestSerialPort();
+    TestPortDiscovery portDiscoverer(serialPort);
+    VirtualClock clock;
+
+    MachineCommunication communicator(2000, &clock);
+
+    QSignalSpy machineInitializedSpy(&communicator, &MachineCommunication::machineInitialized);
+
+    communicator.portFound(m_info.get(), &portDiscoverer);
+
+    QElapsedTimer timer;
+    timer.start();
+    communicator.hardReset();
+    const auto elapsed = timer.elapsed();
+
+    QVERIFY(elapsed < 1000);
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(2000000));
+    QCOMPARE(machineInitializedSpy.count(), 2);
+}
+
 void MachineCommunicationTest::emitCommandReceivedWhenACommandIsReceived()
 {
     auto serialPort = new TestSerialPort();
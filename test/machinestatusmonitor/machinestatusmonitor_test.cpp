@@ -1,7 +1,9 @@
 #include <QString>
 #include <QtTest>
 #include <QTime>
+#include "core/clock.h"
 #include "core/machinestatusmonitor.h"
+#include "core/metrics.h"
 #include "testcommon/testmachineinfo.h"
 #include "testcommon/testportdiscovery.h"
 #include "testcommon/testserialport.h"
@@ -30,6 +32,8 @@ private Q_SLOTS:
     void resetStateToUnknownWhenPortClosedWithError();
     void resetStateToUnknownWhenMachineIsInitialized();
     void closePortIfNoMessageIsReceivedWithinWatchdogDelay();
+    void pollAndCloseThePortInVirtualTime();
+    void measureThePollRoundTripWithTheGivenClock();
 };
 
 MachineStatusMonitorTest::MachineStatusMonitorTest()
@@ -258,6 +262,55 @@ void MachineStatusMonitorTest::closePortIfNoMessageIsReceivedWithinWatchdogDelay
     QVERIFY(chrono.elapsed() > 900);
 }
 
+void MachineStatusMonitorTest::pollAndCloseThePortInVirtualTime()
+{
+    auto serialPort = new TestSerialPort();
+    TestPortDiscovery portDiscoverer(serialPort);
+    auto communicator = std::make_unique<MachineCommunication>(1000);
+    VirtualClock clock;
+
+    MachineStatusMonitor statusMonitor(200, 60000, communicator.get(), &clock);
+
+    QSignalSpy dataSentSpy(communicator.get(), &MachineCommunication::dataSent);
+    QSignalSpy portClosedSpy(communicator.get(), &MachineCommunication::portClosedWithError);
+
+    communicator->portFound(&m_info, &portDiscoverer);
+
+    // One query at start and then one every 200 milliseconds
+    clock.advance(59999);
+    QCOMPARE(dataSentSpy.count(), 300);
+    QCOMPARE(portClosedSpy.count(), 0);
+
+    serialPort->simulateReceivedData("<Idle|MPos:0.000,0.000,0.000|FS:0,0>\r\n");
+
+    // A whole minute without answers after the last message
+    clock.advance(59999);
+    QCOMPARE(portClosedSpy.count(), 0);
+    clock.advance(1);
+    QCOMPARE(portClosedSpy.count(), 1);
+}
+
+void MachineStatusMonitorTest::measureThePollRoundTripWithTheGivenClock()
+{
+    auto serialPort = new TestSerialPort();
+    TestPortDiscovery portDiscoverer(serialPort);
+    auto communicator = std::make_unique<MachineCommunication>(1000);
+    VirtualClock clock;
+    auto& histogram = MetricsRegistry::global().histogram("statusMonitor.pollRoundTripUs");
+
+    MachineStatusMonitor statusMonitor(200, 60000, communicator.get(), &clock);
+    const auto countAtStart = histogram.snapshot().count;
+    const auto sumAtStart = histogram.snapshot().sum;
+
+    communicator->portFound(&m_info, &portDiscoverer);
+    // The second query is not answered, the round trip is measured from the first one
+    clock.advance(250);
+    serialPort->simulateReceivedData("<Idle|MPos:0.000,0.000,0.000|FS:0,0>\r\n");
+
+    QCOMPARE(histogram.snapshot().count, countAtStart + 1);
+    QCOMPARE(histogram.snapshot().sum, sumAtStart + 250000);
+}
+
 QTEST_GUILESS_MAIN(MachineStatusMonitorTest)
 
 #include "machinestatusmonitor_test.moc"
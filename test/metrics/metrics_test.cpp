@@ -0,0 +1,227 @@
+#include <thread>
+#include <vector>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/metrics.h"
+#include "core/metricslogger.h"
+
+class MetricsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsTest();
+
+private Q_SLOTS:
+    void addToCounters();
+    void setGauges();
+    void recordValuesInHistograms();
+    void computePercentilesOfHistograms();
+    void returnEmptySnapshotsOfEmptyHistograms();
+    void updateMetricsFromManyThreads();
+    void returnTheSameMetricForTheSameName();
+    void takeSnapshotsOfAllMetrics();
+    void convertSnapshotsToJson();
+    void appendSnapshotsToTheLogFile();
+    void startANewLogFileWhenTooLarge();
+};
+
+MetricsTest::MetricsTest()
+{
+}
+
+void MetricsTest::addToCounters()
+{
+    Counter counter;
+
+    counter.add();
+    counter.add(10);
+
+    QCOMPARE(counter.value(), Q_INT64_C(11));
+}
+
+void MetricsTest::setGauges()
+{
+    Gauge gauge;
+
+    gauge.set(10);
+    gauge.set(7);
+
+    QCOMPARE(gauge.value(), Q_INT64_C(7));
+}
+
+void MetricsTest::recordValuesInHistograms()
+{
+    Histogram histogram;
+
+    histogram.record(0);
+    histogram.record(1);
+    histogram.record(5);
+    histogram.record(6);
+    histogram.record(-3);
+
+    const auto s = histogram.snapshot();
+    QCOMPARE(s.count, Q_INT64_C(5));
+    QCOMPARE(s.sum, Q_INT64_C(12));
+    QCOMPARE(s.min, Q_INT64_C(0));
+    QCOMPARE(s.max, Q_INT64_C(6));
+    QCOMPARE(s.buckets.size(), Histogram::numBuckets);
+    QCOMPARE(s.buckets[0], Q_INT64_C(2));
+    QCOMPARE(s.buckets[1], Q_INT64_C(1));
+    QCOMPARE(s.buckets[3], Q_INT64_C(2));
+    QCOMPARE(s.mean(), 2.4);
+}
+
+void MetricsTest::computePercentilesOfHistograms()
+{
+    Histogram histogram;
+
+    for (auto i = 1; i <= 100; ++i) {
+        histogram.record(i);
+    }
+
+    const auto s = histogram.snapshot();
+    // Values are only known up to a power of two
+    QCOMPARE(s.percentile(0.5), Q_INT64_C(63));
+    QCOMPARE(s.percentile(0.6), Q_INT64_C(63));
+    QCOMPARE(s.percentile(0.64), Q_INT64_C(100));
+    QCOMPARE(s.percentile(1.0), Q_INT64_C(100));
+    QCOMPARE(s.percentile(0.0), Q_INT64_C(1));
+}
+
+void MetricsTest::returnEmptySnapshotsOfEmptyHistograms()
+{
+    Histogram histogram;
+
+    const auto s = histogram.snapshot();
+    QCOMPARE(s.count, Q_INT64_C(0));
+    QCOMPARE(s.min, Q_INT64_C(0));
+    QCOMPARE(s.max, Q_INT64_C(0));
+    QCOMPARE(s.percentile(0.5), Q_INT64_C(0));
+    QCOMPARE(s.mean(), 0.0);
+}
+
+void MetricsTest::updateMetricsFromManyThreads()
+{
+    Counter counter;
+    Histogram histogram;
+    const int numThreads = 4;
+    const int valuesPerThread = 100000;
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&counter, &histogram, t]() {
+            for (auto i = 0; i < valuesPerThread; ++i) {
+                counter.add();
+                histogram.record(t);
+            }
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    QCOMPARE(counter.value(), static_cast<qint64>(numThreads * valuesPerThread));
+    const auto s = histogram.snapshot();
+    QCOMPARE(s.count, static_cast<qint64>(numThreads * valuesPerThread));
+    QCOMPARE(s.min, Q_INT64_C(0));
+    QCOMPARE(s.max, static_cast<qint64>(numThreads - 1));
+}
+
+void MetricsTest::returnTheSameMetricForTheSameName()
+{
+    MetricsRegistry registry;
+
+    QCOMPARE(&registry.counter("a"), &registry.counter("a"));
+    QVERIFY(&registry.counter("a") != &registry.counter("b"));
+    QCOMPARE(&registry.gauge("a"), &registry.gauge("a"));
+    QCOMPARE(&registry.histogram("a"), &registry.histogram("a"));
+}
+
+void MetricsTest::takeSnapshotsOfAllMetrics()
+{
+    MetricsRegistry registry;
+    registry.counter("component.counter").add(3);
+    registry.gauge("component.gauge").set(-2);
+    registry.histogram("component.histogram").record(10);
+
+    const auto s = registry.snapshot();
+
+    QVERIFY(s.timestampMs > 0);
+    QCOMPARE(s.counters.size(), 1);
+    QCOMPARE(s.counters["component.counter"], Q_INT64_C(3));
+    QCOMPARE(s.gauges.size(), 1);
+    QCOMPARE(s.gauges["component.gauge"], Q_INT64_C(-2));
+    QCOMPARE(s.histograms.size(), 1);
+    QCOMPARE(s.histograms["component.histogram"].count, Q_INT64_C(1));
+}
+
+void MetricsTest::convertSnapshotsToJson()
+{
+    MetricsRegistry registry;
+    registry.counter("c").add(3);
+    registry.gauge("g").set(4);
+    registry.histogram("h").record(5);
+
+    const auto json = MetricsLogger::snapshotToJson(registry.snapshot());
+
+    QVERIFY(!json.contains('\n'));
+    const auto obj = QJsonDocument::fromJson(json).object();
+    QVERIFY(obj["timestampMs"].toDouble() > 0);
+    QCOMPARE(obj["counters"].toObject()["c"].toInt(), 3);
+    QCOMPARE(obj["gauges"].toObject()["g"].toInt(), 4);
+    const auto h = obj["histograms"].toObject()["h"].toObject();
+    QCOMPARE(h["count"].toInt(), 1);
+    QCOMPARE(h["max"].toInt(), 5);
+    QCOMPARE(h["p99"].toInt(), 5);
+}
+
+void MetricsTest::appendSnapshotsToTheLogFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto filename = dir.path() + "/logs/metrics.log";
+    MetricsRegistry registry;
+    MetricsLogger logger(registry, filename, 10);
+
+    registry.counter("c").add(1);
+    QVERIFY(logger.writeSnapshot());
+    registry.counter("c").add(1);
+    QVERIFY(logger.writeSnapshot());
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto lines = file.readAll().split('\n');
+    QCOMPARE(lines.size(), 3);
+    QVERIFY(lines[2].isEmpty());
+    QCOMPARE(QJsonDocument::fromJson(lines[0]).object()["counters"].toObject()["c"].toInt(), 1);
+    QCOMPARE(QJsonDocument::fromJson(lines[1]).object()["counters"].toObject()["c"].toInt(), 2);
+}
+
+void MetricsTest::startANewLogFileWhenTooLarge()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto filename = dir.path() + "/metrics.log";
+    MetricsRegistry registry;
+    registry.counter("c").add(1);
+    MetricsLogger logger(registry, filename, 10, 10);
+
+    QVERIFY(logger.writeSnapshot());
+    QVERIFY(logger.writeSnapshot());
+    QVERIFY(logger.writeSnapshot());
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll().count('\n'), 1);
+    QFile oldFile(filename + ".old");
+    QVERIFY(oldFile.open(QIODevice::ReadOnly));
+    QCOMPARE(oldFile.readAll().count('\n'), 1);
+}
+
+QTEST_GUILESS_MAIN(MetricsTest)
+
+#include "metrics_test.moc"
@@ -0,0 +1,249 @@
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QtTest>
+#include "core/clock.h"
+#include "core/nativeserialport.h"
+
+namespace {
+    // The master side of a pseudo terminal, the port opens the slave side
+    class PseudoTerminal
+    {
+    public:
+        PseudoTerminal()
+            : m_master(::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK))
+        {
+            if (m_master != -1 && (::grantpt(m_master) == -1 || ::unlockpt(m_master) == -1)) {
+                closeMaster();
+            }
+        }
+
+        ~PseudoTerminal()
+        {
+            closeMaster();
+        }
+
+        bool isValid() const
+        {
+            return m_master != -1;
+        }
+
+        QString slaveName() const
+        {
+            return QString::fromLocal8Bit(::ptsname(m_master));
+        }
+
+        qint64 write(const QByteArray& data)
+        {
+            return ::write(m_master, data.constData(), static_cast<size_t>(data.size()));
+        }
+
+        QByteArray readAll()
+        {
+            QByteArray data;
+            char buffer[4096];
+            ssize_t n;
+            while ((n = ::read(m_master, buffer, sizeof(buffer))) > 0) {
+                data.append(buffer, static_cast<int>(n));
+            }
+
+            return data;
+        }
+
+        void closeMaster()
+        {
+            if (m_master != -1) {
+                ::close(m_master);
+                m_master = -1;
+            }
+        }
+
+    private:
+        int m_master;
+    };
+}
+
+class NativeSerialPortTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    NativeSerialPortTest();
+
+private Q_SLOTS:
+    void openPseudoTerminals();
+    void openAtBaudRatesWithoutATermiosConstant();
+    void failToOpenMissingDevices();
+    void doNotSetLowLatencyOnPseudoTerminals();
+    void readDataWhenAvailable();
+    void writeData();
+    void writeDataLargerThanTheKernelBuffer();
+    void waitBetweenCharactersUsingTheClock();
+    void failToWriteIfNotOpen();
+    void signalErrorWhenTheOtherSideIsClosed();
+};
+
+NativeSerialPortTest::NativeSerialPortTest()
+{
+}
+
+void NativeSerialPortTest::openPseudoTerminals()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+
+    QVERIFY(port.open());
+}
+
+void NativeSerialPortTest::openAtBaudRatesWithoutATermiosConstant()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    port.setBaudRate(250000);
+
+    QVERIFY(port.open());
+    QCOMPARE(port.baudRate(), 250000);
+}
+
+void NativeSerialPortTest::failToOpenMissingDevices()
+{
+    // This file should not exists...
+    NativeSerialPort port("/dev/jdsflkjhesriohvuiehhrewiuq");
+    QSignalSpy spy(&port, &NativeSerialPort::errorOccurred);
+
+    QVERIFY(!port.open());
+    QVERIFY(!port.errorString().isEmpty());
+    // The signal is queued
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(spy.wait(1000));
+}
+
+void NativeSerialPortTest::doNotSetLowLatencyOnPseudoTerminals()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    QSignalSpy spy(&port, &NativeSerialPort::errorOccurred);
+
+    QVERIFY(port.open());
+
+    QVERIFY(!port.lowLatency());
+    QVERIFY(!spy.wait(100));
+}
+
+void NativeSerialPortTest::readDataWhenAvailable()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    QVERIFY(port.open());
+    QSignalSpy spy(&port, &NativeSerialPort::dataAvailable);
+    QSignalSpy errorSpy(&port, &NativeSerialPort::errorOccurred);
+
+    QCOMPARE(pty.write("ok\r\n"), Q_INT64_C(4));
+
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(port.readAll(), "ok\r\n");
+    QCOMPARE(port.readAll(), "");
+
+    // Reading everything is not an error, the port keeps working
+    QCOMPARE(port.write("G1 X10\n"), Q_INT64_C(7));
+    QTRY_COMPARE(pty.readAll(), "G1 X10\n");
+    QCOMPARE(pty.write("ok\r\n"), Q_INT64_C(4));
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(port.readAll(), "ok\r\n");
+    QCoreApplication::processEvents();
+    QCOMPARE(errorSpy.count(), 0);
+}
+
+void NativeSerialPortTest::writeData()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    QVERIFY(port.open());
+
+    QCOMPARE(port.write("G1 X10\n"), Q_INT64_C(7));
+    QCOMPARE(port.write("G1 Y10\n"), Q_INT64_C(7));
+
+    QByteArray received;
+    QTRY_VERIFY((received += pty.readAll()).size() >= 14);
+    QCOMPARE(received, "G1 X10\nG1 Y10\n");
+}
+
+void NativeSerialPortTest::writeDataLargerThanTheKernelBuffer()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    QVERIFY(port.open());
+
+    QByteArray data;
+    for (auto i = 0; i < 100000; ++i) {
+        data += QByteArray::number(i) + "\n";
+    }
+    const auto half = data.size() / 2;
+
+    // The rest is queued and written when the other side reads
+    QCOMPARE(port.write(data.left(half)), static_cast<qint64>(half));
+    QCOMPARE(port.write(data.mid(half)), static_cast<qint64>(data.size() - half));
+    QVERIFY(port.bytesToWrite() > 0);
+
+    QByteArray received;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pty.readAll()).size() >= data.size(), 10000);
+    QCOMPARE(received, data);
+    QCOMPARE(port.bytesToWrite(), Q_INT64_C(0));
+}
+
+void NativeSerialPortTest::waitBetweenCharactersUsingTheClock()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    VirtualClock clock;
+    NativeSerialPort port(pty.slaveName(), &clock);
+    QVERIFY(port.open());
+    port.setCharacterSendDelayUs(1000);
+
+    QElapsedTimer realTime;
+    realTime.start();
+
+    QCOMPARE(port.write("G1 X10\n"), Q_INT64_C(7));
+
+    QVERIFY(realTime.elapsed() < 1000);
+    QCOMPARE(clock.elapsedUs(), Q_INT64_C(7000));
+    QByteArray received;
+    QTRY_VERIFY((received += pty.readAll()).size() >= 7);
+    QCOMPARE(received, "G1 X10\n");
+}
+
+void NativeSerialPortTest::failToWriteIfNotOpen()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+
+    QCOMPARE(port.write("G1 X10\n"), Q_INT64_C(-1));
+    QVERIFY(!port.errorString().isEmpty());
+}
+
+void NativeSerialPortTest::signalErrorWhenTheOtherSideIsClosed()
+{
+    PseudoTerminal pty;
+    QVERIFY(pty.isValid());
+    NativeSerialPort port(pty.slaveName());
+    QVERIFY(port.open());
+    QSignalSpy spy(&port, &NativeSerialPort::errorOccurred);
+
+    pty.closeMaster();
+
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(port.write("G1 X10\n"), Q_INT64_C(-1));
+}
+
+QTEST_GUILESS_MAIN(NativeSerialPortTest)
+
+#include "nativeserialport_test.moc"
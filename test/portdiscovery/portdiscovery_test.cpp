@@ -5,6 +5,7 @@
 #include <QSerialPort>
 #include <QSignalSpy>
 #include <QTime>
+#include "core/clock.h"
 #include "core/machineinfo.h"
 #include "core/portdiscovery.h"
 #include "core/serialport.h"
@@ -123,6 +124,7 @@ private Q_SLOTS:
     void emitAMessageWhenStartProbing();
     void continuouslyProbeForPortsAtRegularIntervals();
     void openPortWhenTheExpectedVendorAndProductIdAreFound();
+    void openAnyPortIfVendorAndProductCheckIsDisabled();
     void resetAndAskFirmwareVersionAfterOpeningPort();
     void askFirmwareVersionAgainIfNoAswerIsReceived();
     void ifTheExpectedReplyIsReceivedEmitSignal();
@@ -138,6 +140,11 @@ private Q_SLOTS:
     void doNotAskFirmwareVersionAgainIfPortFoundAfterAFailureAtOpening();
     void setInitialCharacterSendDelayOnPortOpen();
     void setInitialCharacterSendDelayOnPortOpenWhenSetterIsUsed();
+    void openPortsAtTheDefaultBaudRateIfNoneIsSet();
+    void openPortsAtTheFirstBaudRate();
+    void tryTheNextBaudRateAfterFailingTheMaximumNumberOfAttempts();
+    void continueWithNextPortAfterFailingWithAllBaudRates();
+    void reportTheBaudRateOfTheMachineFound();
 };
 
 PortDiscoveryTest::PortDiscoveryTest()
@@ -215,6 +222,31 @@ void PortDiscoveryTest::openPortWhenTheExpectedVendorAndProductIdAreFound()
     QCOMPARE(openSpy.count(), 1);
 }
 
+void PortDiscoveryTest::openAnyPortIfVendorAndProductCheckIsDisabled()
+{
+    auto portListingFunction = []() {
+        return QList<TestPortInfo>{TestPortInfo(13, 17), TestPortInfo(0x2341, 0x0043)};
+    };
+    auto serialPort = new TestSerialPort();
+    auto serialPortFactory = [this, serialPort](TestPortInfo p) {
+        emit serialPortCreated(p);
+        return std::unique_ptr<SerialPortInterface>(serialPort);
+    };
+
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 3000, 1, 1, 0, false);
+
+    QSignalSpy creationSpy(this, &PortDiscoveryTest::serialPortCreated);
+    QSignalSpy openSpy(serialPort, &TestSerialPort::portOpened);
+
+    portDiscoverer.start();
+
+    QCOMPARE(creationSpy.count(), 1);
+    auto portInfo = creationSpy.at(0).at(0).value<TestPortInfo>();
+    QCOMPARE(portInfo.vendorIdentifier(), 13);
+    QCOMPARE(portInfo.productIdentifier(), 17);
+    QCOMPARE(openSpy.count(), 1);
+}
+
 void PortDiscoveryTest::resetAndAskFirmwareVersionAfterOpeningPort()
 {
     TestPortInfo portInfo(0x2341, 0x0043);
@@ -673,5 +705,119 @@ void PortDiscoveryTest::setInitialCharacterSendDelayOnPortOpenWhenSetterIsUsed()
     QCOMPARE(serialPort->characterSendDelayUs(), 1317ul);
 }
 
+void PortDiscoveryTest::openPortsAtTheDefaultBaudRateIfNoneIsSet()
+{
+    auto portListingFunction = []() { return QList<TestPortInfo>{TestPortInfo(0x2341, 0x0043)}; };
+    auto serialPort = new TestSerialPort();
+    auto serialPortFactory = [serialPort](TestPortInfo) {
+        return std::unique_ptr<SerialPortInterface>(serialPort);
+    };
+
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 3000, 1, 1, 0);
+
+    portDiscoverer.setBaudRates(QList<qint32>());
+    portDiscoverer.start();
+
+    QCOMPARE(serialPort->baudRate(), SerialPortInterface::defaultBaudRate);
+}
+
+void PortDiscoveryTest::openPortsAtTheFirstBaudRate()
+{
+    auto portListingFunction = []() { return QList<TestPortInfo>{TestPortInfo(0x2341, 0x0043)}; };
+    auto serialPort = new TestSerialPort();
+    auto serialPortFactory = [serialPort](TestPortInfo) {
+        return std::unique_ptr<SerialPortInterface>(serialPort);
+    };
+
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 3000, 1, 1, 0);
+
+    portDiscoverer.setBaudRates(QList<qint32>{250000, 115200});
+    portDiscoverer.start();
+
+    QCOMPARE(serialPort->baudRate(), 250000);
+}
+
+void PortDiscoveryTest::tryTheNextBaudRateAfterFailingTheMaximumNumberOfAttempts()
+{
+    auto portListingFunction = []() { return QList<TestPortInfo>{TestPortInfo(0x2341, 0x0043)}; };
+    // The baud rate is set before opening
+    QList<qint32> openedBaudRates;
+    TestSerialPort* lastSerialPort = nullptr;
+    auto serialPortFactory = [&openedBaudRates, &lastSerialPort](TestPortInfo) {
+        auto serialPort = new TestSerialPort();
+        QObject::connect(serialPort, &TestSerialPort::portOpened, [serialPort, &openedBaudRates]() {
+            openedBaudRates.append(serialPort->baudRate());
+        });
+        lastSerialPort = serialPort;
+        return std::unique_ptr<SerialPortInterface>(serialPort);
+    };
+
+    VirtualClock clock;
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 1000, 100, 2, 0, true, &clock);
+
+    portDiscoverer.setBaudRates(QList<qint32>{250000, 115200});
+    portDiscoverer.start();
+    clock.advance(100);
+
+    QCOMPARE(openedBaudRates, (QList<qint32>{250000}));
+
+    clock.advance(100);
+
+    // The port has been opened again at the next baud rate and is polled as usual
+    QCOMPARE(openedBaudRates, (QList<qint32>{250000, 115200}));
+    QSignalSpy dataWrittenSpy(lastSerialPort, &TestSerialPort::dataWritten);
+    clock.advance(100);
+    QCOMPARE(dataWrittenSpy.count(), 1);
+    QCOMPARE(dataWrittenSpy.at(0).at(0).toByteArray(), "$I\n");
+}
+
+void PortDiscoveryTest::continueWithNextPortAfterFailingWithAllBaudRates()
+{
+    auto portListingFunction = []() {
+        return QList<TestPortInfo>{TestPortInfo(0x2341, 0x0043), TestPortInfo(0x2341, 0x0043)};
+    };
+    QList<qint32> openedBaudRates;
+    auto serialPortFactory = [&openedBaudRates](TestPortInfo) {
+        auto serialPort = new TestSerialPort();
+        QObject::connect(serialPort, &TestSerialPort::portOpened, [serialPort, &openedBaudRates]() {
+            openedBaudRates.append(serialPort->baudRate());
+        });
+        return std::unique_ptr<SerialPortInterface>(serialPort);
+    };
+
+    VirtualClock clock;
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 1000, 100, 1, 0, true, &clock);
+
+    portDiscoverer.setBaudRates(QList<qint32>{500000, 250000, 115200});
+    portDiscoverer.start();
+    clock.advance(300);
+
+    QCOMPARE(openedBaudRates, (QList<qint32>{500000, 250000, 115200, 500000}));
+}
+
+void PortDiscoveryTest::reportTheBaudRateOfTheMachineFound()
+{
+    auto portListingFunction = []() { return QList<TestPortInfo>{TestPortInfo(0x2341, 0x0043)}; };
+    TestSerialPort* lastSerialPort = nullptr;
+    auto serialPortFactory = [&lastSerialPort](TestPortInfo) {
+        lastSerialPort = new TestSerialPort();
+        return std::unique_ptr<SerialPortInterface>(lastSerialPort);
+    };
+
+    VirtualClock clock;
+    PortDiscovery<TestPortInfo> portDiscoverer(portListingFunction, serialPortFactory, 1000, 100, 1, 0, true, &clock);
+
+    QSignalSpy spy(&portDiscoverer, &PortDiscovery<TestPortInfo>::portFound);
+
+    portDiscoverer.setBaudRates(QList<qint32>{250000, 115200});
+    portDiscoverer.start();
+    clock.advance(100);
+
+    lastSerialPort->simulateReceivedData("[PolyShaper Oranje][pn123 sn456 789]ok\r\n");
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(portDiscoverer.baudRate(), 115200);
+}
+
 QTEST_GUILESS_MAIN(PortDiscoveryTest)
 #include "portdiscovery_test.moc"
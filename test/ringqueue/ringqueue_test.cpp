@@ -0,0 +1,141 @@
+#include <QByteArray>
+#include <QtTest>
+#include "core/ringqueue.h"
+
+class RingQueueTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    RingQueueTest();
+
+private Q_SLOTS:
+    void beEmptyAtStart();
+    void dequeueInTheSameOrderOfEnqueue();
+    void wrapAroundTheEndOfTheBuffer();
+    void accessElementsFromTheHead();
+    void growWhenFullKeepingTheOrder();
+    void keepTheValueOfDequeuedElementsInSlots();
+    void keepTheBuffersOfElementsWhenGrowing();
+    void clearTheQueueWithoutChangingCapacity();
+};
+
+RingQueueTest::RingQueueTest()
+{
+}
+
+void RingQueueTest::beEmptyAtStart()
+{
+    RingQueue<int> queue(4);
+
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.size(), 0);
+    QCOMPARE(queue.capacity(), 4);
+}
+
+void RingQueueTest::dequeueInTheSameOrderOfEnqueue()
+{
+    RingQueue<int> queue(4);
+
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.enqueue(3);
+
+    QCOMPARE(queue.size(), 3);
+    QCOMPARE(queue.head(), 1);
+    queue.dequeue();
+    QCOMPARE(queue.head(), 2);
+    queue.dequeue();
+    QCOMPARE(queue.head(), 3);
+    queue.dequeue();
+    QVERIFY(queue.isEmpty());
+}
+
+void RingQueueTest::wrapAroundTheEndOfTheBuffer()
+{
+    RingQueue<int> queue(3);
+
+    for (auto i = 0; i < 10; ++i) {
+        queue.enqueue(i);
+        queue.enqueue(i + 100);
+        QCOMPARE(queue.head(), i);
+        queue.dequeue();
+        QCOMPARE(queue.head(), i + 100);
+        queue.dequeue();
+    }
+
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.capacity(), 3);
+}
+
+void RingQueueTest::accessElementsFromTheHead()
+{
+    RingQueue<int> queue(3);
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.dequeue();
+    queue.enqueue(3);
+    queue.enqueue(4);
+
+    QCOMPARE(queue.at(0), 2);
+    QCOMPARE(queue.at(1), 3);
+    QCOMPARE(queue.at(2), 4);
+}
+
+void RingQueueTest::growWhenFullKeepingTheOrder()
+{
+    RingQueue<int> queue(3);
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.dequeue();
+    queue.enqueue(3);
+    queue.enqueue(4);
+
+    queue.enqueue(5);
+
+    QCOMPARE(queue.capacity(), 6);
+    QCOMPARE(queue.size(), 4);
+    for (auto i = 2; i <= 5; ++i) {
+        QCOMPARE(queue.head(), i);
+        queue.dequeue();
+    }
+}
+
+void RingQueueTest::keepTheValueOfDequeuedElementsInSlots()
+{
+    RingQueue<QByteArray> queue(1);
+    queue.enqueueSlot() = "G1 X10\n";
+    queue.dequeue();
+
+    QCOMPARE(queue.enqueueSlot(), "G1 X10\n");
+}
+
+void RingQueueTest::keepTheBuffersOfElementsWhenGrowing()
+{
+    RingQueue<QByteArray> queue(2);
+    queue.enqueueSlot().reserve(128);
+    queue.enqueueSlot().reserve(128);
+
+    queue.enqueue("G1 X10\n");
+
+    QCOMPARE(queue.capacity(), 4);
+    QCOMPARE(queue.at(0).capacity(), 128);
+    QCOMPARE(queue.at(1).capacity(), 128);
+}
+
+void RingQueueTest::clearTheQueueWithoutChangingCapacity()
+{
+    RingQueue<int> queue(2);
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.enqueue(3);
+
+    queue.clear();
+
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.capacity(), 4);
+}
+
+QTEST_GUILESS_MAIN(RingQueueTest)
+
+#include "ringqueue_test.moc"
@@ -0,0 +1,331 @@
+#include <memory>
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/shapeindex.h"
+#include "core/shapeinfo.h"
+
+namespace {
+    // Metadata of a shape whose G-code and SVG files do not change
+    ShapeFilesMetadata filesMetadata(qint64 size, qint64 modificationTime, quint64 inode)
+    {
+        return ShapeFilesMetadata{FileMetadata{size, modificationTime, inode}, FileMetadata{1, 2, 3}, FileMetadata{4, 5, 6}};
+    }
+}
+
+class ShapeIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShapeIndexTest();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_indexFilename;
+    ShapeInfo createShape(QString psjName, QByteArray name);
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void beEmptyAtStart();
+    void returnInvalidShapeForUnknownFiles();
+    void returnStoredShapeIfMetadataMatches();
+    void returnInvalidShapeIfMetadataDiffers();
+    void returnInvalidShapeIfMetadataOfGCodeOrSvgDiffers();
+    void returnStoredShapeWhateverTheMetadata();
+    void saveAndLoadTheIndex();
+    void failLoadingIfFileDoesNotExist();
+    void failLoadingAndStayEmptyIfFileIsInvalid();
+    void removeEntries();
+    void retainOnlyTheGivenFiles();
+    void computeFileMetadata();
+    void computeMetadataOfTheFilesOfAShape();
+    void lookupShapesByPsjHash();
+    void saveAndLoadContentHashes();
+};
+
+ShapeIndexTest::ShapeIndexTest()
+{
+}
+
+ShapeInfo ShapeIndexTest::createShape(QString psjName, QByteArray name)
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": ")" + name + R"(",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+
+    QFile file(m_dir->path() + "/" + psjName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        throw QString("CANNOT CREATE psj TEMPORARY FILE!!!");
+    }
+    file.write(content);
+    file.close();
+
+    return ShapeInfo::createFromFile(file.fileName());
+}
+
+void ShapeIndexTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_indexFilename = m_dir->path() + "/index/shapes.index";
+}
+
+void ShapeIndexTest::cleanup()
+{
+    m_dir.reset();
+}
+
+void ShapeIndexTest::beEmptyAtStart()
+{
+    ShapeIndex index(m_indexFilename);
+
+    QCOMPARE(index.filename(), m_indexFilename);
+    QCOMPARE(index.size(), 0);
+}
+
+void ShapeIndexTest::returnInvalidShapeForUnknownFiles()
+{
+    ShapeIndex index(m_indexFilename);
+
+    QVERIFY(!index.lookup("/some/file.psj", filesMetadata(10, 20, 30)).isValid());
+}
+
+void ShapeIndexTest::returnStoredShapeIfMetadataMatches()
+{
+    ShapeIndex index(m_indexFilename);
+    const auto shape = createShape("a.psj", "sandman");
+    QVERIFY(shape.isValid());
+
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), shape);
+
+    QCOMPARE(index.size(), 1);
+    const auto found = index.lookup("/some/a.psj", filesMetadata(10, 20, 30));
+    QVERIFY(found.isValid());
+    QCOMPARE(found.name(), "sandman");
+}
+
+void ShapeIndexTest::returnInvalidShapeIfMetadataDiffers()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+
+    QVERIFY(!index.lookup("/some/a.psj", filesMetadata(11, 20, 30)).isValid());
+    QVERIFY(!index.lookup("/some/a.psj", filesMetadata(10, 21, 30)).isValid());
+    QVERIFY(!index.lookup("/some/a.psj", filesMetadata(10, 20, 31)).isValid());
+}
+
+void ShapeIndexTest::returnInvalidShapeIfMetadataOfGCodeOrSvgDiffers()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+
+    auto metadata = filesMetadata(10, 20, 30);
+    metadata.gcode.size = 100;
+    QVERIFY(!index.lookup("/some/a.psj", metadata).isValid());
+
+    metadata = filesMetadata(10, 20, 30);
+    metadata.svg.modificationTime = 100;
+    QVERIFY(!index.lookup("/some/a.psj", metadata).isValid());
+}
+
+void ShapeIndexTest::returnStoredShapeWhateverTheMetadata()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+
+    QCOMPARE(index.shape("/some/a.psj").name(), "sandman");
+    QVERIFY(!index.shape("/some/b.psj").isValid());
+}
+
+void ShapeIndexTest::saveAndLoadTheIndex()
+{
+    const auto shape = createShape("a.psj", "sandman");
+
+    {
+        ShapeIndex index(m_indexFilename);
+        index.insert("/some/a.psj", filesMetadata(10, 20, 30), shape);
+        index.insert("/some/b.psj", filesMetadata(40, 50, 60), createShape("b.psj", "wolf"));
+
+        // The directory of the index is created if needed
+        QVERIFY(index.save());
+    }
+
+    ShapeIndex index(m_indexFilename);
+    QVERIFY(index.load());
+
+    QCOMPARE(index.size(), 2);
+    const auto a = index.lookup("/some/a.psj", filesMetadata(10, 20, 30));
+    QVERIFY(a.isValid());
+    QCOMPARE(a.version(), shape.version());
+    QCOMPARE(a.path(), shape.path());
+    QCOMPARE(a.psjFilename(), shape.psjFilename());
+    QCOMPARE(a.name(), shape.name());
+    QCOMPARE(a.svgFilename(), shape.svgFilename());
+    QCOMPARE(a.square(), shape.square());
+    QCOMPARE(a.machineType(), shape.machineType());
+    QCOMPARE(a.drawToolpath(), shape.drawToolpath());
+    QCOMPARE(a.margin(), shape.margin());
+    QCOMPARE(a.generatedBy(), shape.generatedBy());
+    QCOMPARE(a.creationTime(), shape.creationTime());
+    QCOMPARE(a.flatness(), shape.flatness());
+    QCOMPARE(a.workpieceDimX(), shape.workpieceDimX());
+    QCOMPARE(a.workpieceDimY(), shape.workpieceDimY());
+    QCOMPARE(a.autoClosePath(), shape.autoClosePath());
+    QCOMPARE(a.duration(), shape.duration());
+    QCOMPARE(a.pointsInsideWorkpiece(), shape.pointsInsideWorkpiece());
+    QCOMPARE(a.speed(), shape.speed());
+    QCOMPARE(a.gcodeFilename(), shape.gcodeFilename());
+
+    const auto b = index.lookup("/some/b.psj", filesMetadata(40, 50, 60));
+    QVERIFY(b.isValid());
+    QCOMPARE(b.name(), "wolf");
+}
+
+void ShapeIndexTest::failLoadingIfFileDoesNotExist()
+{
+    ShapeIndex index(m_indexFilename);
+
+    QVERIFY(!index.load());
+    QCOMPARE(index.size(), 0);
+}
+
+void ShapeIndexTest::failLoadingAndStayEmptyIfFileIsInvalid()
+{
+    QDir::root().mkpath(QFileInfo(m_indexFilename).absolutePath());
+    QFile file(m_indexFilename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("Not an index at all, just some random text");
+    file.close();
+
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+
+    QVERIFY(!index.load());
+    QCOMPARE(index.size(), 0);
+}
+
+void ShapeIndexTest::removeEntries()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+    index.insert("/some/b.psj", filesMetadata(10, 20, 30), createShape("b.psj", "wolf"));
+
+    index.remove("/some/a.psj");
+
+    QCOMPARE(index.size(), 1);
+    QVERIFY(!index.lookup("/some/a.psj", filesMetadata(10, 20, 30)).isValid());
+
+    index.clear();
+
+    QCOMPARE(index.size(), 0);
+}
+
+void ShapeIndexTest::retainOnlyTheGivenFiles()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman"));
+    index.insert("/some/b.psj", filesMetadata(10, 20, 30), createShape("b.psj", "wolf"));
+
+    QVERIFY(!index.retainOnly(QSet<QString>{"/some/a.psj", "/some/b.psj", "/some/c.psj"}));
+    QCOMPARE(index.size(), 2);
+
+    QVERIFY(index.retainOnly(QSet<QString>{"/some/b.psj"}));
+    QCOMPARE(index.size(), 1);
+    QVERIFY(index.lookup("/some/b.psj", filesMetadata(10, 20, 30)).isValid());
+}
+
+void ShapeIndexTest::computeFileMetadata()
+{
+    createShape("a.psj", "sandman");
+    const QFileInfo info(m_dir->path() + "/a.psj");
+
+    const auto metadata = FileMetadata::fromFileInfo(info);
+
+    QCOMPARE(metadata.size, info.size());
+    QCOMPARE(metadata.modificationTime, info.lastModified().toMSecsSinceEpoch());
+#ifdef Q_OS_UNIX
+    QVERIFY(metadata.inode != 0);
+#endif
+}
+
+void ShapeIndexTest::computeMetadataOfTheFilesOfAShape()
+{
+    const auto shape = createShape("a.psj", "sandman");
+    QFile gcodeFile(m_dir->path() + "/" + shape.gcodeFilename());
+    QVERIFY(gcodeFile.open(QIODevice::WriteOnly));
+    gcodeFile.write("G1 X10\n");
+    gcodeFile.close();
+    const FileMetadata psjMetadata{10, 20, 30};
+
+    const auto metadata = ShapeFilesMetadata::fromShape(psjMetadata, shape);
+
+    QVERIFY(metadata.psj == psjMetadata);
+    QCOMPARE(metadata.gcode.size, Q_INT64_C(7));
+    QVERIFY(metadata.gcode == FileMetadata::fromFileInfo(QFileInfo(gcodeFile.fileName())));
+    // The SVG file does not exist
+    QVERIFY(metadata.svg == FileMetadata::fromFileInfo(QFileInfo(m_dir->path() + "/" + shape.svgFilename())));
+}
+
+void ShapeIndexTest::lookupShapesByPsjHash()
+{
+    ShapeIndex index(m_indexFilename);
+    index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman").withContentHashes(1, 2, 3));
+    index.insert("/some/b.psj", filesMetadata(10, 20, 30), createShape("b.psj", "wolf").withContentHashes(4, 5, 6));
+
+    QCOMPARE(index.lookupByPsjHash(1).name(), "sandman");
+    QCOMPARE(index.lookupByPsjHash(4).name(), "wolf");
+    QVERIFY(!index.lookupByPsjHash(7).isValid());
+    QVERIFY(!index.lookupByPsjHash(0).isValid());
+
+    // Replacing and removing entries also updates hashes
+    index.insert("/some/a.psj", filesMetadata(11, 20, 30), createShape("a.psj", "sandman").withContentHashes(8, 2, 3));
+    index.remove("/some/b.psj");
+
+    QVERIFY(!index.lookupByPsjHash(1).isValid());
+    QCOMPARE(index.lookupByPsjHash(8).name(), "sandman");
+    QVERIFY(!index.lookupByPsjHash(4).isValid());
+}
+
+void ShapeIndexTest::saveAndLoadContentHashes()
+{
+    {
+        ShapeIndex index(m_indexFilename);
+        index.insert("/some/a.psj", filesMetadata(10, 20, 30), createShape("a.psj", "sandman").withContentHashes(1, 2, 3));
+        QVERIFY(index.save());
+    }
+
+    ShapeIndex index(m_indexFilename);
+    QVERIFY(index.load());
+
+    const auto a = index.lookup("/some/a.psj", filesMetadata(10, 20, 30));
+    QCOMPARE(a.psjHash(), Q_UINT64_C(1));
+    QCOMPARE(a.gcodeHash(), Q_UINT64_C(2));
+    QCOMPARE(a.svgHash(), Q_UINT64_C(3));
+    QCOMPARE(index.lookupByPsjHash(1).name(), "sandman");
+}
+
+QTEST_GUILESS_MAIN(ShapeIndexTest)
+
+#include "shapeindex_test.moc"
@@ -28,6 +28,13 @@ private Q_SLOTS:
     void createInvalidShapeIfDurationIsNegative();
     void createInvalidShapeIfDurationIsNotInt();
     void openJsonFileAsText();
+    void skipTheUtf8ByteOrderMark();
+    void ignoreUnknownFields();
+    void decodeEscapeSequencesInStrings();
+    void createInvalidShapeIfStringHasInvalidEscapeSequence();
+    void createInvalidShapeIfThereIsContentAfterTheObject();
+    void createInvalidShapeIfUnknownFieldHasInvalidValue();
+    void shareRepeatedValuesAmongShapes();
 };
 
 ShapeInfoTest::ShapeInfoTest()
@@ -415,6 +422,231 @@ void ShapeInfoTest::openJsonFileAsText()
     QCOMPARE(infoDos.gcodeFilename(), "polyshaper-000.gcode");
 }
 
+void ShapeInfoTest::skipTheUtf8ByteOrderMark()
+{
+    QByteArray content = "\xEF\xBB\xBF" R"({
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(info.isValid());
+    QCOMPARE(info.name(), "sandman");
+
+    // Only at the beginning of the file
+    content.insert(3, "\xEF\xBB\xBF");
+    auto fileWithTwoMarks = writeJsonToFile(content);
+    QVERIFY(!ShapeInfo::createFromFile(fileWithTwoMarks->fileName()).isValid());
+}
+
+void ShapeInfoTest::ignoreUnknownFields()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "comment": "a \"quoted\" string",
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "layers": [{"id": 1, "visible": true}, {"id": 2, "visible": false, "tags": []}, null],
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "extra": {"nested": {"value": -1.5e3}},
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(info.isValid());
+    QCOMPARE(info.name(), "sandman");
+    QCOMPARE(info.margin(), 10.0);
+    QCOMPARE(info.workpieceDimY(), 450.0);
+    QCOMPARE(info.speed(), 1000.0);
+    QCOMPARE(info.gcodeFilename(), "polyshaper-000.gcode");
+}
+
+void ShapeInfoTest::decodeEscapeSequencesInStrings()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sand\"man\\\/\tsh\u00e8p\ud83d\ude00",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(info.isValid());
+    QCOMPARE(info.name(), QString::fromUtf8("sand\"man\\/\tsh\xC3\xA8p\xF0\x9F\x98\x80"));
+    QCOMPARE(info.gcodeFilename(), "polyshaper-000.gcode");
+}
+
+void ShapeInfoTest::createInvalidShapeIfStringHasInvalidEscapeSequence()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sand\qman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(!info.isValid());
+}
+
+void ShapeInfoTest::createInvalidShapeIfThereIsContentAfterTheObject()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+} garbage)";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(!info.isValid());
+}
+
+void ShapeInfoTest::createInvalidShapeIfUnknownFieldHasInvalidValue()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "extra": [1, 2,],
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file = writeJsonToFile(content);
+
+    auto info = ShapeInfo::createFromFile(file->fileName());
+
+    QVERIFY(!info.isValid());
+}
+
+void ShapeInfoTest::shareRepeatedValuesAmongShapes()
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": "sandman",
+  "svgFilename": "polyshaper-000.svg",
+  "square": true,
+  "machineType": "PolyShaperOranje",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": 400.0,
+  "workpieceDimY": 450.0,
+  "autoClosePath": true,
+  "duration": 81,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+    auto file1 = writeJsonToFile(content);
+    auto file2 = writeJsonToFile(content);
+
+    auto info1 = ShapeInfo::createFromFile(file1->fileName());
+    auto info2 = ShapeInfo::createFromFile(file2->fileName());
+
+    QVERIFY(info1.isValid());
+    QVERIFY(info2.isValid());
+    QCOMPARE(info1.path().constData(), info2.path().constData());
+    QCOMPARE(info1.machineType().constData(), info2.machineType().constData());
+    QCOMPARE(info1.generatedBy().constData(), info2.generatedBy().constData());
+}
+
 QTEST_GUILESS_MAIN(ShapeInfoTest)
 
 #include "shapeinfo_test.moc"
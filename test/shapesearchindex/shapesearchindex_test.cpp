@@ -0,0 +1,350 @@
+#include <memory>
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "core/shapesearchindex.h"
+#include "core/shapeinfo.h"
+
+class ShapeSearchIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShapeSearchIndexTest();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    ShapeInfo createShape(QByteArray name, QByteArray machineType = "PolyShaperOranje", bool square = true,
+                          double dimX = 400.0, double dimY = 450.0, unsigned int duration = 81);
+    // Returns the keys of shapes matching the query. Also checks that search and matches agree
+    QStringList search(const ShapeSearchIndex& index, const QStringList& keys, const ShapeSearchIndex::Query& query);
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void beEmptyAtStart();
+    void matchEverythingWithAnEmptyQuery();
+    void searchNamesIgnoringCase();
+    void searchNamesWithShortText();
+    void returnNothingIfATrigramIsNotInAnyName();
+    void filterByMachineType();
+    void filterBySquare();
+    void filterByRanges();
+    void combineTextAndFacets();
+    void removeShapes();
+    void removeShapesInTheMiddleOfLists();
+    void reuseIdsOfRemovedShapes();
+    void replaceShapesInsertedTwice();
+    void clearTheIndex();
+};
+
+ShapeSearchIndexTest::ShapeSearchIndexTest()
+{
+}
+
+ShapeInfo ShapeSearchIndexTest::createShape(QByteArray name, QByteArray machineType, bool square, double dimX, double dimY, unsigned int duration)
+{
+    QByteArray content = R"(
+{
+  "version": 1,
+  "name": ")" + name + R"(",
+  "svgFilename": "polyshaper-000.svg",
+  "square": )" + QByteArray(square ? "true" : "false") + R"(,
+  "machineType": ")" + machineType + R"(",
+  "drawToolpath": true,
+  "margin": 10.0,
+  "generatedBy": "2DPlugin",
+  "creationTime": "2018-07-26T22:56:56.931242",
+  "flatness": 0.001,
+  "workpieceDimX": )" + QByteArray::number(dimX) + R"(,
+  "workpieceDimY": )" + QByteArray::number(dimY) + R"(,
+  "autoClosePath": true,
+  "duration": )" + QByteArray::number(duration) + R"(,
+  "pointsInsideWorkpiece": true,
+  "speed": 1000.0,
+  "gcodeFilename": "polyshaper-000.gcode"
+})";
+
+    QFile file(m_dir->path() + "/shape.psj");
+    if (!file.open(QIODevice::WriteOnly)) {
+        throw QString("CANNOT CREATE psj TEMPORARY FILE!!!");
+    }
+    file.write(content);
+    file.close();
+
+    return ShapeInfo::createFromFile(file.fileName());
+}
+
+QStringList ShapeSearchIndexTest::search(const ShapeSearchIndex& index, const QStringList& keys, const ShapeSearchIndex::Query& query)
+{
+    const auto result = index.search(query);
+
+    QStringList found;
+    for (const auto& key: keys) {
+        const auto id = index.id(key);
+        const bool inResult = id >= 0 && static_cast<std::size_t>(id) < result.size() && result[static_cast<std::size_t>(id)];
+
+        if (inResult != index.matches(id, query)) {
+            throw QString("search and matches disagree for " + key);
+        }
+
+        if (inResult) {
+            found.append(key);
+        }
+    }
+
+    return found;
+}
+
+void ShapeSearchIndexTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+void ShapeSearchIndexTest::cleanup()
+{
+    m_dir.reset();
+}
+
+void ShapeSearchIndexTest::beEmptyAtStart()
+{
+    ShapeSearchIndex index;
+
+    QCOMPARE(index.size(), 0);
+    QCOMPARE(index.id("a"), -1);
+    QVERIFY(!index.matches(0, ShapeSearchIndex::Query()));
+}
+
+void ShapeSearchIndexTest::matchEverythingWithAnEmptyQuery()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+    index.insert("b", createShape("Wolf"));
+
+    QCOMPARE(index.size(), 2);
+    QCOMPARE(search(index, {"a", "b"}, ShapeSearchIndex::Query()), (QStringList{"a", "b"}));
+}
+
+void ShapeSearchIndexTest::searchNamesIgnoringCase()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+    index.insert("b", createShape("Wolf"));
+    index.insert("c", createShape("The big SANDWICH"));
+
+    ShapeSearchIndex::Query query;
+    query.text = "sand";
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"a", "c"}));
+
+    query.text = "ANDM";
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"a"}));
+
+    // All trigrams are in "Sandman" but not the whole text
+    query.text = "mansand";
+    QCOMPARE(search(index, {"a", "b", "c"}, query), QStringList());
+}
+
+void ShapeSearchIndexTest::searchNamesWithShortText()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+    index.insert("b", createShape("Wolf"));
+
+    ShapeSearchIndex::Query query;
+    query.text = "o";
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"b"}));
+
+    query.text = "Sa";
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"a"}));
+}
+
+void ShapeSearchIndexTest::returnNothingIfATrigramIsNotInAnyName()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+
+    ShapeSearchIndex::Query query;
+    query.text = "xyz";
+    QCOMPARE(search(index, {"a"}, query), QStringList());
+}
+
+void ShapeSearchIndexTest::filterByMachineType()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman", "PolyShaperOranje"));
+    index.insert("b", createShape("Wolf", "PolyShaperAzzurro"));
+
+    ShapeSearchIndex::Query query;
+    query.machineType = "PolyShaperAzzurro";
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"b"}));
+
+    query.machineType = "Unknown";
+    QCOMPARE(search(index, {"a", "b"}, query), QStringList());
+}
+
+void ShapeSearchIndexTest::filterBySquare()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman", "PolyShaperOranje", true));
+    index.insert("b", createShape("Wolf", "PolyShaperOranje", false));
+
+    ShapeSearchIndex::Query query;
+    query.square = ShapeSearchIndex::SquareFilter::Square;
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"a"}));
+
+    query.square = ShapeSearchIndex::SquareFilter::NotSquare;
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"b"}));
+}
+
+void ShapeSearchIndexTest::filterByRanges()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman", "PolyShaperOranje", true, 100.0, 200.0, 10));
+    index.insert("b", createShape("Wolf", "PolyShaperOranje", true, 300.0, 400.0, 20));
+    index.insert("c", createShape("Fox", "PolyShaperOranje", true, 500.0, 600.0, 30));
+
+    ShapeSearchIndex::Query query;
+    query.workpieceDimX = ShapeSearchIndex::Range{100.0, 300.0};
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"a", "b"}));
+
+    query = ShapeSearchIndex::Query();
+    query.workpieceDimY = ShapeSearchIndex::Range{450.0, 1000.0};
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"c"}));
+
+    query = ShapeSearchIndex::Query();
+    query.duration.max = 20;
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"a", "b"}));
+}
+
+void ShapeSearchIndexTest::combineTextAndFacets()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman", "PolyShaperOranje", true, 100.0, 200.0, 10));
+    index.insert("b", createShape("Sandwich", "PolyShaperAzzurro", false, 300.0, 400.0, 20));
+    index.insert("c", createShape("Sandcastle", "PolyShaperOranje", false, 500.0, 600.0, 30));
+
+    ShapeSearchIndex::Query query;
+    query.text = "sand";
+    query.machineType = "PolyShaperOranje";
+    query.square = ShapeSearchIndex::SquareFilter::NotSquare;
+    QCOMPARE(search(index, {"a", "b", "c"}, query), (QStringList{"c"}));
+
+    query.duration.max = 20;
+    QCOMPARE(search(index, {"a", "b", "c"}, query), QStringList());
+}
+
+void ShapeSearchIndexTest::removeShapes()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+    index.insert("b", createShape("Sandwich"));
+
+    index.remove("a");
+    index.remove("not there");
+
+    QCOMPARE(index.size(), 1);
+    QCOMPARE(index.id("a"), -1);
+    ShapeSearchIndex::Query query;
+    query.text = "sand";
+    QCOMPARE(search(index, {"a", "b"}, query), (QStringList{"b"}));
+}
+
+void ShapeSearchIndexTest::removeShapesInTheMiddleOfLists()
+{
+    // Shapes share trigrams, machine type, squareness and dimensions, so they are in the same
+    // lists and removing one moves the others
+    const QStringList keys{"a", "b", "c", "d", "e"};
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman 1"));
+    index.insert("b", createShape("Sandman 2"));
+    index.insert("c", createShape("Sandman 3"));
+    index.insert("d", createShape("Sandman 4"));
+    index.insert("e", createShape("Sandman 5"));
+
+    index.remove("b");
+    index.remove("d");
+    index.remove("a");
+    index.insert("b", createShape("Sandman 2", "PolyShaperAzzurro", false, 100.0, 100.0, 10));
+
+    ShapeSearchIndex::Query query;
+    query.text = "sandman";
+    QCOMPARE(search(index, keys, query), (QStringList{"b", "c", "e"}));
+    query.text = "man 5";
+    QCOMPARE(search(index, keys, query), (QStringList{"e"}));
+
+    query = ShapeSearchIndex::Query();
+    query.machineType = "PolyShaperOranje";
+    QCOMPARE(search(index, keys, query), (QStringList{"c", "e"}));
+
+    query = ShapeSearchIndex::Query();
+    query.square = ShapeSearchIndex::SquareFilter::NotSquare;
+    QCOMPARE(search(index, keys, query), (QStringList{"b"}));
+
+    query = ShapeSearchIndex::Query();
+    query.workpieceDimX = ShapeSearchIndex::Range{400.0, 400.0};
+    QCOMPARE(search(index, keys, query), (QStringList{"c", "e"}));
+    query.workpieceDimX = ShapeSearchIndex::Range{0.0, 400.0};
+    QCOMPARE(search(index, keys, query), (QStringList{"b", "c", "e"}));
+
+    index.remove("c");
+    index.remove("e");
+    index.remove("b");
+    QCOMPARE(index.size(), 0);
+    QCOMPARE(search(index, keys, ShapeSearchIndex::Query()), QStringList());
+}
+
+void ShapeSearchIndexTest::reuseIdsOfRemovedShapes()
+{
+    ShapeSearchIndex index;
+    const auto idA = index.insert("a", createShape("Sandman", "PolyShaperOranje", true));
+    index.insert("b", createShape("Wolf"));
+
+    index.remove("a");
+    const auto idC = index.insert("c", createShape("Fox", "PolyShaperAzzurro", false));
+
+    QCOMPARE(idC, idA);
+    QCOMPARE(index.id("c"), idC);
+
+    // Nothing of the removed shape must be left
+    ShapeSearchIndex::Query query;
+    query.text = "sandman";
+    QCOMPARE(search(index, {"b", "c"}, query), QStringList());
+    query = ShapeSearchIndex::Query();
+    query.machineType = "PolyShaperAzzurro";
+    query.square = ShapeSearchIndex::SquareFilter::NotSquare;
+    QCOMPARE(search(index, {"b", "c"}, query), (QStringList{"c"}));
+}
+
+void ShapeSearchIndexTest::replaceShapesInsertedTwice()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+    index.insert("a", createShape("Wolf"));
+
+    QCOMPARE(index.size(), 1);
+    ShapeSearchIndex::Query query;
+    query.text = "sand";
+    QCOMPARE(search(index, {"a"}, query), QStringList());
+    query.text = "wolf";
+    QCOMPARE(search(index, {"a"}, query), (QStringList{"a"}));
+}
+
+void ShapeSearchIndexTest::clearTheIndex()
+{
+    ShapeSearchIndex index;
+    index.insert("a", createShape("Sandman"));
+
+    index.clear();
+
+    QCOMPARE(index.size(), 0);
+    QCOMPARE(index.id("a"), -1);
+    QCOMPARE(search(index, {"a"}, ShapeSearchIndex::Query()), QStringList());
+}
+
+QTEST_GUILESS_MAIN(ShapeSearchIndexTest)
+
+#include "shapesearchindex_test.moc"
@@ -0,0 +1,9 @@
+# Check the config files exist
+!include(../test.pri) {
+    error("Couldn't find the test.pri file!")
+}
+
+TARGET = statusmirror_test
+
+SOURCES += \
+        statusmirror_test.cpp
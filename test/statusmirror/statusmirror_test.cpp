@@ -0,0 +1,172 @@
+#include <memory>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QThread>
+#include <QtTest>
+#include "core/commandsender.h"
+#include "core/machinecommunication.h"
+#include "core/machinestatusmonitor.h"
+#include "core/statusmirror.h"
+#include "core/wirecontroller.h"
+#include "testcommon/testmachineinfo.h"
+#include "testcommon/testserialport.h"
+#include "testcommon/utils.h"
+
+class StatusMirrorTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    StatusMirrorTest();
+
+private:
+    TestMachineInfo m_info;
+
+private Q_SLOTS:
+    void startWithWireOffUnknownStateAndTheGivenTemperature();
+    void emitSignalsOnlyWhenValuesChange();
+    void followWireControllerChanges();
+    void followMachineStateChanges();
+    void readingStateDoesNotDependOnWorkerThreadLoad();
+};
+
+StatusMirrorTest::StatusMirrorTest()
+{
+}
+
+void StatusMirrorTest::startWithWireOffUnknownStateAndTheGivenTemperature()
+{
+    StatusMirror mirror(33.0f);
+
+    QVERIFY(!mirror.wireOn());
+    QCOMPARE(mirror.temperature(), 33.0f);
+    QCOMPARE(mirror.machineState(), MachineState::Unknown);
+}
+
+void StatusMirrorTest::emitSignalsOnlyWhenValuesChange()
+{
+    StatusMirror mirror(33.0f);
+
+    QSignalSpy wireSpy(&mirror, &StatusMirror::wireOnChanged);
+    QSignalSpy temperatureSpy(&mirror, &StatusMirror::temperatureChanged);
+    QSignalSpy stateSpy(&mirror, &StatusMirror::machineStateChanged);
+
+    mirror.setWireOff();
+    mirror.setTemperature(33.0f);
+    mirror.setMachineState(MachineState::Unknown);
+
+    QCOMPARE(wireSpy.count(), 0);
+    QCOMPARE(temperatureSpy.count(), 0);
+    QCOMPARE(stateSpy.count(), 0);
+
+    mirror.setWireOn();
+    mirror.setWireOn();
+    mirror.setTemperature(40.0f);
+    mirror.setMachineState(MachineState::Idle);
+
+    QCOMPARE(wireSpy.count(), 1);
+    QVERIFY(mirror.wireOn());
+    QCOMPARE(temperatureSpy.count(), 1);
+    QCOMPARE(mirror.temperature(), 40.0f);
+    QCOMPARE(stateSpy.count(), 1);
+    QCOMPARE(mirror.machineState(), MachineState::Idle);
+}
+
+void StatusMirrorTest::followWireControllerChanges()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    CommandSender commandSender(communicator.get());
+    WireController wireController(communicator.get(), &commandSender);
+
+    StatusMirror mirror(wireController.temperature());
+    mirror.trackWireController(&wireController);
+
+    wireController.switchWireOn();
+    QVERIFY(mirror.wireOn());
+
+    wireController.setTemperature(20.0f);
+    QCOMPARE(mirror.temperature(), 20.0f);
+
+    wireController.switchWireOff();
+    QVERIFY(!mirror.wireOn());
+}
+
+void StatusMirrorTest::followMachineStateChanges()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    MachineStatusMonitor statusMonitor(1000, 10000, communicator.get());
+
+    StatusMirror mirror(0.0f);
+    mirror.trackStatusMonitor(&statusMonitor);
+
+    serialPort->simulateReceivedData("<Idle|MPos:0.000,0.000,0.000|FS:0.0,0>\r\n");
+    QCOMPARE(mirror.machineState(), MachineState::Idle);
+
+    serialPort->simulateReceivedData("<Run|MPos:0.000,0.000,0.000|FS:0.0,0>\r\n");
+    QCOMPARE(mirror.machineState(), MachineState::Run);
+}
+
+void StatusMirrorTest::readingStateDoesNotDependOnWorkerThreadLoad()
+{
+    // A frame at 60Hz lasts about 16 milliseconds. The worker thread is kept busy for much longer
+    // than that: reading the mirrored state must never wait for it
+    const qint64 frameMillis = 16;
+    const unsigned long workerBusyMillis = 500;
+    const int numReads = 10000;
+
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    CommandSender commandSender(communicator.get());
+    WireController wireController(communicator.get(), &commandSender);
+
+    StatusMirror mirror(wireController.temperature());
+    mirror.trackWireController(&wireController);
+
+    QThread workerThread;
+    communicator->moveToThread(&workerThread);
+    commandSender.moveToThread(&workerThread);
+    wireController.moveToThread(&workerThread);
+    workerThread.start();
+
+    auto readState = [&mirror, numReads]() {
+        QElapsedTimer timer;
+        timer.start();
+        int wireOnCount = 0;
+        for (int i = 0; i < numReads; ++i) {
+            wireOnCount += mirror.wireOn() ? 1 : 0;
+            wireOnCount += (mirror.temperature() > 1000.0f) ? 1 : 0;
+        }
+        Q_UNUSED(wireOnCount)
+        return timer.elapsed();
+    };
+
+    const auto idleMillis = readState();
+
+    QSignalSpy spy(&mirror, &StatusMirror::wireOnChanged);
+    auto p = &wireController;
+    QMetaObject::invokeMethod(p, [p, workerBusyMillis](){
+        p->switchWireOn();
+        QThread::msleep(workerBusyMillis);
+    });
+
+    QElapsedTimer busyTimer;
+    busyTimer.start();
+    const auto busyMillis = readState();
+
+    QVERIFY(idleMillis < frameMillis);
+    QVERIFY(busyMillis < frameMillis);
+    // We didn't wait for the worker
+    QVERIFY(busyTimer.elapsed() < static_cast<qint64>(workerBusyMillis));
+
+    // The change is eventually notified
+    QVERIFY(spy.wait(2 * workerBusyMillis));
+    QVERIFY(mirror.wireOn());
+
+    workerThread.quit();
+    workerThread.wait();
+}
+
+QTEST_GUILESS_MAIN(StatusMirrorTest)
+
+#include "statusmirror_test.moc"
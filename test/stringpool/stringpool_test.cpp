@@ -0,0 +1,103 @@
+#include <QString>
+#include <QtConcurrent>
+#include <QtTest>
+#include <QVector>
+#include "core/stringpool.h"
+
+class StringPoolTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    StringPoolTest();
+
+private Q_SLOTS:
+    void returnAnEqualString();
+    void shareDataOfEqualStrings();
+    void doNotShareDataOfDifferentStrings();
+    void returnNullStringsAsTheyAre();
+    void clearThePool();
+    void internFromMultipleThreads();
+};
+
+StringPoolTest::StringPoolTest()
+{
+}
+
+void StringPoolTest::returnAnEqualString()
+{
+    StringPool pool;
+
+    QCOMPARE(pool.intern("PolyShaperOranje"), "PolyShaperOranje");
+    QCOMPARE(pool.size(), 1);
+}
+
+void StringPoolTest::shareDataOfEqualStrings()
+{
+    StringPool pool;
+
+    // Built at runtime so that the two strings do not share data
+    const auto s1 = QString("Poly") + QString("ShaperOranje");
+    const auto s2 = QString("PolyShaper") + QString("Oranje");
+    QVERIFY(s1.constData() != s2.constData());
+
+    const auto i1 = pool.intern(s1);
+    const auto i2 = pool.intern(s2);
+
+    QCOMPARE(i1.constData(), i2.constData());
+    QCOMPARE(pool.size(), 1);
+}
+
+void StringPoolTest::doNotShareDataOfDifferentStrings()
+{
+    StringPool pool;
+
+    const auto i1 = pool.intern("PolyShaperOranje");
+    const auto i2 = pool.intern("PolyShaperAzul");
+
+    QCOMPARE(i1, "PolyShaperOranje");
+    QCOMPARE(i2, "PolyShaperAzul");
+    QCOMPARE(pool.size(), 2);
+}
+
+void StringPoolTest::returnNullStringsAsTheyAre()
+{
+    StringPool pool;
+
+    QVERIFY(pool.intern(QString()).isNull());
+    QCOMPARE(pool.size(), 0);
+}
+
+void StringPoolTest::clearThePool()
+{
+    StringPool pool;
+    const auto s = pool.intern("2DPlugin");
+
+    pool.clear();
+
+    QCOMPARE(pool.size(), 0);
+    QCOMPARE(s, "2DPlugin");
+}
+
+void StringPoolTest::internFromMultipleThreads()
+{
+    StringPool pool;
+    QVector<int> values;
+    for (auto i = 0; i < 10000; ++i) {
+        values.append(i % 10);
+    }
+
+    const auto interned = QtConcurrent::blockingMapped<QVector<QString>>(values, std::function<QString(int)>([&pool](int v) {
+        return pool.intern(QString("machine-%1").arg(v));
+    }));
+
+    QCOMPARE(pool.size(), 10);
+    for (auto i = 0; i < values.size(); ++i) {
+        QCOMPARE(interned[i], QString("machine-%1").arg(values[i]));
+        QCOMPARE(interned[i].constData(), interned[values[i]].constData());
+    }
+}
+
+QTEST_GUILESS_MAIN(StringPoolTest)
+
+#include "stringpool_test.moc"
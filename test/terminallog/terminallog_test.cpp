@@ -0,0 +1,259 @@
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QtTest>
+#include "core/terminallog.h"
+
+class TerminalLogTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    TerminalLogTest();
+
+private Q_SLOTS:
+    void beEmptyAtStart();
+    void doNotStoreLinesUntilCommitted();
+    void splitSentDataInLines();
+    void completeSentLinesWithoutEndline();
+    void accumulateReceivedDataUntilEndline();
+    void completePartialReceivedLineWhenDataIsSent();
+    void addInfoLines();
+    void discardOldestLinesWhenFull();
+    void computeTheNumberOfLinesToDiscard();
+    void onlyReturnTheLastCapacityLinesIfMoreAreCompleted();
+    void filterStatusPollingIfRequested();
+    void clearEverything();
+    void costOfAddingLinesDoesNotDependOnStoredLines();
+};
+
+TerminalLogTest::TerminalLogTest()
+{
+}
+
+void TerminalLogTest::beEmptyAtStart()
+{
+    TerminalLog log(10);
+
+    QCOMPARE(log.capacity(), 10);
+    QCOMPARE(log.size(), 0);
+    QVERIFY(log.takeCompletedLines().isEmpty());
+}
+
+void TerminalLogTest::doNotStoreLinesUntilCommitted()
+{
+    TerminalLog log(10);
+
+    log.appendSent("G1 X10\n");
+
+    QCOMPARE(log.size(), 0);
+
+    const auto lines = log.takeCompletedLines();
+    QCOMPARE(lines.size(), 1);
+    QVERIFY(log.takeCompletedLines().isEmpty());
+
+    log.commitLines(lines);
+
+    QCOMPARE(log.size(), 1);
+    QCOMPARE(log.line(0).direction, TerminalLog::Direction::Sent);
+    QCOMPARE(log.line(0).text, QByteArray("G1 X10"));
+}
+
+void TerminalLogTest::splitSentDataInLines()
+{
+    TerminalLog log(10);
+
+    log.appendSent("G1 X10\nG1 Y20\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 2);
+    QCOMPARE(log.line(0).text, QByteArray("G1 X10"));
+    QCOMPARE(log.line(1).text, QByteArray("G1 Y20"));
+}
+
+void TerminalLogTest::completeSentLinesWithoutEndline()
+{
+    TerminalLog log(10);
+
+    log.appendSent("!");
+    log.appendSent("~");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 2);
+    QCOMPARE(log.line(0).text, QByteArray("!"));
+    QCOMPARE(log.line(1).text, QByteArray("~"));
+}
+
+void TerminalLogTest::accumulateReceivedDataUntilEndline()
+{
+    TerminalLog log(10);
+
+    log.appendReceived("o");
+    QVERIFY(log.takeCompletedLines().isEmpty());
+
+    log.appendReceived("k\r\nerr");
+    log.appendReceived("or:2\r\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 2);
+    QCOMPARE(log.line(0).direction, TerminalLog::Direction::Received);
+    QCOMPARE(log.line(0).text, QByteArray("ok"));
+    QCOMPARE(log.line(1).direction, TerminalLog::Direction::Received);
+    QCOMPARE(log.line(1).text, QByteArray("error:2"));
+}
+
+void TerminalLogTest::completePartialReceivedLineWhenDataIsSent()
+{
+    TerminalLog log(10);
+
+    log.appendReceived("Grbl");
+    log.appendSent("$I\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 2);
+    QCOMPARE(log.line(0).direction, TerminalLog::Direction::Received);
+    QCOMPARE(log.line(0).text, QByteArray("Grbl"));
+    QCOMPARE(log.line(1).direction, TerminalLog::Direction::Sent);
+    QCOMPARE(log.line(1).text, QByteArray("$I"));
+}
+
+void TerminalLogTest::addInfoLines()
+{
+    TerminalLog log(10);
+
+    log.appendInfo("--------");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 1);
+    QCOMPARE(log.line(0).direction, TerminalLog::Direction::Info);
+    QCOMPARE(log.line(0).text, QByteArray("--------"));
+}
+
+void TerminalLogTest::discardOldestLinesWhenFull()
+{
+    TerminalLog log(3);
+
+    log.appendSent("1\n2\n");
+    log.commitLines(log.takeCompletedLines());
+    log.appendSent("3\n4\n5\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 3);
+    QCOMPARE(log.line(0).text, QByteArray("3"));
+    QCOMPARE(log.line(1).text, QByteArray("4"));
+    QCOMPARE(log.line(2).text, QByteArray("5"));
+
+    log.discardOldestLines(2);
+    QCOMPARE(log.size(), 1);
+    QCOMPARE(log.line(0).text, QByteArray("5"));
+
+    log.appendSent("6\n7\n");
+    log.commitLines(log.takeCompletedLines());
+    QCOMPARE(log.size(), 3);
+    QCOMPARE(log.line(0).text, QByteArray("5"));
+    QCOMPARE(log.line(1).text, QByteArray("6"));
+    QCOMPARE(log.line(2).text, QByteArray("7"));
+}
+
+void TerminalLogTest::computeTheNumberOfLinesToDiscard()
+{
+    TerminalLog log(5);
+
+    QCOMPARE(log.linesToDiscard(3), 0);
+
+    log.appendSent("1\n2\n3\n4\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.linesToDiscard(1), 0);
+    QCOMPARE(log.linesToDiscard(3), 2);
+    // Never more than the stored lines
+    QCOMPARE(log.linesToDiscard(100), 4);
+}
+
+void TerminalLogTest::onlyReturnTheLastCapacityLinesIfMoreAreCompleted()
+{
+    TerminalLog log(2);
+
+    log.appendSent("1\n2\n3\n4\n");
+    const auto lines = log.takeCompletedLines();
+
+    QCOMPARE(lines.size(), 2);
+    QCOMPARE(lines[0].text, QByteArray("3"));
+    QCOMPARE(lines[1].text, QByteArray("4"));
+}
+
+void TerminalLogTest::filterStatusPollingIfRequested()
+{
+    TerminalLog log(10);
+
+    QVERIFY(!log.filterStatusPolling());
+    log.setFilterStatusPolling(true);
+    QVERIFY(log.filterStatusPolling());
+
+    log.appendSent("?");
+    log.appendReceived("<Idle|MPos:0.000,0.000,0.000|FS:0,0>\r\n");
+    log.appendSent("G1 X1\n");
+    log.appendReceived("ok\r\n");
+    log.commitLines(log.takeCompletedLines());
+
+    QCOMPARE(log.size(), 2);
+    QCOMPARE(log.line(0).text, QByteArray("G1 X1"));
+    QCOMPARE(log.line(1).text, QByteArray("ok"));
+}
+
+void TerminalLogTest::clearEverything()
+{
+    TerminalLog log(10);
+
+    log.appendSent("1\n2\n");
+    log.commitLines(log.takeCompletedLines());
+    log.appendSent("3\n");
+    log.appendReceived("partial");
+
+    log.clear();
+
+    QCOMPARE(log.size(), 0);
+    QVERIFY(log.takeCompletedLines().isEmpty());
+    log.appendSent("4\n");
+    QCOMPARE(log.takeCompletedLines().size(), 1);
+}
+
+void TerminalLogTest::costOfAddingLinesDoesNotDependOnStoredLines()
+{
+    // Filling a large log and then adding more lines: adding lines to a full log must not cost
+    // much more than adding them to an almost empty one (no copies of the whole buffer)
+    const int capacity = 300000;
+    const int linesPerUpdate = 100;
+    const int numUpdates = 100;
+    TerminalLog log(capacity);
+
+    auto addLines = [&log, linesPerUpdate, numUpdates]() {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < numUpdates; ++i) {
+            for (int j = 0; j < linesPerUpdate; ++j) {
+                log.appendReceived("ok\r\n");
+            }
+            const auto lines = log.takeCompletedLines();
+            log.discardOldestLines(log.linesToDiscard(lines.size()));
+            log.commitLines(lines);
+        }
+        return timer.nsecsElapsed();
+    };
+
+    const auto emptyLogNs = addLines();
+
+    while (log.size() < capacity) {
+        log.appendReceived("ok\r\n");
+        log.commitLines(log.takeCompletedLines());
+    }
+
+    const auto fullLogNs = addLines();
+
+    QCOMPARE(log.size(), capacity);
+    // Generous margin to avoid spurious failures on loaded machines
+    QVERIFY(fullLogNs < 10 * emptyLogNs + 20000000);
+}
+
+QTEST_GUILESS_MAIN(TerminalLogTest)
+
+#include "terminallog_test.moc"
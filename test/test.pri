@@ -6,7 +6,7 @@
 TEMPLATE = app
 CONFIG += testcase console
 CONFIG -= app_bundle
-QT += testlib serialport
+QT += testlib serialport concurrent network
 QT -= gui
 
 # NOTE: These paths are relative to the .pro file including this (which is in a subdirectory)
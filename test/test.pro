@@ -8,9 +8,25 @@ SUBDIRS = \
     wirecontroller \
     machinestate \
     machinestatusmonitor \
+    metrics \
+    clock \
+    clirunner \
     commandsender \
+    contenthash \
+    gcodevalidator \
+    hdrhistogram \
+    jobserver \
     localshapesfinder \
-    shapeinfo
+    ringqueue \
+    shapeinfo \
+    shapeindex \
+    shapesearchindex \
+    statusmirror \
+    stringpool \
+    terminallog \
+    tracerecorder \
+    traffictap \
+    worker
 
 portdiscovery.depends = testcommon
 machineinfo.depends = testcommon
@@ -19,6 +35,30 @@ gcodesender.depends = testcommon
 wirecontroller.depends = testcommon
 machinestate.depends = testcommon
 machinestatusmonitor.depends = testcommon
+metrics.depends = testcommon
+clock.depends = testcommon
+clirunner.depends = testcommon
 commandsender.depends = testcommon
+contenthash.depends = testcommon
+gcodevalidator.depends = testcommon
+hdrhistogram.depends = testcommon
+jobserver.depends = testcommon
 localshapesfinder.depends = testcommon
+ringqueue.depends = testcommon
 shapeinfo.depends = testcommon
+shapeindex.depends = testcommon
+shapesearchindex.depends = testcommon
+statusmirror.depends = testcommon
+stringpool.depends = testcommon
+terminallog.depends = testcommon
+tracerecorder.depends = testcommon
+traffictap.depends = testcommon
+worker.depends = testcommon
+
+# NativeSerialPort is only available on Linux. Allocations are counted by replacing the malloc
+# functions of glibc
+linux {
+    SUBDIRS += nativeserialport commandsenderallocations
+    nativeserialport.depends = testcommon
+    commandsenderallocations.depends = testcommon
+}
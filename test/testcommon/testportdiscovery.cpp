@@ -18,6 +18,16 @@ void TestPortDiscovery::setCharacterSendDelayUs(unsigned long)
     throw QString("TestPortDiscovery::setCharacterSendDelayUs should not be used in this test");
 }
 
+void TestPortDiscovery::setBaudRates(QList<qint32>)
+{
+    throw QString("TestPortDiscovery::setBaudRates should not be used in this test");
+}
+
+qint32 TestPortDiscovery::baudRate() const
+{
+    return SerialPortInterface::defaultBaudRate;
+}
+
 void TestPortDiscovery::start()
 {
 }
@@ -12,6 +12,8 @@ public:
 
     std::unique_ptr<SerialPortInterface> obtainPort() override;
     void setCharacterSendDelayUs(unsigned long us) override;
+    void setBaudRates(QList<qint32> baudRates) override;
+    qint32 baudRate() const override;
     void start() override;
 
 signals:
@@ -0,0 +1,240 @@
+#include <thread>
+#include <QByteArray>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtTest>
+#include "core/tracerecorder.h"
+
+class TraceRecorderTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    TraceRecorderTest();
+
+private:
+    // Only returns events that are not metadata
+    QJsonArray exportedEvents(const TraceRecorder& recorder);
+
+private Q_SLOTS:
+    void beDisabledByDefault();
+    void doNotRecordZonesWhenDisabled();
+    void exportZonesInChromeTraceFormat();
+    void exportInstantAndAsyncEvents();
+    void keepEventsOfDifferentThreadsSeparated();
+    void reuseTheBuffersOfThreadsThatFinished();
+    void overwriteTheOldestEventsWhenTheBufferIsFull();
+    void discardEventsWhenCleared();
+    void escapeNamesInJson();
+    void saveTracesToFile();
+};
+
+TraceRecorderTest::TraceRecorderTest()
+{
+}
+
+QJsonArray TraceRecorderTest::exportedEvents(const TraceRecorder& recorder)
+{
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(recorder.toChromeJson(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        return QJsonArray();
+    }
+
+    QJsonArray events;
+    for (const auto e: doc.object()["traceEvents"].toArray()) {
+        if (e.toObject()["ph"].toString() != "M") {
+            events.append(e);
+        }
+    }
+
+    return events;
+}
+
+void TraceRecorderTest::beDisabledByDefault()
+{
+    TraceRecorder recorder;
+
+    QVERIFY(!recorder.isEnabled());
+}
+
+void TraceRecorderTest::doNotRecordZonesWhenDisabled()
+{
+    TraceRecorder recorder;
+
+    {
+        TraceZone zone(recorder, "zone");
+    }
+
+    QCOMPARE(recorder.recordedEvents(), Q_INT64_C(0));
+    QCOMPARE(exportedEvents(recorder).size(), 0);
+}
+
+void TraceRecorderTest::exportZonesInChromeTraceFormat()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+
+    {
+        TraceZone outer(recorder, "outer");
+        QThread::msleep(2);
+        TraceZone inner(recorder, "inner");
+    }
+
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 2);
+    // Zones are recorded when they end
+    const auto inner = events[0].toObject();
+    const auto outer = events[1].toObject();
+    QCOMPARE(inner["name"].toString(), QString("inner"));
+    QCOMPARE(inner["ph"].toString(), QString("X"));
+    QCOMPARE(outer["name"].toString(), QString("outer"));
+    QCOMPARE(outer["ph"].toString(), QString("X"));
+    QVERIFY(outer["dur"].toDouble() >= 2000.0);
+    QVERIFY(inner["ts"].toDouble() >= outer["ts"].toDouble() + 2000.0);
+    QVERIFY(inner["ts"].toDouble() + inner["dur"].toDouble() <= outer["ts"].toDouble() + outer["dur"].toDouble());
+    QCOMPARE(inner["tid"].toInt(), outer["tid"].toInt());
+}
+
+void TraceRecorderTest::exportInstantAndAsyncEvents()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+
+    recorder.recordInstant("instant");
+    recorder.recordAsyncBegin("async", 26);
+    recorder.recordAsyncEnd("async", 26);
+
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 3);
+    QCOMPARE(events[0].toObject()["ph"].toString(), QString("i"));
+    QCOMPARE(events[1].toObject()["ph"].toString(), QString("b"));
+    QCOMPARE(events[1].toObject()["id"].toString(), QString("0x1a"));
+    QCOMPARE(events[2].toObject()["ph"].toString(), QString("e"));
+    QCOMPARE(events[2].toObject()["id"].toString(), QString("0x1a"));
+}
+
+void TraceRecorderTest::keepEventsOfDifferentThreadsSeparated()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+    const int eventsPerThread = 1000;
+
+    auto recordEvents = [&recorder]() {
+        for (auto i = 0; i < eventsPerThread; ++i) {
+            TraceZone zone(recorder, "zone");
+        }
+    };
+    std::thread t1(recordEvents);
+    std::thread t2(recordEvents);
+    recordEvents();
+    t1.join();
+    t2.join();
+
+    QCOMPARE(recorder.recordedEvents(), static_cast<qint64>(3 * eventsPerThread));
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 3 * eventsPerThread);
+    QSet<int> tids;
+    for (const auto e: events) {
+        tids.insert(e.toObject()["tid"].toInt());
+    }
+    QCOMPARE(tids.size(), 3);
+}
+
+void TraceRecorderTest::reuseTheBuffersOfThreadsThatFinished()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+
+    std::thread t1([&recorder]() { recorder.recordInstant("first"); });
+    t1.join();
+
+    // The event of the finished thread is kept until another thread needs a buffer
+    auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events[0].toObject()["name"].toString(), QString("first"));
+
+    std::thread t2([&recorder]() { recorder.recordInstant("second"); });
+    t2.join();
+
+    QCOMPARE(recorder.recordedEvents(), Q_INT64_C(2));
+    events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events[0].toObject()["name"].toString(), QString("second"));
+    const auto doc = QJsonDocument::fromJson(recorder.toChromeJson());
+    auto threadNames = 0;
+    for (const auto e: doc.object()["traceEvents"].toArray()) {
+        if (e.toObject()["name"].toString() == "thread_name") {
+            ++threadNames;
+        }
+    }
+    QCOMPARE(threadNames, 1);
+}
+
+void TraceRecorderTest::overwriteTheOldestEventsWhenTheBufferIsFull()
+{
+    TraceRecorder recorder(4);
+    recorder.setEnabled(true);
+    const char* names[] = {"e0", "e1", "e2", "e3", "e4", "e5"};
+
+    for (auto name: names) {
+        recorder.recordInstant(name);
+    }
+
+    QCOMPARE(recorder.recordedEvents(), Q_INT64_C(6));
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 4);
+    QCOMPARE(events[0].toObject()["name"].toString(), QString("e2"));
+    QCOMPARE(events[3].toObject()["name"].toString(), QString("e5"));
+}
+
+void TraceRecorderTest::discardEventsWhenCleared()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+
+    recorder.recordInstant("before");
+    recorder.clear();
+    recorder.recordInstant("after");
+
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events[0].toObject()["name"].toString(), QString("after"));
+}
+
+void TraceRecorderTest::escapeNamesInJson()
+{
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+
+    recorder.recordInstant("a \"quoted\" \\ name\n");
+
+    const auto events = exportedEvents(recorder);
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events[0].toObject()["name"].toString(), QString("a \"quoted\" \\ name\n"));
+}
+
+void TraceRecorderTest::saveTracesToFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TraceRecorder recorder;
+    recorder.setEnabled(true);
+    recorder.recordInstant("instant");
+
+    QVERIFY(recorder.saveChromeJson(dir.path() + "/trace.json"));
+
+    QFile file(dir.path() + "/trace.json");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), recorder.toChromeJson());
+    QVERIFY(!recorder.saveChromeJson(dir.path() + "/notExistingDir/trace.json"));
+}
+
+QTEST_GUILESS_MAIN(TraceRecorderTest)
+
+#include "tracerecorder_test.moc"
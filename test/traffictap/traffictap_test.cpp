@@ -0,0 +1,186 @@
+#include <memory>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QtTest>
+#include "core/machinecommunication.h"
+#include "core/traffictap.h"
+#include "testcommon/testmachineinfo.h"
+#include "testcommon/testserialport.h"
+#include "testcommon/utils.h"
+
+class TrafficTapTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    TrafficTapTest();
+
+private:
+    TestMachineInfo m_info;
+
+private Q_SLOTS:
+    void haveNoSubscribersAtStart();
+    void doNotCollectDataWithoutSubscribers();
+    void deliverCollectedDataInBatches();
+    void mergeConsecutiveChunksInTheSameDirection();
+    void deliverAtMostOneBatchPerInterval();
+    void countSubscribers();
+    void stopCollectingAndDiscardPendingDataWhenLastSubscriberLeaves();
+    void ignoreUnsubscribeWithoutSubscribers();
+};
+
+TrafficTapTest::TrafficTapTest()
+{
+}
+
+void TrafficTapTest::haveNoSubscribersAtStart()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    TrafficTap tap(communicator.get(), 50);
+
+    QCOMPARE(tap.subscribers(), 0);
+}
+
+void TrafficTapTest::doNotCollectDataWithoutSubscribers()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    TrafficTap tap(communicator.get(), 50);
+
+    QSignalSpy spy(&tap, &TrafficTap::trafficAvailable);
+
+    communicator->writeData("G1 X10\n");
+    serialPort->simulateReceivedData("ok\r\n");
+
+    QVERIFY(!spy.wait(200));
+}
+
+void TrafficTapTest::deliverCollectedDataInBatches()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    TrafficTap tap(communicator.get(), 50);
+
+    QSignalSpy spy(&tap, &TrafficTap::trafficAvailable);
+
+    tap.subscribe();
+
+    communicator->writeData("G1 X10\n");
+    serialPort->simulateReceivedData("ok\r\n");
+
+    // Not delivered immediately
+    QCOMPARE(spy.count(), 0);
+
+    QVERIFY(spy.wait(200));
+    QCOMPARE(spy.count(), 1);
+
+    const auto batch = spy.at(0).at(0).value<TrafficTap::Batch>();
+    QCOMPARE(batch.size(), 2);
+    QCOMPARE(batch[0].direction, TrafficTap::Direction::Sent);
+    QCOMPARE(batch[0].data, QByteArray("G1 X10\n"));
+    QCOMPARE(batch[1].direction, TrafficTap::Direction::Received);
+    QCOMPARE(batch[1].data, QByteArray("ok\r\n"));
+}
+
+void TrafficTapTest::mergeConsecutiveChunksInTheSameDirection()
+{
+    auto communicatorAndPort = createCommunicator(&m_info);
+    auto communicator = std::move(communicatorAndPort.first);
+    auto serialPort = communicatorAndPort.second;
+    TrafficTap tap(communicator.get(), 50);
+
+    QSignalSpy spy(&tap, &TrafficTap::trafficAvailable);
+
+    tap.subscribe();
+
+    communicator->writeData("G1 X10\n");
+    communicator->writeData("G1 Y10\n");
+    serialPort->simulateReceivedData("ok\r\n");
+    serialPort->simulateReceivedData("ok\r\n");
+    communicator->writeData("?");
+
+    QVERIFY(spy.wait(200));
+
+    const auto batch = spy.at(0).at(0).value<TrafficTap::Batch>();
+    QCOMPARE(batch.size(), 3);
+    QCOMPARE(batch[0].data, QByteArray("G1 X10\nG1 Y10\n"));
+    QCOMPARE(batch[1].data, QByteArray("ok\r\nok\r\n"));
+    QCOMPARE(batch[2].data, QByteArray("?"));
+}
+
+void TrafficTapTest::deliverAtMostOneBatchPerInterval()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    TrafficTap tap(communicator.get(), 200);
+
+    QSignalSpy spy(&tap, &TrafficTap::trafficAvailable);
+
+    tap.subscribe();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 500) {
+        communicator->writeData("G1 X10\n");
+        QCoreApplication::processEvents();
+    }
+    QVERIFY(spy.wait(300));
+
+    // 500 milliseconds of continuous data with a 200 milliseconds interval
+    QVERIFY(spy.count() <= 3);
+}
+
+void TrafficTapTest::countSubscribers()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    TrafficTap tap(communicator.get(), 50);
+
+    tap.subscribe();
+    tap.subscribe();
+    QCOMPARE(tap.subscribers(), 2);
+
+    tap.unsubscribe();
+    QCOMPARE(tap.subscribers(), 1);
+}
+
+void TrafficTapTest::stopCollectingAndDiscardPendingDataWhenLastSubscriberLeaves()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    TrafficTap tap(communicator.get(), 50);
+
+    QSignalSpy spy(&tap, &TrafficTap::trafficAvailable);
+
+    tap.subscribe();
+    tap.subscribe();
+    communicator->writeData("one\n");
+    tap.unsubscribe();
+    communicator->writeData("two\n");
+    tap.unsubscribe();
+    communicator->writeData("three\n");
+
+    QVERIFY(!spy.wait(200));
+
+    // Subscribing again only delivers new data
+    tap.subscribe();
+    communicator->writeData("four\n");
+
+    QVERIFY(spy.wait(200));
+    const auto batch = spy.at(0).at(0).value<TrafficTap::Batch>();
+    QCOMPARE(batch.size(), 1);
+    QCOMPARE(batch[0].data, QByteArray("four\n"));
+}
+
+void TrafficTapTest::ignoreUnsubscribeWithoutSubscribers()
+{
+    auto communicator = std::move(createCommunicator(&m_info).first);
+    TrafficTap tap(communicator.get(), 50);
+
+    tap.unsubscribe();
+
+    QCOMPARE(tap.subscribers(), 0);
+}
+
+QTEST_GUILESS_MAIN(TrafficTapTest)
+
+#include "traffictap_test.moc"
@@ -0,0 +1,15 @@
+# Check the config files exist
+!include(../test.pri) {
+    error("Couldn't find the test.pri file!")
+}
+
+TARGET = worker_test
+
+# Worker is not in a library
+HEADERS += \
+        ../../app/settings.h \
+        ../../app/worker.h
+SOURCES += \
+        worker_test.cpp \
+        ../../app/settings.cpp \
+        ../../app/worker.cpp
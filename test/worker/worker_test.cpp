@@ -0,0 +1,213 @@
+#include <memory>
+#include <QCoreApplication>
+#include <QList>
+#include <QSerialPortInfo>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QtTest>
+#include <QUrl>
+#include "app/worker.h"
+#include "testcommon/testserialport.h"
+
+class WorkerTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    WorkerTest();
+
+private:
+    // The worker finds the machine on a single fake port, which is stored in m_serialPort when
+    // it is created
+    std::unique_ptr<Worker> createWorker();
+    std::unique_ptr<QTemporaryFile> createGCodeFile(QByteArray gcode);
+    // Finds the machine, which then is idle
+    void connectMachine(Worker& worker);
+    void sendState(QByteArray state);
+    void sendReplies(QByteArray reply, int numReplies);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void doNotStartJobsWhileTheFileOfTheGuiIsReady();
+    void startJobsWhenTheFileOfTheGuiIsReleased();
+    void startJobsWhenTheCutOfTheGuiEnds();
+    void refuseTheFileOfTheGuiWhileAJobIsStreaming();
+    void refuseInvalidFilesOfTheGui();
+
+private:
+    TestSerialPort* m_serialPort;
+};
+
+WorkerTest::WorkerTest()
+    : m_serialPort(nullptr)
+{
+}
+
+std::unique_ptr<Worker> WorkerTest::createWorker()
+{
+    auto portDiscoverer = std::make_unique<PortDiscovery<QSerialPortInfo>>(
+        [](){ return QList<QSerialPortInfo>{QSerialPortInfo()}; },
+        [this](QSerialPortInfo) {
+            m_serialPort = new TestSerialPort();
+            return std::unique_ptr<SerialPortInterface>(m_serialPort);
+        },
+        1000, 300, 5, 0, false);
+
+    return std::make_unique<Worker>(std::move(portDiscoverer), QList<qint32>());
+}
+
+std::unique_ptr<QTemporaryFile> WorkerTest::createGCodeFile(QByteArray gcode)
+{
+    auto file = std::make_unique<QTemporaryFile>();
+    if (!file->open()) {
+        return nullptr;
+    }
+
+    file->write(gcode);
+    file->close();
+
+    return file;
+}
+
+void WorkerTest::connectMachine(Worker& worker)
+{
+    worker.portDiscoverer()->start();
+    m_serialPort->simulateReceivedData("[PolyShaper Oranje][pn123 sn456 789]ok\r\n");
+    sendState("Idle");
+}
+
+void WorkerTest::sendState(QByteArray state)
+{
+    m_serialPort->simulateReceivedData("<" + state + "|MPos:0.000,0.000,0.000|FS:0,0|WCO:0.000,0.000,0.000>\r\n");
+}
+
+void WorkerTest::sendReplies(QByteArray reply, int numReplies)
+{
+    for (auto i = 0; i < numReplies; ++i) {
+        m_serialPort->simulateReceivedData(reply + "\r\n");
+    }
+}
+
+void WorkerTest::initTestCase()
+{
+    // Baud rates of found machines are saved, this keeps them away from the settings of ShaCo
+    QCoreApplication::setOrganizationName("PolyShaperTest");
+    QCoreApplication::setApplicationName("worker_test");
+}
+
+void WorkerTest::init()
+{
+    m_serialPort = nullptr;
+}
+
+void WorkerTest::doNotStartJobsWhileTheFileOfTheGuiIsReady()
+{
+    auto guiFile = createGCodeFile("G01 X10 F100\n");
+    auto jobFile = createGCodeFile("G01 Y20 F100\n");
+    QVERIFY(guiFile && jobFile);
+    auto worker = createWorker();
+    connectMachine(*worker);
+
+    QSignalSpy startedSpy(worker.get(), &Worker::streamingStarted);
+
+    worker->setGCodeFile(QUrl::fromLocalFile(guiFile->fileName()));
+    auto guiSender = worker->gcodeSender();
+    emit worker->jobServer()->fileJobSubmitted(1, jobFile->fileName());
+    sendState("Idle");
+    QCoreApplication::processEvents();
+
+    QCOMPARE(worker->gcodeSender(), guiSender);
+    QCOMPARE(startedSpy.count(), 0);
+    QVERIFY(!m_serialPort->writtenData().contains("G01 Y20 F100\n"));
+}
+
+void WorkerTest::startJobsWhenTheFileOfTheGuiIsReleased()
+{
+    auto guiFile = createGCodeFile("G01 X10 F100\n");
+    auto jobFile = createGCodeFile("G01 Y20 F100\n");
+    QVERIFY(guiFile && jobFile);
+    auto worker = createWorker();
+    connectMachine(*worker);
+
+    QSignalSpy startedSpy(worker.get(), &Worker::streamingStarted);
+
+    worker->setGCodeFile(QUrl::fromLocalFile(guiFile->fileName()));
+    emit worker->jobServer()->fileJobSubmitted(1, jobFile->fileName());
+    worker->releaseGCodeFile();
+
+    QCOMPARE(startedSpy.count(), 1);
+    QVERIFY(m_serialPort->writtenData().contains("G01 Y20 F100\n"));
+    QVERIFY(!m_serialPort->writtenData().contains("G01 X10 F100\n"));
+}
+
+void WorkerTest::startJobsWhenTheCutOfTheGuiEnds()
+{
+    auto guiFile = createGCodeFile("G01 X10 F100\n");
+    auto jobFile = createGCodeFile("G01 Y20 F100\n");
+    QVERIFY(guiFile && jobFile);
+    auto worker = createWorker();
+    connectMachine(*worker);
+
+    QSignalSpy startedSpy(worker.get(), &Worker::streamingStarted);
+    QSignalSpy endedSpy(worker.get(), &Worker::streamingEnded);
+
+    worker->setGCodeFile(QUrl::fromLocalFile(guiFile->fileName()));
+    emit worker->jobServer()->fileJobSubmitted(1, jobFile->fileName());
+    worker->gcodeSender()->streamData();
+    sendState("Run");
+    // Replies to commands of the wire controller and to our line, more replies are ignored
+    sendReplies("ok", 10);
+    sendState("Idle");
+
+    QCOMPARE(endedSpy.count(), 1);
+    QCOMPARE(endedSpy.at(0).at(0).value<GCodeSender::StreamEndReason>(), GCodeSender::StreamEndReason::Completed);
+    QTRY_COMPARE(startedSpy.count(), 2);
+    QVERIFY(m_serialPort->writtenData().contains("G01 Y20 F100\n"));
+}
+
+void WorkerTest::refuseTheFileOfTheGuiWhileAJobIsStreaming()
+{
+    auto guiFile = createGCodeFile("G01 X10 F100\n");
+    auto jobFile = createGCodeFile("G01 Y20 F100\n");
+    QVERIFY(guiFile && jobFile);
+    auto worker = createWorker();
+    connectMachine(*worker);
+
+    QSignalSpy startedSpy(worker.get(), &Worker::streamingStarted);
+    QSignalSpy createdSpy(worker.get(), &Worker::gcodeSenderCreated);
+    QSignalSpy refusedSpy(worker.get(), &Worker::gcodeRefused);
+
+    emit worker->jobServer()->fileJobSubmitted(1, jobFile->fileName());
+    QCOMPARE(startedSpy.count(), 1);
+    auto jobSender = worker->gcodeSender();
+    worker->setGCodeFile(QUrl::fromLocalFile(guiFile->fileName()));
+
+    QCOMPARE(worker->gcodeSender(), jobSender);
+    QCOMPARE(createdSpy.count(), 1);
+    QCOMPARE(refusedSpy.count(), 1);
+}
+
+void WorkerTest::refuseInvalidFilesOfTheGui()
+{
+    auto validFile = createGCodeFile("G01 X10 F100\n");
+    // A move without a feed rate
+    auto invalidFile = createGCodeFile("G01 X10\n");
+    QVERIFY(validFile && invalidFile);
+    auto worker = createWorker();
+    connectMachine(*worker);
+
+    QSignalSpy refusedSpy(worker.get(), &Worker::gcodeRefused);
+
+    worker->setGCodeFile(QUrl::fromLocalFile(validFile->fileName()));
+    worker->setGCodeFile(QUrl::fromLocalFile(invalidFile->fileName()));
+
+    // The previous file must not be streamed in place of the refused one
+    QVERIFY(worker->gcodeSender() == nullptr);
+    QCOMPARE(refusedSpy.count(), 1);
+    QVERIFY(refusedSpy.at(0).at(0).toString().startsWith("Invalid G-code at line 1: "));
+}
+
+QTEST_GUILESS_MAIN(WorkerTest)
+
+#include "worker_test.moc"